@@ -0,0 +1,29 @@
+#include "Credentials.h"
+#include <QFile>
+#include <QMessageAuthenticationCode>
+
+QByteArray Credentials::proof(const QByteArray& challenge) const
+{
+    return proof(secret, challenge, user);
+}
+
+QByteArray Credentials::proof(const QByteArray& secret, const QByteArray& challenge, const QString& user)
+{
+    // Имя входит в подпись, чтобы ответ одного пользователя нельзя было выдать за другого
+    return QMessageAuthenticationCode::hash(challenge + '\0' + user.toUtf8(), secret, QCryptographicHash::Sha256);
+}
+
+bool Credentials::loadSecret(const QString& path, QByteArray* secret, QString* error)
+{
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly)) {
+        if (error) *error = QString("Cannot read %1: %2").arg(path, file.errorString());
+        return false;
+    }
+    *secret = file.readLine().trimmed();
+    if (secret->isEmpty()) {
+        if (error) *error = QString("Empty secret in %1").arg(path);
+        return false;
+    }
+    return true;
+}
@@ -0,0 +1,24 @@
+#ifndef CREDENTIALS_H
+#define CREDENTIALS_H
+
+#include <QString>
+#include <QByteArray>
+
+// Вход в демон по схеме вызов-ответ: демон в ответе на hello присылает случайный
+// вызов, клиент отвечает HMAC-SHA256 от вызова и имени общим секретом.
+// Сам секрет по сети не передаётся, а перехваченный ответ не годится для
+// другого соединения.
+struct Credentials {
+    QString user;
+    QByteArray secret;
+
+    bool isEmpty() const { return user.isEmpty() || secret.isEmpty(); }
+
+    QByteArray proof(const QByteArray& challenge) const;
+    static QByteArray proof(const QByteArray& secret, const QByteArray& challenge, const QString& user);
+
+    // Секрет из файла: первая строка без пробелов по краям
+    static bool loadSecret(const QString& path, QByteArray* secret, QString* error);
+};
+
+#endif // CREDENTIALS_H
@@ -0,0 +1,183 @@
+#include "DeltaSync.h"
+#include <QCryptographicHash>
+#include <QFile>
+#include <QHash>
+#include <QJsonObject>
+#include <QVector>
+#include <cmath>
+
+namespace {
+
+const int strongChecksumBytes = 8;
+const int readChunkSize = 1024 * 1024;
+
+// Слабая сумма rsync: a - сумма байт, b - сумма байт с весами L..1, обе по модулю 2^16
+struct RollingChecksum {
+    quint32 a = 0;
+    quint32 b = 0;
+    int length = 0;
+
+    void reset(const uchar* data, int size)
+    {
+        a = b = 0;
+        length = size;
+        for (int i = 0; i < size; ++i) {
+            a += data[i];
+            b += static_cast<quint32>(size - i) * data[i];
+        }
+    }
+
+    // Окно сдвигается на байт: out уходит слева, in приходит справа
+    void roll(uchar out, uchar in)
+    {
+        a = a - out + in;
+        b = b - static_cast<quint32>(length) * out + a;
+    }
+
+    quint32 value() const { return (a & 0xffff) | ((b & 0xffff) << 16); }
+};
+
+} // namespace
+
+int DeltaSync::blockSizeFor(qint64 size)
+{
+    const int root = static_cast<int>(std::sqrt(static_cast<double>(size)));
+    return qBound(2048, root / 1024 * 1024, 64 * 1024);
+}
+
+quint32 DeltaSync::weakChecksum(const char* data, int length)
+{
+    RollingChecksum sum;
+    sum.reset(reinterpret_cast<const uchar*>(data), length);
+    return sum.value();
+}
+
+QString DeltaSync::strongChecksum(const char* data, int length)
+{
+    const QByteArray digest = QCryptographicHash::hash(QByteArray::fromRawData(data, length), QCryptographicHash::Md5);
+    return QString::fromLatin1(digest.left(strongChecksumBytes).toHex());
+}
+
+QString DeltaSync::fileHash(const QString& path)
+{
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly)) return QString();
+    QCryptographicHash hash(QCryptographicHash::Sha256);
+    if (!hash.addData(&file)) return QString();
+    return QString::fromLatin1(hash.result().toHex());
+}
+
+QJsonArray DeltaSync::signatures(QIODevice* file, int blockSize, QString* sha256)
+{
+    QJsonArray result;
+    QCryptographicHash hash(QCryptographicHash::Sha256);
+    for (;;) {
+        const QByteArray block = file->read(blockSize);
+        if (block.isEmpty()) break;
+        hash.addData(block);
+        // Неполный хвост не подписываем: в новой версии он почти всегда другой
+        if (block.size() == blockSize) {
+            result.append(QJsonArray{ static_cast<double>(weakChecksum(block.constData(), block.size())),
+                                      strongChecksum(block.constData(), block.size()) });
+        }
+    }
+    if (sha256) *sha256 = QString::fromLatin1(hash.result().toHex());
+    return result;
+}
+
+QJsonArray DeltaSync::delta(const QByteArray& data, const QJsonArray& signatures, int blockSize, qint64* literalBytes)
+{
+    // Слабая сумма -> номера блоков; сильная считается только при совпадении слабой
+    QHash<quint32, QVector<int>> index;
+    for (int i = 0; i < signatures.size(); ++i) {
+        index[static_cast<quint32>(signatures[i].toArray().at(0).toDouble())].append(i);
+    }
+
+    QJsonArray ops;
+    qint64 literal = 0;
+    const uchar* bytes = reinterpret_cast<const uchar*>(data.constData());
+    const int size = data.size();
+    int literalStart = 0;
+    int lastBlock = -2;
+
+    auto flushLiteral = [&](int end) {
+        if (end <= literalStart) return;
+        ops.append(QJsonObject{{"data", QString::fromLatin1(data.mid(literalStart, end - literalStart).toBase64())}});
+        literal += end - literalStart;
+        lastBlock = -2;
+    };
+
+    RollingChecksum sum;
+    int pos = 0;
+    if (!index.isEmpty() && size >= blockSize) sum.reset(bytes, blockSize);
+    while (!index.isEmpty() && pos + blockSize <= size) {
+        int match = -1;
+        const auto it = index.constFind(sum.value());
+        if (it != index.constEnd()) {
+            const QString strong = strongChecksum(data.constData() + pos, blockSize);
+            for (int candidate : it.value()) {
+                if (signatures[candidate].toArray().at(1).toString() == strong) {
+                    match = candidate;
+                    break;
+                }
+            }
+        }
+        if (match >= 0) {
+            flushLiteral(pos);
+            // Блоки подряд - одна операция copy
+            if (match == lastBlock + 1 && !ops.isEmpty()) {
+                QJsonObject last = ops.last().toObject();
+                last["count"] = last["count"].toInt() + 1;
+                ops[ops.size() - 1] = last;
+            } else {
+                ops.append(QJsonObject{{"copy", match}, {"count", 1}});
+            }
+            lastBlock = match;
+            pos += blockSize;
+            literalStart = pos;
+            if (pos + blockSize <= size) sum.reset(bytes + pos, blockSize);
+            continue;
+        }
+        if (pos + blockSize < size) sum.roll(bytes[pos], bytes[pos + blockSize]);
+        ++pos;
+    }
+    flushLiteral(size);
+
+    if (literalBytes) *literalBytes = literal;
+    return ops;
+}
+
+bool DeltaSync::apply(QIODevice* base, const QJsonArray& delta, int blockSize, QIODevice* out,
+                      QCryptographicHash* hash, QString* error)
+{
+    auto write = [&](const QByteArray& chunk) {
+        if (hash) hash->addData(chunk);
+        if (out->write(chunk) == chunk.size()) return true;
+        if (error) *error = "Write failed: " + out->errorString();
+        return false;
+    };
+
+    for (const QJsonValue& value : delta) {
+        const QJsonObject op = value.toObject();
+        if (op.contains("data")) {
+            if (!write(QByteArray::fromBase64(op["data"].toString().toLatin1()))) return false;
+            continue;
+        }
+        const qint64 first = op["copy"].toInt(-1);
+        const qint64 count = op["count"].toInt(0);
+        if (first < 0 || count <= 0 || !base->seek(first * blockSize)) {
+            if (error) *error = "Invalid delta block reference";
+            return false;
+        }
+        for (qint64 remaining = count * blockSize; remaining > 0;) {
+            const QByteArray chunk = base->read(qMin<qint64>(remaining, readChunkSize));
+            if (chunk.isEmpty()) {
+                if (error) *error = "Delta refers past the end of the base file";
+                return false;
+            }
+            if (!write(chunk)) return false;
+            remaining -= chunk.size();
+        }
+    }
+    return true;
+}
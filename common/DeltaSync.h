@@ -0,0 +1,41 @@
+#ifndef DELTASYNC_H
+#define DELTASYNC_H
+
+#include <QByteArray>
+#include <QJsonArray>
+#include <QString>
+
+class QIODevice;
+class QCryptographicHash;
+
+// Блочная разница для syncTree, как в rsync. Демон присылает подписи полных
+// блоков своей версии файла: слабую скользящую сумму и первые 8 байт MD5.
+// Клиент сдвигает окно по новой версии на байт и, найдя совпадение, вместо
+// данных шлёт ссылку на блок. Результат сверяется по SHA-256 всего файла,
+// так что редкие коллизии подписей не портят данные.
+//
+// Разница - массив операций: {"copy": номер блока, "count": n} или {"data": base64}.
+struct DeltaSync {
+    // Меньше этого файл дешевле передать целиком, чем считать подписи
+    static const qint64 minDeltaSize = 64 * 1024;
+
+    // Около sqrt(размера), кратно 1 КиБ, от 2 до 64 КиБ
+    static int blockSizeFor(qint64 size);
+
+    static quint32 weakChecksum(const char* data, int length);
+    static QString strongChecksum(const char* data, int length);
+    // SHA-256 файла в hex; пусто, если файл не читается
+    static QString fileHash(const QString& path);
+
+    // Подписи полных блоков: [[weak, "strong"], ...]; sha256 - хэш всего файла попутно
+    static QJsonArray signatures(QIODevice* file, int blockSize, QString* sha256 = nullptr);
+    // Разница новой версии data относительно файла с подписями signatures.
+    // literalBytes - сколько байт уходит данными, а не ссылками
+    static QJsonArray delta(const QByteArray& data, const QJsonArray& signatures, int blockSize,
+                            qint64* literalBytes = nullptr);
+    // Сборка новой версии из base и разницы; hash, если задан, получает все записанные байты
+    static bool apply(QIODevice* base, const QJsonArray& delta, int blockSize, QIODevice* out,
+                      QCryptographicHash* hash, QString* error);
+};
+
+#endif // DELTASYNC_H
@@ -0,0 +1,349 @@
+#include "FrameChannel.h"
+#include <QDataStream>
+#include <QAbstractSocket>
+#include <QSslSocket>
+#include <QTimer>
+#include <QtEndian>
+#include <QDebug>
+
+namespace {
+
+const quint32 multiplexFlag = 0x80000000u;
+const int multiplexHeaderExtra = sizeof(quint32) + 2 * sizeof(quint8);
+
+// Сокет держим почти пустым: иначе новый интерактивный кадр встанет
+// в очередь за уже записанными кусками большой передачи
+const qint64 lowWaterMark = 64 * 1024;
+
+const qint64 maxBufferedIncoming = 64 * 1024 * 1024;
+const int maxRefusedStreams = 32;
+
+} // namespace
+
+FrameChannel::FrameChannel(QIODevice* device, QObject* parent)
+    : QObject(parent),
+      device(device),
+      tlsSocket(qobject_cast<QSslSocket*>(device)),
+      multiplexing(false),
+      outputHighWaterMark(0),
+      maxMessageSize(defaultMaxMessageSize),
+      readingPaused(false),
+      frameLength(0),
+      frameMultiplexed(false),
+      haveHeader(false),
+      nextStreamId(1),
+      bufferedIncoming(0)
+{
+    connect(device, &QIODevice::readyRead, this, &FrameChannel::onReadyRead);
+    connect(device, &QIODevice::bytesWritten, this, &FrameChannel::onBytesWritten);
+    if (tlsSocket) connect(tlsSocket, &QSslSocket::encryptedBytesWritten, this, &FrameChannel::onBytesWritten);
+}
+
+// У QSslSocket bytesToWrite() - только ещё не зашифрованные данные; уже
+// зашифрованные ждут в нижнем сокете и тоже должны сдерживать отправку
+qint64 FrameChannel::deviceBytesToWrite() const
+{
+    qint64 total = device->bytesToWrite();
+    if (tlsSocket) total += tlsSocket->encryptedBytesToWrite();
+    return total;
+}
+
+void FrameChannel::reset()
+{
+    multiplexing = false;
+    haveHeader = false;
+    frameLength = 0;
+    nextStreamId = 1;
+    outgoing.clear();
+    for (QList<quint32>& queue : readyQueues) queue.clear();
+    incoming.clear();
+    refusedStreams.clear();
+    bufferedIncoming = 0;
+    if (readingPaused) resumeReading();
+}
+
+qint64 FrameChannel::queuedBytes() const
+{
+    qint64 total = 0;
+    for (const OutgoingStream& stream : outgoing) total += stream.data.size() - stream.offset;
+    return total;
+}
+
+qint64 FrameChannel::pendingOutput() const
+{
+    qint64 total = deviceBytesToWrite();
+    for (const OutgoingStream& stream : outgoing) {
+        total += qMin<qint64>(stream.data.size() - stream.offset, stream.window);
+    }
+    return total;
+}
+
+void FrameChannel::sendMessage(const QByteArray& message, Priority priority)
+{
+    if (!multiplexing) {
+        writeLegacyFrame(message);
+        return;
+    }
+
+    const quint32 streamId = nextStreamId++;
+    if (nextStreamId == 0) nextStreamId = 1;
+
+    OutgoingStream stream;
+    stream.data = message;
+    stream.priority = qBound(static_cast<int>(Interactive), static_cast<int>(priority), static_cast<int>(Bulk));
+    outgoing.insert(streamId, stream);
+    readyQueues[stream.priority].append(streamId);
+    pump();
+}
+
+void FrameChannel::writeLegacyFrame(const QByteArray& message)
+{
+    QByteArray packet;
+    QDataStream out(&packet, QIODevice::WriteOnly);
+    out.setByteOrder(QDataStream::BigEndian);
+    out << static_cast<quint32>(message.size());
+    packet.append(message);
+    device->write(packet);
+}
+
+void FrameChannel::writeFrame(quint32 streamId, FrameType type, quint8 priority, const QByteArray& payload)
+{
+    QByteArray packet;
+    packet.reserve(sizeof(quint32) + multiplexHeaderExtra + payload.size());
+    QDataStream out(&packet, QIODevice::WriteOnly);
+    out.setByteOrder(QDataStream::BigEndian);
+    out << (multiplexFlag | static_cast<quint32>(payload.size())) << streamId
+        << static_cast<quint8>(type) << priority;
+    packet.append(payload);
+    device->write(packet);
+}
+
+void FrameChannel::onBytesWritten()
+{
+    pump();
+    // Возобновляем чтение с запасом, чтобы не переключаться на каждом кадре
+    if (readingPaused && pendingOutput() <= outputHighWaterMark / 2) resumeReading();
+}
+
+void FrameChannel::pauseReading()
+{
+    readingPaused = true;
+    if (QAbstractSocket* socket = qobject_cast<QAbstractSocket*>(device)) {
+        socket->setReadBufferSize(qMax<qint64>(1, socket->bytesAvailable()));
+    }
+}
+
+void FrameChannel::resumeReading()
+{
+    readingPaused = false;
+    if (QAbstractSocket* socket = qobject_cast<QAbstractSocket*>(device)) {
+        socket->setReadBufferSize(0);
+    }
+    // Уже принятые данные readyRead повторно не объявит
+    QTimer::singleShot(0, this, &FrameChannel::onReadyRead);
+}
+
+void FrameChannel::pump()
+{
+    if (!multiplexing) return;
+
+    while (device->isOpen() && deviceBytesToWrite() < lowWaterMark) {
+        // Строгий приоритет между уровнями, внутри уровня - по кругу.
+        // Уведомления (Normal) идут строго по порядку, иначе куски журнала перемешаются.
+        quint32 streamId = 0;
+        bool found = false;
+        for (int level = Interactive; level <= Bulk && !found; ++level) {
+            QList<quint32>& queue = readyQueues[level];
+            const int candidates = level == Normal ? qMin(1, queue.size()) : queue.size();
+            for (int i = 0; i < candidates; ++i) {
+                const OutgoingStream& candidate = outgoing[queue[i]];
+                if (candidate.window > 0 || candidate.offset == candidate.data.size()) {
+                    streamId = queue.takeAt(i);
+                    found = true;
+                    break;
+                }
+            }
+        }
+        if (!found) return; // всё оставшееся ждёт WindowUpdate от получателя
+
+        OutgoingStream& stream = outgoing[streamId];
+        const int length = static_cast<int>(qMin<qint64>(qMin(chunkSize, stream.data.size() - stream.offset),
+                                                         stream.window));
+        const bool last = stream.offset + length == stream.data.size();
+        writeFrame(streamId, last ? DataEnd : Data, static_cast<quint8>(stream.priority),
+                   stream.data.mid(stream.offset, length));
+        stream.offset += length;
+        stream.window -= length;
+
+        if (last) {
+            outgoing.remove(streamId);
+        } else if (stream.priority == Normal) {
+            readyQueues[Normal].prepend(streamId);
+        } else {
+            readyQueues[stream.priority].append(streamId);
+        }
+    }
+}
+
+void FrameChannel::onReadyRead()
+{
+    QDataStream in(device);
+    in.setVersion(QDataStream::Qt_5_14);
+    in.setByteOrder(QDataStream::BigEndian);
+
+    while (device->isOpen()) {
+        if (outputHighWaterMark > 0 && pendingOutput() > outputHighWaterMark) {
+            pauseReading();
+            return;
+        }
+        if (readingPaused) return;
+
+        if (!haveHeader) {
+            if (device->bytesAvailable() < static_cast<qint64>(sizeof(quint32))) return;
+            quint32 header;
+            in >> header;
+            frameMultiplexed = header & multiplexFlag;
+            frameLength = header & ~multiplexFlag;
+            haveHeader = true;
+
+            if (frameMultiplexed && frameLength > static_cast<quint32>(chunkSize)) {
+                emit protocolError(QString("Frame of %1 bytes exceeds chunk size").arg(frameLength));
+                device->close();
+                return;
+            }
+            if (!frameMultiplexed && frameLength > maxMessageSize) {
+                emit protocolError(QString("Message of %1 bytes is too large").arg(frameLength));
+                device->close();
+                return;
+            }
+        }
+
+        const qint64 needed = frameLength + (frameMultiplexed ? multiplexHeaderExtra : 0);
+        if (device->bytesAvailable() < needed) return;
+        haveHeader = false;
+
+        if (!frameMultiplexed) {
+            QByteArray message;
+            message.resize(frameLength);
+            in.readRawData(message.data(), frameLength);
+            emit messageReceived(message);
+            continue;
+        }
+
+        quint32 streamId;
+        quint8 type;
+        quint8 priority;
+        in >> streamId >> type >> priority;
+        Q_UNUSED(priority); // приоритет важен только отправителю, получатель обрабатывает кадры сразу
+
+        QByteArray payload;
+        payload.resize(frameLength);
+        in.readRawData(payload.data(), frameLength);
+        handleFrame(streamId, static_cast<FrameType>(type), payload);
+    }
+}
+
+void FrameChannel::handleFrame(quint32 streamId, FrameType type, const QByteArray& payload)
+{
+    switch (type) {
+    case Data:
+    case DataEnd:
+        handleData(streamId, payload, type == DataEnd);
+        break;
+    case WindowUpdate: {
+        if (payload.size() < static_cast<int>(sizeof(quint32))) break;
+        auto it = outgoing.find(streamId);
+        if (it == outgoing.end()) break; // поток уже отправлен целиком
+        it->window += qFromBigEndian<quint32>(payload.constData());
+        pump();
+        break;
+    }
+    case Reset:
+        if (!payload.isEmpty() && static_cast<quint8>(payload[0]) == ReceiverRefuse) {
+            dropOutgoing(streamId);
+        } else {
+            auto it = incoming.find(streamId);
+            if (it != incoming.end()) {
+                bufferedIncoming -= it->data.size();
+                incoming.erase(it);
+            }
+        }
+        break;
+    default:
+        emit protocolError(QString("Unknown frame type %1").arg(static_cast<int>(type)));
+        break;
+    }
+}
+
+void FrameChannel::handleData(quint32 streamId, const QByteArray& payload, bool last)
+{
+    if (refusedStreams.contains(streamId)) {
+        if (last) refusedStreams.removeOne(streamId);
+        return;
+    }
+
+    // Окно ограничивает каждый поток, а этот порог - их сумму
+    if (!incoming.contains(streamId) && bufferedIncoming > maxBufferedIncoming) {
+        refuseStream(streamId, "too much buffered data");
+        return;
+    }
+
+    IncomingStream& stream = incoming[streamId];
+    stream.window -= payload.size();
+    if (stream.window < 0) {
+        refuseStream(streamId, "flow control window exceeded");
+        return;
+    }
+    if (stream.data.size() + payload.size() > maxMessageSize) {
+        refuseStream(streamId, "message too large");
+        return;
+    }
+
+    stream.data.append(payload);
+    stream.unacknowledged += payload.size();
+    bufferedIncoming += payload.size();
+
+    if (last) {
+        QByteArray message = incoming.take(streamId).data;
+        bufferedIncoming -= message.size();
+        emit messageReceived(message);
+        return;
+    }
+    grantCredit(streamId, stream);
+}
+
+void FrameChannel::grantCredit(quint32 streamId, IncomingStream& stream)
+{
+    // Кредит возвращаем сразу: начатые сообщения нужно дособрать, иначе память
+    // не освободится. Общий объём ограничивается отказом в новых потоках.
+    if (stream.unacknowledged < initialWindow / 2) return;
+
+    QByteArray payload(sizeof(quint32), Qt::Uninitialized);
+    qToBigEndian<quint32>(static_cast<quint32>(stream.unacknowledged), payload.data());
+    writeFrame(streamId, WindowUpdate, Interactive, payload);
+    stream.window += stream.unacknowledged;
+    stream.unacknowledged = 0;
+}
+
+void FrameChannel::refuseStream(quint32 streamId, const QString& reason)
+{
+    qWarning() << "Refusing stream" << streamId << ":" << reason;
+
+    auto it = incoming.find(streamId);
+    if (it != incoming.end()) {
+        bufferedIncoming -= it->data.size();
+        incoming.erase(it);
+    }
+    refusedStreams.append(streamId);
+    if (refusedStreams.size() > maxRefusedStreams) refusedStreams.removeFirst();
+
+    writeFrame(streamId, Reset, Interactive, QByteArray(1, static_cast<char>(ReceiverRefuse)));
+}
+
+void FrameChannel::dropOutgoing(quint32 streamId)
+{
+    auto it = outgoing.find(streamId);
+    if (it == outgoing.end()) return;
+    readyQueues[it->priority].removeOne(streamId);
+    outgoing.erase(it);
+}
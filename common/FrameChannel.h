@@ -0,0 +1,125 @@
+#ifndef FRAMECHANNEL_H
+#define FRAMECHANNEL_H
+
+#include <QObject>
+#include <QIODevice>
+#include <QByteArray>
+#include <QHash>
+#include <QList>
+
+// Кадрирование сообщений поверх одного TCP-соединения, общее для клиента и демона.
+//
+// Старый формат: quint32 длина (big-endian) + JSON. После согласования (RPC hello)
+// обе стороны переходят к мультиплексированию: каждое сообщение идёт отдельным
+// логическим потоком, нарезается на куски по 16 КБ, и куски разных потоков
+// чередуются по приоритетам. Большая передача больше не задерживает короткие RPC.
+//
+// Кадр мультиплексора:
+//   quint32  0x80000000 | длина полезной нагрузки
+//   quint32  id потока (свой у каждой стороны, направление определяется типом кадра)
+//   quint8   тип: Data, DataEnd, WindowUpdate, Reset
+//   quint8   приоритет
+//   payload
+// Кадры старого формата принимаются всегда: старший бит длины у них нулевой.
+class QSslSocket;
+
+class FrameChannel : public QObject
+{
+    Q_OBJECT
+public:
+    enum Priority {
+        Interactive = 0, // короткие запросы и ответы
+        Normal = 1,      // уведомления подписок
+        Bulk = 2         // передача файлов и другие крупные сообщения
+    };
+
+    explicit FrameChannel(QIODevice* device, QObject* parent = nullptr);
+
+    void setMultiplexing(bool enabled) { multiplexing = enabled; }
+    bool isMultiplexing() const { return multiplexing; }
+
+    void sendMessage(const QByteArray& message, Priority priority = Interactive);
+
+    // Сбрасывает все потоки и возвращает канал в старый режим (после разрыва соединения)
+    void reset();
+
+    // Сколько байт ещё ждут отправки в очередях потоков
+    qint64 queuedBytes() const;
+    // Что можно отправить прямо сейчас: буфер сокета плюс данные потоков в пределах
+    // их окон. Потоки, ждущие WindowUpdate, не учитываются - их тормозит получатель.
+    qint64 pendingOutput() const;
+
+    // Пока неотправленного больше порога, входящие кадры не читаются: сокет
+    // перестаёт забирать данные из ядра, и TCP притормаживает отправителя.
+    // 0 - без ограничения.
+    void setOutputHighWaterMark(qint64 bytes) { outputHighWaterMark = bytes; }
+    bool isReadingPaused() const { return readingPaused; }
+
+    // Предел размера одного входящего сообщения; больше - разрыв или сброс потока
+    void setMaxMessageSize(qint64 bytes) { maxMessageSize = bytes; }
+    qint64 maxMessageBytes() const { return maxMessageSize; }
+    static constexpr qint64 defaultMaxMessageSize = 256 * 1024 * 1024;
+
+    static constexpr int chunkSize = 16 * 1024;
+    static constexpr int initialWindow = 1024 * 1024;
+
+signals:
+    void messageReceived(const QByteArray& message);
+    void protocolError(const QString& message);
+
+private slots:
+    void onReadyRead();
+    void onBytesWritten();
+    void pump();
+
+private:
+    enum FrameType : quint8 { Data = 0, DataEnd = 1, WindowUpdate = 2, Reset = 3 };
+    // В Reset указываем, чью сторону потока сбрасываем
+    enum ResetDirection : quint8 { SenderAbort = 0, ReceiverRefuse = 1 };
+
+    struct OutgoingStream {
+        QByteArray data;
+        int offset = 0;
+        int priority = Interactive;
+        qint64 window = initialWindow;
+    };
+
+    struct IncomingStream {
+        QByteArray data;
+        qint64 window = initialWindow;
+        qint64 unacknowledged = 0;
+    };
+
+    void writeFrame(quint32 streamId, FrameType type, quint8 priority, const QByteArray& payload);
+    void writeLegacyFrame(const QByteArray& message);
+    void handleFrame(quint32 streamId, FrameType type, const QByteArray& payload);
+    void handleData(quint32 streamId, const QByteArray& payload, bool last);
+    void grantCredit(quint32 streamId, IncomingStream& stream);
+    void refuseStream(quint32 streamId, const QString& reason);
+    void dropOutgoing(quint32 streamId);
+    void pauseReading();
+    void resumeReading();
+    qint64 deviceBytesToWrite() const;
+
+    QIODevice* device;
+    QSslSocket* tlsSocket; // тот же device, если это TLS-сокет
+    bool multiplexing;
+    qint64 outputHighWaterMark;
+    qint64 maxMessageSize;
+    bool readingPaused;
+
+    // Разбор входящих кадров
+    quint32 frameLength;
+    bool frameMultiplexed;
+    bool haveHeader;
+
+    quint32 nextStreamId;
+    QHash<quint32, OutgoingStream> outgoing;
+    QList<quint32> readyQueues[Bulk + 1]; // круговая очередь потоков на каждый приоритет
+
+    QHash<quint32, IncomingStream> incoming;
+    QList<quint32> refusedStreams; // хвосты отклонённых потоков, ещё летящие по сети
+    qint64 bufferedIncoming;
+};
+
+#endif // FRAMECHANNEL_H
@@ -0,0 +1,377 @@
+#include "RpcClient.h"
+#include <QJsonDocument>
+#include <QEventLoop>
+#include <QTimer>
+#include <QDebug>
+
+bool RpcResult::isBusy() const
+{
+    return errorCode == RpcClient::busyErrorCode;
+}
+
+namespace {
+
+RpcResult transportError(int code, const QString& message)
+{
+    RpcResult reply;
+    reply.errorCode = code;
+    reply.errorMessage = message;
+    return reply;
+}
+
+// "адрес:порт" -> последний билет сеанса TLS; клиенты живут в главном потоке
+QHash<QString, QByteArray>& sessionTickets()
+{
+    static QHash<QString, QByteArray> tickets;
+    return tickets;
+}
+
+} // namespace
+
+RpcClient::RpcClient(QObject* parent)
+    : QObject(parent), tlsEnabled(false), nextId(1), helloId(-1), authId(-1)
+{
+    qRegisterMetaType<RpcResult>("RpcResult");
+
+    // Без setTls() QSslSocket работает как обычный TCP-сокет
+    socket = new QSslSocket(this);
+    channel = new FrameChannel(socket, this);
+    connect(channel, &FrameChannel::messageReceived, this, &RpcClient::onMessage);
+    connect(channel, &FrameChannel::protocolError, this, [](const QString& message) {
+        qWarning() << "Protocol error:" << message;
+    });
+    connect(socket, &QSslSocket::connected, this, &RpcClient::onConnected);
+    connect(socket, &QSslSocket::encrypted, this, &RpcClient::onEncrypted);
+    connect(socket, &QSslSocket::disconnected, this, &RpcClient::onDisconnected);
+    connect(socket, QOverload<QAbstractSocket::SocketError>::of(&QSslSocket::error),
+            this, &RpcClient::onErrorOccurred);
+    connect(socket, QOverload<const QList<QSslError>&>::of(&QSslSocket::sslErrors),
+            this, [](const QList<QSslError>& errors) {
+        for (const QSslError& error : errors) qWarning() << "TLS error:" << error.errorString();
+    });
+#if QT_VERSION >= QT_VERSION_CHECK(5, 15, 0)
+    // В TLS 1.3 билет приходит уже после рукопожатия
+    connect(socket, &QSslSocket::newSessionTicketReceived, this, &RpcClient::rememberSessionTicket);
+#endif
+}
+
+RpcClient::~RpcClient()
+{
+    // Ожидающие QFuture не должны висеть вечно после удаления клиента;
+    // сигналы из деструктора уже не шлём
+    for (Pending& entry : pending) {
+        if (!entry.hasPromise) continue;
+        entry.promise.reportResult(transportError(transportErrorCode, "Client destroyed"));
+        entry.promise.reportFinished();
+    }
+}
+
+bool RpcClient::setTls(const TlsOptions& options, QString* error)
+{
+    tlsEnabled = false;
+    if (!options.enabled) return true;
+    QSslConfiguration configuration;
+    if (!options.makeConfiguration(QSslSocket::SslClientMode, &configuration, error)) return false;
+    setTlsConfiguration(configuration, options.peerName);
+    return true;
+}
+
+void RpcClient::setTlsConfiguration(const QSslConfiguration& configuration, const QString& peerName)
+{
+    tlsConfiguration = configuration;
+    tlsPeerName = peerName;
+    tlsEnabled = !configuration.isNull();
+}
+
+void RpcClient::connectToHost(const QString& hostName, quint16 port)
+{
+    host = QString("%1:%2").arg(hostName).arg(port);
+    if (!tlsEnabled) {
+        socket->connectToHost(hostName, port);
+        return;
+    }
+
+    QSslConfiguration config = tlsConfiguration;
+    const QByteArray ticket = sessionTickets().value(host);
+    if (!ticket.isEmpty()) config.setSessionTicket(ticket);
+    socket->setSslConfiguration(config);
+    socket->connectToHostEncrypted(hostName, port, tlsPeerName.isEmpty() ? hostName : tlsPeerName);
+}
+
+bool RpcClient::connectSync(const QString& hostName, quint16 port, int timeoutMs, QString* error)
+{
+    QEventLoop loop;
+    QString failure;
+    bool ready = false;
+    QMetaObject::Connection onReady = connect(this, &RpcClient::connected, &loop, [&]() {
+        ready = true;
+        loop.quit();
+    });
+    QMetaObject::Connection onError = connect(this, &RpcClient::connectionError, &loop, [&](const QString& message) {
+        failure = message;
+        loop.quit();
+    });
+    QTimer::singleShot(timeoutMs, &loop, &QEventLoop::quit);
+
+    connectToHost(hostName, port);
+    if (!ready && failure.isEmpty()) loop.exec();
+    disconnect(onReady);
+    disconnect(onError);
+
+    if (!ready) {
+        if (failure.isEmpty()) failure = "Connection timed out";
+        if (error) *error = failure;
+        socket->abort();
+        channel->reset();
+    }
+    return ready;
+}
+
+void RpcClient::disconnectFromHost()
+{
+    socket->abort();
+    failAll("Disconnected");
+    channel->reset();
+    helloId = -1;
+    authId = -1;
+}
+
+bool RpcClient::isConnected() const
+{
+    return socket->state() == QAbstractSocket::ConnectedState;
+}
+
+int RpcClient::send(const QString& method, const QJsonObject& params, FrameChannel::Priority priority)
+{
+    if (!isConnected()) {
+        qWarning() << "Trying to send data while not connected";
+        return -1;
+    }
+    QJsonObject request;
+    request["method"] = method;
+    if (!params.isEmpty()) request["params"] = params;
+    const int id = nextId++;
+    request["id"] = id;
+
+    Pending entry;
+    entry.method = method;
+    pending.insert(id, entry);
+    channel->sendMessage(QJsonDocument(request).toJson(QJsonDocument::Compact), priority);
+    return id;
+}
+
+int RpcClient::call(const QString& method, const QJsonObject& params, FrameChannel::Priority priority)
+{
+    return send(method, params, priority);
+}
+
+QFuture<RpcResult> RpcClient::callAsync(const QString& method, const QJsonObject& params,
+                                        FrameChannel::Priority priority)
+{
+    QFutureInterface<RpcResult> promise;
+    promise.reportStarted();
+
+    const int id = send(method, params, priority);
+    if (id < 0) {
+        const RpcResult reply = transportError(transportErrorCode, "Not connected");
+        promise.reportResult(reply);
+        promise.reportFinished();
+        return promise.future();
+    }
+
+    Pending& entry = pending[id];
+    entry.promise = promise;
+    entry.hasPromise = true;
+    return promise.future();
+}
+
+RpcResult RpcClient::callSync(const QString& method, const QJsonObject& params, int timeoutMs,
+                              FrameChannel::Priority priority)
+{
+    const int id = send(method, params, priority);
+    if (id < 0) return transportError(transportErrorCode, "Not connected");
+
+    QEventLoop loop;
+    RpcResult outcome;
+    bool done = false;
+    QMetaObject::Connection onReply = connect(this, &RpcClient::replyReceived, &loop,
+        [&](int replyId, const QString&, const RpcResult& reply) {
+            if (replyId != id) return;
+            outcome = reply;
+            done = true;
+            loop.quit();
+        });
+    QTimer::singleShot(timeoutMs, &loop, &QEventLoop::quit);
+    loop.exec();
+    disconnect(onReply);
+
+    if (!done) {
+        pending.remove(id);
+        return transportError(timeoutErrorCode, QString("%1 timed out").arg(method));
+    }
+    return outcome;
+}
+
+void RpcClient::onConnected()
+{
+    // По TLS протокол начинается только после рукопожатия
+    if (!tlsEnabled) startSession();
+}
+
+void RpcClient::onEncrypted()
+{
+    rememberSessionTicket();
+    startSession();
+}
+
+void RpcClient::startSession()
+{
+    // Просим демон перейти на мультиплексированные кадры; старый демон ответит ошибкой
+    helloId = send("hello", QJsonObject{{"multiplex", true}}, FrameChannel::Interactive);
+}
+
+void RpcClient::rememberSessionTicket()
+{
+    const QByteArray ticket = socket->sslConfiguration().sessionTicket();
+    if (!ticket.isEmpty()) sessionTickets().insert(host, ticket);
+}
+
+void RpcClient::onMessage(const QByteArray& data)
+{
+    QJsonParseError parseError;
+    QJsonDocument doc = QJsonDocument::fromJson(data, &parseError);
+    if (parseError.error != QJsonParseError::NoError) {
+        qWarning() << "JSON parse error:" << parseError.errorString();
+        return;
+    }
+    const QJsonObject response = doc.object();
+
+    if (!response.contains("id") && response.contains("method")) {
+        emit notificationReceived(response["method"].toString(), response["params"].toObject());
+        return;
+    }
+    if (!response.contains("id")) {
+        qWarning() << "JSON-RPC response without id";
+        return;
+    }
+
+    const int id = response["id"].toInt(-1);
+    if (!pending.contains(id)) {
+        qWarning() << "Unknown id in response:" << id;
+        return;
+    }
+
+    RpcResult reply;
+    if (response.contains("error")) {
+        const QJsonValue error = response["error"];
+        if (error.isObject()) {
+            const QJsonObject err = error.toObject();
+            reply.errorCode = err["code"].toInt(-32000);
+            reply.errorMessage = err["message"].toString();
+            reply.errorData = err["data"];
+        } else {
+            reply.errorCode = -32000;
+            reply.errorMessage = error.toString();
+        }
+    } else {
+        reply.result = response["result"];
+    }
+
+    if (id == helloId) {
+        pending.remove(id);
+        helloId = -1;
+        finishHello(reply);
+        return;
+    }
+    if (id == authId) {
+        pending.remove(id);
+        authId = -1;
+        if (!reply.ok()) {
+            emit connectionError("Ошибка входа: " + reply.errorMessage);
+            socket->abort();
+            return;
+        }
+        sessionRole = reply.result.toObject()["role"].toString();
+        emit connected();
+        return;
+    }
+    complete(id, reply);
+}
+
+void RpcClient::finishHello(const RpcResult& reply)
+{
+    // Билет TLS 1.3 приходит после рукопожатия; к ответу на hello он уже принят
+    if (tlsEnabled) rememberSessionTicket();
+    const QJsonObject result = reply.result.toObject();
+    channel->setMultiplexing(result["multiplex"].toBool());
+
+    // Демон без аутентификации не присылает auth и пускает всех
+    const QJsonObject auth = result["auth"].toObject();
+    sessionRole = result.contains("auth") ? auth["role"].toString() : QString("admin");
+    if (auth.contains("challenge") && !credentials.isEmpty()) {
+        const QByteArray challenge = QByteArray::fromBase64(auth["challenge"].toString().toLatin1());
+        authId = send("authenticate", QJsonObject{
+            {"user", credentials.user},
+            {"proof", QString::fromLatin1(credentials.proof(challenge).toBase64())}
+        }, FrameChannel::Interactive);
+        return;
+    }
+    emit connected();
+}
+
+void RpcClient::complete(int id, const RpcResult& reply)
+{
+    Pending entry = pending.take(id);
+    if (entry.hasPromise) {
+        entry.promise.reportResult(reply);
+        entry.promise.reportFinished();
+    }
+    emit replyReceived(id, entry.method, reply);
+}
+
+void RpcClient::failAll(const QString& reason)
+{
+    const QList<int> ids = pending.keys();
+    for (int id : ids) {
+        if (id == helloId || id == authId) {
+            pending.remove(id);
+            continue;
+        }
+        complete(id, transportError(transportErrorCode, reason));
+    }
+}
+
+void RpcClient::onDisconnected()
+{
+    channel->reset();
+    failAll("Connection closed");
+    helloId = -1;
+    authId = -1;
+    emit disconnected();
+}
+
+void RpcClient::onErrorOccurred(QAbstractSocket::SocketError socketError)
+{
+    QString errorMsg;
+    switch (socketError) {
+    case QAbstractSocket::ConnectionRefusedError:
+        errorMsg = "Сервер отверг подключение";
+        break;
+    case QAbstractSocket::HostNotFoundError:
+        errorMsg = "Сервер не найден";
+        break;
+    case QAbstractSocket::NetworkError:
+        errorMsg = "Сетевая ошибка";
+        break;
+    case QAbstractSocket::SslHandshakeFailedError:
+        // Билет мог устареть вместе с ключами демона; следующая попытка - полное рукопожатие
+        sessionTickets().remove(host);
+        errorMsg = "Ошибка TLS: " + socket->errorString();
+        break;
+    default:
+        errorMsg = socket->errorString();
+    }
+
+    qWarning() << "Connection error:" << errorMsg;
+    emit connectionError(errorMsg);
+}
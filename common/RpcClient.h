@@ -0,0 +1,131 @@
+#ifndef RPCCLIENT_H
+#define RPCCLIENT_H
+
+#include <QObject>
+#include <QSslSocket>
+#include <QJsonObject>
+#include <QJsonValue>
+#include <QHash>
+#include <QFuture>
+#include <QFutureInterface>
+#include "FrameChannel.h"
+#include "TlsOptions.h"
+#include "Credentials.h"
+
+// Ответ демона на один вызов: результат либо ошибка JSON-RPC.
+// Ошибки транспорта (нет соединения, таймаут, разрыв) приходят с кодами
+// transportErrorCode/timeoutErrorCode, чтобы их можно было отличить от ошибок демона.
+struct RpcResult {
+    QJsonValue result;
+    int errorCode = 0;
+    QString errorMessage;
+    QJsonValue errorData;
+
+    bool ok() const { return errorCode == 0; }
+    // Демон перегружен или превышен лимит частоты; можно повторить через retryAfterMs
+    bool isBusy() const;
+    int retryAfterMs() const { return errorData.toObject()["retryAfterMs"].toInt(); }
+};
+
+// Протокол клиента без GUI: соединение, согласование мультиплексирования,
+// сопоставление ответов с запросами и уведомления подписок.
+//
+// Если демон требует входа, а заданы setCredentials(), клиент отвечает на вызов
+// из hello до сигнала connected(); без них работает с анонимной ролью демона.
+//
+// С setTls() соединение идёт по TLS. Билет сеанса, выданный демоном, запоминается
+// на хост (общий для всех RpcClient процесса) и предъявляется при следующем
+// подключении, чтобы повторные подключения обходились без полного рукопожатия.
+//
+// Три способа вызова:
+//   call()      - асинхронно, ответ приходит сигналом replyReceived (для GUI);
+//   callAsync() - асинхронно, QFuture с результатом (QFutureWatcher или цепочки в скриптах);
+//   callSync()  - блокирующий вызов с локальным циклом событий (для CLI и cron).
+class RpcClient : public QObject
+{
+    Q_OBJECT
+public:
+    static constexpr int busyErrorCode = -32001;
+    static constexpr int authenticationFailedCode = -32002;
+    static constexpr int permissionDeniedCode = -32003;
+    static constexpr int transportErrorCode = -32098;
+    static constexpr int timeoutErrorCode = -32099;
+
+    explicit RpcClient(QObject* parent = nullptr);
+    ~RpcClient() override;
+
+    // Для следующих подключений; false и текст ошибки, если сертификаты не читаются
+    bool setTls(const TlsOptions& options, QString* error = nullptr);
+    // Уже собранная конфигурация: при опросе множества хостов файлы читаются один раз
+    void setTlsConfiguration(const QSslConfiguration& configuration, const QString& peerName = QString());
+    bool isTlsEnabled() const { return tlsEnabled; }
+
+    // Для следующих подключений; пустые - без входа
+    void setCredentials(const Credentials& credentials) { this->credentials = credentials; }
+    // Роль, выданная демоном ("admin", если демон без аутентификации)
+    QString role() const { return sessionRole; }
+
+    void connectToHost(const QString& host, quint16 port);
+    // Подключается и дожидается согласования протокола
+    bool connectSync(const QString& host, quint16 port, int timeoutMs = 5000, QString* error = nullptr);
+    void disconnectFromHost();
+    bool isConnected() const;
+
+    QString peerName() const { return host; }
+
+    // Возвращает id запроса или -1 без соединения
+    int call(const QString& method, const QJsonObject& params = QJsonObject(),
+             FrameChannel::Priority priority = FrameChannel::Interactive);
+    QFuture<RpcResult> callAsync(const QString& method, const QJsonObject& params = QJsonObject(),
+                                 FrameChannel::Priority priority = FrameChannel::Interactive);
+    RpcResult callSync(const QString& method, const QJsonObject& params = QJsonObject(),
+                       int timeoutMs = 30000, FrameChannel::Priority priority = FrameChannel::Interactive);
+
+signals:
+    // После TCP-подключения, ответа на hello и входа, если он нужен
+    void connected();
+    void disconnected();
+    void connectionError(const QString& errorString);
+
+    void replyReceived(int id, const QString& method, const RpcResult& reply);
+    void notificationReceived(const QString& method, const QJsonObject& params);
+
+private slots:
+    void onConnected();
+    void onEncrypted();
+    void onMessage(const QByteArray& message);
+    void onDisconnected();
+    void onErrorOccurred(QAbstractSocket::SocketError socketError);
+
+private:
+    struct Pending {
+        QString method;
+        QFutureInterface<RpcResult> promise;
+        bool hasPromise = false;
+    };
+
+    int send(const QString& method, const QJsonObject& params, FrameChannel::Priority priority);
+    void complete(int id, const RpcResult& reply);
+    void failAll(const QString& reason);
+    void startSession();
+    void finishHello(const RpcResult& reply);
+    void rememberSessionTicket();
+
+    QSslSocket* socket;
+    FrameChannel* channel;
+    QString host;
+    bool tlsEnabled;
+    QString tlsPeerName;
+    QSslConfiguration tlsConfiguration;
+    Credentials credentials;
+    QString sessionRole;
+
+    QHash<int, Pending> pending;
+    int nextId;
+    int helloId;
+    int authId;
+};
+
+Q_DECLARE_METATYPE(RpcResult)
+
+#endif // RPCCLIENT_H
@@ -0,0 +1,84 @@
+#include "TlsOptions.h"
+#include <QFile>
+#include <QSslCertificate>
+#include <QSslKey>
+
+namespace {
+
+bool loadCertificates(const QString& path, QList<QSslCertificate>* certificates, QString* error)
+{
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly)) {
+        if (error) *error = QString("Cannot read %1: %2").arg(path, file.errorString());
+        return false;
+    }
+    *certificates = QSslCertificate::fromData(file.readAll(), QSsl::Pem);
+    if (certificates->isEmpty()) {
+        if (error) *error = QString("No PEM certificates in %1").arg(path);
+        return false;
+    }
+    return true;
+}
+
+bool loadPrivateKey(const QString& path, QSslKey* key, QString* error)
+{
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly)) {
+        if (error) *error = QString("Cannot read %1: %2").arg(path, file.errorString());
+        return false;
+    }
+    const QByteArray pem = file.readAll();
+    // Алгоритм в PEM не всегда указан явно: пробуем EC (быстрее при рукопожатии), затем RSA
+    *key = QSslKey(pem, QSsl::Ec);
+    if (key->isNull()) *key = QSslKey(pem, QSsl::Rsa);
+    if (key->isNull()) {
+        if (error) *error = QString("Unsupported or encrypted private key in %1").arg(path);
+        return false;
+    }
+    return true;
+}
+
+} // namespace
+
+bool TlsOptions::makeConfiguration(QSslSocket::SslMode mode, QSslConfiguration* configuration, QString* error) const
+{
+    if (!QSslSocket::supportsSsl()) {
+        if (error) *error = "TLS is not available: OpenSSL was not found by Qt";
+        return false;
+    }
+
+    QSslConfiguration config = QSslConfiguration::defaultConfiguration();
+    config.setProtocol(allowTls12 ? QSsl::TlsV1_2OrLater : QSsl::TlsV1_3OrLater);
+
+    if (!certificateFile.isEmpty()) {
+        QList<QSslCertificate> chain;
+        QSslKey key;
+        if (!loadCertificates(certificateFile, &chain, error)) return false;
+        if (!loadPrivateKey(privateKeyFile.isEmpty() ? certificateFile : privateKeyFile, &key, error)) return false;
+        config.setLocalCertificateChain(chain);
+        config.setPrivateKey(key);
+    } else if (mode == QSslSocket::SslServerMode) {
+        if (error) *error = "TLS server requires a certificate";
+        return false;
+    }
+
+    if (!caFile.isEmpty()) {
+        QList<QSslCertificate> authorities;
+        if (!loadCertificates(caFile, &authorities, error)) return false;
+        config.setCaCertificates(authorities);
+    }
+
+    if (mode == QSslSocket::SslServerMode) {
+        // Без обязательной проверки сертификат клиента всё равно запрашивается,
+        // если задан CA: им можно пользоваться для опознания
+        config.setPeerVerifyMode(verifyPeer ? QSslSocket::VerifyPeer
+                                 : caFile.isEmpty() ? QSslSocket::VerifyNone : QSslSocket::QueryPeer);
+    } else {
+        config.setPeerVerifyMode(verifyPeer ? QSslSocket::VerifyPeer : QSslSocket::VerifyNone);
+        // Иначе QSslConfiguration::sessionTicket() пуст и возобновлять сеанс нечем
+        config.setSslOption(QSsl::SslOptionDisableSessionPersistence, false);
+    }
+
+    *configuration = config;
+    return true;
+}
@@ -0,0 +1,30 @@
+#ifndef TLSOPTIONS_H
+#define TLSOPTIONS_H
+
+#include <QString>
+#include <QSslConfiguration>
+#include <QSslSocket>
+
+// Настройки TLS, общие для демона и клиентов. Все файлы в PEM.
+//
+// Демон: certificateFile/privateKeyFile - свой сертификат (цепочка в том же файле),
+// caFile - CA клиентских сертификатов, verifyPeer - требовать сертификат клиента.
+// Клиент: caFile - CA демонов (пусто - системные корни), certificateFile/privateKeyFile -
+// сертификат клиента для взаимной аутентификации, peerName - имя в сертификате
+// демона, если подключение идёт по IP-адресу из обнаружения.
+struct TlsOptions {
+    bool enabled = false;
+    QString certificateFile;
+    QString privateKeyFile;
+    QString caFile;
+    QString peerName;
+    bool verifyPeer = true;
+    // По умолчанию только TLS 1.3: рукопожатие в один RTT
+    bool allowTls12 = false;
+
+    // Собирает конфигурацию сокета; false и текст ошибки, если файл не читается
+    // или TLS недоступен в сборке Qt
+    bool makeConfiguration(QSslSocket::SslMode mode, QSslConfiguration* configuration, QString* error) const;
+};
+
+#endif // TLSOPTIONS_H
@@ -0,0 +1,309 @@
+#include "Server.h"
+#include "FrameChannel.h"
+#include <QtTest>
+#include <QTemporaryDir>
+#include <QJsonDocument>
+#include <QBuffer>
+#include <QRandomGenerator>
+
+// Микробенчмарки горячих путей демона. Сборщики /proc работают на фикстурах
+// из fixtures/, поэтому цифры сравнимы между машинами и коммитами.
+//
+//   ./daemon_benchmarks                      все бенчмарки
+//   ./daemon_benchmarks fileSystem           один бенчмарк
+//   ./daemon_benchmarks -tickcounter         такты вместо времени
+//   ./daemon_benchmarks -o result.xml,xml    для сравнения прогонов
+
+namespace {
+
+const QString fixtureDir = QStringLiteral(BENCHMARK_FIXTURE_DIR);
+
+// Отдаёт заранее записанный поток кадров, а всё записанное (WindowUpdate) выбрасывает
+class ReplayDevice : public QIODevice
+{
+public:
+    void replay(const QByteArray& bytes)
+    {
+        data = bytes;
+        offset = 0;
+        emit readyRead();
+    }
+
+    bool isSequential() const override { return true; }
+    qint64 bytesAvailable() const override { return data.size() - offset + QIODevice::bytesAvailable(); }
+
+protected:
+    qint64 readData(char* out, qint64 maxSize) override
+    {
+        const qint64 n = qMin<qint64>(maxSize, data.size() - offset);
+        memcpy(out, data.constData() + offset, static_cast<size_t>(n));
+        offset += n;
+        return n;
+    }
+    qint64 writeData(const char*, qint64 size) override { return size; }
+
+private:
+    QByteArray data;
+    qint64 offset = 0;
+};
+
+QByteArray randomBytes(int size)
+{
+    QByteArray bytes(size, Qt::Uninitialized);
+    QRandomGenerator generator(42);
+    for (int i = 0; i < size; ++i) bytes[i] = static_cast<char>(generator.bounded(256));
+    return bytes;
+}
+
+// Кодирует сообщения в буфер, как это делает канал поверх сокета
+QByteArray encodeFrames(const QList<QByteArray>& messages, bool multiplexed)
+{
+    QBuffer buffer;
+    buffer.open(QIODevice::WriteOnly);
+    FrameChannel channel(&buffer);
+    channel.setMultiplexing(multiplexed);
+    for (const QByteArray& message : messages) channel.sendMessage(message);
+    return buffer.data();
+}
+
+} // namespace
+
+class DaemonBenchmarks : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void initTestCase();
+
+    void cpuInfo();
+    void memoryInfo();
+    void uptimeInfo();
+    void systemInfo();
+    void processList();
+
+    void fileSystem_data();
+    void fileSystem();
+
+    void frameEncode_data();
+    void frameEncode();
+    void frameDecode_data();
+    void frameDecode();
+
+    void jsonResponse();
+
+    void base64Download_data();
+    void base64Download();
+    void base64Upload_data();
+    void base64Upload();
+
+private:
+    void addFrameRows();
+    void addTransferRows();
+
+    Server* server = nullptr;
+    QTemporaryDir workDir;
+};
+
+void DaemonBenchmarks::initTestCase()
+{
+    QVERIFY2(QFileInfo::exists(fixtureDir + "/proc/stat"), qPrintable("No fixtures in " + fixtureDir));
+    QVERIFY(workDir.isValid());
+    server = new Server(fixtureDir + "/proc", fixtureDir + "/sys", this);
+
+    // Синтетические каталоги для обхода файловой системы
+    for (int count : { 1000, 100000 }) {
+        const QString path = workDir.filePath(QString("dir_%1").arg(count));
+        QVERIFY(QDir().mkpath(path));
+        for (int i = 0; i < count; ++i) {
+            QFile file(QString("%1/file_%2.dat").arg(path).arg(i, 6, 10, QChar('0')));
+            QVERIFY(file.open(QIODevice::WriteOnly));
+        }
+    }
+}
+
+void DaemonBenchmarks::cpuInfo()
+{
+    QCOMPARE(server->getCpuInfo()["cores"].toInt(), 16);
+    QBENCHMARK {
+        server->getCpuInfo();
+    }
+}
+
+void DaemonBenchmarks::memoryInfo()
+{
+    QVERIFY(server->getMemoryInfo()["total"].toDouble() > 0);
+    QBENCHMARK {
+        server->getMemoryInfo();
+    }
+}
+
+void DaemonBenchmarks::uptimeInfo()
+{
+    QBENCHMARK {
+        server->getUptimeInfo();
+    }
+}
+
+void DaemonBenchmarks::systemInfo()
+{
+    QBENCHMARK {
+        server->getSystemInfo();
+    }
+}
+
+void DaemonBenchmarks::processList()
+{
+    // Список процессов берётся у ps, фикстурой его не подменить:
+    // результат зависит от машины и включает запуск процесса
+    QBENCHMARK {
+        server->getProcessList();
+    }
+}
+
+void DaemonBenchmarks::fileSystem_data()
+{
+    QTest::addColumn<int>("count");
+    QTest::newRow("1k") << 1000;
+    QTest::newRow("100k") << 100000;
+}
+
+void DaemonBenchmarks::fileSystem()
+{
+    QFETCH(int, count);
+    const QString path = workDir.filePath(QString("dir_%1").arg(count));
+    QCOMPARE(server->getFileSystem(path).size(), count);
+    QBENCHMARK {
+        server->getFileSystem(path);
+    }
+}
+
+void DaemonBenchmarks::addFrameRows()
+{
+    QTest::addColumn<bool>("multiplexed");
+    QTest::addColumn<int>("size");
+    QTest::newRow("legacy 256B") << false << 256;
+    QTest::newRow("legacy 64KB") << false << 64 * 1024;
+    QTest::newRow("mux 256B") << true << 256;
+    QTest::newRow("mux 64KB") << true << 64 * 1024;
+    // Больше окна потока не берём: без получателя WindowUpdate не придёт
+    QTest::newRow("mux 512KB") << true << 512 * 1024;
+}
+
+void DaemonBenchmarks::frameEncode_data()
+{
+    addFrameRows();
+}
+
+void DaemonBenchmarks::frameEncode()
+{
+    QFETCH(bool, multiplexed);
+    QFETCH(int, size);
+    const QList<QByteArray> messages(QList<QByteArray>() << randomBytes(size));
+    QBENCHMARK {
+        encodeFrames(messages, multiplexed);
+    }
+}
+
+void DaemonBenchmarks::frameDecode_data()
+{
+    addFrameRows();
+}
+
+void DaemonBenchmarks::frameDecode()
+{
+    QFETCH(bool, multiplexed);
+    QFETCH(int, size);
+
+    // Несколько сообщений подряд, чтобы разбор шёл через границы кадров
+    const int messageCount = 16;
+    QList<QByteArray> messages;
+    for (int i = 0; i < messageCount; ++i) messages << randomBytes(size);
+    const QByteArray wire = encodeFrames(messages, multiplexed);
+
+    ReplayDevice device;
+    device.open(QIODevice::ReadWrite | QIODevice::Unbuffered);
+    FrameChannel channel(&device);
+    channel.setMultiplexing(multiplexed);
+    int received = 0;
+    connect(&channel, &FrameChannel::messageReceived, this, [&received](const QByteArray&) { ++received; });
+
+    QBENCHMARK {
+        channel.reset();
+        channel.setMultiplexing(multiplexed);
+        device.replay(wire);
+    }
+    QVERIFY(received > 0 && received % messageCount == 0);
+}
+
+void DaemonBenchmarks::jsonResponse()
+{
+    // Типичный ответ на RPC: несколько десятков полей вперемешку
+    QJsonObject response;
+    response["id"] = 17;
+    response["result"] = server->getSystemInfo();
+    const QByteArray encoded = QJsonDocument(response).toJson(QJsonDocument::Compact);
+    QBENCHMARK {
+        QJsonDocument(response).toJson(QJsonDocument::Compact);
+        QJsonDocument::fromJson(encoded).object();
+    }
+}
+
+void DaemonBenchmarks::addTransferRows()
+{
+    QTest::addColumn<int>("size");
+    QTest::newRow("1MB") << 1024 * 1024;
+    QTest::newRow("16MB") << 16 * 1024 * 1024;
+}
+
+void DaemonBenchmarks::base64Download_data()
+{
+    addTransferRows();
+}
+
+void DaemonBenchmarks::base64Download()
+{
+    // Тот же путь, что у downloadFile в ClientConnection: чтение, base64, JSON
+    QFETCH(int, size);
+    const QString path = workDir.filePath(QString("download_%1.bin").arg(size));
+    QFile file(path);
+    QVERIFY(file.open(QIODevice::WriteOnly));
+    file.write(randomBytes(size));
+    file.close();
+
+    QBENCHMARK {
+        QJsonObject result;
+        result["data"] = QString::fromUtf8(server->downloadFile(path).toBase64());
+        QJsonObject response;
+        response["result"] = result;
+        QJsonDocument(response).toJson(QJsonDocument::Compact);
+    }
+}
+
+void DaemonBenchmarks::base64Upload_data()
+{
+    addTransferRows();
+}
+
+void DaemonBenchmarks::base64Upload()
+{
+    // Обратный путь uploadFile: разбор JSON, декодирование base64, запись
+    QFETCH(int, size);
+    const QString path = workDir.filePath(QString("upload_%1.bin").arg(size));
+    QJsonObject params;
+    params["path"] = path;
+    params["data"] = QString::fromLatin1(randomBytes(size).toBase64());
+    QJsonObject request;
+    request["method"] = "uploadFile";
+    request["params"] = params;
+    const QByteArray encoded = QJsonDocument(request).toJson(QJsonDocument::Compact);
+
+    QBENCHMARK {
+        const QJsonObject parsed = QJsonDocument::fromJson(encoded).object()["params"].toObject();
+        QVERIFY(server->uploadFile(parsed["path"].toString(),
+                                   QByteArray::fromBase64(parsed["data"].toString().toUtf8())));
+    }
+}
+
+QTEST_GUILESS_MAIN(DaemonBenchmarks)
+
+#include "DaemonBenchmarks.moc"
@@ -0,0 +1,63 @@
+#ifndef ACCESSCONTROL_H
+#define ACCESSCONTROL_H
+
+#include <QObject>
+#include <QHash>
+#include <QByteArray>
+
+// Роли по возрастанию прав: каждая следующая может всё, что предыдущая
+enum class Role { None, Viewer, Operator, Admin };
+
+// Кто и какие методы может вызывать.
+//
+// Все решения, требующие чтения файлов или криптографии, принимаются один раз:
+// файл пользователей читается при старте, HMAC проверяется при входе, и дальше
+// роль хранится в ClientConnection. Проверка запроса - поиск метода в хэше и
+// сравнение ролей, поэтому горячий путь опроса метрик ничего не платит.
+class AccessControl : public QObject
+{
+    Q_OBJECT
+public:
+    explicit AccessControl(QObject* parent = nullptr);
+
+    // Выключено - все клиенты Admin, как до появления аутентификации
+    void setEnabled(bool enable) { enabled = enable; }
+    bool isEnabled() const { return enabled; }
+
+    // Роль до входа; None - без входа доступен только hello
+    void setAnonymousRole(Role role) { anonymous = role; }
+    Role anonymousRole() const { return enabled ? anonymous : Role::Admin; }
+
+    // Строки "имя роль секрет"; пустые и начинающиеся с # пропускаются
+    bool loadUsers(const QString& path, QString* error);
+    int userCount() const { return users.size(); }
+
+    // Переопределение роли метода из настроек
+    void setRequiredRole(const QString& method, Role role) { methodRoles.insert(method, role); }
+    // Неизвестный метод требует Admin: новый метод без записи в таблице закрыт по умолчанию
+    Role requiredRole(const QString& method) const { return methodRoles.value(method, Role::Admin); }
+    bool isAllowed(Role role, const QString& method) const { return role >= requiredRole(method); }
+
+    // Одноразовый вызов для соединения
+    static QByteArray makeChallenge();
+    // Роль пользователя, если ответ на вызов верен, иначе None
+    Role verify(const QString& user, const QByteArray& challenge, const QByteArray& proof) const;
+    // Роль по CN проверенного сертификата клиента
+    Role roleForCertificate(const QString& identity) const;
+
+    static QString roleName(Role role);
+    static Role roleFromName(const QString& name, bool* ok = nullptr);
+
+private:
+    struct User {
+        Role role = Role::None;
+        QByteArray secret;
+    };
+
+    QHash<QString, User> users;
+    QHash<QString, Role> methodRoles;
+    bool enabled;
+    Role anonymous;
+};
+
+#endif // ACCESSCONTROL_H
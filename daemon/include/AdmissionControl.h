@@ -0,0 +1,82 @@
+#ifndef ADMISSIONCONTROL_H
+#define ADMISSIONCONTROL_H
+
+#include <QObject>
+#include <QHash>
+#include <QAtomicInt>
+#include <QElapsedTimer>
+
+// Ведро токенов: rate токенов в секунду, не больше burst в запасе
+class TokenBucket
+{
+public:
+    TokenBucket(double ratePerSecond = 0.0, double burst = 0.0);
+
+    bool tryTake(qint64 nowMs, double cost = 1.0);
+    // Через сколько миллисекунд в ведре наберётся cost токенов
+    qint64 msUntilAvailable(qint64 nowMs, double cost = 1.0) const;
+
+private:
+    void refill(qint64 nowMs);
+
+    double rate;
+    double capacity;
+    double tokens;
+    qint64 lastRefillMs;
+};
+
+// Общие для всех клиентов правила допуска запросов: лимиты частоты по методам
+// и ограничение числа одновременно выполняемых тяжёлых операций.
+// Сами вёдра токенов живут в ClientConnection - у каждого клиента свои.
+class AdmissionControl : public QObject
+{
+    Q_OBJECT
+public:
+    struct MethodPolicy {
+        double ratePerSecond = 0.0; // 0 - без отдельного лимита
+        double burst = 0.0;
+        bool expensive = false;     // выполняется в пуле потоков и занимает слот
+        bool background = false;    // обход и передача: низкий приоритет, откладывается у пределов ресурсов
+    };
+
+    explicit AdmissionControl(QObject* parent = nullptr);
+
+    MethodPolicy policy(const QString& method) const { return policies.value(method); }
+
+    // Общий лимит запросов одного клиента
+    double clientRatePerSecond() const { return 50.0; }
+    double clientBurst() const { return 100.0; }
+
+    int maxExpensivePerClient() const { return 2; }
+
+    // Слоты тяжёлых операций; finishExpensive можно звать из рабочего потока
+    bool tryStartExpensive();
+    void finishExpensive();
+    int expensiveInFlight() const { return inFlight.loadAcquire(); }
+    // 0 - половина ядер, но не меньше двух; занятые слоты не отбираются
+    void setMaxExpensive(int count);
+    int maxExpensiveSlots() const { return maxExpensive; }
+
+    // Слоты фоновых методов - отдельные, по размеру фонового пула: в SCHED_IDLE
+    // они могут стоять подолгу и не должны отнимать слоты у наблюдения
+    bool tryStartBackground();
+    void finishBackground();
+    int backgroundInFlight() const { return backgroundRunning.loadAcquire(); }
+    void setMaxBackground(int count) { maxBackground = qMax(1, count); }
+    int maxBackgroundSlots() const { return maxBackground; }
+
+    // Подсказка клиенту, когда повторить запрос, если свободных слотов нет
+    qint64 busyRetryAfterMs() const { return 250; }
+
+    qint64 now() const { return clock.elapsed(); }
+
+private:
+    QHash<QString, MethodPolicy> policies;
+    QAtomicInt inFlight;
+    int maxExpensive;
+    QAtomicInt backgroundRunning;
+    int maxBackground;
+    QElapsedTimer clock;
+};
+
+#endif // ADMISSIONCONTROL_H
@@ -0,0 +1,100 @@
+#ifndef ASYNCLOGGER_H
+#define ASYNCLOGGER_H
+
+#include <QThread>
+#include <QFile>
+#include <QMutex>
+#include <QWaitCondition>
+#include <QAtomicInteger>
+#include <QLoggingCategory>
+
+// Категории журнала демона. qCDebug/qCInfo проверяют уровень категории до
+// форматирования, поэтому отключённые сообщения почти ничего не стоят.
+Q_DECLARE_LOGGING_CATEGORY(lcServer)
+Q_DECLARE_LOGGING_CATEGORY(lcDiscovery)
+Q_DECLARE_LOGGING_CATEGORY(lcRpc)
+
+// Журнал в отдельном потоке. Обработчик сообщений Qt только кладёт запись в
+// ограниченную очередь без блокировок (при переполнении запись отбрасывается
+// со счётчиком), а поток журнала форматирует, схлопывает повторы, пишет в файл
+// пачками и ротирует его по размеру.
+class AsyncLogger : public QThread
+{
+    Q_OBJECT
+public:
+    struct Options {
+        QString filePath = "os_server.log";
+        qint64 maxFileSize = 10 * 1024 * 1024;
+        int maxFiles = 5;          // os_server.log.1 ... .N
+        bool echoToConsole = true;
+    };
+
+    explicit AsyncLogger(const Options& options, QObject* parent = nullptr);
+    ~AsyncLogger() override;
+
+    // Устанавливает обработчик сообщений Qt и запускает поток
+    void install();
+    // Дописывает очередь и останавливает поток; обработчик возвращается стандартный
+    void shutdown();
+    // Ждёт, пока всё поставленное в очередь окажется в файле (для фатальных ошибок)
+    void flush();
+
+    // debug | info | warning - через правила QLoggingCategory
+    static void setLevel(const QString& level);
+
+protected:
+    void run() override;
+
+private:
+    struct Record {
+        QtMsgType type = QtDebugMsg;
+        qint64 timestampMs = 0;
+        QByteArray category;
+        QString text;
+    };
+
+    struct Cell {
+        QAtomicInteger<quint64> sequence;
+        Record record;
+    };
+
+    static void messageHandler(QtMsgType type, const QMessageLogContext& context, const QString& msg);
+
+    bool enqueue(Record&& record);
+    bool dequeue(Record& record);
+    void drain();
+    void write(const Record& record);
+    void writeLine(const QByteArray& line);
+    void flushRepeats();
+    void rotateIfNeeded();
+    void openFile();
+
+    static AsyncLogger* instance;
+
+    Options options;
+
+    // Ограниченная MPSC-очередь Вьюкова: номер в ячейке говорит, свободна ли она
+    static constexpr quint64 capacity = 8192;
+    Cell* cells;
+    QAtomicInteger<quint64> enqueuePos;
+    quint64 dequeuePos;
+    QAtomicInteger<quint64> droppedRecords;
+
+    QAtomicInteger<int> stopping;
+    QMutex wakeMutex;
+    QWaitCondition wakeCondition;
+    QMutex flushMutex;
+    QWaitCondition flushDone;
+    QAtomicInteger<quint64> writtenPos;
+
+    // Состояние потока журнала
+    QFile file;
+    // Размер файла без QFile::size(): тот сбрасывает буфер записи на каждой строке
+    qint64 fileBytes;
+    QFile console;
+    Record lastRecord;
+    int repeats;
+    qint64 lastWrittenMs;
+};
+
+#endif // ASYNCLOGGER_H
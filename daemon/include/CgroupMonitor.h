@@ -0,0 +1,77 @@
+#ifndef CGROUPMONITOR_H
+#define CGROUPMONITOR_H
+
+#include <QObject>
+#include <QHash>
+#include <QJsonArray>
+#include <QJsonObject>
+#include <QElapsedTimer>
+#include <QStringList>
+
+// Сбор статистики cgroup v2 (/sys/fs/cgroup) с расчётом дельт между выборками.
+// Список групп и их контроллеров кэшируется и пересканируется реже, чем
+// читаются счётчики, чтобы частые запросы не обходили всё дерево.
+class CgroupMonitor : public QObject
+{
+    Q_OBJECT
+public:
+    explicit CgroupMonitor(const QString& root = "/sys/fs/cgroup", QObject* parent = nullptr);
+
+    bool isAvailable() const;
+
+    // query: path (поддерево), maxDepth, sort (cpu|memory|io|pids), limit
+    QJsonArray collect(const QJsonObject& query);
+
+    void setRefreshInterval(int msec) { refreshIntervalMs = msec; }
+    void setRescanInterval(int msec) { rescanIntervalMs = msec; }
+
+private:
+    struct Sample {
+        qint64 timestampMs = 0;
+        qulonglong cpuUsageUsec = 0;
+        qulonglong cpuUserUsec = 0;
+        qulonglong cpuSystemUsec = 0;
+        qulonglong nrPeriods = 0;
+        qulonglong nrThrottled = 0;
+        qulonglong throttledUsec = 0;
+        qulonglong memoryCurrent = 0;
+        qint64 memoryMax = -1; // -1 означает "max"
+        qulonglong memoryAnon = 0;
+        qulonglong memoryFile = 0;
+        qulonglong pgMajFault = 0;
+        qulonglong ioReadBytes = 0;
+        qulonglong ioWriteBytes = 0;
+        qulonglong ioReadOps = 0;
+        qulonglong ioWriteOps = 0;
+        qulonglong pidsCurrent = 0;
+        qint64 pidsMax = -1;
+    };
+
+    struct Entry {
+        QString relativePath;
+        int depth = 0;
+        bool hasCpu = false;
+        bool hasMemory = false;
+        bool hasIo = false;
+        bool hasPids = false;
+        bool hasSample = false;
+        bool hasPrevious = false;
+        Sample previous;
+        Sample current;
+    };
+
+    void rescan();
+    void refresh();
+    void readSample(Entry& entry) const;
+    QJsonObject toJson(const Entry& entry) const;
+
+    QString rootPath;
+    QHash<QString, Entry> entries;
+    QElapsedTimer clock;
+    qint64 lastRefreshMs;
+    qint64 lastRescanMs;
+    int refreshIntervalMs;
+    int rescanIntervalMs;
+};
+
+#endif // CGROUPMONITOR_H
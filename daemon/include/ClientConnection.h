@@ -1,10 +1,18 @@
 #ifndef CLIENTCONNECTION_H
 #define CLIENTCONNECTION_H
 
-#include <QTcpSocket>
+#include <QSslSocket>
 #include <QObject>
+#include <QHash>
+#include <QElapsedTimer>
+#include "FrameChannel.h"
+#include "AdmissionControl.h"
+#include "AccessControl.h"
 
 class Server;
+class LogStream;
+class ExecSession;
+class FileOperation;
 
 class ClientConnection : public QObject
 {
@@ -14,20 +22,72 @@ public:
     virtual ~ClientConnection() = default;
     bool setSocketDescriptor(qintptr socketDescriptor);
 
+    // Все методы, которые понимает processRequest
+    static QStringList methods();
+
+    qint64 pendingOutput() const { return channel->pendingOutput(); }
+    void setMaxMessageSize(qint64 bytes) { channel->setMaxMessageSize(bytes); }
+    int subscriptionCount() const { return subscriptions.size(); }
+    // CN сертификата клиента при взаимной аутентификации TLS, иначе пусто
+    QString peerIdentity() const { return identity; }
+    // Роль, определённая при подключении или входе; проверяется на каждом запросе
+    Role role() const { return sessionRole; }
+
 signals:
     void disconnected();
 
 private slots:
-    void onReadyRead();
+    void onMessage(const QByteArray& message);
+    void onEncrypted();
     void onDisconnected();
+    void onLogData(int subscriptionId, const QByteArray& data, qint64 droppedBytes);
+    void onLogClosed(int subscriptionId, const QString& reason);
+    void onExecOutput(int executionId, const QString& stream, const QByteArray& data);
+    void onExecFinished(int executionId, const QJsonObject& summary);
+    void onFileOperationProgress(int operationId, const QJsonObject& state);
+    void onFileOperationFinished(int operationId, const QJsonObject& summary);
 
 private:
     void processRequest(const QJsonObject& request);
-    void sendResponse(const QJsonObject& response);
+    bool admit(const QString& method, qint64& retryAfterMs, bool methodLimit = true);
+    void processExpensive(const QString& method, const QJsonObject& params, QJsonObject response,
+                          const QElapsedTimer& timer);
+    void finishRequest(const QString& method, const QJsonObject& response, const QElapsedTimer& timer,
+                       FrameChannel::Priority priority = FrameChannel::Interactive);
+    void sendResponse(const QJsonObject& response,
+                      FrameChannel::Priority priority = FrameChannel::Interactive);
+    void sendNotification(const QString& method, const QJsonObject& params);
+    bool addSubscription(LogStream* stream, QJsonObject& response);
+    void startExec(const QJsonObject& params, QJsonObject& response);
+    void startFileOperation(const QJsonObject& params, QJsonObject& response);
+    bool canReceiveSecrets() const;
+    void authenticate(const QJsonObject& params, QJsonObject& response);
 
-    QTcpSocket* socket;
+    QSslSocket* socket;
+    FrameChannel* channel;
     Server* server;
-    quint32 blockSize;
+    QString identity;
+
+    // Решение о правах принимается при входе и дальше только читается
+    Role sessionRole;
+    QString sessionUser;
+    QByteArray challenge; // одноразовый, выдаётся в ответе на hello
+
+    // Лимиты этого клиента
+    TokenBucket requestBucket;
+    QHash<QString, TokenBucket> methodBuckets;
+    int expensiveInFlight;
+
+    QHash<int, LogStream*> subscriptions;
+    QHash<int, qint64> suppressedBytes; // журнал, не отправленный медленному клиенту
+    int nextSubscriptionId;
+
+    QHash<int, ExecSession*> executions;
+    QHash<int, qint64> suppressedExecBytes; // вывод, не отправленный медленному клиенту
+    int nextExecutionId;
+
+    QHash<int, FileOperation*> fileOperations;
+    int nextFileOperationId;
 };
 
 #endif // CLIENTCONNECTION_H
@@ -0,0 +1,71 @@
+#ifndef DAEMONCONFIG_H
+#define DAEMONCONFIG_H
+
+#include <QObject>
+#include <QVariantMap>
+#include <QDateTime>
+#include "Server.h"
+#include "ResourceGovernor.h"
+
+class QSettings;
+class QFileSystemWatcher;
+class QSocketNotifier;
+class QTimer;
+
+// Настраиваемая на лету часть конфигурации демона: пулы потоков, интервалы
+// опроса, время жизни кэшей, пределы соединений, уровень журнала, приоритет
+// процесса и его собственные пределы ресурсов. Перечитывается по SIGHUP и при
+// изменении файла настроек, открытые соединения при этом не разрываются.
+// Адрес, порт, TLS, exec и права методов читаются только при старте - их
+// изменение требует перезапуска.
+class DaemonConfig : public QObject
+{
+    Q_OBJECT
+public:
+    struct Options {
+        Server::Tuning tuning;
+        int workerThreads = 0;        // пул тяжёлых RPC; 0 - по числу ядер
+        int maxExpensive = 0;         // одновременных тяжёлых RPC; 0 - половина ядер
+        int fileOperationThreads = 0; // пул пакетных файловых операций; 0 - по числу ядер
+        QString logLevel = "info";
+        int nice = 0;
+        QString ioClass;              // realtime | best-effort | idle; пусто - по nice
+        int ioLevel = 4;              // 0 (высший) ... 7
+        QString usersFile = "/etc/life/users";
+        ResourceGovernor::Options resources;
+    };
+
+    explicit DaemonConfig(Server* server, QObject* parent = nullptr);
+
+    static Options read(QSettings& settings);
+    void apply(const Options& options);
+    const Options& options() const { return current; }
+
+    // Перечитывает файл настроек и применяет то, что можно поменять без перезапуска
+    void reload();
+    // Перечитывание по SIGHUP и при изменении файла
+    void watch();
+
+signals:
+    void reloaded();
+
+private slots:
+    void onHangup();
+    void onPathChanged();
+
+private:
+    static QVariantMap startupOnlyValues(QSettings& settings);
+
+    Server* server;
+    QString fileName;
+    Options current;
+    bool applied;
+    QVariantMap startupValues;
+    QDateTime fileModified;
+    qint64 fileSize;
+    QFileSystemWatcher* watcher;
+    QTimer* settleTimer;
+    QSocketNotifier* hangupNotifier;
+};
+
+#endif // DAEMONCONFIG_H
@@ -0,0 +1,122 @@
+#ifndef DAEMONMETRICS_H
+#define DAEMONMETRICS_H
+
+#include <QObject>
+#include <QHash>
+#include <QStringList>
+#include <QAtomicInteger>
+#include <QElapsedTimer>
+#include <QDateTime>
+#include <QJsonObject>
+#include <QTcpServer>
+
+class Server;
+
+// Гистограмма задержек в микросекундах с логарифмически-линейными корзинами,
+// как в HdrHistogram: каждая степень двойки делится на 8 частей, так что
+// погрешность перцентилей не больше 12.5%. Запись - несколько атомарных операций.
+class LatencyHistogram
+{
+public:
+    LatencyHistogram();
+
+    void record(quint64 micros);
+
+    quint64 count() const { return total.loadRelaxed(); }
+    quint64 sumMicros() const { return sum.loadRelaxed(); }
+    quint64 maxMicros() const { return maximum.loadRelaxed(); }
+
+    // Верхняя граница корзины, в которую попал перцентиль q (0..1)
+    quint64 percentile(double q) const;
+    // Сколько значений не больше bound (le у Prometheus); точно для bound,
+    // совпадающих с границами корзин, в том числе для степеней двойки
+    quint64 countAtMost(quint64 bound) const;
+
+private:
+    static constexpr int subBucketBits = 3;
+    static constexpr int subBuckets = 1 << subBucketBits;
+    static constexpr int bucketCount = (64 - subBucketBits + 1) * subBuckets;
+
+    static int bucketIndex(quint64 value);
+    static quint64 bucketUpperBound(int index);
+
+    QAtomicInteger<quint64> buckets[bucketCount];
+    QAtomicInteger<quint64> total;
+    QAtomicInteger<quint64> sum;
+    QAtomicInteger<quint64> maximum;
+};
+
+// Собственные метрики демона: запросы по методам, задержки, трафик, соединения,
+// потребление памяти и CPU. Набор методов фиксируется в конструкторе, чтобы
+// произвольные имена от клиентов не раздували число рядов.
+class DaemonMetrics : public QObject
+{
+    Q_OBJECT
+public:
+    enum class Outcome { Ok, Error, Busy };
+
+    // Мгновенные значения, которые знает только Server
+    struct Gauges {
+        int connections = 0;
+        qint64 queuedBytes = 0;
+        int expensiveInFlight = 0;
+        int subscriptions = 0;
+    };
+
+    explicit DaemonMetrics(const QStringList& methods, QObject* parent = nullptr);
+    ~DaemonMetrics() override;
+
+    void recordRequest(const QString& method, qint64 micros, Outcome outcome);
+    void addBytesIn(qint64 bytes) { bytesIn.fetchAndAddRelaxed(static_cast<quint64>(bytes)); }
+    void addBytesOut(qint64 bytes) { bytesOut.fetchAndAddRelaxed(static_cast<quint64>(bytes)); }
+    void connectionAccepted() { connectionsAccepted.fetchAndAddRelaxed(1); }
+    void connectionRejected() { connectionsRejected.fetchAndAddRelaxed(1); }
+
+    QJsonObject toJson(const Gauges& gauges) const;
+    // Текстовый формат экспозиции Prometheus 0.0.4
+    QByteArray toPrometheus(const Gauges& gauges) const;
+
+private:
+    struct MethodStats {
+        LatencyHistogram latency; // только допущенные запросы
+        QAtomicInteger<quint64> errors;
+        QAtomicInteger<quint64> busy;
+    };
+
+    struct ProcessStats {
+        qint64 residentBytes = 0;
+        qint64 virtualBytes = 0;
+        double cpuSeconds = 0.0;
+        int openFds = 0;
+        int threads = 0;
+    };
+
+    MethodStats* statsFor(const QString& method) const;
+    ProcessStats readProcessStats() const;
+
+    QHash<QString, MethodStats*> methods;
+    QAtomicInteger<quint64> bytesIn;
+    QAtomicInteger<quint64> bytesOut;
+    QAtomicInteger<quint64> connectionsAccepted;
+    QAtomicInteger<quint64> connectionsRejected;
+    QElapsedTimer uptime;
+    QDateTime startTime;
+};
+
+// Минимальный HTTP-сервер с единственным адресом GET /metrics для Prometheus.
+// Слушает только заданный адрес (по умолчанию 127.0.0.1) и закрывает соединение
+// после каждого ответа.
+class MetricsEndpoint : public QTcpServer
+{
+    Q_OBJECT
+public:
+    explicit MetricsEndpoint(Server* server, QObject* parent = nullptr);
+
+private slots:
+    void onNewConnection();
+
+private:
+    Server* server;
+};
+
+#endif // DAEMONMETRICS_H
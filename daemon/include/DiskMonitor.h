@@ -0,0 +1,79 @@
+#ifndef DISKMONITOR_H
+#define DISKMONITOR_H
+
+#include <QObject>
+#include <QHash>
+#include <QList>
+#include <QJsonArray>
+#include <QElapsedTimer>
+
+// Ёмкость смонтированных томов и скорости ввода-вывода из /proc/diskstats.
+// Таблица монтирования кэшируется и перечитывается только когда
+// /proc/self/mountinfo сообщает об изменении через poll().
+class DiskMonitor : public QObject
+{
+    Q_OBJECT
+public:
+    explicit DiskMonitor(const QString& root = "/proc", QObject* parent = nullptr);
+    ~DiskMonitor() override;
+
+    QJsonArray volumes();      // ёмкость и I/O по точкам монтирования
+    QJsonArray deviceStats();  // I/O по блочным устройствам
+
+    void setMinInterval(int msec) { minIntervalMs = msec; }
+
+private:
+    struct MountEntry {
+        QString mountPoint;
+        QString source;
+        QString fsType;
+        quint32 major = 0;
+        quint32 minor = 0;
+    };
+
+    struct DeviceCounters {
+        QString name;
+        qulonglong reads = 0;
+        qulonglong sectorsRead = 0;
+        qulonglong msReading = 0;
+        qulonglong writes = 0;
+        qulonglong sectorsWritten = 0;
+        qulonglong msWriting = 0;
+        qulonglong inFlight = 0;
+        qulonglong msDoingIo = 0;
+        qulonglong weightedMs = 0;
+    };
+
+    struct DeviceRates {
+        double readIops = 0.0;
+        double writeIops = 0.0;
+        double readBytesPerSec = 0.0;
+        double writeBytesPerSec = 0.0;
+        double readAwaitMs = 0.0;
+        double writeAwaitMs = 0.0;
+        double awaitMs = 0.0;
+        double utilPercent = 0.0;
+        double queueDepth = 0.0;
+        qulonglong inFlight = 0;
+    };
+
+    static quint64 deviceKey(quint32 major, quint32 minor) { return (quint64(major) << 32) | minor; }
+
+    void refreshMountsIfChanged();
+    void loadMounts(const QByteArray& content);
+    void refreshDeviceStats();
+    QJsonObject ratesToJson(const DeviceRates& rates) const;
+
+    QString procRoot;
+    int mountInfoFd;
+    QList<MountEntry> mounts;
+
+    QHash<quint64, DeviceCounters> previousCounters;
+    QHash<quint64, DeviceRates> rates;
+    QElapsedTimer clock;
+    qint64 lastSampleMs;
+    qint64 sampleIntervalMs;
+    int minIntervalMs;
+};
+
+#endif // DISKMONITOR_H
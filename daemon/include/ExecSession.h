@@ -0,0 +1,123 @@
+#ifndef EXECSESSION_H
+#define EXECSESSION_H
+
+#include <QObject>
+#include <QProcess>
+#include <QTimer>
+#include <QElapsedTimer>
+#include <QHash>
+#include <QJsonObject>
+#include <QStringList>
+
+// Какие команды демон может запускать по RPC exec и с какими ограничениями.
+// Команды задаются по имени; клиент не передаёт ни путь, ни строку для shell.
+class ExecPolicy : public QObject
+{
+    Q_OBJECT
+public:
+    struct Options {
+        bool enabled = false;
+        bool allowExtraArguments = false; // аргументы клиента дописываются после заданных
+        int defaultTimeoutMs = 30000;
+        int maxTimeoutMs = 600000;
+        qint64 maxOutputBytes = 4 * 1024 * 1024; // на команду, stdout и stderr вместе
+        int maxConcurrent = 32;
+        int maxPerClient = 8;
+        // Запуск в отдельной области systemd (cgroup) с лимитами; только от root
+        bool useScope = true;
+        QString memoryMax = "256M";
+        QString cpuQuota = "50%";
+        int tasksMax = 64;
+    };
+
+    struct Command {
+        QString program;
+        QStringList arguments;
+    };
+
+    explicit ExecPolicy(QObject* parent = nullptr);
+
+    void setOptions(const Options& options);
+    const Options& options() const { return opts; }
+    bool isEnabled() const { return opts.enabled && !commands.isEmpty(); }
+    // Есть ли systemd-run и права на создание области
+    bool scopesAvailable() const { return scopes; }
+
+    // commandLine - абсолютный путь и неизменяемые аргументы через пробел
+    bool allow(const QString& name, const QString& commandLine, QString* error);
+    bool resolve(const QString& name, Command* command) const;
+    QStringList commandNames() const { return commands.keys(); }
+
+    // Слоты одновременно выполняемых команд всего демона
+    bool tryAcquire();
+    void release() { --running; }
+    int runningCount() const { return running; }
+
+private:
+    Options opts;
+    QHash<QString, Command> commands;
+    int running;
+    bool scopes;
+};
+
+// Одна запущенная команда. Ничего не ждёт синхронно: вывод, завершение и
+// таймаут приходят через цикл событий, поэтому команд может идти сколько угодно
+// без блокировки главного потока. Вывод копится не дольше flush-интервала и
+// уходит кусками по границам символов UTF-8; сверх maxOutputBytes
+// отбрасывается с подсчётом.
+//
+// Слот ExecPolicy занимает вызывающий, освобождает деструктор.
+class ExecSession : public QObject
+{
+    Q_OBJECT
+public:
+    ExecSession(int executionId, ExecPolicy* policy, const ExecPolicy::Command& command,
+                int timeoutMs, QObject* parent = nullptr);
+    ~ExecSession() override;
+
+    int id() const { return executionId; }
+    void start();
+    // SIGTERM, через killDelay - SIGKILL
+    void cancel() { stop("cancelled"); }
+
+signals:
+    void output(int executionId, const QString& stream, const QByteArray& data);
+    void finished(int executionId, const QJsonObject& summary);
+
+private slots:
+    void onStdout();
+    void onStderr();
+    void onFinished(int exitCode, QProcess::ExitStatus status);
+    void onError(QProcess::ProcessError error);
+    void flush();
+
+private:
+    void collect(QByteArray& buffer, const QByteArray& data);
+    // Отдаёт накопленное до последнего целого символа UTF-8; last - весь остаток
+    void send(const QString& stream, QByteArray& buffer, bool last);
+    void stop(const QString& reason);
+    void killScope();
+    void complete(QJsonObject summary);
+
+    int executionId;
+    ExecPolicy* policy;
+    ExecPolicy::Command command;
+    int timeoutMs;
+    QString scopeUnit; // пусто - запуск без systemd-run
+
+    // Куча, а не член: работающий процесс переживает сессию (см. деструктор)
+    QProcess* process;
+    QTimer timeoutTimer;
+    QTimer killTimer;
+    QTimer flushTimer;
+    QElapsedTimer clock;
+
+    QByteArray stdoutBuffer;
+    QByteArray stderrBuffer;
+    qint64 outputBytes;
+    qint64 droppedBytes;
+    QString stopReason;
+    bool done;
+};
+
+#endif // EXECSESSION_H
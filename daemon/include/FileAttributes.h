@@ -0,0 +1,55 @@
+#ifndef FILEATTRIBUTES_H
+#define FILEATTRIBUTES_H
+
+#include <QJsonObject>
+#include <QJsonArray>
+#include <QByteArray>
+#include <QHash>
+
+// ACL POSIX и расширенные атрибуты файлов.
+//
+// ACL читаются и пишутся прямо как xattr system.posix_acl_access/default в
+// двоичном формате ядра, без libacl. В протоколе - текстовая форма getfacl/setfacl:
+// "user::rwx,user:alice:r-x,group::r-x,mask::r-x,other::r--". Значения остальных
+// атрибутов - строка, если это читаемый UTF-8, иначе "0s" + base64, как у getfattr.
+// Символические ссылки не разыменовываются.
+class FileAttributes
+{
+public:
+    enum Field { Acl = 0x1, Xattrs = 0x2 };
+    Q_DECLARE_FLAGS(Fields, Field)
+
+    // "include": ["acl", "xattr"] из параметров запроса
+    static Fields parseFields(const QJsonValue& include);
+
+    // Имена пользователей и групп кэшируются на время одного ответа
+    explicit FileAttributes(Fields fields);
+    Fields fields() const { return wanted; }
+
+    // Дописывает acl, defaultAcl и xattrs в описание файла. Атрибуты читаются,
+    // только если поле запрошено; файл без расширенного ACL поля acl не получает
+    void project(const QString& path, QJsonObject& file);
+
+    // Один элемент setFileAttributes: acl, defaultAcl, removeAcl, removeDefaultAcl,
+    // xattrs {имя: значение}, removeXattrs [имена]
+    static bool apply(const QString& path, const QJsonObject& changes, QString* error);
+
+    // Текстовый ACL -> значение xattr. Маска без явного mask:: считается как в setfacl
+    static bool encodeAcl(const QString& text, QByteArray* value, QString* error);
+    QString decodeAcl(const QByteArray& value);
+
+    static const char* accessAclName();
+    static const char* defaultAclName();
+
+private:
+    QString userName(uint uid);
+    QString groupName(uint gid);
+
+    Fields wanted;
+    QHash<uint, QString> users;
+    QHash<uint, QString> groups;
+};
+
+Q_DECLARE_OPERATORS_FOR_FLAGS(FileAttributes::Fields)
+
+#endif // FILEATTRIBUTES_H
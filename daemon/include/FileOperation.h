@@ -0,0 +1,62 @@
+#ifndef FILEOPERATION_H
+#define FILEOPERATION_H
+
+#include <QObject>
+#include <QJsonObject>
+#include <QTimer>
+#include <QElapsedTimer>
+#include <memory>
+
+struct FileJob;
+
+// Пакетная операция над файлами и деревьями каталогов за один запрос:
+// chmod, chown, setAcl, delete, copy, move.
+//
+// Обход идёт несколькими рабочими потоками из отдельного пула по общей стопке
+// записей. Все системные вызовы делаются относительно дескрипторов уже открытых
+// каталогов (openat, fstatat, fchmodat, fchownat, unlinkat, renameat), без
+// повторного разбора полного пути и без перехода по символическим ссылкам.
+// Действие над самим каталогом (удаление, права, права копии) выполняется,
+// когда обработаны все его дети. Ход работы отдаётся сигналом progress,
+// ошибки копятся по каждому пути, отмена останавливает обход на следующей записи.
+class FileOperation : public QObject
+{
+    Q_OBJECT
+public:
+    // params - параметры RPC fileOperation; при ошибке isValid() == false
+    FileOperation(int operationId, const QJsonObject& params, QObject* parent = nullptr);
+    ~FileOperation() override;
+
+    int id() const { return operationId; }
+    bool isValid() const { return valid; }
+    QString errorString() const { return error; }
+
+    void start();
+    void cancel();
+
+    // Размер общего пула обхода; 0 - по числу ядер, но не больше 8.
+    // Уже идущие операции сохраняют число своих потоков
+    static void setWorkerThreads(int count);
+
+signals:
+    void progress(int operationId, const QJsonObject& state);
+    void finished(int operationId, const QJsonObject& summary);
+
+private slots:
+    void reportProgress();
+    void onWorkerFinished();
+
+private:
+    void fail(const QString& message);
+    QJsonObject state() const;
+
+    int operationId;
+    bool valid;
+    QString error;
+    std::shared_ptr<FileJob> job;
+    QTimer progressTimer;
+    QElapsedTimer clock;
+    int workersRunning;
+};
+
+#endif // FILEOPERATION_H
@@ -0,0 +1,98 @@
+#ifndef LOGTAIL_H
+#define LOGTAIL_H
+
+#include <QObject>
+#include <QFile>
+#include <QProcess>
+#include <QTimer>
+#include <QElapsedTimer>
+#include <QRegularExpression>
+#include <QFileSystemWatcher>
+
+// Базовый поток журнала: режет данные на строки, фильтрует их регулярным
+// выражением и отдаёт пачками не чаще раза в flushInterval, не превышая
+// заданную скорость. Лишнее отбрасывается с подсчётом потерянных байт.
+class LogStream : public QObject
+{
+    Q_OBJECT
+public:
+    LogStream(int subscriptionId, const QString& filter, int maxBytesPerSecond, QObject* parent = nullptr);
+
+    int id() const { return subscriptionId; }
+    bool isValid() const { return valid; }
+    QString errorString() const { return error; }
+
+signals:
+    void dataReady(int subscriptionId, const QByteArray& data, qint64 droppedBytes);
+    void closed(int subscriptionId, const QString& reason);
+
+protected:
+    void feed(const QByteArray& bytes);
+    void drop(qint64 bytes) { droppedBytes += bytes; }
+    void fail(const QString& message);
+    qint64 budgetLeft() const { return tokens; }
+
+    bool valid;
+    QString error;
+
+private slots:
+    void flush();
+
+private:
+    void appendLine(const QByteArray& line);
+
+    int subscriptionId;
+    QRegularExpression filter;
+    QByteArray partialLine;
+    QByteArray pending;
+    qint64 droppedBytes;
+    qint64 tokens;
+    qint64 maxBytesPerSecond;
+    QTimer flushTimer;
+    QElapsedTimer refillClock;
+};
+
+// Хвост файла: следит за изменениями через QFileSystemWatcher (inotify в Linux)
+// и читает только дописанные байты начиная с сохранённого смещения.
+// Переживает усечение и ротацию файла.
+class FileTailStream : public LogStream
+{
+    Q_OBJECT
+public:
+    FileTailStream(int subscriptionId, const QString& path, qint64 backlogBytes,
+                   const QString& filter, int maxBytesPerSecond, QObject* parent = nullptr);
+
+private slots:
+    void onFileChanged();
+    void onDirectoryChanged();
+
+private:
+    bool reopen(qint64 startOffset);
+
+    QString path;
+    QFile file;
+    qint64 offset;
+    QFileSystemWatcher watcher;
+};
+
+// Поток systemd-журнала по выбранным юнитам через journalctl -f. Запуск и
+// остановка не ждут процесс синхронно: ошибка запуска приходит как closed
+class JournalStream : public LogStream
+{
+    Q_OBJECT
+public:
+    JournalStream(int subscriptionId, const QStringList& units, int backlogLines,
+                  const QString& filter, int maxBytesPerSecond, QObject* parent = nullptr);
+    ~JournalStream() override;
+
+private slots:
+    void onReadyRead();
+    void onFinished(int exitCode, QProcess::ExitStatus status);
+    void onError(QProcess::ProcessError error);
+
+private:
+    // Куча, а не член: работающий процесс переживает поток (см. деструктор)
+    QProcess* journalctl;
+};
+
+#endif // LOGTAIL_H
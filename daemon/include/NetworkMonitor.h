@@ -0,0 +1,54 @@
+#ifndef NETWORKMONITOR_H
+#define NETWORKMONITOR_H
+
+#include <QObject>
+#include <QHash>
+#include <QJsonObject>
+#include <QElapsedTimer>
+
+// Статистика сети из /proc/net/dev, /proc/net/snmp, /proc/net/netstat и
+// /proc/net/sockstat, состояние интерфейсов - из /sys/class/net. Скорости
+// считаются между соседними выборками.
+class NetworkMonitor : public QObject
+{
+    Q_OBJECT
+public:
+    explicit NetworkMonitor(const QString& procRoot = "/proc", const QString& sysRoot = "/sys",
+                            QObject* parent = nullptr);
+
+    QJsonObject collect();
+
+    // Запросы чаще этого интервала получают предыдущий результат
+    void setMinInterval(int msec) { minIntervalMs = msec; }
+
+private:
+    struct InterfaceCounters {
+        qulonglong rxBytes = 0;
+        qulonglong rxPackets = 0;
+        qulonglong rxErrors = 0;
+        qulonglong rxDropped = 0;
+        qulonglong txBytes = 0;
+        qulonglong txPackets = 0;
+        qulonglong txErrors = 0;
+        qulonglong txDropped = 0;
+    };
+
+    struct Sample {
+        qint64 timestampMs = -1;
+        QHash<QString, InterfaceCounters> interfaces;
+        QHash<QByteArray, qulonglong> protocol; // "Tcp.RetransSegs", "TcpExt.ListenDrops", ...
+    };
+
+    Sample readSample() const;
+    void readProtocolTable(const QString& path, QHash<QByteArray, qulonglong>& out) const;
+    QJsonObject readSocketCounts() const;
+
+    QString procRoot;
+    QString sysRoot;
+    Sample previous;
+    QJsonObject lastResult;
+    QElapsedTimer clock;
+    int minIntervalMs;
+};
+
+#endif // NETWORKMONITOR_H
@@ -0,0 +1,90 @@
+#ifndef RESOURCEGOVERNOR_H
+#define RESOURCEGOVERNOR_H
+
+#include <QObject>
+#include <QHash>
+#include <QJsonObject>
+#include <QThreadPool>
+#include <QElapsedTimer>
+
+class QTimer;
+
+// Собственные ограничения демона, чтобы он не конкурировал с рабочей нагрузкой
+// хоста: отдельная cgroup с квотой CPU и memory.max, пониженный приоритет потоков
+// фоновой работы (обход деревьев, передача файлов) и отказ от неё, когда
+// потребление подходит к пределам. Ответы наблюдения при этом не откладываются.
+class ResourceGovernor : public QObject
+{
+    Q_OBJECT
+public:
+    struct Options {
+        QString cgroup;                 // имя под текущей cgroup или путь от корня cgroupfs; пусто - не переносить
+        QString cpuQuota;               // "20%" от одного ядра, как CPUQuota= у systemd; пусто - без квоты
+        QString memoryMax;              // "256M", как memory.max; пусто - без предела
+        QString memoryHigh;             // с этого объёма ядро начинает отбирать память
+        QString background = "normal";  // idle | batch | normal - планирование фоновых потоков
+        QString backgroundIoClass;      // realtime | best-effort | idle; пусто - как у процесса
+        int shedPercent = 90;           // с какой доли предела фоновая работа откладывается
+    };
+
+    // Снимок потребления; -1 - значение неизвестно или предела нет
+    struct Usage {
+        QString cgroup;
+        qint64 memoryCurrent = -1;
+        qint64 memoryWorkingSet = -1; // memory.current без неактивного страничного кэша
+        qint64 memoryLimit = -1;  // наименьший из memory.max/memory.high своей cgroup и предков
+        double cpuPercent = -1.0; // за последний интервал, 100 - одно ядро
+        double cpuQuotaPercent = -1.0;
+        double memoryRatio = 0.0; // доля предела по рабочей памяти на самом загруженном уровне
+        double cpuRatio = 0.0;
+    };
+
+    ResourceGovernor(const QString& procRoot, const QString& cgroupRoot, QObject* parent = nullptr);
+
+    // Cgroup меняется только при первом вызове, пределы и приоритеты - при каждом
+    void setOptions(const Options& options);
+    const Options& options() const { return current; }
+
+    // Пул для фоновых тяжёлых методов (см. AdmissionControl::MethodPolicy::background)
+    QThreadPool* backgroundPool() { return &pool; }
+    // Переводит вызывающий поток в фоновый режим; дёшево, если уже переведён
+    static void enterBackground();
+
+    // Потребление близко к пределам: фоновые методы получают отказ
+    bool isShedding() const { return shedding; }
+    qint64 shedRetryAfterMs() const;
+    void requestShed() { ++shedRequests; }
+
+    // Ответ getResourceLimits
+    QJsonObject status() const;
+
+    // nice и класс ввода-вывода для всех потоков процесса
+    static bool setProcessPriority(int nice, const QString& ioClass, int ioLevel, QString* error);
+
+private slots:
+    void sample();
+
+private:
+    bool enterCgroup(const QString& name, QString* error);
+    bool writeLimits(const Options& options, QString* error);
+    void setBackgroundPolicy(const Options& options);
+
+    QString procRoot;
+    QString cgroupRoot;
+    QString startCgroup; // где демон был запущен
+    QString ownCgroup;   // куда перенесён; пусто - не переносился
+    Options current;
+    bool configured;
+
+    QThreadPool pool;
+    QTimer* sampleTimer;
+    QElapsedTimer clock;
+    qint64 lastSampleUsec;
+    QHash<QString, qint64> previousCpuUsec; // usage_usec по уровням иерархии
+    Usage lastUsage;
+    bool shedding;
+    QString shedReason;
+    qint64 shedRequests;
+};
+
+#endif // RESOURCEGOVERNOR_H
@@ -13,30 +13,99 @@
 #include <QUdpSocket>
 #include <QNetworkDatagram>
 #include <QNetworkInterface>
+#include <QTimer>
+#include <QSet>
+#include <QHostAddress>
+#include <QSslConfiguration>
+#include <QAtomicInt>
 #include <cmath>
+#include "FrameChannel.h"
 
 class ClientConnection;
+class CgroupMonitor;
+class NetworkMonitor;
+class DiskMonitor;
+class AdmissionControl;
+class AccessControl;
+class ExecPolicy;
+class ResourceGovernor;
+class DaemonMetrics;
+class MetricsEndpoint;
+struct TlsOptions;
 
 class Server : public QTcpServer
 {
     Q_OBJECT
 public:
     explicit Server(QObject* parent = nullptr);
+    // Корни /proc и /sys можно подменить, например на фикстуры в бенчмарках
+    Server(const QString& procRoot, const QString& sysRoot, QObject* parent = nullptr);
     virtual ~Server() = default;
-    void startServer(quint16 port);
+    void startServer(quint16 port, const QHostAddress& address = QHostAddress::Any);
+
+    // TLS для всех новых подключений; вызывать до startServer
+    bool setTlsOptions(const TlsOptions& options, QString* error);
+    bool isTlsEnabled() const { return tlsEnabled; }
+    const QSslConfiguration& tlsConfiguration() const { return tlsConfig; }
+    // Пароли по открытому TCP принимаются только с loopback, если не разрешено явно
+    void setAllowPlaintextSecrets(bool allow) { plaintextSecretsAllowed = allow; }
+    bool allowsPlaintextSecrets() const { return plaintextSecretsAllowed; }
+
+    // Пределы и интервалы, которые можно менять на лету (см. DaemonConfig):
+    // новые значения действуют и для уже открытых соединений
+    struct Tuning {
+        int maxClients = 256;
+        qint64 maxMessageSize = FrameChannel::defaultMaxMessageSize;
+        // Сколько каталог должен не меняться, чтобы получить etag для кэша клиента
+        int etagSettleMs = 2000;
+        int cgroupRefreshMs = 1000;
+        int cgroupRescanMs = 10000;
+        int networkMinIntervalMs = 500;
+        int diskMinIntervalMs = 500;
+    };
+    void setTuning(const Tuning& tuning);
+    const Tuning& tuning() const { return currentTuning; }
+
+    AdmissionControl* admission() const { return admissionControl; }
+    AccessControl* access() const { return accessControl; }
+    ExecPolicy* execPolicy() const { return execCommands; }
+    ResourceGovernor* governor() const { return resourceGovernor; }
+    DaemonMetrics* metrics() const { return metricsRegistry; }
+
+    // Локальный HTTP /metrics для Prometheus; по умолчанию выключен
+    bool startMetricsEndpoint(const QHostAddress& address, quint16 port);
+    QByteArray metricsText() const;
 
     // System information methods
     QJsonObject getSystemInfo() const;
+    QJsonObject getCpuInfo() const;
+    QJsonObject getMemoryInfo() const;
+    QJsonObject getUptimeInfo() const;
     QStringList getUserList() const;
-    QJsonArray getFileSystem(const QString& path) const;
-    QJsonArray getProcessList() const;
+    // include - необязательные поля записей: "acl", "xattr" (см. FileAttributes)
+    QJsonArray getFileSystem(const QString& path, const QJsonValue& include = QJsonValue()) const;
+    // ACL и атрибуты многих файлов одним запросом
+    QJsonArray getFileAttributes(const QJsonArray& paths, const QJsonValue& include) const;
+    // Валидатор списка каталога для кэша клиента; пустой - кэшировать нельзя
+    QString directoryEtag(const QString& path) const;
+    // Неверное регулярное выражение name - ошибка в error, а не пустой список
+    QJsonArray getProcessList(const QJsonObject& query = QJsonObject(), QString* error = nullptr) const;
     QJsonArray getServiceList() const;
+    // Имя, не похожее на юнит systemd, не передаётся в systemctl: ошибка в error
+    QJsonObject getServiceStatus(const QString& service, QString* error = nullptr) const;
+    QJsonArray getCgroupStats(const QJsonObject& query) const;
+    QJsonObject getNetworkStats() const;
+    QJsonArray getDiskStats() const;
+    QJsonObject getDaemonStats() const;
+    QJsonObject getResourceLimits() const;
 
     // System management methods
     bool addUser(const QString& username, const QString& password);
     bool removeUser(const QString& username);
     bool changeUserPassword(const QString& username, const QString& password);
     bool setFilePermissions(const QString& path, const QString& permissions);
+    // Каждый элемент применяется отдельно; результат - {path, ok, error} по каждому
+    QJsonArray setFileAttributes(const QJsonArray& items);
     bool manageService(const QString& service, const QString& action);
 
     // File operations
@@ -45,20 +114,43 @@ public:
 
 private slots:
     void handleDiscoveryRequest();
+    void sendPeriodicAnnouncement();
 
 protected:
     void incomingConnection(qintptr socketDescriptor) override;
 
 private:
-    QJsonObject getCpuInfo() const;
-    QJsonObject getMemoryInfo() const;
     QJsonArray getDiskInfo() const;
-    QJsonObject getUptimeInfo() const;
+
+    QString procRoot;
+    QString sysRoot;
 
     QList<ClientConnection*> clients;
+    CgroupMonitor* cgroupMonitor;
+    NetworkMonitor* networkMonitor;
+    DiskMonitor* diskMonitor;
+    AdmissionControl* admissionControl;
+    AccessControl* accessControl;
+    ExecPolicy* execCommands;
+    ResourceGovernor* resourceGovernor;
+    DaemonMetrics* metricsRegistry;
+    MetricsEndpoint* metricsEndpoint;
+    Tuning currentTuning;
+    // Читается из рабочих потоков (directoryEtag), меняется в главном
+    QAtomicInt etagSettleMs;
+
+    QByteArray buildAnnouncement() const;
+    void joinDiscoveryGroup();
 
     QUdpSocket* discoverySocket;
+    QTimer* announceTimer;
+    QList<QNetworkInterface> multicastInterfaces;
+    QSet<QString> pendingReplies;
     quint16 tcpPort;
+
+    bool tlsEnabled;
+    QSslConfiguration tlsConfig;
+    bool plaintextSecretsAllowed;
 };
 
 #endif // SERVER_H
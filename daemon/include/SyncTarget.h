@@ -0,0 +1,37 @@
+#ifndef SYNCTARGET_H
+#define SYNCTARGET_H
+
+#include <QJsonObject>
+#include <QString>
+
+// Приёмная сторона syncTree: синхронизация дерева каталогов с клиента.
+//
+// syncTree - обмен манифестом: клиент присылает пути, размеры, mtime, права и
+// SHA-256 своих файлов, демон отвечает, что передать. Файл с тем же размером и
+// mtime считается неизменным без чтения; при другом mtime, но том же содержимом
+// правятся только метаданные. Для большого изменённого файла в ответ идут
+// подписи блоков (DeltaSync), чтобы клиент прислал только разницу.
+//
+// syncTreeCommit - запись пачки файлов: каждый пишется во временный файл рядом
+// (QSaveFile), проверяется по SHA-256, и только когда вся пачка готова, файлы
+// атомарно переименовываются на место. Ошибка в любом файле отменяет всю пачку.
+//
+// Оба метода выполняются в пуле потоков и не трогают общего состояния.
+class SyncTarget
+{
+public:
+    // Пустой результат и текст ошибки - неверные параметры
+    static QJsonObject compare(const QJsonObject& params, QString* error);
+    static QJsonObject commit(const QJsonObject& params, QString* error);
+
+private:
+    struct Root {
+        QString path;
+        QString canonical;
+    };
+    static bool openRoot(const QJsonObject& params, Root* root, QString* error);
+    // Относительный путь из запроса -> путь под корнем; ссылки не должны уводить наружу
+    static bool resolve(const Root& root, const QString& relative, QString* target, QString* error);
+};
+
+#endif // SYNCTARGET_H
@@ -1,44 +1,14 @@
 #include "Server.h"
+#include "AsyncLogger.h"
+#include "TlsOptions.h"
+#include "AccessControl.h"
+#include "ExecSession.h"
+#include "DaemonConfig.h"
+#include <QHostAddress>
 #include <QCoreApplication>
 #include <QSettings>
-#include <QFile>
-#include <QTextStream>
 #include <QDebug>
 
-void messageHandler(QtMsgType type, const QMessageLogContext& context, const QString& msg)
-{
-    Q_UNUSED(context);
-
-    QString txt;
-    switch (type) {
-    case QtDebugMsg:
-        txt = QString("Debug: %1").arg(msg);
-        break;
-    case QtInfoMsg:
-        txt = QString("Info: %1").arg(msg);
-        break;
-    case QtWarningMsg:
-        txt = QString("Warning: %1").arg(msg);
-        break;
-    case QtCriticalMsg:
-        txt = QString("Critical: %1").arg(msg);
-        break;
-    case QtFatalMsg:
-        txt = QString("Fatal: %1").arg(msg);
-        break;
-    }
-
-    // Логирование в файл
-    QFile outFile("os_server.log");
-    outFile.open(QIODevice::WriteOnly | QIODevice::Append);
-    QTextStream ts(&outFile);
-    ts << QDateTime::currentDateTime().toString() << " - " << txt << "\n";
-    outFile.close();
-
-    // Также выводим в консоль для отладки
-    QTextStream(stdout) << txt << "\n";
-}
-
 int main(int argc, char* argv[])
 {
     QCoreApplication a(argc, argv);
@@ -48,19 +18,114 @@ int main(int argc, char* argv[])
     a.setApplicationVersion("1.0");
     a.setOrganizationName("YourCompany");
 
-    // Настройка логирования
-    qInstallMessageHandler(messageHandler);
-    qInfo() << "Starting OS Overview Server...";
-
     // Загрузка конфигурации
     QSettings settings;
+
+    // Настройка логирования: запись в файл идёт в отдельном потоке
+    AsyncLogger::Options logOptions;
+    logOptions.filePath = settings.value("log/file", logOptions.filePath).toString();
+    logOptions.maxFileSize = settings.value("log/maxSizeMb", 10).toLongLong() * 1024 * 1024;
+    logOptions.maxFiles = settings.value("log/maxFiles", logOptions.maxFiles).toInt();
+    logOptions.echoToConsole = settings.value("log/console", true).toBool();
+    AsyncLogger::setLevel(settings.value("log/level", "info").toString());
+    AsyncLogger logger(logOptions);
+    logger.install();
+    qCInfo(lcServer) << "Starting OS Overview Server...";
+
     quint16 port = settings.value("server/port", 45454).toUInt();
-    qInfo() << "Configuration loaded. Port:" << port;
+    QHostAddress address(settings.value("server/address", "0.0.0.0").toString());
+    if (address.isNull() || address == QHostAddress::AnyIPv4) address = QHostAddress::Any;
+    qCInfo(lcServer) << "Configuration loaded. Port:" << port;
+
+    // TLS: при заданной секции [tls] открытый протокол не принимается вовсе
+    TlsOptions tls;
+    tls.enabled = settings.value("tls/enabled", false).toBool();
+    tls.certificateFile = settings.value("tls/certificate").toString();
+    tls.privateKeyFile = settings.value("tls/privateKey").toString();
+    tls.caFile = settings.value("tls/clientCa").toString();
+    tls.verifyPeer = settings.value("tls/requireClientCertificate", false).toBool();
+    tls.allowTls12 = settings.value("tls/allowTls12", false).toBool();
 
     // Создание и запуск сервера
     Server server;
-    server.startServer(port);
-    qInfo() << "Server initialized. Ready for connections.";
+    QString tlsError;
+    if (!server.setTlsOptions(tls, &tlsError)) {
+        qCCritical(lcServer) << "TLS configuration error:" << tlsError;
+        logger.shutdown();
+        return 1;
+    }
+    server.setAllowPlaintextSecrets(settings.value("tls/allowPlaintextPasswords", false).toBool());
+
+    // Потоки, пределы, интервалы и приоритет; перечитываются по SIGHUP и при изменении файла
+    DaemonConfig config(&server);
+    config.apply(DaemonConfig::read(settings));
+    config.watch();
+
+    // Аутентификация: права и анонимная роль читаются при старте, список
+    // пользователей DaemonConfig перечитывает вместе с остальными настройками
+    AccessControl* access = server.access();
+    access->setEnabled(settings.value("auth/enabled", false).toBool());
+    if (access->isEnabled()) {
+        QString authError;
+        bool roleOk = false;
+        const Role anonymous = AccessControl::roleFromName(settings.value("auth/anonymousRole", "viewer").toString(), &roleOk);
+        if (!roleOk) authError = "unknown auth/anonymousRole";
+        if (authError.isEmpty()) access->loadUsers(config.options().usersFile, &authError);
+        if (!authError.isEmpty()) {
+            qCCritical(lcServer) << "Auth configuration error:" << authError;
+            logger.shutdown();
+            return 1;
+        }
+        access->setAnonymousRole(anonymous);
+        settings.beginGroup("permissions");
+        for (const QString& method : settings.childKeys()) {
+            const Role required = AccessControl::roleFromName(settings.value(method).toString(), &roleOk);
+            if (!roleOk) qCWarning(lcServer) << "Unknown role for" << method << "- only admin may call it";
+            access->setRequiredRole(method, roleOk ? required : Role::Admin);
+        }
+        settings.endGroup();
+        qCInfo(lcServer) << "Authentication enabled," << access->userCount() << "users, anonymous role"
+                         << AccessControl::roleName(anonymous);
+    } else {
+        qCWarning(lcServer) << "Authentication disabled: every client that reaches the port is admin";
+    }
+
+    // Команды для exec: только явно перечисленные в [execCommands]
+    ExecPolicy::Options execOptions;
+    execOptions.enabled = settings.value("exec/enabled", false).toBool();
+    execOptions.allowExtraArguments = settings.value("exec/allowExtraArguments", false).toBool();
+    execOptions.defaultTimeoutMs = settings.value("exec/timeoutMs", execOptions.defaultTimeoutMs).toInt();
+    execOptions.maxTimeoutMs = settings.value("exec/maxTimeoutMs", execOptions.maxTimeoutMs).toInt();
+    execOptions.maxOutputBytes = settings.value("exec/maxOutputKb", 4096).toLongLong() * 1024;
+    execOptions.maxConcurrent = settings.value("exec/maxConcurrent", execOptions.maxConcurrent).toInt();
+    execOptions.maxPerClient = settings.value("exec/maxPerClient", execOptions.maxPerClient).toInt();
+    execOptions.useScope = settings.value("exec/scope", true).toBool();
+    execOptions.memoryMax = settings.value("exec/memoryMax", execOptions.memoryMax).toString();
+    execOptions.cpuQuota = settings.value("exec/cpuQuota", execOptions.cpuQuota).toString();
+    execOptions.tasksMax = settings.value("exec/tasksMax", execOptions.tasksMax).toInt();
+    ExecPolicy* exec = server.execPolicy();
+    exec->setOptions(execOptions);
+    if (execOptions.enabled) {
+        settings.beginGroup("execCommands");
+        for (const QString& name : settings.childKeys()) {
+            QString execError;
+            if (!exec->allow(name, settings.value(name).toString(), &execError)) qCWarning(lcServer) << execError;
+        }
+        settings.endGroup();
+        qCInfo(lcServer) << "exec enabled for" << exec->commandNames();
+    }
+
+    server.startServer(port, address);
+
+    // Экспорт метрик для Prometheus: только если задан порт, по умолчанию на loopback
+    quint16 metricsPort = settings.value("metrics/port", 0).toUInt();
+    if (metricsPort != 0) {
+        QHostAddress metricsAddress(settings.value("metrics/address", "127.0.0.1").toString());
+        server.startMetricsEndpoint(metricsAddress, metricsPort);
+    }
+    qCInfo(lcServer) << "Server initialized. Ready for connections.";
 
-    return a.exec();
+    int result = a.exec();
+    logger.shutdown();
+    return result;
 }
@@ -0,0 +1,124 @@
+#include "AccessControl.h"
+#include "AsyncLogger.h"
+#include "Credentials.h"
+#include <QFile>
+#include <QRandomGenerator>
+
+namespace {
+
+const int challengeBytes = 32;
+
+// Сравнение за время, не зависящее от места первого расхождения
+bool constantTimeEquals(const QByteArray& a, const QByteArray& b)
+{
+    if (a.size() != b.size()) return false;
+    unsigned char diff = 0;
+    for (int i = 0; i < a.size(); ++i) diff |= static_cast<unsigned char>(a[i] ^ b[i]);
+    return diff == 0;
+}
+
+} // namespace
+
+AccessControl::AccessControl(QObject* parent)
+    : QObject(parent), enabled(false), anonymous(Role::Viewer)
+{
+    // Доступно до входа: согласование протокола и сам вход
+    methodRoles.insert("hello", Role::None);
+    methodRoles.insert("authenticate", Role::None);
+    // Чтение состояния системы
+    for (const char* method : { "getSystemInfo", "getUserList", "getFileSystem", "getFileAttributes",
+                                "getProcessList", "getServiceList", "getServiceStatus", "getCgroupStats",
+                                "getNetworkStats", "getDiskStats", "getDaemonStats", "getResourceLimits",
+                                "unsubscribe" }) {
+        methodRoles.insert(method, Role::Viewer);
+    }
+    // Содержимое файлов и журналов, управление службами и файлами
+    for (const char* method : { "tailFile", "followJournal", "downloadFile", "uploadFile",
+                                "setFilePermissions", "manageService", "exec", "cancelExec",
+                                "fileOperation", "cancelFileOperation", "setFileAttributes",
+                                "syncTree", "syncTreeCommit" }) {
+        methodRoles.insert(method, Role::Operator);
+    }
+    // Учётные записи
+    for (const char* method : { "addUser", "removeUser", "changeUserPassword" }) {
+        methodRoles.insert(method, Role::Admin);
+    }
+}
+
+bool AccessControl::loadUsers(const QString& path, QString* error)
+{
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly | QIODevice::Text)) {
+        if (error) *error = QString("Cannot read %1: %2").arg(path, file.errorString());
+        return false;
+    }
+#ifdef Q_OS_UNIX
+    if (file.permissions() & (QFileDevice::ReadGroup | QFileDevice::ReadOther)) {
+        qCWarning(lcServer) << "User secrets file" << path << "is readable by group or others";
+    }
+#endif
+
+    QHash<QString, User> loaded;
+    int lineNumber = 0;
+    while (!file.atEnd()) {
+        ++lineNumber;
+        const QString line = QString::fromUtf8(file.readLine()).trimmed();
+        if (line.isEmpty() || line.startsWith('#')) continue;
+
+        const QStringList fields = line.simplified().split(' ');
+        bool ok = false;
+        const Role role = fields.size() == 3 ? roleFromName(fields[1], &ok) : Role::None;
+        if (!ok || role == Role::None) {
+            if (error) *error = QString("%1:%2: expected 'user role secret'").arg(path).arg(lineNumber);
+            return false;
+        }
+        loaded.insert(fields[0], User{ role, fields[2].toUtf8() });
+    }
+
+    users.swap(loaded);
+    return true;
+}
+
+QByteArray AccessControl::makeChallenge()
+{
+    QByteArray challenge(challengeBytes, Qt::Uninitialized);
+    QRandomGenerator* generator = QRandomGenerator::system();
+    for (char& byte : challenge) byte = static_cast<char>(generator->bounded(256));
+    return challenge;
+}
+
+Role AccessControl::verify(const QString& user, const QByteArray& challenge, const QByteArray& proof) const
+{
+    const auto it = users.constFind(user);
+    // Неизвестному имени тоже считаем HMAC, чтобы по времени ответа нельзя было перебирать имена
+    const QByteArray expected = Credentials::proof(it != users.constEnd() ? it->secret : QByteArray(challengeBytes, '\0'),
+                                                   challenge, user);
+    if (it == users.constEnd() || !constantTimeEquals(expected, proof)) return Role::None;
+    return it->role;
+}
+
+Role AccessControl::roleForCertificate(const QString& identity) const
+{
+    return identity.isEmpty() ? Role::None : users.value(identity).role;
+}
+
+QString AccessControl::roleName(Role role)
+{
+    switch (role) {
+    case Role::Viewer: return "viewer";
+    case Role::Operator: return "operator";
+    case Role::Admin: return "admin";
+    case Role::None: break;
+    }
+    return "none";
+}
+
+Role AccessControl::roleFromName(const QString& name, bool* ok)
+{
+    static const QHash<QString, Role> roles = {
+        { "none", Role::None }, { "viewer", Role::Viewer }, { "operator", Role::Operator }, { "admin", Role::Admin }
+    };
+    const auto it = roles.constFind(name.toLower());
+    if (ok) *ok = it != roles.constEnd();
+    return it != roles.constEnd() ? it.value() : Role::None;
+}
@@ -0,0 +1,125 @@
+#include "AdmissionControl.h"
+#include <QThread>
+#include <cmath>
+
+namespace {
+
+// Занимает слот, если занято меньше limit; звать можно из любого потока
+bool tryAcquire(QAtomicInt& counter, int limit)
+{
+    int current = counter.loadAcquire();
+    while (current < limit) {
+        if (counter.testAndSetOrdered(current, current + 1)) return true;
+        current = counter.loadAcquire();
+    }
+    return false;
+}
+
+} // namespace
+
+// ========== TokenBucket ==========
+
+TokenBucket::TokenBucket(double ratePerSecond, double burst)
+    : rate(ratePerSecond), capacity(burst), tokens(burst), lastRefillMs(-1)
+{}
+
+void TokenBucket::refill(qint64 nowMs)
+{
+    if (lastRefillMs >= 0 && nowMs > lastRefillMs) {
+        tokens = qMin(capacity, tokens + (nowMs - lastRefillMs) * rate / 1000.0);
+    }
+    lastRefillMs = nowMs;
+}
+
+bool TokenBucket::tryTake(qint64 nowMs, double cost)
+{
+    if (rate <= 0.0) return true;
+    refill(nowMs);
+    if (tokens < cost) return false;
+    tokens -= cost;
+    return true;
+}
+
+qint64 TokenBucket::msUntilAvailable(qint64 nowMs, double cost) const
+{
+    if (rate <= 0.0) return 0;
+    double available = tokens;
+    if (lastRefillMs >= 0 && nowMs > lastRefillMs) {
+        available = qMin(capacity, available + (nowMs - lastRefillMs) * rate / 1000.0);
+    }
+    if (available >= cost) return 0;
+    return static_cast<qint64>(std::ceil((cost - available) * 1000.0 / rate));
+}
+
+// ========== AdmissionControl ==========
+
+AdmissionControl::AdmissionControl(QObject* parent)
+    : QObject(parent),
+      inFlight(0),
+      maxExpensive(0),
+      backgroundRunning(0),
+      maxBackground(1)
+{
+    setMaxExpensive(0);
+    clock.start();
+
+    // Обход файловой системы, запуск ps/systemctl и передача файлов - тяжёлые:
+    // их частота ограничена отдельно и они не выполняются в главном потоке
+    const MethodPolicy heavy = { 5.0, 10.0, true };
+    policies.insert("getFileSystem", heavy);
+    policies.insert("getProcessList", heavy);
+    policies.insert("getServiceList", heavy);
+    policies.insert("getServiceStatus", { 20.0, 40.0, true });
+    // Передача и синхронизация файлов - фоновая работа (см. ResourceGovernor)
+    const MethodPolicy transfer = { 2.0, 4.0, true, true };
+    policies.insert("uploadFile", transfer);
+    policies.insert("downloadFile", transfer);
+    // Пачка путей, по несколько xattr-вызовов на каждый
+    policies.insert("getFileAttributes", heavy);
+    policies.insert("setFileAttributes", transfer);
+    // Манифест читает и хэширует файлы; пачек записи на одну синхронизацию много
+    policies.insert("syncTree", transfer);
+    policies.insert("syncTreeCommit", { 20.0, 40.0, true, true });
+
+    // Сборщики статистики кэшируют результат, но разбор /proc тоже не бесплатен
+    const MethodPolicy collector = { 10.0, 20.0, false };
+    policies.insert("getCgroupStats", collector);
+    policies.insert("getNetworkStats", collector);
+    policies.insert("getDiskStats", collector);
+    policies.insert("getSystemInfo", collector);
+    policies.insert("getDaemonStats", collector);
+    policies.insert("getResourceLimits", collector);
+
+    policies.insert("tailFile", { 1.0, 4.0, false });
+    policies.insert("followJournal", { 1.0, 4.0, false });
+    // Запуск процесса - fork/exec, но не ожидание: число одновременных команд
+    // ограничивает ExecPolicy, здесь - только частота
+    policies.insert("exec", { 5.0, 20.0, false });
+    // Обход дерева идёт в своём пуле, с ответом сразу; ограничиваем только частоту
+    policies.insert("fileOperation", { 2.0, 8.0, false, true });
+}
+
+bool AdmissionControl::tryStartExpensive()
+{
+    return tryAcquire(inFlight, maxExpensive);
+}
+
+void AdmissionControl::setMaxExpensive(int count)
+{
+    maxExpensive = count > 0 ? count : qMax(2, QThread::idealThreadCount() / 2);
+}
+
+void AdmissionControl::finishExpensive()
+{
+    inFlight.fetchAndSubOrdered(1);
+}
+
+bool AdmissionControl::tryStartBackground()
+{
+    return tryAcquire(backgroundRunning, maxBackground);
+}
+
+void AdmissionControl::finishBackground()
+{
+    backgroundRunning.fetchAndSubOrdered(1);
+}
@@ -0,0 +1,280 @@
+#include "AsyncLogger.h"
+#include <QDateTime>
+#include <QFileInfo>
+#include <QDir>
+#include <QMutexLocker>
+#include <cstdio>
+
+Q_LOGGING_CATEGORY(lcServer, "daemon.server")
+Q_LOGGING_CATEGORY(lcDiscovery, "daemon.discovery")
+Q_LOGGING_CATEGORY(lcRpc, "daemon.rpc")
+
+namespace {
+
+const int idleWakeupMs = 200;
+// Одинаковые сообщения подряд в пределах окна заменяются счётчиком повторов
+const qint64 repeatWindowMs = 10000;
+
+const char* levelName(QtMsgType type)
+{
+    switch (type) {
+    case QtDebugMsg: return "Debug";
+    case QtInfoMsg: return "Info";
+    case QtWarningMsg: return "Warning";
+    case QtCriticalMsg: return "Critical";
+    case QtFatalMsg: return "Fatal";
+    }
+    return "Unknown";
+}
+
+} // namespace
+
+AsyncLogger* AsyncLogger::instance = nullptr;
+
+AsyncLogger::AsyncLogger(const Options& options, QObject* parent)
+    : QThread(parent),
+      options(options),
+      cells(new Cell[capacity]),
+      enqueuePos(0),
+      dequeuePos(0),
+      droppedRecords(0),
+      stopping(0),
+      writtenPos(0),
+      fileBytes(0),
+      repeats(0),
+      lastWrittenMs(0)
+{
+    for (quint64 i = 0; i < capacity; ++i) cells[i].sequence.storeRelaxed(i);
+}
+
+AsyncLogger::~AsyncLogger()
+{
+    shutdown();
+    delete[] cells;
+}
+
+void AsyncLogger::setLevel(const QString& level)
+{
+    const QString normalized = level.trimmed().toLower();
+    if (normalized == "debug") {
+        QLoggingCategory::setFilterRules("*.debug=true");
+    } else if (normalized == "warning") {
+        QLoggingCategory::setFilterRules("*.debug=false\n*.info=false");
+    } else {
+        QLoggingCategory::setFilterRules("*.debug=false");
+    }
+}
+
+void AsyncLogger::install()
+{
+    instance = this;
+    start(QThread::LowPriority);
+    qInstallMessageHandler(&AsyncLogger::messageHandler);
+}
+
+void AsyncLogger::shutdown()
+{
+    if (instance == this) {
+        qInstallMessageHandler(nullptr);
+        instance = nullptr;
+    }
+    if (!isRunning()) return;
+
+    stopping.storeRelease(1);
+    wakeCondition.wakeAll();
+    wait();
+}
+
+void AsyncLogger::flush()
+{
+    // Из самого потока журнала ждать некого
+    if (!isRunning() || QThread::currentThread() == this) return;
+
+    const quint64 target = enqueuePos.loadAcquire();
+    QMutexLocker locker(&flushMutex);
+    while (writtenPos.loadAcquire() < target && isRunning()) {
+        wakeCondition.wakeAll();
+        flushDone.wait(&flushMutex, idleWakeupMs);
+    }
+}
+
+void AsyncLogger::messageHandler(QtMsgType type, const QMessageLogContext& context, const QString& msg)
+{
+    AsyncLogger* logger = instance;
+    if (!logger) {
+        std::fprintf(stderr, "%s\n", msg.toLocal8Bit().constData());
+        return;
+    }
+
+    Record record;
+    record.type = type;
+    record.timestampMs = QDateTime::currentMSecsSinceEpoch();
+    if (context.category && qstrcmp(context.category, "default") != 0) record.category = context.category;
+    record.text = msg;
+
+    if (!logger->enqueue(std::move(record))) {
+        logger->droppedRecords.fetchAndAddRelaxed(1);
+    }
+
+    // Обычные сообщения поток заберёт по таймеру, важные - сразу. Перечисляем
+    // явно: QtInfoMsg в QtMsgType стоит после QtWarningMsg
+    if (type == QtWarningMsg || type == QtCriticalMsg || type == QtFatalMsg) logger->wakeCondition.wakeOne();
+    // После фатального сообщения Qt завершит процесс - запись должна успеть в файл
+    if (type == QtFatalMsg) logger->flush();
+}
+
+bool AsyncLogger::enqueue(Record&& record)
+{
+    quint64 pos = enqueuePos.loadRelaxed();
+    Cell* cell;
+    for (;;) {
+        cell = &cells[pos & (capacity - 1)];
+        const qint64 diff = static_cast<qint64>(cell->sequence.loadAcquire()) - static_cast<qint64>(pos);
+        if (diff == 0) {
+            if (enqueuePos.testAndSetRelaxed(pos, pos + 1, pos)) break;
+        } else if (diff < 0) {
+            return false; // очередь полна, поток журнала не успевает
+        } else {
+            pos = enqueuePos.loadRelaxed();
+        }
+    }
+    cell->record = std::move(record);
+    cell->sequence.storeRelease(pos + 1);
+    return true;
+}
+
+bool AsyncLogger::dequeue(Record& record)
+{
+    Cell& cell = cells[dequeuePos & (capacity - 1)];
+    const qint64 diff = static_cast<qint64>(cell.sequence.loadAcquire()) - static_cast<qint64>(dequeuePos + 1);
+    if (diff < 0) return false;
+
+    record = std::move(cell.record);
+    cell.record = Record();
+    cell.sequence.storeRelease(dequeuePos + capacity);
+    ++dequeuePos;
+    return true;
+}
+
+void AsyncLogger::run()
+{
+    openFile();
+    if (options.echoToConsole) console.open(stdout, QIODevice::WriteOnly);
+
+    while (!stopping.loadAcquire()) {
+        drain();
+        QMutexLocker locker(&wakeMutex);
+        if (!stopping.loadAcquire()) wakeCondition.wait(&wakeMutex, idleWakeupMs);
+    }
+
+    drain();
+    flushRepeats();
+    file.close();
+    console.close();
+}
+
+void AsyncLogger::drain()
+{
+    Record record;
+    bool wrote = false;
+    while (dequeue(record)) {
+        write(record);
+        wrote = true;
+    }
+
+    const quint64 dropped = droppedRecords.fetchAndStoreRelaxed(0);
+    if (dropped > 0) {
+        Record notice;
+        notice.type = QtWarningMsg;
+        notice.timestampMs = QDateTime::currentMSecsSinceEpoch();
+        notice.text = QString("%1 log messages dropped: queue overflow").arg(dropped);
+        write(notice);
+        wrote = true;
+    }
+
+    // Повтор, который так и не сменился другим сообщением, тоже нужно отметить
+    if (repeats > 0 && QDateTime::currentMSecsSinceEpoch() - lastWrittenMs >= repeatWindowMs) {
+        flushRepeats();
+        wrote = true;
+    }
+
+    if (wrote) {
+        file.flush();
+        console.flush();
+    }
+
+    QMutexLocker locker(&flushMutex);
+    writtenPos.storeRelease(dequeuePos);
+    flushDone.wakeAll();
+}
+
+void AsyncLogger::write(const Record& record)
+{
+    if (record.type == lastRecord.type && record.text == lastRecord.text && record.category == lastRecord.category
+        && record.timestampMs - lastWrittenMs < repeatWindowMs) {
+        ++repeats;
+        return;
+    }
+
+    flushRepeats();
+
+    QByteArray line = QDateTime::fromMSecsSinceEpoch(record.timestampMs).toString(Qt::ISODateWithMs).toUtf8();
+    line += " - ";
+    line += levelName(record.type);
+    if (!record.category.isEmpty()) line += " [" + record.category + ']';
+    line += ": ";
+    line += record.text.toUtf8();
+    line += '\n';
+    writeLine(line);
+
+    lastRecord = record;
+    lastWrittenMs = record.timestampMs;
+}
+
+void AsyncLogger::flushRepeats()
+{
+    if (repeats == 0) return;
+    const QByteArray line = QDateTime::currentDateTime().toString(Qt::ISODateWithMs).toUtf8()
+        + " - " + levelName(lastRecord.type) + ": last message repeated "
+        + QByteArray::number(repeats) + " times\n";
+    repeats = 0;
+    lastRecord = Record();
+    writeLine(line);
+}
+
+void AsyncLogger::writeLine(const QByteArray& line)
+{
+    if (file.isOpen()) {
+        if (file.write(line) > 0) fileBytes += line.size();
+        rotateIfNeeded();
+    }
+    if (console.isOpen()) console.write(line);
+}
+
+void AsyncLogger::rotateIfNeeded()
+{
+    if (options.maxFileSize <= 0 || fileBytes < options.maxFileSize) return;
+
+    file.close();
+    const QString base = options.filePath;
+    QFile::remove(base + '.' + QString::number(options.maxFiles));
+    for (int i = options.maxFiles - 1; i >= 1; --i) {
+        QFile::rename(base + '.' + QString::number(i), base + '.' + QString::number(i + 1));
+    }
+    if (options.maxFiles > 0) QFile::rename(base, base + ".1");
+    else QFile::remove(base);
+    openFile();
+}
+
+void AsyncLogger::openFile()
+{
+    if (options.filePath.isEmpty()) return;
+    QDir().mkpath(QFileInfo(options.filePath).absolutePath());
+    file.setFileName(options.filePath);
+    fileBytes = 0;
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Append)) {
+        std::fprintf(stderr, "Cannot open log file %s\n", qPrintable(options.filePath));
+        return;
+    }
+    fileBytes = file.size();
+}
@@ -0,0 +1,278 @@
+#include "CgroupMonitor.h"
+#include <QDirIterator>
+#include <QFile>
+#include <QFileInfo>
+#include <QSet>
+#include <algorithm>
+#include <vector>
+
+namespace {
+
+QByteArray readSmallFile(const QString& path)
+{
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly)) return QByteArray();
+    return file.readAll();
+}
+
+// Разбор файлов вида "ключ значение" (cpu.stat, memory.stat)
+QHash<QByteArray, qulonglong> readKeyValues(const QString& path)
+{
+    QHash<QByteArray, qulonglong> values;
+    for (const QByteArray& line : readSmallFile(path).split('\n')) {
+        int space = line.indexOf(' ');
+        if (space <= 0) continue;
+        values.insert(line.left(space), line.mid(space + 1).toULongLong());
+    }
+    return values;
+}
+
+// Значение либо число, либо "max"
+qint64 readLimit(const QString& path)
+{
+    QByteArray value = readSmallFile(path).trimmed();
+    if (value.isEmpty() || value == "max") return -1;
+    return value.toLongLong();
+}
+
+// Счётчики обнуляются, если группу пересоздали с тем же путём
+qulonglong delta(qulonglong current, qulonglong previous)
+{
+    return current >= previous ? current - previous : 0;
+}
+
+double ratePerSecond(qulonglong current, qulonglong previous, qint64 elapsedMs)
+{
+    if (elapsedMs <= 0 || current < previous) return 0.0;
+    return (current - previous) * 1000.0 / elapsedMs;
+}
+
+} // namespace
+
+CgroupMonitor::CgroupMonitor(const QString& root, QObject* parent)
+    : QObject(parent),
+      rootPath(root),
+      lastRefreshMs(-1),
+      lastRescanMs(-1),
+      refreshIntervalMs(1000),
+      rescanIntervalMs(10000)
+{
+    // В гибридном режиме иерархия v2 смонтирована в unified/
+    if (!QFileInfo::exists(rootPath + "/cgroup.controllers") &&
+        QFileInfo::exists(rootPath + "/unified/cgroup.controllers")) {
+        rootPath += "/unified";
+    }
+    clock.start();
+}
+
+bool CgroupMonitor::isAvailable() const
+{
+    return QFileInfo::exists(rootPath + "/cgroup.controllers");
+}
+
+QJsonArray CgroupMonitor::collect(const QJsonObject& query)
+{
+    QJsonArray result;
+    if (!isAvailable()) return result;
+
+    const qint64 now = clock.elapsed();
+    if (lastRescanMs < 0 || now - lastRescanMs >= rescanIntervalMs) {
+        rescan();
+        lastRescanMs = now;
+    }
+    if (lastRefreshMs < 0 || now - lastRefreshMs >= refreshIntervalMs) {
+        refresh();
+        lastRefreshMs = now;
+    }
+
+    QString subtree = query["path"].toString();
+    if (subtree.endsWith('/') && subtree.size() > 1) subtree.chop(1);
+    const int maxDepth = query["maxDepth"].toInt(-1);
+    const QString sortKey = query["sort"].toString("cpu");
+    const int limit = query["limit"].toInt(0);
+
+    std::vector<const Entry*> selected;
+    selected.reserve(entries.size());
+    for (const Entry& entry : entries) {
+        if (!subtree.isEmpty() && subtree != "/" &&
+            entry.relativePath != subtree && !entry.relativePath.startsWith(subtree + '/')) {
+            continue;
+        }
+        if (maxDepth >= 0 && entry.depth > maxDepth) continue;
+        selected.push_back(&entry);
+    }
+
+    auto weight = [&sortKey](const Entry* entry) -> double {
+        const Sample& cur = entry->current;
+        const Sample& prev = entry->previous;
+        if (sortKey == "memory") return static_cast<double>(cur.memoryCurrent);
+        if (sortKey == "pids") return static_cast<double>(cur.pidsCurrent);
+        if (!entry->hasPrevious) return 0.0;
+        if (sortKey == "io") {
+            return static_cast<double>(delta(cur.ioReadBytes, prev.ioReadBytes) +
+                                       delta(cur.ioWriteBytes, prev.ioWriteBytes));
+        }
+        return static_cast<double>(delta(cur.cpuUsageUsec, prev.cpuUsageUsec));
+    };
+    auto heavier = [&weight](const Entry* a, const Entry* b) { return weight(a) > weight(b); };
+
+    if (limit > 0 && static_cast<size_t>(limit) < selected.size()) {
+        std::partial_sort(selected.begin(), selected.begin() + limit, selected.end(), heavier);
+        selected.resize(limit);
+    } else {
+        std::sort(selected.begin(), selected.end(), heavier);
+    }
+
+    for (const Entry* entry : selected) result.append(toJson(*entry));
+    return result;
+}
+
+void CgroupMonitor::rescan()
+{
+    QSet<QString> seen;
+
+    auto visit = [this, &seen](const QString& absolutePath) {
+        QString relative = absolutePath.mid(rootPath.size());
+        if (relative.isEmpty()) relative = "/";
+        seen.insert(relative);
+
+        auto it = entries.find(relative);
+        if (it == entries.end()) {
+            Entry entry;
+            entry.relativePath = relative;
+            entry.depth = relative == "/" ? 0 : relative.count('/');
+            it = entries.insert(relative, entry);
+        }
+
+        // Набор контроллеров группы может меняться через cgroup.subtree_control
+        it->hasCpu = QFileInfo::exists(absolutePath + "/cpu.stat");
+        it->hasMemory = QFileInfo::exists(absolutePath + "/memory.current");
+        it->hasIo = QFileInfo::exists(absolutePath + "/io.stat");
+        it->hasPids = QFileInfo::exists(absolutePath + "/pids.current");
+    };
+
+    visit(rootPath);
+    QDirIterator it(rootPath, QDir::Dirs | QDir::NoDotAndDotDot | QDir::NoSymLinks,
+                    QDirIterator::Subdirectories);
+    while (it.hasNext()) visit(it.next());
+
+    for (auto entry = entries.begin(); entry != entries.end();) {
+        if (seen.contains(entry.key())) ++entry;
+        else entry = entries.erase(entry);
+    }
+}
+
+void CgroupMonitor::refresh()
+{
+    for (Entry& entry : entries) {
+        if (entry.hasSample) {
+            entry.previous = entry.current;
+            entry.hasPrevious = true;
+        }
+        readSample(entry);
+        entry.hasSample = true;
+    }
+}
+
+void CgroupMonitor::readSample(Entry& entry) const
+{
+    const QString dir = rootPath + (entry.relativePath == "/" ? QString() : entry.relativePath);
+    Sample sample;
+    sample.timestampMs = clock.elapsed();
+
+    if (entry.hasCpu) {
+        QHash<QByteArray, qulonglong> cpu = readKeyValues(dir + "/cpu.stat");
+        sample.cpuUsageUsec = cpu.value("usage_usec");
+        sample.cpuUserUsec = cpu.value("user_usec");
+        sample.cpuSystemUsec = cpu.value("system_usec");
+        sample.nrPeriods = cpu.value("nr_periods");
+        sample.nrThrottled = cpu.value("nr_throttled");
+        sample.throttledUsec = cpu.value("throttled_usec");
+    }
+
+    if (entry.hasMemory) {
+        sample.memoryCurrent = readSmallFile(dir + "/memory.current").trimmed().toULongLong();
+        sample.memoryMax = readLimit(dir + "/memory.max");
+        QHash<QByteArray, qulonglong> mem = readKeyValues(dir + "/memory.stat");
+        sample.memoryAnon = mem.value("anon");
+        sample.memoryFile = mem.value("file");
+        sample.pgMajFault = mem.value("pgmajfault");
+    }
+
+    if (entry.hasIo) {
+        // Строки вида "8:0 rbytes=... wbytes=... rios=... wios=..." суммируем по устройствам
+        for (const QByteArray& line : readSmallFile(dir + "/io.stat").split('\n')) {
+            for (const QByteArray& field : line.split(' ')) {
+                int eq = field.indexOf('=');
+                if (eq <= 0) continue;
+                const QByteArray key = field.left(eq);
+                const qulonglong value = field.mid(eq + 1).toULongLong();
+                if (key == "rbytes") sample.ioReadBytes += value;
+                else if (key == "wbytes") sample.ioWriteBytes += value;
+                else if (key == "rios") sample.ioReadOps += value;
+                else if (key == "wios") sample.ioWriteOps += value;
+            }
+        }
+    }
+
+    if (entry.hasPids) {
+        sample.pidsCurrent = readSmallFile(dir + "/pids.current").trimmed().toULongLong();
+        sample.pidsMax = readLimit(dir + "/pids.max");
+    }
+
+    entry.current = sample;
+}
+
+QJsonObject CgroupMonitor::toJson(const Entry& entry) const
+{
+    const Sample& cur = entry.current;
+    const Sample& prev = entry.previous;
+    const qint64 elapsedMs = entry.hasPrevious ? cur.timestampMs - prev.timestampMs : 0;
+
+    QJsonObject group;
+    group["path"] = entry.relativePath;
+    group["interval_ms"] = elapsedMs;
+
+    if (entry.hasCpu) {
+        QJsonObject cpu;
+        cpu["usage_usec"] = static_cast<qint64>(cur.cpuUsageUsec);
+        // Проценты относительно одного ядра, как в systemd-cgtop
+        cpu["usage_percent"] = ratePerSecond(cur.cpuUsageUsec, prev.cpuUsageUsec, elapsedMs) / 10000.0;
+        cpu["user_percent"] = ratePerSecond(cur.cpuUserUsec, prev.cpuUserUsec, elapsedMs) / 10000.0;
+        cpu["system_percent"] = ratePerSecond(cur.cpuSystemUsec, prev.cpuSystemUsec, elapsedMs) / 10000.0;
+        const qulonglong throttled = entry.hasPrevious ? delta(cur.nrThrottled, prev.nrThrottled) : 0;
+        const qulonglong periods = entry.hasPrevious ? delta(cur.nrPeriods, prev.nrPeriods) : 0;
+        cpu["nr_throttled"] = static_cast<qint64>(throttled);
+        cpu["throttled_usec"] = static_cast<qint64>(entry.hasPrevious ? delta(cur.throttledUsec, prev.throttledUsec) : 0);
+        cpu["throttled_percent"] = periods > 0 ? throttled * 100.0 / periods : 0.0;
+        group["cpu"] = cpu;
+    }
+
+    if (entry.hasMemory) {
+        QJsonObject memory;
+        memory["current"] = static_cast<qint64>(cur.memoryCurrent);
+        memory["max"] = cur.memoryMax;
+        memory["anon"] = static_cast<qint64>(cur.memoryAnon);
+        memory["file"] = static_cast<qint64>(cur.memoryFile);
+        memory["pgmajfault_per_sec"] = ratePerSecond(cur.pgMajFault, prev.pgMajFault, elapsedMs);
+        group["memory"] = memory;
+    }
+
+    if (entry.hasIo) {
+        QJsonObject io;
+        io["read_bytes_per_sec"] = ratePerSecond(cur.ioReadBytes, prev.ioReadBytes, elapsedMs);
+        io["write_bytes_per_sec"] = ratePerSecond(cur.ioWriteBytes, prev.ioWriteBytes, elapsedMs);
+        io["read_iops"] = ratePerSecond(cur.ioReadOps, prev.ioReadOps, elapsedMs);
+        io["write_iops"] = ratePerSecond(cur.ioWriteOps, prev.ioWriteOps, elapsedMs);
+        group["io"] = io;
+    }
+
+    if (entry.hasPids) {
+        QJsonObject pids;
+        pids["current"] = static_cast<qint64>(cur.pidsCurrent);
+        pids["max"] = cur.pidsMax;
+        group["pids"] = pids;
+    }
+
+    return group;
+}
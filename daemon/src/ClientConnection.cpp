@@ -1,59 +1,253 @@
 #include "ClientConnection.h"
 #include "Server.h"
+#include "LogTail.h"
+#include "ExecSession.h"
+#include "FileOperation.h"
+#include "SyncTarget.h"
+#include "AdmissionControl.h"
+#include "AccessControl.h"
+#include "DaemonMetrics.h"
+#include "ResourceGovernor.h"
 #include <QJsonDocument>
 #include <QJsonObject>
 #include <QJsonArray>
 #include <QJsonParseError>
 #include <QDebug>
-#include <QDataStream>
+#include <QFutureWatcher>
+#include <QtConcurrentRun>
+#include <QThreadPool>
+#include <QTimer>
+#include <QSslCertificate>
+
+namespace {
+
+//   JSON-RPC
+const int invalidParamsCode = -32602;
+const int methodNotFoundCode = -32601;
+const int serverErrorCode = -32000;
+const int busyCode = -32001;
+const int authenticationFailedCode = -32002;
+const int permissionDeniedCode = -32003;
+
+//        :
+//    ,    
+const qint64 outputHighWaterMark = 4 * 1024 * 1024;
+
+//       
+const int maxFileOperationsPerClient = 4;
+//    getFileAttributes/setFileAttributes
+const int maxAttributeBatch = 10000;
+
+// ,    TLS   , 
+const int handshakeTimeoutMs = 10000;
+
+void setError(QJsonObject& response, int code, const QString& message)
+{
+    QJsonObject error;
+    error["code"] = code;
+    error["message"] = message;
+    response["error"] = error;
+}
+
+void setBusy(QJsonObject& response, qint64 retryAfterMs, const QString& reason)
+{
+    QJsonObject error;
+    error["code"] = busyCode;
+    error["message"] = "Server busy: " + reason;
+    error["data"] = QJsonObject{{"retryAfterMs", qMax<qint64>(1, retryAfterMs)}};
+    response["error"] = error;
+}
+
+//      .   Server  
+//    ,     .
+QJsonObject executeExpensive(Server* server, const QString& method, const QJsonObject& params)
+{
+    QJsonObject outcome;
+    if (method == "getFileSystem") {
+        const QString path = params["path"].toString();
+        if (params.contains("etag")) {
+            //   :    ,    
+            //         
+            QJsonObject result;
+            result["etag"] = server->directoryEtag(path);
+            result["entries"] = server->getFileSystem(path, params["include"]);
+            outcome["result"] = result;
+        } else {
+            outcome["result"] = server->getFileSystem(path, params["include"]);
+        }
+    }
+    else if (method == "syncTree" || method == "syncTreeCommit") {
+        QString error;
+        const QJsonObject result = method == "syncTree" ? SyncTarget::compare(params, &error)
+                                                        : SyncTarget::commit(params, &error);
+        if (error.isEmpty()) outcome["result"] = result;
+        else setError(outcome, invalidParamsCode, error);
+    }
+    else if (method == "getFileAttributes" || method == "setFileAttributes") {
+        const QJsonArray items = params[method == "getFileAttributes" ? "paths" : "items"].toArray();
+        if (items.size() > maxAttributeBatch) {
+            setError(outcome, invalidParamsCode, QString("At most %1 paths per request").arg(maxAttributeBatch));
+        } else if (method == "getFileAttributes") {
+            outcome["result"] = server->getFileAttributes(items, params["include"]);
+        } else {
+            outcome["result"] = server->setFileAttributes(items);
+        }
+    }
+    else if (method == "getProcessList") {
+        QString error;
+        const QJsonArray processes = server->getProcessList(params, &error);
+        if (error.isEmpty()) outcome["result"] = processes;
+        else setError(outcome, invalidParamsCode, error);
+    }
+    else if (method == "getServiceList") {
+        outcome["result"] = server->getServiceList();
+    }
+    else if (method == "getServiceStatus") {
+        QString error;
+        const QJsonObject status = server->getServiceStatus(params["service"].toString(), &error);
+        if (error.isEmpty()) outcome["result"] = status;
+        else setError(outcome, invalidParamsCode, error);
+    }
+    else if (method == "uploadFile") {
+        QByteArray fileData = QByteArray::fromBase64(params["data"].toString().toUtf8());
+        bool success = server->uploadFile(params["remotePath"].toString(), fileData);
+        outcome["result"] = success;
+        if (!success) setError(outcome, serverErrorCode, "Failed to upload file");
+    }
+    else if (method == "downloadFile") {
+        QByteArray fileData = server->downloadFile(params["remotePath"].toString());
+        QJsonObject result;
+        result["data"] = QString::fromUtf8(fileData.toBase64());
+        outcome["result"] = result;
+    }
+    else {
+        setError(outcome, methodNotFoundCode, "Unknown method");
+    }
+    return outcome;
+}
+
+} // namespace
 
 ClientConnection::ClientConnection(Server* server, QObject* parent)
-    : QObject(parent), socket(nullptr), server(server), blockSize(0)
+    : QObject(parent),
+      socket(nullptr),
+      channel(nullptr),
+      server(server),
+      sessionRole(server->access()->anonymousRole()),
+      requestBucket(server->admission()->clientRatePerSecond(), server->admission()->clientBurst()),
+      expensiveInFlight(0),
+      nextSubscriptionId(1),
+      nextExecutionId(1),
+      nextFileOperationId(1)
 {
-    socket = new QTcpSocket(this);
-    connect(socket, &QTcpSocket::readyRead, this, &ClientConnection::onReadyRead);
-    connect(socket, &QTcpSocket::disconnected, this, &ClientConnection::disconnected);
+    //  TLS QSslSocket    TCP-
+    socket = new QSslSocket(this);
+    channel = new FrameChannel(socket, this);
+    channel->setOutputHighWaterMark(outputHighWaterMark);
+    channel->setMaxMessageSize(server->tuning().maxMessageSize);
+    connect(channel, &FrameChannel::messageReceived, this, &ClientConnection::onMessage);
+    connect(channel, &FrameChannel::protocolError, this, [](const QString& message) {
+        qWarning() << "Protocol error:" << message;
+    });
+    connect(socket, &QSslSocket::disconnected, this, &ClientConnection::disconnected);
+    connect(socket, &QSslSocket::encrypted, this, &ClientConnection::onEncrypted);
+    connect(socket, QOverload<const QList<QSslError>&>::of(&QSslSocket::sslErrors),
+            this, [this](const QList<QSslError>& errors) {
+        for (const QSslError& error : errors) {
+            qWarning() << "TLS error from" << socket->peerAddress().toString() << ":" << error.errorString();
+        }
+    });
 }
 
 bool ClientConnection::setSocketDescriptor(qintptr socketDescriptor)
 {
-    return socket->setSocketDescriptor(socketDescriptor);
+    if (!socket->setSocketDescriptor(socketDescriptor)) return false;
+    if (server->isTlsEnabled()) {
+        socket->setSslConfiguration(server->tlsConfiguration());
+        //         
+        QTimer::singleShot(handshakeTimeoutMs, this, [this]() {
+            if (!socket->isEncrypted()) socket->abort();
+        });
+        socket->startServerEncryption();
+    }
+    return true;
 }
 
-void ClientConnection::onReadyRead()
+void ClientConnection::onEncrypted()
 {
-    QDataStream in(socket);
-    in.setVersion(QDataStream::Qt_5_14);
-    in.setByteOrder(QDataStream::BigEndian);
-
-    while (socket->bytesAvailable() > 0) {
-        if (blockSize == 0) {
-            if (socket->bytesAvailable() < static_cast<int>(sizeof(quint32))) return;
-            in >> blockSize;
+    const QSslCertificate certificate = socket->peerCertificate();
+    if (!certificate.isNull()) identity = certificate.subjectInfo(QSslCertificate::CommonName).value(0);
+    // ,   CA ,    
+    if (socket->peerVerifyMode() == QSslSocket::VerifyPeer) {
+        const Role certificateRole = server->access()->roleForCertificate(identity);
+        if (certificateRole > sessionRole) {
+            sessionRole = certificateRole;
+            sessionUser = identity;
         }
+    }
+    qDebug() << "TLS session with" << socket->peerAddress().toString()
+             << socket->sessionCipher().name() << (identity.isEmpty() ? QString() : "as " + identity);
+}
 
-        if (socket->bytesAvailable() < blockSize) return;
+//       TLS;  loopback   
+bool ClientConnection::canReceiveSecrets() const
+{
+    return socket->isEncrypted() || socket->peerAddress().isLoopback() || server->allowsPlaintextSecrets();
+}
 
-        QByteArray data;
-        data.resize(blockSize);
-        in.readRawData(data.data(), blockSize);
-        blockSize = 0;
+//     hello.  ,    
+// ,         
+void ClientConnection::authenticate(const QJsonObject& params, QJsonObject& response)
+{
+    const QByteArray expected = challenge;
+    challenge.clear();
+    const QString user = params["user"].toString();
+    const Role granted = expected.isEmpty() ? Role::None
+        : server->access()->verify(user, expected, QByteArray::fromBase64(params["proof"].toString().toLatin1()));
 
-        QJsonParseError parseError;
-        QJsonDocument doc = QJsonDocument::fromJson(data, &parseError);
-        if (parseError.error != QJsonParseError::NoError) {
-            qWarning() << "JSON parse error:" << parseError.errorString();
-            continue;
-        }
+    if (granted == Role::None) {
+        qWarning() << "Authentication failed for" << user << "from" << socket->peerAddress().toString();
+        setError(response, authenticationFailedCode, "Authentication failed");
+        return;
+    }
+    sessionRole = granted;
+    sessionUser = user;
+    response["result"] = QJsonObject{{"user", user}, {"role", AccessControl::roleName(granted)}};
+}
 
-        if (doc.isObject()) {
-            processRequest(doc.object());
-        }
+void ClientConnection::onMessage(const QByteArray& data)
+{
+    server->metrics()->addBytesIn(data.size());
+
+    QJsonParseError parseError;
+    QJsonDocument doc = QJsonDocument::fromJson(data, &parseError);
+    if (parseError.error != QJsonParseError::NoError) {
+        qWarning() << "JSON parse error:" << parseError.errorString();
+        return;
+    }
+
+    if (doc.isObject()) {
+        processRequest(doc.object());
     }
 }
 
+QStringList ClientConnection::methods()
+{
+    return {
+        "hello", "getSystemInfo", "getUserList", "getFileSystem", "getProcessList",
+        "addUser", "removeUser", "changeUserPassword", "setFilePermissions", "manageService",
+        "uploadFile", "downloadFile", "getServiceList", "getServiceStatus", "getCgroupStats",
+        "getNetworkStats", "getDiskStats", "getDaemonStats", "tailFile", "followJournal", "unsubscribe",
+        "authenticate", "exec", "cancelExec", "fileOperation", "cancelFileOperation",
+        "getFileAttributes", "setFileAttributes", "syncTree", "syncTreeCommit", "getResourceLimits"
+    };
+}
+
 void ClientConnection::processRequest(const QJsonObject& request) //  
 {
+    QElapsedTimer timer;
+    timer.start();
+
     QJsonObject response;
     response["jsonrpc"] = "2.0";
     response["id"] = request["id"];
@@ -61,31 +255,94 @@ void ClientConnection::processRequest(const QJsonObject& request) // 
     QString method = request["method"].toString();
     QJsonObject params = request["params"].toObject();
 
+    //  :   hello       
+    if (method == "hello") {
+        QJsonObject result;
+        result["multiplex"] = params["multiplex"].toBool();
+        result["chunkSize"] = FrameChannel::chunkSize;
+        result["initialWindow"] = FrameChannel::initialWindow;
+        if (server->access()->isEnabled()) {
+            challenge = AccessControl::makeChallenge();
+            QJsonObject auth;
+            auth["mechanism"] = "hmac-sha256";
+            auth["challenge"] = QString::fromLatin1(challenge.toBase64());
+            auth["role"] = AccessControl::roleName(sessionRole);
+            if (!sessionUser.isEmpty()) auth["user"] = sessionUser;
+            result["auth"] = auth;
+        }
+        response["result"] = result;
+        finishRequest(method, response, timer); //     ,    
+        channel->setMultiplexing(result["multiplex"].toBool());
+        return;
+    }
+
+    //     ,  stat()  etag
+    if (!server->access()->isAllowed(sessionRole, method)) {
+        setError(response, permissionDeniedCode, QString("Permission denied: %1 requires role %2")
+                 .arg(method, AccessControl::roleName(server->access()->requiredRole(method))));
+        finishRequest(method, response, timer);
+        return;
+    }
+
+    //      :   stat(),  
+    //        
+    const QString etag = params["etag"].toString();
+    const bool notModified = method == "getFileSystem" && !etag.isEmpty()
+        && server->directoryEtag(params["path"].toString()) == etag;
+
+    qint64 retryAfterMs = 0;
+    if (!admit(method, retryAfterMs, !notModified)) {
+        setBusy(response, retryAfterMs, "rate limit exceeded");
+        finishRequest(method, response, timer);
+        return;
+    }
+    if (method == "authenticate") {
+        authenticate(params, response);
+        finishRequest(method, response, timer);
+        if (response.contains("error")) socket->disconnectFromHost();
+        return;
+    }
+    if (notModified) {
+        response["result"] = QJsonObject{{"notModified", true}, {"etag", etag}};
+        finishRequest(method, response, timer);
+        return;
+    }
+    //    cgroup   ,   
+    const AdmissionControl::MethodPolicy policy = server->admission()->policy(method);
+    if (policy.background && server->governor()->isShedding()) {
+        server->governor()->requestShed();
+        setBusy(response, server->governor()->shedRetryAfterMs(), "near resource limits, background work deferred");
+        finishRequest(method, response, timer);
+        return;
+    }
+    if (policy.expensive) {
+        processExpensive(method, params, response, timer);
+        return;
+    }
+    if ((method == "addUser" || method == "changeUserPassword") && !canReceiveSecrets()) {
+        setError(response, serverErrorCode, "Passwords are accepted only over TLS");
+        finishRequest(method, response, timer);
+        return;
+    }
+
 	if (method == "getSystemInfo") { //    switch case 
         response["result"] = server->getSystemInfo();
     }
     else if (method == "getUserList") {
         response["result"] = QJsonArray::fromStringList(server->getUserList());
     }
-    else if (method == "getFileSystem") {
-        QString path = params["path"].toString();
-        response["result"] = server->getFileSystem(path);
-    }
-    else if (method == "getProcessList") {
-        response["result"] = server->getProcessList();
-    }
     else if (method == "addUser") {
         bool success = server->addUser(
             params["username"].toString(),
             params["password"].toString()
         );
         response["result"] = success;
-        if (!success) response["error"] = "Failed to add user";
+        if (!success) setError(response, serverErrorCode, "Failed to add user");
     }
     else if (method == "removeUser") {
         bool success = server->removeUser(params["username"].toString());
         response["result"] = success;
-        if (!success) response["error"] = "Failed to remove user";
+        if (!success) setError(response, serverErrorCode, "Failed to remove user");
     }
     else if (method == "changeUserPassword") {
         bool success = server->changeUserPassword(
@@ -93,7 +350,7 @@ void ClientConnection::processRequest(const QJsonObject& request) // 
             params["password"].toString()
         );
         response["result"] = success;
-        if (!success) response["error"] = "Failed to change password";
+        if (!success) setError(response, serverErrorCode, "Failed to change password");
     }
     else if (method == "setFilePermissions") {
         bool success = server->setFilePermissions(
@@ -101,7 +358,7 @@ void ClientConnection::processRequest(const QJsonObject& request) // 
             params["permissions"].toString()
         );
         response["result"] = success;
-        if (!success) response["error"] = "Failed to set permissions";
+        if (!success) setError(response, serverErrorCode, "Failed to set permissions");
     }
     else if (method == "manageService") {
         bool success = server->manageService(
@@ -109,46 +366,322 @@ void ClientConnection::processRequest(const QJsonObject& request) // 
             params["action"].toString()
         );
         response["result"] = success;
-        if (!success) response["error"] = "Failed to manage service";
+        if (!success) setError(response, serverErrorCode, "Failed to manage service");
     }
-    else if (method == "uploadFile") {
-        QByteArray fileData = QByteArray::fromBase64(params["data"].toString().toUtf8());
-        bool success = server->uploadFile(
-            params["remotePath"].toString(),
-            fileData
-        );
-        response["result"] = success;
-        if (!success) response["error"] = "Failed to upload file";
+    else if (method == "getCgroupStats") {
+        response["result"] = server->getCgroupStats(params);
     }
-    else if (method == "downloadFile") {
-        QByteArray fileData = server->downloadFile(params["remotePath"].toString());
-        QJsonObject result;
-        result["data"] = QString::fromUtf8(fileData.toBase64());
-        response["result"] = result;
+    else if (method == "getNetworkStats") {
+        response["result"] = server->getNetworkStats();
     }
-    else if (method == "getServiceList") {
-        response["result"] = server->getServiceList();
+    else if (method == "getDiskStats") {
+        response["result"] = server->getDiskStats();
+    }
+    else if (method == "getDaemonStats") {
+        response["result"] = server->getDaemonStats();
+    }
+    else if (method == "getResourceLimits") {
+        response["result"] = server->getResourceLimits();
+    }
+    else if (method == "tailFile") {
+        addSubscription(new FileTailStream(
+            nextSubscriptionId,
+            params["path"].toString(),
+            params["backlogBytes"].toVariant().toLongLong(),
+            params["filter"].toString(),
+            params["maxBytesPerSecond"].toInt(256 * 1024),
+            this), response);
+    }
+    else if (method == "followJournal") {
+        QStringList units;
+        for (const QJsonValue& unit : params["units"].toArray()) units << unit.toString();
+        addSubscription(new JournalStream(
+            nextSubscriptionId,
+            units,
+            params["lines"].toInt(50),
+            params["filter"].toString(),
+            params["maxBytesPerSecond"].toInt(256 * 1024),
+            this), response);
+    }
+    else if (method == "exec") {
+        startExec(params, response);
+    }
+    else if (method == "cancelExec") {
+        ExecSession* session = executions.value(params["execution"].toInt());
+        response["result"] = session != nullptr;
+        if (session) session->cancel();
+        else setError(response, invalidParamsCode, "Unknown execution");
+    }
+    else if (method == "fileOperation") {
+        startFileOperation(params, response);
+    }
+    else if (method == "cancelFileOperation") {
+        FileOperation* operation = fileOperations.value(params["operation"].toInt());
+        response["result"] = operation != nullptr;
+        if (operation) operation->cancel();
+        else setError(response, invalidParamsCode, "Unknown file operation");
+    }
+    else if (method == "unsubscribe") {
+        LogStream* stream = subscriptions.take(params["subscription"].toInt());
+        response["result"] = stream != nullptr;
+        suppressedBytes.remove(params["subscription"].toInt());
+        if (stream) stream->deleteLater();
+        else setError(response, invalidParamsCode, "Unknown subscription");
     }
     else {
-        response["error"] = "Unknown method";
+        setError(response, methodNotFoundCode, "Unknown method");
+    }
+
+    finishRequest(method, response, timer);
+}
+
+//   ,   ;      .
+//   (methodLimit == false)    
+bool ClientConnection::admit(const QString& method, qint64& retryAfterMs, bool methodLimit)
+{
+    AdmissionControl* admission = server->admission();
+    const qint64 now = admission->now();
+    if (!requestBucket.tryTake(now)) {
+        retryAfterMs = requestBucket.msUntilAvailable(now);
+        return false;
     }
 
-    sendResponse(response);
+    if (!methodLimit) return true;
+    const AdmissionControl::MethodPolicy policy = admission->policy(method);
+    if (policy.ratePerSecond <= 0.0) return true;
+
+    auto it = methodBuckets.find(method);
+    if (it == methodBuckets.end()) {
+        it = methodBuckets.insert(method, TokenBucket(policy.ratePerSecond, policy.burst));
+    }
+    if (!it->tryTake(now)) {
+        retryAfterMs = it->msUntilAvailable(now);
+        return false;
+    }
+    return true;
 }
 
-void ClientConnection::sendResponse(const QJsonObject& response)
+void ClientConnection::processExpensive(const QString& method, const QJsonObject& params, QJsonObject response,
+                                        const QElapsedTimer& timer)
 {
-    QJsonDocument doc(response);
-    QByteArray data = doc.toJson(QJsonDocument::Compact);
+    AdmissionControl* admission = server->admission();
+    //     ,      
+    const bool background = admission->policy(method).background;
+    if (expensiveInFlight >= admission->maxExpensivePerClient()
+        || !(background ? admission->tryStartBackground() : admission->tryStartExpensive())) {
+        setBusy(response, admission->busyRetryAfterMs(), "too many concurrent operations");
+        finishRequest(method, response, timer);
+        return;
+    }
 
-    QByteArray packet;
-    quint32 len = data.size();
-    QDataStream out(&packet, QIODevice::WriteOnly);
-    out.setByteOrder(QDataStream::BigEndian);
-    out << len;
-    packet.append(data);
+    const FrameChannel::Priority priority = method == "downloadFile" ? FrameChannel::Bulk : FrameChannel::Interactive;
+    ++expensiveInFlight;
+
+    //    , watcher    ,  
+    //     
+    auto* watcher = new QFutureWatcher<QJsonObject>(this);
+    connect(watcher, &QFutureWatcher<QJsonObject>::finished, this, [this, watcher, method, response, timer, priority]() mutable {
+        --expensiveInFlight;
+        const QJsonObject outcome = watcher->result();
+        for (auto it = outcome.constBegin(); it != outcome.constEnd(); ++it) {
+            response[it.key()] = it.value();
+        }
+        watcher->deleteLater();
+        finishRequest(method, response, timer, priority);
+    });
+
+    //          
+    QThreadPool* pool = background ? server->governor()->backgroundPool() : QThreadPool::globalInstance();
+    Server* target = server;
+    watcher->setFuture(QtConcurrent::run(pool, [target, admission, method, params, background]() {
+        if (background) ResourceGovernor::enterBackground();
+        QJsonObject outcome = executeExpensive(target, method, params);
+        if (background) admission->finishBackground();
+        else admission->finishExpensive();
+        return outcome;
+    }));
+}
+
+//           
+void ClientConnection::finishRequest(const QString& method, const QJsonObject& response,
+                                     const QElapsedTimer& timer, FrameChannel::Priority priority)
+{
+    DaemonMetrics::Outcome outcome = DaemonMetrics::Outcome::Ok;
+    if (response.contains("error")) {
+        outcome = response["error"].toObject()["code"].toInt() == busyCode
+            ? DaemonMetrics::Outcome::Busy : DaemonMetrics::Outcome::Error;
+    }
+    server->metrics()->recordRequest(method, timer.nsecsElapsed() / 1000, outcome);
+    sendResponse(response, priority);
+}
+
+void ClientConnection::sendResponse(const QJsonObject& response, FrameChannel::Priority priority)
+{
+    const QByteArray message = QJsonDocument(response).toJson(QJsonDocument::Compact);
+    server->metrics()->addBytesOut(message.size());
+    channel->sendMessage(message, priority);
+}
+
+bool ClientConnection::addSubscription(LogStream* stream, QJsonObject& response)
+{
+    const int maxSubscriptions = 16;
+    if (!stream->isValid() || subscriptions.size() >= maxSubscriptions) {
+        if (stream->isValid()) setBusy(response, 1000, "too many subscriptions");
+        else setError(response, invalidParamsCode, stream->errorString());
+        delete stream;
+        return false;
+    }
+
+    connect(stream, &LogStream::dataReady, this, &ClientConnection::onLogData);
+    connect(stream, &LogStream::closed, this, &ClientConnection::onLogClosed);
+    subscriptions.insert(stream->id(), stream);
+
+    QJsonObject result;
+    result["subscription"] = nextSubscriptionId++;
+    response["result"] = result;
+    return true;
+}
+
+//  JSON-RPC  id:       
+void ClientConnection::sendNotification(const QString& method, const QJsonObject& params)
+{
+    QJsonObject notification;
+    notification["jsonrpc"] = "2.0";
+    notification["method"] = method;
+    notification["params"] = params;
+    sendResponse(notification, FrameChannel::Normal);
+}
 
-    socket->write(packet);
+void ClientConnection::onLogData(int subscriptionId, const QByteArray& data, qint64 droppedBytes)
+{
+    //     :      
+    if (channel->pendingOutput() > outputHighWaterMark) {
+        suppressedBytes[subscriptionId] += data.size() + droppedBytes;
+        return;
+    }
+
+    QJsonObject params;
+    params["subscription"] = subscriptionId;
+    params["data"] = QString::fromUtf8(data);
+    params["dropped"] = droppedBytes + suppressedBytes.take(subscriptionId);
+    sendNotification("logData", params);
+}
+
+void ClientConnection::onLogClosed(int subscriptionId, const QString& reason)
+{
+    LogStream* stream = subscriptions.take(subscriptionId);
+    if (!stream) return;
+    stream->deleteLater();
+    suppressedBytes.remove(subscriptionId);
+
+    QJsonObject params;
+    params["subscription"] = subscriptionId;
+    params["reason"] = reason;
+    sendNotification("logClosed", params);
+}
+
+//    :   id ,    - 
+void ClientConnection::startExec(const QJsonObject& params, QJsonObject& response)
+{
+    ExecPolicy* policy = server->execPolicy();
+    if (!policy->isEnabled()) {
+        setError(response, serverErrorCode, "exec is disabled on this host");
+        return;
+    }
+    const ExecPolicy::Options& options = policy->options();
+
+    ExecPolicy::Command command;
+    const QString name = params["command"].toString();
+    if (!policy->resolve(name, &command)) {
+        setError(response, invalidParamsCode, "Command is not allowed: " + name);
+        return;
+    }
+    const QJsonArray extra = params["args"].toArray();
+    if (!extra.isEmpty() && !options.allowExtraArguments) {
+        setError(response, invalidParamsCode, "Extra arguments are not allowed");
+        return;
+    }
+    for (const QJsonValue& arg : extra) command.arguments << arg.toString();
+
+    if (executions.size() >= options.maxPerClient || !policy->tryAcquire()) {
+        setBusy(response, 1000, "too many running commands");
+        return;
+    }
+
+    const int requested = params["timeoutMs"].toInt(options.defaultTimeoutMs);
+    const int timeoutMs = qBound(1, requested, options.maxTimeoutMs);
+    ExecSession* session = new ExecSession(nextExecutionId++, policy, command, timeoutMs, this);
+    connect(session, &ExecSession::output, this, &ClientConnection::onExecOutput);
+    // Queued:       start(),      
+    connect(session, &ExecSession::finished, this, &ClientConnection::onExecFinished, Qt::QueuedConnection);
+    executions.insert(session->id(), session);
+    session->start();
+
+    response["result"] = QJsonObject{{"execution", session->id()}, {"timeoutMs", timeoutMs}};
+}
+
+void ClientConnection::onExecOutput(int executionId, const QString& stream, const QByteArray& data)
+{
+    //    :     ,  
+    if (channel->pendingOutput() > outputHighWaterMark) {
+        suppressedExecBytes[executionId] += data.size();
+        return;
+    }
+
+    QJsonObject params;
+    params["execution"] = executionId;
+    params["stream"] = stream;
+    params["data"] = QString::fromUtf8(data);
+    const qint64 dropped = suppressedExecBytes.take(executionId);
+    if (dropped > 0) params["dropped"] = dropped;
+    sendNotification("execOutput", params);
+}
+
+void ClientConnection::onExecFinished(int executionId, const QJsonObject& summary)
+{
+    ExecSession* session = executions.take(executionId);
+    if (session) session->deleteLater();
+
+    QJsonObject params = summary;
+    params["droppedBytes"] = summary["droppedBytes"].toDouble() + suppressedExecBytes.take(executionId);
+    sendNotification("execFinished", params);
+}
+
+//      :   id ,    - 
+void ClientConnection::startFileOperation(const QJsonObject& params, QJsonObject& response)
+{
+    if (fileOperations.size() >= maxFileOperationsPerClient) {
+        setBusy(response, 1000, "too many running file operations");
+        return;
+    }
+
+    FileOperation* operation = new FileOperation(nextFileOperationId++, params, this);
+    if (!operation->isValid()) {
+        setError(response, invalidParamsCode, operation->errorString());
+        delete operation;
+        return;
+    }
+    connect(operation, &FileOperation::progress, this, &ClientConnection::onFileOperationProgress);
+    connect(operation, &FileOperation::finished, this, &ClientConnection::onFileOperationFinished);
+    fileOperations.insert(operation->id(), operation);
+    operation->start();
+
+    response["result"] = QJsonObject{{"operation", operation->id()}};
+}
+
+void ClientConnection::onFileOperationProgress(int operationId, const QJsonObject& state)
+{
+    Q_UNUSED(operationId)
+    //    ,      
+    if (channel->pendingOutput() > outputHighWaterMark) return;
+    sendNotification("fileOperationProgress", state);
+}
+
+void ClientConnection::onFileOperationFinished(int operationId, const QJsonObject& summary)
+{
+    FileOperation* operation = fileOperations.take(operationId);
+    if (operation) operation->deleteLater();
+    sendNotification("fileOperationFinished", summary);
 }
 
 void ClientConnection::onDisconnected()
@@ -0,0 +1,214 @@
+#include "DaemonConfig.h"
+#include "AsyncLogger.h"
+#include "AdmissionControl.h"
+#include "AccessControl.h"
+#include "FileOperation.h"
+#include <QSettings>
+#include <QFileSystemWatcher>
+#include <QSocketNotifier>
+#include <QFileInfo>
+#include <QDir>
+#include <QTimer>
+#include <QThread>
+#include <QThreadPool>
+
+#ifdef Q_OS_UNIX
+#include <signal.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#endif
+
+namespace {
+
+// Редактор сохраняет файл в несколько приёмов; перечитываем, когда всё утихнет
+const int reloadSettleMs = 500;
+
+// Эти секции читаются только при старте (см. main.cpp)
+const QStringList startupOnlyGroups = { "server", "tls", "exec", "execCommands", "metrics", "permissions" };
+const QStringList startupOnlyKeys = { "auth/enabled", "auth/anonymousRole" };
+
+#ifdef Q_OS_UNIX
+// Обработчику сигнала можно только записать байт; остальное делается в цикле событий
+int hangupFds[2] = { -1, -1 };
+
+void hangupHandler(int)
+{
+    const char byte = 1;
+    const ssize_t written = ::write(hangupFds[0], &byte, sizeof(byte));
+    Q_UNUSED(written)
+}
+#endif
+
+} // namespace
+
+DaemonConfig::DaemonConfig(Server* server, QObject* parent)
+    : QObject(parent),
+      server(server),
+      applied(false),
+      fileSize(-1),
+      watcher(nullptr),
+      settleTimer(nullptr),
+      hangupNotifier(nullptr)
+{
+    QSettings settings;
+    fileName = settings.fileName();
+    startupValues = startupOnlyValues(settings);
+    const QFileInfo info(fileName);
+    fileModified = info.lastModified();
+    fileSize = info.exists() ? info.size() : -1;
+}
+
+DaemonConfig::Options DaemonConfig::read(QSettings& settings)
+{
+    Options options;
+    Server::Tuning& tuning = options.tuning;
+    tuning.maxClients = qMax(1, settings.value("limits/maxClients", tuning.maxClients).toInt());
+    tuning.maxMessageSize = qMax<qint64>(1, settings.value("limits/maxFrameMb", tuning.maxMessageSize / (1024 * 1024)).toLongLong())
+        * 1024 * 1024;
+    tuning.etagSettleMs = qMax(0, settings.value("cache/etagSettleMs", tuning.etagSettleMs).toInt());
+    tuning.cgroupRefreshMs = qMax(0, settings.value("sampling/cgroupRefreshMs", tuning.cgroupRefreshMs).toInt());
+    tuning.cgroupRescanMs = qMax(0, settings.value("sampling/cgroupRescanMs", tuning.cgroupRescanMs).toInt());
+    tuning.networkMinIntervalMs = qMax(0, settings.value("sampling/networkMs", tuning.networkMinIntervalMs).toInt());
+    tuning.diskMinIntervalMs = qMax(0, settings.value("sampling/diskMs", tuning.diskMinIntervalMs).toInt());
+
+    options.workerThreads = qMax(0, settings.value("threads/workers", options.workerThreads).toInt());
+    options.maxExpensive = qMax(0, settings.value("threads/maxExpensive", options.maxExpensive).toInt());
+    options.fileOperationThreads = qMax(0, settings.value("threads/fileOperations", options.fileOperationThreads).toInt());
+
+    options.logLevel = settings.value("log/level", options.logLevel).toString();
+    options.nice = qBound(-20, settings.value("process/nice", options.nice).toInt(), 19);
+    options.ioClass = settings.value("process/ioClass", options.ioClass).toString();
+    options.ioLevel = qBound(0, settings.value("process/ioLevel", options.ioLevel).toInt(), 7);
+    options.usersFile = settings.value("auth/usersFile", options.usersFile).toString();
+
+    ResourceGovernor::Options& resources = options.resources;
+    resources.cgroup = settings.value("resources/cgroup", resources.cgroup).toString();
+    resources.cpuQuota = settings.value("resources/cpuQuota", resources.cpuQuota).toString();
+    resources.memoryMax = settings.value("resources/memoryMax", resources.memoryMax).toString();
+    resources.memoryHigh = settings.value("resources/memoryHigh", resources.memoryHigh).toString();
+    resources.background = settings.value("resources/background", resources.background).toString();
+    resources.backgroundIoClass = settings.value("resources/backgroundIoClass", resources.backgroundIoClass).toString();
+    resources.shedPercent = qBound(10, settings.value("resources/shedPercent", resources.shedPercent).toInt(), 100);
+    return options;
+}
+
+void DaemonConfig::apply(const Options& options)
+{
+    server->setTuning(options.tuning);
+    server->admission()->setMaxExpensive(options.maxExpensive);
+    QThreadPool::globalInstance()->setMaxThreadCount(
+        options.workerThreads > 0 ? options.workerThreads : QThread::idealThreadCount());
+    FileOperation::setWorkerThreads(options.fileOperationThreads);
+    AsyncLogger::setLevel(options.logLevel);
+    server->governor()->setOptions(options.resources);
+
+    // Приоритет трогаем, только если его просили: понизить nice обратно может лишь root
+    const bool priorityRequested = options.nice != 0 || !options.ioClass.isEmpty();
+    const bool priorityChanged = options.nice != current.nice || options.ioClass != current.ioClass
+        || options.ioLevel != current.ioLevel;
+    if (applied ? priorityChanged : priorityRequested) {
+        QString error;
+        if (ResourceGovernor::setProcessPriority(options.nice, options.ioClass, options.ioLevel, &error)) {
+            qCInfo(lcServer) << "Process priority: nice" << options.nice << "io class"
+                             << (options.ioClass.isEmpty() ? QString("default") : options.ioClass) << options.ioLevel;
+        } else {
+            qCWarning(lcServer) << "Cannot set process priority:" << error;
+        }
+    }
+
+    // Пользователи при старте загружаются в main.cpp; здесь - только при перечитывании
+    AccessControl* access = server->access();
+    if (applied && access->isEnabled()) {
+        QString authError;
+        if (!access->loadUsers(options.usersFile, &authError)) {
+            qCWarning(lcServer) << "Users not reloaded, keeping the previous list:" << authError;
+        }
+    }
+
+    current = options;
+    applied = true;
+}
+
+void DaemonConfig::reload()
+{
+    QSettings settings;
+    settings.sync();
+    if (settings.status() != QSettings::NoError) {
+        qCWarning(lcServer) << "Cannot read configuration" << fileName << "- keeping the current settings";
+        return;
+    }
+    if (startupOnlyValues(settings) != startupValues) {
+        qCWarning(lcServer) << "Changes to server, tls, auth, exec, metrics or permissions settings take effect after restart";
+    }
+    apply(read(settings));
+    qCInfo(lcServer) << "Configuration reloaded from" << fileName;
+    emit reloaded();
+}
+
+void DaemonConfig::watch()
+{
+#ifdef Q_OS_UNIX
+    if (::socketpair(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0, hangupFds) == 0) {
+        hangupNotifier = new QSocketNotifier(hangupFds[1], QSocketNotifier::Read, this);
+        connect(hangupNotifier, &QSocketNotifier::activated, this, &DaemonConfig::onHangup);
+        struct sigaction action = {};
+        action.sa_handler = hangupHandler;
+        sigemptyset(&action.sa_mask);
+        action.sa_flags = SA_RESTART;
+        ::sigaction(SIGHUP, &action, nullptr);
+    } else {
+        qCWarning(lcServer) << "SIGHUP reload unavailable: socketpair failed";
+    }
+#endif
+
+    // Каталог тоже под наблюдением: редакторы сохраняют через переименование,
+    // и после этого наблюдение за самим файлом теряется
+    settleTimer = new QTimer(this);
+    settleTimer->setSingleShot(true);
+    settleTimer->setInterval(reloadSettleMs);
+    connect(settleTimer, &QTimer::timeout, this, &DaemonConfig::onPathChanged);
+
+    watcher = new QFileSystemWatcher(this);
+    const QFileInfo info(fileName);
+    if (QDir(info.absolutePath()).exists()) watcher->addPath(info.absolutePath());
+    if (info.exists()) watcher->addPath(info.absoluteFilePath());
+    connect(watcher, &QFileSystemWatcher::fileChanged, settleTimer, QOverload<>::of(&QTimer::start));
+    connect(watcher, &QFileSystemWatcher::directoryChanged, settleTimer, QOverload<>::of(&QTimer::start));
+}
+
+void DaemonConfig::onHangup()
+{
+#ifdef Q_OS_UNIX
+    char byte;
+    const ssize_t received = ::read(hangupFds[1], &byte, sizeof(byte));
+    Q_UNUSED(received)
+#endif
+    qCInfo(lcServer) << "SIGHUP received";
+    reload();
+}
+
+void DaemonConfig::onPathChanged()
+{
+    const QFileInfo info(fileName);
+    if (info.exists() && !watcher->files().contains(info.absoluteFilePath())) watcher->addPath(info.absoluteFilePath());
+
+    // Соседние файлы каталога тоже будят наблюдателя; сам файл мог не измениться
+    const qint64 size = info.exists() ? info.size() : -1;
+    if (size == fileSize && info.lastModified() == fileModified) return;
+    fileSize = size;
+    fileModified = info.lastModified();
+    if (size < 0) return; // удалён: ждём, пока появится снова
+    reload();
+}
+
+QVariantMap DaemonConfig::startupOnlyValues(QSettings& settings)
+{
+    QVariantMap values;
+    for (const QString& group : startupOnlyGroups) {
+        settings.beginGroup(group);
+        for (const QString& key : settings.childKeys()) values.insert(group + '/' + key, settings.value(key));
+        settings.endGroup();
+    }
+    for (const QString& key : startupOnlyKeys) values.insert(key, settings.value(key));
+    return values;
+}
@@ -0,0 +1,331 @@
+#include "DaemonMetrics.h"
+#include "Server.h"
+#include <QTcpSocket>
+#include <QFile>
+#include <QDir>
+#include <QJsonArray>
+#include <QtAlgorithms>
+
+#ifdef Q_OS_LINUX
+#include <unistd.h>
+#endif
+
+namespace {
+
+const QString otherMethod = "other";
+const int maxHttpRequestSize = 8192;
+
+// Границы корзин для экспорта: степени двойки от 16 мкс до ~33 с
+const int firstExportExponent = 4;
+const int lastExportExponent = 25;
+
+QString formatSeconds(quint64 micros)
+{
+    return QString::number(micros / 1e6, 'g', 10);
+}
+
+} // namespace
+
+// ========== LatencyHistogram ==========
+
+LatencyHistogram::LatencyHistogram()
+    : total(0), sum(0), maximum(0)
+{
+    for (QAtomicInteger<quint64>& bucket : buckets) bucket.storeRelaxed(0);
+}
+
+// Значения меньше subBuckets лежат каждое в своей корзине, дальше каждая
+// степень двойки делится на subBuckets равных частей. Корзины включают верхнюю
+// границу, а не нижнюю - (L, U], как le у Prometheus: 2^n попадает в корзину,
+// которая на 2^n заканчивается
+int LatencyHistogram::bucketIndex(quint64 value)
+{
+    if (value > 0) --value;
+    if (value < static_cast<quint64>(subBuckets)) return static_cast<int>(value);
+    const int exponent = 63 - qCountLeadingZeroBits(value);
+    const int sub = static_cast<int>((value >> (exponent - subBucketBits)) & (subBuckets - 1));
+    return (exponent - subBucketBits + 1) * subBuckets + sub;
+}
+
+quint64 LatencyHistogram::bucketUpperBound(int index)
+{
+    if (index < subBuckets) return static_cast<quint64>(index) + 1;
+    const int exponent = index / subBuckets + subBucketBits - 1;
+    const quint64 sub = static_cast<quint64>(index % subBuckets);
+    const quint64 next = (static_cast<quint64>(subBuckets) + sub + 1) << (exponent - subBucketBits);
+    return next == 0 ? ~quint64(0) : next;
+}
+
+void LatencyHistogram::record(quint64 micros)
+{
+    buckets[bucketIndex(micros)].fetchAndAddRelaxed(1);
+    total.fetchAndAddRelaxed(1);
+    sum.fetchAndAddRelaxed(micros);
+
+    quint64 current = maximum.loadRelaxed();
+    while (micros > current && !maximum.testAndSetRelaxed(current, micros, current)) {}
+}
+
+quint64 LatencyHistogram::percentile(double q) const
+{
+    const quint64 n = count();
+    if (n == 0) return 0;
+
+    const quint64 rank = qMax<quint64>(1, static_cast<quint64>(q * n + 0.5));
+    quint64 seen = 0;
+    for (int i = 0; i < bucketCount; ++i) {
+        seen += buckets[i].loadRelaxed();
+        if (seen >= rank) return qMin(bucketUpperBound(i), maxMicros());
+    }
+    return maxMicros();
+}
+
+quint64 LatencyHistogram::countAtMost(quint64 bound) const
+{
+    quint64 result = 0;
+    for (int i = 0; i < bucketCount && bucketUpperBound(i) <= bound; ++i) {
+        result += buckets[i].loadRelaxed();
+    }
+    return result;
+}
+
+// ========== DaemonMetrics ==========
+
+DaemonMetrics::DaemonMetrics(const QStringList& methodNames, QObject* parent)
+    : QObject(parent),
+      bytesIn(0),
+      bytesOut(0),
+      connectionsAccepted(0),
+      connectionsRejected(0),
+      startTime(QDateTime::currentDateTimeUtc())
+{
+    for (const QString& method : methodNames) {
+        methods.insert(method, new MethodStats());
+    }
+    methods.insert(otherMethod, new MethodStats());
+    uptime.start();
+}
+
+DaemonMetrics::~DaemonMetrics()
+{
+    qDeleteAll(methods);
+}
+
+DaemonMetrics::MethodStats* DaemonMetrics::statsFor(const QString& method) const
+{
+    MethodStats* stats = methods.value(method);
+    return stats ? stats : methods.value(otherMethod);
+}
+
+void DaemonMetrics::recordRequest(const QString& method, qint64 micros, Outcome outcome)
+{
+    MethodStats* stats = statsFor(method);
+    if (outcome == Outcome::Busy) {
+        stats->busy.fetchAndAddRelaxed(1);
+        return;
+    }
+    stats->latency.record(static_cast<quint64>(qMax<qint64>(0, micros)));
+    if (outcome == Outcome::Error) stats->errors.fetchAndAddRelaxed(1);
+}
+
+DaemonMetrics::ProcessStats DaemonMetrics::readProcessStats() const
+{
+    ProcessStats stats;
+#ifdef Q_OS_LINUX
+    const long pageSize = sysconf(_SC_PAGESIZE);
+    const long ticksPerSecond = sysconf(_SC_CLK_TCK);
+
+    QFile statm("/proc/self/statm");
+    if (statm.open(QIODevice::ReadOnly)) {
+        QList<QByteArray> fields = statm.readAll().simplified().split(' ');
+        if (fields.size() >= 2) {
+            stats.virtualBytes = fields[0].toLongLong() * pageSize;
+            stats.residentBytes = fields[1].toLongLong() * pageSize;
+        }
+    }
+
+    // Имя процесса в скобках может содержать пробелы - считаем поля после ')'
+    QFile stat("/proc/self/stat");
+    if (stat.open(QIODevice::ReadOnly)) {
+        QByteArray content = stat.readAll();
+        QList<QByteArray> fields = content.mid(content.lastIndexOf(')') + 2).simplified().split(' ');
+        if (fields.size() > 17 && ticksPerSecond > 0) {
+            stats.cpuSeconds = (fields[11].toULongLong() + fields[12].toULongLong())
+                / static_cast<double>(ticksPerSecond);
+            stats.threads = fields[17].toInt();
+        }
+    }
+
+    stats.openFds = QDir("/proc/self/fd").entryList(QDir::AllEntries | QDir::NoDotAndDotDot | QDir::System).size();
+#endif
+    return stats;
+}
+
+QJsonObject DaemonMetrics::toJson(const Gauges& gauges) const
+{
+    QJsonObject result;
+    result["uptime_seconds"] = uptime.elapsed() / 1000.0;
+    result["start_time"] = startTime.toString(Qt::ISODate);
+    result["connections"] = gauges.connections;
+    result["connections_accepted"] = static_cast<qint64>(connectionsAccepted.loadRelaxed());
+    result["connections_rejected"] = static_cast<qint64>(connectionsRejected.loadRelaxed());
+    result["subscriptions"] = gauges.subscriptions;
+    result["queued_bytes"] = gauges.queuedBytes;
+    result["expensive_in_flight"] = gauges.expensiveInFlight;
+    result["bytes_in"] = static_cast<qint64>(bytesIn.loadRelaxed());
+    result["bytes_out"] = static_cast<qint64>(bytesOut.loadRelaxed());
+
+    const ProcessStats process = readProcessStats();
+    QJsonObject processJson;
+    processJson["rss_bytes"] = process.residentBytes;
+    processJson["virtual_bytes"] = process.virtualBytes;
+    processJson["cpu_seconds"] = process.cpuSeconds;
+    processJson["open_fds"] = process.openFds;
+    processJson["threads"] = process.threads;
+    result["process"] = processJson;
+
+    QJsonArray methodsJson;
+    for (auto it = methods.constBegin(); it != methods.constEnd(); ++it) {
+        const MethodStats* stats = it.value();
+        const quint64 count = stats->latency.count();
+        const quint64 busy = stats->busy.loadRelaxed();
+        if (count == 0 && busy == 0) continue;
+
+        QJsonObject method;
+        method["method"] = it.key();
+        method["count"] = static_cast<qint64>(count);
+        method["errors"] = static_cast<qint64>(stats->errors.loadRelaxed());
+        method["busy"] = static_cast<qint64>(busy);
+        method["mean_us"] = count > 0 ? static_cast<double>(stats->latency.sumMicros()) / count : 0.0;
+        method["p50_us"] = static_cast<qint64>(stats->latency.percentile(0.50));
+        method["p90_us"] = static_cast<qint64>(stats->latency.percentile(0.90));
+        method["p99_us"] = static_cast<qint64>(stats->latency.percentile(0.99));
+        method["max_us"] = static_cast<qint64>(stats->latency.maxMicros());
+        methodsJson.append(method);
+    }
+    result["methods"] = methodsJson;
+    return result;
+}
+
+QByteArray DaemonMetrics::toPrometheus(const Gauges& gauges) const
+{
+    QByteArray out;
+    auto header = [&out](const char* name, const char* type, const char* help) {
+        out += QByteArray("# HELP ") + name + ' ' + help + '\n';
+        out += QByteArray("# TYPE ") + name + ' ' + type + '\n';
+    };
+    auto sample = [&out](const QByteArray& name, const QString& labels, const QString& value) {
+        out += name;
+        if (!labels.isEmpty()) out += '{' + labels.toUtf8() + '}';
+        out += ' ' + value.toUtf8() + '\n';
+    };
+
+    header("os_overview_requests_total", "counter", "RPC requests by method and outcome.");
+    for (auto it = methods.constBegin(); it != methods.constEnd(); ++it) {
+        const MethodStats* stats = it.value();
+        const quint64 errors = stats->errors.loadRelaxed();
+        const quint64 busy = stats->busy.loadRelaxed();
+        const quint64 ok = stats->latency.count() - errors;
+        if (ok == 0 && errors == 0 && busy == 0) continue;
+        const QString method = QString("method=\"%1\"").arg(it.key());
+        sample("os_overview_requests_total", method + ",outcome=\"ok\"", QString::number(ok));
+        sample("os_overview_requests_total", method + ",outcome=\"error\"", QString::number(errors));
+        sample("os_overview_requests_total", method + ",outcome=\"busy\"", QString::number(busy));
+    }
+
+    header("os_overview_request_duration_seconds", "histogram", "Time from request arrival to response, admitted requests only.");
+    for (auto it = methods.constBegin(); it != methods.constEnd(); ++it) {
+        const LatencyHistogram& latency = it.value()->latency;
+        if (latency.count() == 0) continue;
+        const QString method = QString("method=\"%1\"").arg(it.key());
+        for (int exponent = firstExportExponent; exponent <= lastExportExponent; ++exponent) {
+            const quint64 bound = quint64(1) << exponent;
+            sample("os_overview_request_duration_seconds_bucket",
+                   method + QString(",le=\"%1\"").arg(formatSeconds(bound)),
+                   QString::number(latency.countAtMost(bound)));
+        }
+        sample("os_overview_request_duration_seconds_bucket", method + ",le=\"+Inf\"", QString::number(latency.count()));
+        sample("os_overview_request_duration_seconds_sum", method, formatSeconds(latency.sumMicros()));
+        sample("os_overview_request_duration_seconds_count", method, QString::number(latency.count()));
+    }
+
+    header("os_overview_received_bytes_total", "counter", "RPC payload bytes received from clients.");
+    sample("os_overview_received_bytes_total", QString(), QString::number(bytesIn.loadRelaxed()));
+    header("os_overview_sent_bytes_total", "counter", "RPC payload bytes queued to clients.");
+    sample("os_overview_sent_bytes_total", QString(), QString::number(bytesOut.loadRelaxed()));
+
+    header("os_overview_connections", "gauge", "Currently connected clients.");
+    sample("os_overview_connections", QString(), QString::number(gauges.connections));
+    header("os_overview_connections_accepted_total", "counter", "Accepted client connections.");
+    sample("os_overview_connections_accepted_total", QString(), QString::number(connectionsAccepted.loadRelaxed()));
+    header("os_overview_connections_rejected_total", "counter", "Connections rejected by the client limit.");
+    sample("os_overview_connections_rejected_total", QString(), QString::number(connectionsRejected.loadRelaxed()));
+    header("os_overview_subscriptions", "gauge", "Active log subscriptions.");
+    sample("os_overview_subscriptions", QString(), QString::number(gauges.subscriptions));
+    header("os_overview_output_queue_bytes", "gauge", "Response bytes waiting to be sent to clients.");
+    sample("os_overview_output_queue_bytes", QString(), QString::number(gauges.queuedBytes));
+    header("os_overview_expensive_in_flight", "gauge", "Expensive operations running in the thread pool.");
+    sample("os_overview_expensive_in_flight", QString(), QString::number(gauges.expensiveInFlight));
+
+    // Стандартные имена process_*, как у официальных клиентских библиотек
+    const ProcessStats process = readProcessStats();
+    header("process_resident_memory_bytes", "gauge", "Resident memory size in bytes.");
+    sample("process_resident_memory_bytes", QString(), QString::number(process.residentBytes));
+    header("process_virtual_memory_bytes", "gauge", "Virtual memory size in bytes.");
+    sample("process_virtual_memory_bytes", QString(), QString::number(process.virtualBytes));
+    header("process_cpu_seconds_total", "counter", "Total user and system CPU time spent in seconds.");
+    sample("process_cpu_seconds_total", QString(), QString::number(process.cpuSeconds, 'f', 2));
+    header("process_open_fds", "gauge", "Number of open file descriptors.");
+    sample("process_open_fds", QString(), QString::number(process.openFds));
+    header("process_threads", "gauge", "Number of OS threads.");
+    sample("process_threads", QString(), QString::number(process.threads));
+    header("process_start_time_seconds", "gauge", "Start time of the process since unix epoch in seconds.");
+    sample("process_start_time_seconds", QString(), QString::number(startTime.toSecsSinceEpoch()));
+
+    return out;
+}
+
+// ========== MetricsEndpoint ==========
+
+MetricsEndpoint::MetricsEndpoint(Server* server, QObject* parent)
+    : QTcpServer(parent), server(server)
+{
+    connect(this, &QTcpServer::newConnection, this, &MetricsEndpoint::onNewConnection);
+}
+
+void MetricsEndpoint::onNewConnection()
+{
+    while (QTcpSocket* socket = nextPendingConnection()) {
+        connect(socket, &QTcpSocket::disconnected, socket, &QObject::deleteLater);
+        connect(socket, &QTcpSocket::readyRead, this, [this, socket]() {
+            // Ждём конца заголовков; тело у GET не бывает
+            if (!socket->peek(maxHttpRequestSize).contains("\r\n\r\n")) {
+                if (socket->bytesAvailable() >= maxHttpRequestSize) socket->abort();
+                return;
+            }
+
+            const QList<QByteArray> requestLine = socket->readLine().trimmed().split(' ');
+            socket->readAll();
+
+            QByteArray status = "200 OK";
+            QByteArray contentType = "text/plain; version=0.0.4; charset=utf-8";
+            QByteArray body;
+            if (requestLine.size() < 2 || requestLine[0] != "GET") {
+                status = "405 Method Not Allowed";
+                body = "Only GET is supported\n";
+            } else if (requestLine[1] != "/metrics") {
+                status = "404 Not Found";
+                body = "Try /metrics\n";
+            } else {
+                body = server->metricsText();
+            }
+
+            QByteArray response = "HTTP/1.1 " + status + "\r\n"
+                "Content-Type: " + contentType + "\r\n"
+                "Content-Length: " + QByteArray::number(body.size()) + "\r\n"
+                "Connection: close\r\n\r\n" + body;
+            socket->write(response);
+            socket->disconnectFromHost();
+        });
+    }
+}
@@ -0,0 +1,284 @@
+#include "DiskMonitor.h"
+#include <QFile>
+#include <QJsonObject>
+#include <QStorageInfo>
+#include <QDebug>
+
+#ifdef Q_OS_LINUX
+#include <fcntl.h>
+#include <poll.h>
+#include <unistd.h>
+#include <sys/statvfs.h>
+#endif
+
+namespace {
+
+// В mountinfo пробелы и спецсимволы кодируются как \040
+QString unescapeMountField(const QByteArray& field)
+{
+    QByteArray result;
+    result.reserve(field.size());
+    for (int i = 0; i < field.size(); ++i) {
+        if (field[i] == '\\' && i + 3 < field.size()) {
+            bool ok = false;
+            int code = field.mid(i + 1, 3).toInt(&ok, 8);
+            if (ok) {
+                result.append(static_cast<char>(code));
+                i += 3;
+                continue;
+            }
+        }
+        result.append(field[i]);
+    }
+    return QString::fromUtf8(result);
+}
+
+// Повторяет отбор псевдо-ФС из QStorageInfo::mountedVolumes()
+bool isPseudoMount(const QString& mountPoint, const QString& fsType)
+{
+    static const QStringList pseudoRoots = { "/dev", "/proc", "/sys", "/var/run", "/var/lock" };
+    for (const QString& root : pseudoRoots) {
+        if (mountPoint == root || mountPoint.startsWith(root + '/')) return true;
+    }
+    return fsType == "rootfs";
+}
+
+qulonglong delta(qulonglong current, qulonglong previous)
+{
+    return current >= previous ? current - previous : 0;
+}
+
+} // namespace
+
+DiskMonitor::DiskMonitor(const QString& root, QObject* parent)
+    : QObject(parent),
+      procRoot(root),
+      mountInfoFd(-1),
+      lastSampleMs(-1),
+      sampleIntervalMs(0),
+      minIntervalMs(500)
+{
+    clock.start();
+#ifdef Q_OS_LINUX
+    mountInfoFd = ::open(QFile::encodeName(procRoot + "/self/mountinfo").constData(), O_RDONLY | O_CLOEXEC);
+    if (mountInfoFd < 0) {
+        qWarning() << "Cannot open mountinfo, mount table will be re-read on every request";
+    }
+#endif
+}
+
+DiskMonitor::~DiskMonitor()
+{
+#ifdef Q_OS_LINUX
+    if (mountInfoFd >= 0) ::close(mountInfoFd);
+#endif
+}
+
+void DiskMonitor::refreshMountsIfChanged()
+{
+#ifdef Q_OS_LINUX
+    if (mountInfoFd < 0) {
+        QFile file(procRoot + "/self/mountinfo");
+        if (file.open(QIODevice::ReadOnly)) loadMounts(file.readAll());
+        return;
+    }
+
+    // Ядро выставляет POLLPRI|POLLERR после любого mount/umount в пространстве имён,
+    // а при первом обращении таблица ещё пуста и читается безусловно
+    pollfd pfd = { mountInfoFd, POLLPRI, 0 };
+    if (::poll(&pfd, 1, 0) <= 0 || !(pfd.revents & (POLLPRI | POLLERR))) {
+        if (!mounts.isEmpty()) return;
+    }
+
+    QByteArray content;
+    char buffer[16384];
+    ::lseek(mountInfoFd, 0, SEEK_SET);
+    ssize_t n;
+    while ((n = ::read(mountInfoFd, buffer, sizeof(buffer))) > 0) {
+        content.append(buffer, static_cast<int>(n));
+    }
+    loadMounts(content);
+#endif
+}
+
+void DiskMonitor::loadMounts(const QByteArray& content)
+{
+    // Формат: id parent maj:min root mount_point options [optional...] - fstype source superopts
+    mounts.clear();
+    for (const QByteArray& line : content.split('\n')) {
+        QList<QByteArray> fields = line.split(' ');
+        int separator = fields.indexOf("-");
+        if (fields.size() < 7 || separator < 6 || separator + 2 >= fields.size()) continue;
+
+        QList<QByteArray> device = fields[2].split(':');
+        if (device.size() != 2) continue;
+
+        MountEntry entry;
+        entry.major = device[0].toUInt();
+        entry.minor = device[1].toUInt();
+        entry.mountPoint = unescapeMountField(fields[4]);
+        entry.fsType = QString::fromUtf8(fields[separator + 1]);
+        entry.source = unescapeMountField(fields[separator + 2]);
+        mounts.append(entry);
+    }
+}
+
+void DiskMonitor::refreshDeviceStats()
+{
+    const qint64 now = clock.elapsed();
+    if (lastSampleMs >= 0 && now - lastSampleMs < minIntervalMs) return;
+
+    QFile file(procRoot + "/diskstats");
+    if (!file.open(QIODevice::ReadOnly)) return;
+
+    const qint64 elapsedMs = lastSampleMs >= 0 ? now - lastSampleMs : 0;
+    QHash<quint64, DeviceCounters> currentCounters;
+    QHash<quint64, DeviceRates> currentRates;
+
+    for (const QByteArray& line : file.readAll().split('\n')) {
+        QList<QByteArray> f = line.simplified().split(' ');
+        if (f.size() < 14) continue;
+
+        const quint64 key = deviceKey(f[0].toUInt(), f[1].toUInt());
+        DeviceCounters cur;
+        cur.name = QString::fromUtf8(f[2]);
+        cur.reads = f[3].toULongLong();
+        cur.sectorsRead = f[5].toULongLong();
+        cur.msReading = f[6].toULongLong();
+        cur.writes = f[7].toULongLong();
+        cur.sectorsWritten = f[9].toULongLong();
+        cur.msWriting = f[10].toULongLong();
+        cur.inFlight = f[11].toULongLong();
+        cur.msDoingIo = f[12].toULongLong();
+        cur.weightedMs = f[13].toULongLong();
+        currentCounters.insert(key, cur);
+
+        DeviceRates r;
+        r.inFlight = cur.inFlight;
+        auto prevIt = previousCounters.constFind(key);
+        if (elapsedMs > 0 && prevIt != previousCounters.constEnd()) {
+            const DeviceCounters& prev = prevIt.value();
+            const double seconds = elapsedMs / 1000.0;
+            const qulonglong reads = delta(cur.reads, prev.reads);
+            const qulonglong writes = delta(cur.writes, prev.writes);
+            const qulonglong readMs = delta(cur.msReading, prev.msReading);
+            const qulonglong writeMs = delta(cur.msWriting, prev.msWriting);
+
+            // Секторы в diskstats всегда по 512 байт независимо от устройства
+            r.readIops = reads / seconds;
+            r.writeIops = writes / seconds;
+            r.readBytesPerSec = delta(cur.sectorsRead, prev.sectorsRead) * 512.0 / seconds;
+            r.writeBytesPerSec = delta(cur.sectorsWritten, prev.sectorsWritten) * 512.0 / seconds;
+            r.readAwaitMs = reads > 0 ? static_cast<double>(readMs) / reads : 0.0;
+            r.writeAwaitMs = writes > 0 ? static_cast<double>(writeMs) / writes : 0.0;
+            r.awaitMs = reads + writes > 0 ? static_cast<double>(readMs + writeMs) / (reads + writes) : 0.0;
+            r.utilPercent = qMin(100.0, delta(cur.msDoingIo, prev.msDoingIo) * 100.0 / elapsedMs);
+            r.queueDepth = static_cast<double>(delta(cur.weightedMs, prev.weightedMs)) / elapsedMs;
+        }
+        currentRates.insert(key, r);
+    }
+
+    previousCounters = currentCounters;
+    rates = currentRates;
+    sampleIntervalMs = elapsedMs;
+    lastSampleMs = now;
+}
+
+QJsonObject DiskMonitor::ratesToJson(const DeviceRates& r) const
+{
+    QJsonObject io;
+    io["interval_ms"] = sampleIntervalMs;
+    io["read_iops"] = r.readIops;
+    io["write_iops"] = r.writeIops;
+    io["read_bytes_per_sec"] = r.readBytesPerSec;
+    io["write_bytes_per_sec"] = r.writeBytesPerSec;
+    io["r_await_ms"] = r.readAwaitMs;
+    io["w_await_ms"] = r.writeAwaitMs;
+    io["await_ms"] = r.awaitMs;
+    io["util_percent"] = r.utilPercent;
+    io["queue_depth"] = r.queueDepth;
+    io["in_flight"] = static_cast<qint64>(r.inFlight);
+    return io;
+}
+
+QJsonArray DiskMonitor::volumes()
+{
+    QJsonArray disks;
+#ifdef Q_OS_LINUX
+    refreshMountsIfChanged();
+    refreshDeviceStats();
+
+    for (const MountEntry& mount : mounts) {
+        if (isPseudoMount(mount.mountPoint, mount.fsType)) continue;
+
+        struct statvfs fs;
+        if (::statvfs(QFile::encodeName(mount.mountPoint).constData(), &fs) != 0) continue;
+
+        const qint64 total = static_cast<qint64>(fs.f_blocks) * fs.f_frsize;
+        const qint64 free = static_cast<qint64>(fs.f_bfree) * fs.f_frsize;
+        const qint64 available = static_cast<qint64>(fs.f_bavail) * fs.f_frsize;
+        if (total <= 0) continue;
+
+        QJsonObject disk;
+        disk["name"] = mount.mountPoint;
+        disk["device"] = mount.source;
+        disk["mount_point"] = mount.mountPoint;
+        disk["filesystem"] = mount.fsType;
+        disk["total"] = total;
+        disk["free"] = free;
+        disk["available"] = available;
+        disk["used"] = total - free;
+        disk["usage_percent"] = (1.0 - static_cast<double>(free) / total) * 100.0;
+
+        auto io = rates.constFind(deviceKey(mount.major, mount.minor));
+        if (io != rates.constEnd()) disk["io"] = ratesToJson(io.value());
+
+        disks.append(disk);
+    }
+#else
+    for (const QStorageInfo& storage : QStorageInfo::mountedVolumes()) {
+        if (!storage.isValid() || !storage.isReady()) continue;
+
+        QJsonObject disk;
+        disk["name"] = storage.displayName();
+        disk["mount_point"] = storage.rootPath();
+        disk["filesystem"] = QString::fromUtf8(storage.fileSystemType());
+        disk["total"] = static_cast<qint64>(storage.bytesTotal());
+        disk["free"] = static_cast<qint64>(storage.bytesFree());
+        disk["available"] = static_cast<qint64>(storage.bytesAvailable());
+        disk["used"] = static_cast<qint64>(storage.bytesTotal() - storage.bytesFree());
+        disk["usage_percent"] = storage.bytesTotal() > 0
+            ? (1.0 - static_cast<double>(storage.bytesFree()) / storage.bytesTotal()) * 100.0 : 0.0;
+        disks.append(disk);
+    }
+#endif
+    return disks;
+}
+
+QJsonArray DiskMonitor::deviceStats()
+{
+    QJsonArray devices;
+#ifdef Q_OS_LINUX
+    refreshMountsIfChanged();
+    refreshDeviceStats();
+
+    for (auto it = previousCounters.constBegin(); it != previousCounters.constEnd(); ++it) {
+        const DeviceCounters& counters = it.value();
+        // Неиспользуемые ram/loop устройства только засоряют ответ
+        if (counters.reads == 0 && counters.writes == 0) continue;
+
+        QJsonObject device = ratesToJson(rates.value(it.key()));
+        device["name"] = counters.name;
+        device["major"] = static_cast<qint64>(it.key() >> 32);
+        device["minor"] = static_cast<qint64>(it.key() & 0xffffffffu);
+
+        QJsonArray mountPoints;
+        for (const MountEntry& mount : mounts) {
+            if (deviceKey(mount.major, mount.minor) == it.key()) mountPoints.append(mount.mountPoint);
+        }
+        device["mount_points"] = mountPoints;
+        devices.append(device);
+    }
+#endif
+    return devices;
+}
@@ -0,0 +1,262 @@
+#include "ExecSession.h"
+#include "AsyncLogger.h"
+#include <QFileInfo>
+#include <QStandardPaths>
+#include <QCoreApplication>
+#ifdef Q_OS_UNIX
+#include <unistd.h>
+#endif
+
+namespace {
+
+const int flushIntervalMs = 50;
+const int flushThresholdBytes = 64 * 1024;
+const int killDelayMs = 2000;
+
+// Длина data без незаконченной последовательности UTF-8 в конце: кусок вывода
+// может разрезать символ, и его начало уходит вместе со следующим куском
+int completeUtf8Length(const QByteArray& data)
+{
+    const int size = data.size();
+    for (int i = size - 1; i >= 0 && i >= size - 4; --i) {
+        const uchar byte = static_cast<uchar>(data.at(i));
+        if ((byte & 0xC0) == 0x80) continue;
+        const int length = (byte & 0xE0) == 0xC0 ? 2 : (byte & 0xF0) == 0xE0 ? 3 : (byte & 0xF8) == 0xF0 ? 4 : 1;
+        return i + length > size ? i : size;
+    }
+    return size; // не UTF-8: отдаётся как есть
+}
+
+} // namespace
+
+// ========== ExecPolicy ==========
+
+ExecPolicy::ExecPolicy(QObject* parent)
+    : QObject(parent), running(0), scopes(false)
+{}
+
+void ExecPolicy::setOptions(const Options& options)
+{
+    opts = options;
+    scopes = false;
+#ifdef Q_OS_LINUX
+    // Область systemd создаёт только root; иначе лимиты cgroup недоступны
+    scopes = opts.useScope && geteuid() == 0 && !QStandardPaths::findExecutable("systemd-run").isEmpty();
+    if (opts.useScope && !scopes) {
+        qCWarning(lcServer) << "exec: systemd-run scopes unavailable, commands run without cgroup limits";
+    }
+#endif
+}
+
+bool ExecPolicy::allow(const QString& name, const QString& commandLine, QString* error)
+{
+    const QStringList parts = commandLine.simplified().split(' ', Qt::SkipEmptyParts);
+    if (parts.isEmpty() || !QFileInfo(parts.first()).isAbsolute()) {
+        if (error) *error = QString("exec command '%1' must start with an absolute path").arg(name);
+        return false;
+    }
+    if (!QFileInfo(parts.first()).isExecutable()) {
+        if (error) *error = QString("exec command '%1': %2 is not executable").arg(name, parts.first());
+        return false;
+    }
+    commands.insert(name, Command{ parts.first(), parts.mid(1) });
+    return true;
+}
+
+bool ExecPolicy::resolve(const QString& name, Command* command) const
+{
+    const auto it = commands.constFind(name);
+    if (it == commands.constEnd()) return false;
+    *command = it.value();
+    return true;
+}
+
+bool ExecPolicy::tryAcquire()
+{
+    if (running >= opts.maxConcurrent) return false;
+    ++running;
+    return true;
+}
+
+// ========== ExecSession ==========
+
+ExecSession::ExecSession(int id, ExecPolicy* policy, const ExecPolicy::Command& command,
+                         int timeoutMs, QObject* parent)
+    : QObject(parent),
+      executionId(id),
+      policy(policy),
+      command(command),
+      timeoutMs(timeoutMs),
+      process(new QProcess(this)),
+      outputBytes(0),
+      droppedBytes(0),
+      done(false)
+{
+    process->setProcessChannelMode(QProcess::SeparateChannels);
+    process->setWorkingDirectory("/");
+    // Окружение демона командам не передаётся
+    QProcessEnvironment environment;
+    environment.insert("PATH", "/usr/local/sbin:/usr/local/bin:/usr/sbin:/usr/bin:/sbin:/bin");
+    environment.insert("LANG", "C.UTF-8");
+    process->setProcessEnvironment(environment);
+
+    connect(process, &QProcess::readyReadStandardOutput, this, &ExecSession::onStdout);
+    connect(process, &QProcess::readyReadStandardError, this, &ExecSession::onStderr);
+    connect(process, QOverload<int, QProcess::ExitStatus>::of(&QProcess::finished), this, &ExecSession::onFinished);
+    connect(process, &QProcess::errorOccurred, this, &ExecSession::onError);
+
+    timeoutTimer.setSingleShot(true);
+    connect(&timeoutTimer, &QTimer::timeout, this, [this]() { stop("timeout"); });
+    killTimer.setSingleShot(true);
+    connect(&killTimer, &QTimer::timeout, this, [this]() {
+        process->kill();
+        killScope();
+    });
+    flushTimer.setSingleShot(true);
+    flushTimer.setInterval(flushIntervalMs);
+    connect(&flushTimer, &QTimer::timeout, this, &ExecSession::flush);
+}
+
+ExecSession::~ExecSession()
+{
+    if (process->state() != QProcess::NotRunning) {
+        // Клиент ушёл: команда не должна его пережить. Удалять работающий QProcess
+        // нельзя - его деструктор ждёт процесс синхронно, а застрявший в ядре
+        // (df на зависшем NFS) не умирает и от SIGKILL. Процесс доживает под
+        // ExecPolicy и удаляется, когда завершится
+        disconnect(process, nullptr, this, nullptr);
+        process->setParent(policy);
+        connect(process, QOverload<int, QProcess::ExitStatus>::of(&QProcess::finished),
+                process, &QObject::deleteLater);
+        process->kill();
+        killScope();
+    }
+    policy->release();
+}
+
+void ExecSession::start()
+{
+    QString program = command.program;
+    QStringList arguments = command.arguments;
+
+    if (policy->scopesAvailable()) {
+        // Область systemd: лимиты cgroup и возможность убить всех потомков разом
+        const ExecPolicy::Options& options = policy->options();
+        scopeUnit = QString("life-exec-%1-%2").arg(QCoreApplication::applicationPid()).arg(executionId);
+        QStringList scope = { "--scope", "--quiet", "--collect", "--unit=" + scopeUnit,
+                              "-p", "MemoryMax=" + options.memoryMax,
+                              "-p", "CPUQuota=" + options.cpuQuota,
+                              "-p", "TasksMax=" + QString::number(options.tasksMax),
+                              "--", program };
+        arguments = scope + arguments;
+        program = "systemd-run";
+    }
+
+    clock.start();
+    if (timeoutMs > 0) timeoutTimer.start(timeoutMs);
+    process->start(program, arguments);
+    // stdin у команды пустой; закрывается, как только процесс запустится
+    process->closeWriteChannel();
+    qCInfo(lcServer) << "exec" << executionId << command.program << command.arguments;
+}
+
+void ExecSession::onStdout()
+{
+    collect(stdoutBuffer, process->readAllStandardOutput());
+}
+
+void ExecSession::onStderr()
+{
+    collect(stderrBuffer, process->readAllStandardError());
+}
+
+void ExecSession::collect(QByteArray& buffer, const QByteArray& data)
+{
+    const qint64 room = qMax<qint64>(0, policy->options().maxOutputBytes - outputBytes);
+    const int kept = static_cast<int>(qMin<qint64>(room, data.size()));
+    buffer.append(data.constData(), kept);
+    outputBytes += kept;
+    droppedBytes += data.size() - kept;
+
+    if (stdoutBuffer.size() + stderrBuffer.size() >= flushThresholdBytes) flush();
+    else if (!flushTimer.isActive()) flushTimer.start();
+}
+
+void ExecSession::flush()
+{
+    flushTimer.stop();
+    send("stdout", stdoutBuffer, false);
+    send("stderr", stderrBuffer, false);
+}
+
+void ExecSession::send(const QString& stream, QByteArray& buffer, bool last)
+{
+    int length = completeUtf8Length(buffer);
+    if (last) {
+        // Недописанный символ в самом конце оставляем только у полного вывода;
+        // на месте обрезки по maxOutputBytes он считается отброшенным
+        if (droppedBytes == 0) length = buffer.size();
+        outputBytes -= buffer.size() - length;
+        droppedBytes += buffer.size() - length;
+    }
+    if (length > 0) emit output(executionId, stream, buffer.left(length));
+    buffer.remove(0, length);
+    if (last) buffer.clear();
+}
+
+void ExecSession::stop(const QString& reason)
+{
+    if (done || !stopReason.isEmpty()) return;
+    stopReason = reason;
+    process->terminate();
+    killTimer.start(killDelayMs);
+}
+
+void ExecSession::killScope()
+{
+    // Потомки, ушедшие из-под процесса, остаются в области и убиваются вместе с ней
+    if (!scopeUnit.isEmpty()) {
+        QProcess::startDetached("systemctl", { "kill", "--signal=SIGKILL", scopeUnit + ".scope" });
+    }
+}
+
+void ExecSession::onFinished(int exitCode, QProcess::ExitStatus status)
+{
+    // Остаток вывода, который мог прийти вместе с завершением
+    collect(stdoutBuffer, process->readAllStandardOutput());
+    collect(stderrBuffer, process->readAllStandardError());
+
+    QJsonObject summary;
+    summary["exitCode"] = exitCode;
+    summary["status"] = !stopReason.isEmpty() ? stopReason
+                                              : status == QProcess::NormalExit ? QString("exited") : QString("crashed");
+    complete(summary);
+}
+
+void ExecSession::onError(QProcess::ProcessError error)
+{
+    // Остальные ошибки сопровождаются finished
+    if (error != QProcess::FailedToStart) return;
+    QJsonObject summary;
+    summary["status"] = "failedToStart";
+    summary["error"] = process->errorString();
+    complete(summary);
+}
+
+void ExecSession::complete(QJsonObject summary)
+{
+    if (done) return;
+    done = true;
+    timeoutTimer.stop();
+    killTimer.stop();
+    if (!stopReason.isEmpty()) killScope();
+    flushTimer.stop();
+    send("stdout", stdoutBuffer, true);
+    send("stderr", stderrBuffer, true);
+
+    summary["execution"] = executionId;
+    summary["durationMs"] = clock.elapsed();
+    summary["outputBytes"] = outputBytes;
+    summary["droppedBytes"] = droppedBytes;
+    emit finished(executionId, summary);
+}
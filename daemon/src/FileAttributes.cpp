@@ -0,0 +1,397 @@
+#include "FileAttributes.h"
+#include <QFile>
+#include <QStringList>
+#include <QTextCodec>
+#include <QRegularExpression>
+#include <QVector>
+#include <QtEndian>
+#include <algorithm>
+#include <utility>
+#ifdef Q_OS_LINUX
+#include <sys/xattr.h>
+#include <grp.h>
+#include <pwd.h>
+#include <cerrno>
+#endif
+
+namespace {
+
+// Двоичный формат ACL в xattr, см. linux/posix_acl_xattr.h
+const quint32 aclXattrVersion = 2;
+const quint16 tagUserObj = 0x01;
+const quint16 tagUser = 0x02;
+const quint16 tagGroupObj = 0x04;
+const quint16 tagGroup = 0x08;
+const quint16 tagMask = 0x10;
+const quint16 tagOther = 0x20;
+const quint32 undefinedId = 0xFFFFFFFFu;
+const int aclHeaderSize = 4;
+const int aclEntrySize = 8;
+
+// Префикс двоичного значения атрибута, как в getfattr -e base64
+const char base64Prefix[] = "0s";
+
+struct AclEntry {
+    quint16 tag;
+    quint16 perm;
+    quint32 id;
+};
+
+QString permissionText(quint16 perm)
+{
+    QString text = "---";
+    if (perm & 4) text[0] = 'r';
+    if (perm & 2) text[1] = 'w';
+    if (perm & 1) text[2] = 'x';
+    return text;
+}
+
+bool parsePermission(const QString& text, quint16* perm)
+{
+    if (text.size() == 1 && text[0] >= '0' && text[0] <= '7') {
+        *perm = static_cast<quint16>(text[0].digitValue());
+        return true;
+    }
+    quint16 result = 0;
+    for (const QChar c : text) {
+        if (c == 'r') result |= 4;
+        else if (c == 'w') result |= 2;
+        else if (c == 'x') result |= 1;
+        else if (c != '-') return false;
+    }
+    *perm = result;
+    return !text.isEmpty();
+}
+
+// Разбор идёт и в пуле потоков, поэтому только реентерабельные *_r
+bool resolveId(const QString& name, bool user, quint32* id)
+{
+    bool numeric = false;
+    const uint value = name.toUInt(&numeric);
+    if (numeric) {
+        *id = value;
+        return true;
+    }
+#ifdef Q_OS_LINUX
+    const QByteArray native = name.toLocal8Bit();
+    char buffer[4096];
+    if (user) {
+        passwd pw;
+        passwd* found = nullptr;
+        if (getpwnam_r(native.constData(), &pw, buffer, sizeof(buffer), &found) != 0 || !found) return false;
+        *id = found->pw_uid;
+    } else {
+        group gr;
+        group* found = nullptr;
+        if (getgrnam_r(native.constData(), &gr, buffer, sizeof(buffer), &found) != 0 || !found) return false;
+        *id = found->gr_gid;
+    }
+    return true;
+#else
+    Q_UNUSED(user)
+    return false;
+#endif
+}
+
+QString encodeValue(const QByteArray& value)
+{
+    QTextCodec::ConverterState state;
+    const QString text = QTextCodec::codecForName("UTF-8")->toUnicode(value.constData(), value.size(), &state);
+    bool printable = state.invalidChars == 0 && !text.startsWith(base64Prefix);
+    for (const QChar c : text) {
+        if (c.unicode() < 0x20 && c != '\t' && c != '\n') {
+            printable = false;
+            break;
+        }
+    }
+    return printable ? text : base64Prefix + QString::fromLatin1(value.toBase64());
+}
+
+QByteArray decodeValue(const QString& value)
+{
+    if (value.startsWith(base64Prefix)) return QByteArray::fromBase64(value.mid(2).toLatin1());
+    return value.toUtf8();
+}
+
+#ifdef Q_OS_LINUX
+
+// Значение могут поменять между запросом размера и чтением - тогда ERANGE и повтор
+bool readXattr(const QByteArray& path, const char* name, QByteArray* value)
+{
+    for (int attempt = 0; attempt < 3; ++attempt) {
+        const ssize_t size = lgetxattr(path.constData(), name, nullptr, 0);
+        if (size < 0) return false;
+        value->resize(static_cast<int>(size));
+        const ssize_t got = lgetxattr(path.constData(), name, value->data(), value->size());
+        if (got >= 0) {
+            value->resize(static_cast<int>(got));
+            return true;
+        }
+        if (errno != ERANGE) return false;
+    }
+    return false;
+}
+
+QList<QByteArray> listXattrs(const QByteArray& path)
+{
+    for (int attempt = 0; attempt < 3; ++attempt) {
+        const ssize_t size = llistxattr(path.constData(), nullptr, 0);
+        if (size <= 0) return {};
+        QByteArray names(static_cast<int>(size), Qt::Uninitialized);
+        const ssize_t got = llistxattr(path.constData(), names.data(), names.size());
+        if (got >= 0) {
+            names.resize(static_cast<int>(got));
+            if (names.endsWith('\0')) names.chop(1);
+            return names.split('\0');
+        }
+        if (errno != ERANGE) return {};
+    }
+    return {};
+}
+
+#endif
+
+} // namespace
+
+FileAttributes::FileAttributes(Fields fields)
+    : wanted(fields)
+{}
+
+FileAttributes::Fields FileAttributes::parseFields(const QJsonValue& include)
+{
+    Fields fields;
+    for (const QJsonValue& value : include.toArray()) {
+        if (value.toString() == "acl") fields |= Acl;
+        else if (value.toString() == "xattr") fields |= Xattrs;
+    }
+    return fields;
+}
+
+const char* FileAttributes::accessAclName()
+{
+    return "system.posix_acl_access";
+}
+
+const char* FileAttributes::defaultAclName()
+{
+    return "system.posix_acl_default";
+}
+
+QString FileAttributes::userName(uint uid)
+{
+    const auto it = users.constFind(uid);
+    if (it != users.constEnd()) return it.value();
+    QString name = QString::number(uid);
+#ifdef Q_OS_LINUX
+    passwd pw;
+    passwd* found = nullptr;
+    char buffer[4096];
+    if (getpwuid_r(uid, &pw, buffer, sizeof(buffer), &found) == 0 && found) name = QString::fromLocal8Bit(found->pw_name);
+#endif
+    users.insert(uid, name);
+    return name;
+}
+
+QString FileAttributes::groupName(uint gid)
+{
+    const auto it = groups.constFind(gid);
+    if (it != groups.constEnd()) return it.value();
+    QString name = QString::number(gid);
+#ifdef Q_OS_LINUX
+    group gr;
+    group* found = nullptr;
+    char buffer[4096];
+    if (getgrgid_r(gid, &gr, buffer, sizeof(buffer), &found) == 0 && found) name = QString::fromLocal8Bit(found->gr_name);
+#endif
+    groups.insert(gid, name);
+    return name;
+}
+
+bool FileAttributes::encodeAcl(const QString& text, QByteArray* value, QString* error)
+{
+    QVector<AclEntry> entries;
+    bool hasMask = false;
+    bool hasNamed = false;
+    const QStringList items = text.split(QRegularExpression("[,\n]"), Qt::SkipEmptyParts);
+    for (QString item : items) {
+        item = item.trimmed();
+        if (item.isEmpty() || item.startsWith('#')) continue;
+        if (item.startsWith("default:")) item = item.mid(8);
+
+        const QStringList parts = item.split(':');
+        if (parts.size() != 3) {
+            if (error) *error = QString("Invalid ACL entry '%1'").arg(item);
+            return false;
+        }
+        const QString tag = parts[0];
+        const QString qualifier = parts[1];
+        AclEntry entry { 0, 0, undefinedId };
+        if (!parsePermission(parts[2], &entry.perm)) {
+            if (error) *error = QString("Invalid permissions in '%1'").arg(item);
+            return false;
+        }
+        if (tag == "user" || tag == "u") {
+            entry.tag = qualifier.isEmpty() ? tagUserObj : tagUser;
+        } else if (tag == "group" || tag == "g") {
+            entry.tag = qualifier.isEmpty() ? tagGroupObj : tagGroup;
+        } else if ((tag == "mask" || tag == "m") && qualifier.isEmpty()) {
+            entry.tag = tagMask;
+            hasMask = true;
+        } else if ((tag == "other" || tag == "o") && qualifier.isEmpty()) {
+            entry.tag = tagOther;
+        } else {
+            if (error) *error = QString("Invalid ACL entry '%1'").arg(item);
+            return false;
+        }
+        if (entry.tag == tagUser || entry.tag == tagGroup) {
+            hasNamed = true;
+            if (!resolveId(qualifier, entry.tag == tagUser, &entry.id)) {
+                if (error) *error = QString("Unknown %1 '%2'").arg(entry.tag == tagUser ? "user" : "group", qualifier);
+                return false;
+            }
+        }
+        for (const AclEntry& other : entries) {
+            if (other.tag == entry.tag && other.id == entry.id) {
+                if (error) *error = QString("Duplicate ACL entry '%1'").arg(item);
+                return false;
+            }
+        }
+        entries.append(entry);
+    }
+
+    int required = 0;
+    for (const AclEntry& entry : entries) {
+        if (entry.tag == tagUserObj || entry.tag == tagGroupObj || entry.tag == tagOther) ++required;
+    }
+    if (required != 3) {
+        if (error) *error = "ACL must contain user::, group:: and other:: entries";
+        return false;
+    }
+    // Как setfacl: маска - объединение прав группового класса
+    if (hasNamed && !hasMask) {
+        AclEntry mask { tagMask, 0, undefinedId };
+        for (const AclEntry& entry : entries) {
+            if (entry.tag == tagUser || entry.tag == tagGroupObj || entry.tag == tagGroup) mask.perm |= entry.perm;
+        }
+        entries.append(mask);
+    }
+
+    // Ядро принимает записи только по порядку тегов, внутри тега - по id
+    std::sort(entries.begin(), entries.end(), [](const AclEntry& a, const AclEntry& b) {
+        return a.tag != b.tag ? a.tag < b.tag : a.id < b.id;
+    });
+
+    value->resize(aclHeaderSize + entries.size() * aclEntrySize);
+    uchar* out = reinterpret_cast<uchar*>(value->data());
+    qToLittleEndian<quint32>(aclXattrVersion, out);
+    out += aclHeaderSize;
+    for (const AclEntry& entry : entries) {
+        qToLittleEndian<quint16>(entry.tag, out);
+        qToLittleEndian<quint16>(entry.perm, out + 2);
+        qToLittleEndian<quint32>(entry.id, out + 4);
+        out += aclEntrySize;
+    }
+    return true;
+}
+
+QString FileAttributes::decodeAcl(const QByteArray& value)
+{
+    if (value.size() < aclHeaderSize || (value.size() - aclHeaderSize) % aclEntrySize != 0) return QString();
+    const uchar* data = reinterpret_cast<const uchar*>(value.constData());
+    if (qFromLittleEndian<quint32>(data) != aclXattrVersion) return QString();
+
+    QStringList items;
+    for (int offset = aclHeaderSize; offset < value.size(); offset += aclEntrySize) {
+        const quint16 tag = qFromLittleEndian<quint16>(data + offset);
+        const quint16 perm = qFromLittleEndian<quint16>(data + offset + 2);
+        const quint32 id = qFromLittleEndian<quint32>(data + offset + 4);
+        QString item;
+        switch (tag) {
+        case tagUserObj: item = "user:"; break;
+        case tagUser: item = "user:" + userName(id); break;
+        case tagGroupObj: item = "group:"; break;
+        case tagGroup: item = "group:" + groupName(id); break;
+        case tagMask: item = "mask:"; break;
+        case tagOther: item = "other:"; break;
+        default: continue;
+        }
+        items << item + ':' + permissionText(perm);
+    }
+    return items.join(',');
+}
+
+void FileAttributes::project(const QString& path, QJsonObject& file)
+{
+#ifdef Q_OS_LINUX
+    const QByteArray native = QFile::encodeName(path);
+    QByteArray value;
+    if (wanted & Acl) {
+        // Без расширенного ACL атрибута нет (ENODATA): права целиком в mode
+        if (readXattr(native, accessAclName(), &value)) file["acl"] = decodeAcl(value);
+        if (readXattr(native, defaultAclName(), &value)) file["defaultAcl"] = decodeAcl(value);
+    }
+    if (wanted & Xattrs) {
+        // Один listxattr на файл, значения - только по найденным именам
+        QJsonObject xattrs;
+        for (const QByteArray& name : listXattrs(native)) {
+            if (name.isEmpty() || name.startsWith("system.posix_acl_")) continue;
+            if (readXattr(native, name.constData(), &value)) xattrs[QString::fromUtf8(name)] = encodeValue(value);
+        }
+        if (!xattrs.isEmpty()) file["xattrs"] = xattrs;
+    }
+#else
+    Q_UNUSED(path)
+    Q_UNUSED(file)
+#endif
+}
+
+bool FileAttributes::apply(const QString& path, const QJsonObject& changes, QString* error)
+{
+#ifdef Q_OS_LINUX
+    const QByteArray native = QFile::encodeName(path);
+    auto failed = [error](const QString& what) {
+        if (error) *error = QString("%1: %2").arg(what, qt_error_string(errno));
+        return false;
+    };
+
+    for (const auto& field : { std::make_pair("acl", accessAclName()), std::make_pair("defaultAcl", defaultAclName()) }) {
+        if (!changes.contains(field.first)) continue;
+        QByteArray value;
+        if (!encodeAcl(changes[field.first].toString(), &value, error)) return false;
+        if (lsetxattr(native.constData(), field.second, value.constData(), value.size(), 0) != 0) return failed(field.first);
+    }
+    // Отсутствующий атрибут - не ошибка: результат тот же
+    if (changes["removeAcl"].toBool() && lremovexattr(native.constData(), accessAclName()) != 0 && errno != ENODATA) {
+        return failed("removeAcl");
+    }
+    if (changes["removeDefaultAcl"].toBool() && lremovexattr(native.constData(), defaultAclName()) != 0
+        && errno != ENODATA) {
+        return failed("removeDefaultAcl");
+    }
+
+    const QJsonObject xattrs = changes["xattrs"].toObject();
+    for (auto it = xattrs.constBegin(); it != xattrs.constEnd(); ++it) {
+        // ACL меняются через acl/defaultAcl, где значение проверяется
+        if (!it.key().contains('.') || it.key().startsWith("system.posix_acl_")) {
+            if (error) *error = QString("Invalid attribute name '%1'").arg(it.key());
+            return false;
+        }
+        const QByteArray name = it.key().toUtf8();
+        const QByteArray value = decodeValue(it.value().toString());
+        if (lsetxattr(native.constData(), name.constData(), value.constData(), value.size(), 0) != 0) {
+            return failed(it.key());
+        }
+    }
+    for (const QJsonValue& name : changes["removeXattrs"].toArray()) {
+        if (lremovexattr(native.constData(), name.toString().toUtf8().constData()) != 0 && errno != ENODATA) {
+            return failed(name.toString());
+        }
+    }
+    return true;
+#else
+    Q_UNUSED(path)
+    Q_UNUSED(changes)
+    if (error) *error = "ACL and extended attributes are only supported on Linux";
+    return false;
+#endif
+}
@@ -0,0 +1,750 @@
+#include "FileOperation.h"
+#include "ResourceGovernor.h"
+#include "FileAttributes.h"
+#include <QFutureWatcher>
+#include <QtConcurrentRun>
+#include <QThreadPool>
+#include <QMutex>
+#include <QWaitCondition>
+#include <QJsonArray>
+#include <QFile>
+#include <QFileInfo>
+#include <QDir>
+#include <QHash>
+#include <QVector>
+#include <atomic>
+#ifdef Q_OS_LINUX
+#include <dirent.h>
+#include <fcntl.h>
+#include <grp.h>
+#include <pwd.h>
+#include <sys/stat.h>
+#include <sys/xattr.h>
+#include <unistd.h>
+#include <cerrno>
+#include <climits>
+#include <cstdio>
+#include <cstring>
+#endif
+
+namespace {
+
+const int progressIntervalMs = 250;
+// Больше ошибок клиенту не отдаём, только счётчик
+const int maxReportedErrors = 1000;
+const int copyBufferSize = 256 * 1024;
+const int maxWorkers = 8;
+
+int defaultWorkerCount()
+{
+    return qBound(2, QThread::idealThreadCount(), maxWorkers);
+}
+
+// Свой пул: долгий обход дерева не должен занимать потоки тяжёлых RPC
+QThreadPool* workerPool()
+{
+    static QThreadPool pool;
+    static const bool configured = [] {
+        pool.setMaxThreadCount(defaultWorkerCount());
+        return true;
+    }();
+    Q_UNUSED(configured)
+    return &pool;
+}
+
+QString joinPath(const QString& directory, const QString& name)
+{
+    return directory.endsWith('/') ? directory + name : directory + '/' + name;
+}
+
+} // namespace
+
+#ifdef Q_OS_LINUX
+
+enum class FileOpKind { Chmod, Chown, SetAcl, Delete, Copy, Move };
+
+// Открытый каталог дерева. Дескрипторы живут, пока живы записи внутри него;
+// pending - сколько детей ещё не обработано плюс один за сам листинг
+struct DirNode {
+    std::shared_ptr<DirNode> parent;
+    QByteArray name;          // имя в родительском каталоге
+    QString path;             // только для отчёта
+    int fd = -1;              // исходный каталог
+    int dstFd = -1;           // каталог назначения для copy и move
+    struct stat info {};
+    bool root = false;        // родитель путей из запроса: своего действия нет
+    bool crossDevice = false; // move между файловыми системами идёт копированием
+    std::atomic<int> pending { 1 };
+
+    ~DirNode()
+    {
+        if (fd >= 0) ::close(fd);
+        if (dstFd >= 0) ::close(dstFd);
+    }
+};
+
+struct FileEntry {
+    std::shared_ptr<DirNode> parent;
+    QByteArray name;
+    bool crossDevice = false;
+};
+
+struct FileJob {
+    FileOpKind kind = FileOpKind::Chmod;
+    bool recursive = false;
+    bool dryRun = false;
+    bool overwrite = false;
+    bool hasFileMode = false;
+    bool hasDirMode = false;
+    mode_t fileMode = 0;
+    mode_t dirMode = 0;
+    uid_t uid = static_cast<uid_t>(-1);
+    gid_t gid = static_cast<gid_t>(-1);
+    QByteArray accessAcl;  // готовые значения system.posix_acl_*
+    QByteArray defaultAcl;
+
+    std::atomic<bool> cancelled { false };
+    std::atomic<qint64> processed { 0 };
+    std::atomic<qint64> failed { 0 };
+    std::atomic<qint64> bytes { 0 };
+
+    QMutex mutex;
+    QWaitCondition wake;
+    QVector<FileEntry> queue;
+    int busy = 0;
+
+    QMutex errorMutex;
+    QJsonArray errors;
+
+    void push(const FileEntry& entry);
+    bool next(FileEntry* entry);
+    void done();
+    void cancel();
+    void run();
+    void fail(const QString& path, int error);
+
+    void process(const FileEntry& entry);
+    void applyEntry(const FileEntry& entry, const struct stat& info, const QString& path, bool crossDevice);
+    void descend(const FileEntry& entry, const struct stat& info, const QString& path, bool crossDevice);
+    void finishDirectory(const std::shared_ptr<DirNode>& node);
+    void release(const std::shared_ptr<DirNode>& node);
+    bool applyAcl(int fd, bool isDir);
+    bool copyEntry(int srcDir, const char* name, int dstDir, const struct stat& info);
+    bool copyData(int in, int out);
+};
+
+void FileJob::push(const FileEntry& entry)
+{
+    QMutexLocker locker(&mutex);
+    queue.append(entry);
+    wake.wakeOne();
+}
+
+// Стопка, а не очередь: обход в глубину держит открытыми меньше каталогов
+bool FileJob::next(FileEntry* entry)
+{
+    QMutexLocker locker(&mutex);
+    for (;;) {
+        if (cancelled) return false;
+        if (!queue.isEmpty()) {
+            *entry = queue.takeLast();
+            ++busy;
+            return true;
+        }
+        // Пусто и никто не работает - новых записей уже не появится
+        if (busy == 0) {
+            wake.wakeAll();
+            return false;
+        }
+        wake.wait(&mutex);
+    }
+}
+
+void FileJob::done()
+{
+    QMutexLocker locker(&mutex);
+    if (--busy == 0 && queue.isEmpty()) wake.wakeAll();
+}
+
+void FileJob::cancel()
+{
+    QMutexLocker locker(&mutex);
+    cancelled = true;
+    queue.clear();
+    wake.wakeAll();
+}
+
+void FileJob::run()
+{
+    FileEntry entry;
+    while (next(&entry)) {
+        process(entry);
+        entry = FileEntry();
+        done();
+    }
+}
+
+void FileJob::fail(const QString& path, int error)
+{
+    ++failed;
+    QMutexLocker locker(&errorMutex);
+    if (errors.size() >= maxReportedErrors) return;
+    QJsonObject item;
+    item["path"] = path;
+    item["error"] = qt_error_string(error);
+    errors.append(item);
+}
+
+void FileJob::process(const FileEntry& entry)
+{
+    const std::shared_ptr<DirNode>& parent = entry.parent;
+    const QString path = joinPath(parent->path, QFile::decodeName(entry.name));
+    const char* name = entry.name.constData();
+
+    struct stat info;
+    if (fstatat(parent->fd, name, &info, AT_SYMLINK_NOFOLLOW) != 0) {
+        fail(path, errno);
+        release(parent);
+        return;
+    }
+
+    bool crossDevice = entry.crossDevice;
+    // Перемещение внутри одной ФС - один renameat на путь из запроса
+    if (kind == FileOpKind::Move && !crossDevice) {
+        const unsigned int flags = overwrite ? 0 : RENAME_NOREPLACE;
+        if (dryRun || renameat2(parent->fd, name, parent->dstFd, name, flags) == 0) {
+            ++processed;
+            release(parent);
+            return;
+        }
+        if (errno != EXDEV) {
+            fail(path, errno);
+            release(parent);
+            return;
+        }
+        crossDevice = true;
+    }
+
+    if (S_ISDIR(info.st_mode) && (recursive || crossDevice)) {
+        descend(entry, info, path, crossDevice);
+    } else {
+        applyEntry(entry, info, path, crossDevice);
+        release(parent);
+    }
+}
+
+void FileJob::applyEntry(const FileEntry& entry, const struct stat& info, const QString& path, bool crossDevice)
+{
+    const int dirFd = entry.parent->fd;
+    const char* name = entry.name.constData();
+    const bool isDir = S_ISDIR(info.st_mode);
+    bool ok = true;
+
+    switch (kind) {
+    case FileOpKind::Chmod:
+        // У символической ссылки своих прав нет, а цель трогать нельзя
+        if (S_ISLNK(info.st_mode) || (isDir ? !hasDirMode : !hasFileMode)) return;
+        ok = dryRun || fchmodat(dirFd, name, isDir ? dirMode : fileMode, 0) == 0;
+        break;
+    case FileOpKind::Chown:
+        ok = dryRun || fchownat(dirFd, name, uid, gid, AT_SYMLINK_NOFOLLOW) == 0;
+        break;
+    case FileOpKind::SetAcl: {
+        // Открываем без перехода по ссылке; устройства и каналы не трогаем
+        if (!isDir && !S_ISREG(info.st_mode)) return;
+        if (dryRun) break;
+        const int fd = openat(dirFd, name, O_RDONLY | O_NOFOLLOW | O_NONBLOCK | O_CLOEXEC);
+        ok = fd >= 0 && applyAcl(fd, isDir);
+        const int error = errno;
+        if (fd >= 0) ::close(fd);
+        errno = error;
+        break;
+    }
+    case FileOpKind::Delete:
+        ok = dryRun || unlinkat(dirFd, name, isDir ? AT_REMOVEDIR : 0) == 0;
+        break;
+    case FileOpKind::Copy:
+    case FileOpKind::Move:
+        ok = dryRun || copyEntry(dirFd, name, entry.parent->dstFd, info);
+        if (ok && crossDevice && !dryRun) ok = unlinkat(dirFd, name, 0) == 0;
+        if (ok && S_ISREG(info.st_mode)) bytes += info.st_size;
+        break;
+    }
+
+    if (ok) ++processed;
+    else fail(path, errno);
+}
+
+void FileJob::descend(const FileEntry& entry, const struct stat& info, const QString& path, bool crossDevice)
+{
+    const std::shared_ptr<DirNode>& parent = entry.parent;
+    const char* name = entry.name.constData();
+
+    auto node = std::make_shared<DirNode>();
+    node->parent = parent;
+    node->name = entry.name;
+    node->path = path;
+    node->info = info;
+    node->crossDevice = crossDevice;
+    node->fd = openat(parent->fd, name, O_RDONLY | O_DIRECTORY | O_NOFOLLOW | O_CLOEXEC);
+    if (node->fd < 0) {
+        fail(path, errno);
+        release(parent);
+        return;
+    }
+
+    const bool copying = kind == FileOpKind::Copy || crossDevice;
+    if (copying && !dryRun) {
+        // Права копии ставятся после заполнения: каталог без w не даст создать детей
+        if (mkdirat(parent->dstFd, name, 0700) != 0 && errno != EEXIST) {
+            fail(path, errno);
+            release(parent);
+            return;
+        }
+        node->dstFd = openat(parent->dstFd, name, O_RDONLY | O_DIRECTORY | O_NOFOLLOW | O_CLOEXEC);
+        if (node->dstFd < 0) {
+            fail(path, errno);
+            release(parent);
+            return;
+        }
+    }
+
+    // Листинг через свою копию дескриптора: closedir закроет только её
+    const int listFd = dup(node->fd);
+    DIR* dir = listFd >= 0 ? fdopendir(listFd) : nullptr;
+    if (!dir) {
+        const int error = errno;
+        if (listFd >= 0) ::close(listFd);
+        fail(path, error);
+        release(parent);
+        return;
+    }
+    while (dirent* item = readdir(dir)) {
+        if (cancelled) break;
+        if (strcmp(item->d_name, ".") == 0 || strcmp(item->d_name, "..") == 0) continue;
+        ++node->pending;
+        push(FileEntry{ node, QByteArray(item->d_name), crossDevice });
+    }
+    closedir(dir);
+
+    // Родитель отпускается вместе с node в finishDirectory
+    release(node);
+}
+
+// Все дети обработаны: действие над самим каталогом
+void FileJob::finishDirectory(const std::shared_ptr<DirNode>& node)
+{
+    if (!cancelled) {
+        const bool copying = kind == FileOpKind::Copy || node->crossDevice;
+        bool ok = true;
+        if (!dryRun) {
+            if (kind == FileOpKind::Chmod && hasDirMode) {
+                ok = fchmod(node->fd, dirMode) == 0;
+            } else if (kind == FileOpKind::Chown) {
+                ok = fchown(node->fd, uid, gid) == 0;
+            } else if (kind == FileOpKind::SetAcl) {
+                ok = applyAcl(node->fd, true);
+            }
+            if (ok && copying) {
+                const struct timespec times[2] = { node->info.st_atim, node->info.st_mtim };
+                ok = fchmod(node->dstFd, node->info.st_mode & 07777) == 0 && futimens(node->dstFd, times) == 0;
+            }
+            if (ok && (kind == FileOpKind::Delete || node->crossDevice)) {
+                ok = unlinkat(node->parent->fd, node->name.constData(), AT_REMOVEDIR) == 0;
+            }
+        }
+        if (ok) ++processed;
+        else fail(node->path, errno);
+    }
+    release(node->parent);
+}
+
+void FileJob::release(const std::shared_ptr<DirNode>& node)
+{
+    if (node->root) return;
+    if (--node->pending == 0) finishDirectory(node);
+}
+
+// ACL по умолчанию бывает только у каталогов
+bool FileJob::applyAcl(int fd, bool isDir)
+{
+    if (!accessAcl.isEmpty()
+        && fsetxattr(fd, FileAttributes::accessAclName(), accessAcl.constData(), accessAcl.size(), 0) != 0) {
+        return false;
+    }
+    if (isDir && !defaultAcl.isEmpty()
+        && fsetxattr(fd, FileAttributes::defaultAclName(), defaultAcl.constData(), defaultAcl.size(), 0) != 0) {
+        return false;
+    }
+    return true;
+}
+
+bool FileJob::copyEntry(int srcDir, const char* name, int dstDir, const struct stat& info)
+{
+    if (S_ISLNK(info.st_mode)) {
+        char target[PATH_MAX];
+        const ssize_t length = readlinkat(srcDir, name, target, sizeof(target) - 1);
+        if (length < 0) return false;
+        target[length] = '\0';
+        if (symlinkat(target, dstDir, name) == 0) return true;
+        if (errno != EEXIST || !overwrite || unlinkat(dstDir, name, 0) != 0) return false;
+        return symlinkat(target, dstDir, name) == 0;
+    }
+    if (!S_ISREG(info.st_mode)) {
+        // Каталог копируется только с recursive; устройства, сокеты и каналы - никогда
+        errno = S_ISDIR(info.st_mode) ? EISDIR : ENOTSUP;
+        return false;
+    }
+
+    const int in = openat(srcDir, name, O_RDONLY | O_NOFOLLOW | O_CLOEXEC);
+    if (in < 0) return false;
+    const int flags = O_WRONLY | O_CREAT | O_NOFOLLOW | O_CLOEXEC | (overwrite ? O_TRUNC : O_EXCL);
+    const int out = openat(dstDir, name, flags, 0600);
+    if (out < 0) {
+        const int error = errno;
+        ::close(in);
+        errno = error;
+        return false;
+    }
+
+    const struct timespec times[2] = { info.st_atim, info.st_mtim };
+    bool ok = copyData(in, out) && fchmod(out, info.st_mode & 07777) == 0 && futimens(out, times) == 0;
+    const int error = errno;
+    ::close(in);
+    if (::close(out) != 0 && ok) return false;
+    errno = error;
+    return ok;
+}
+
+bool FileJob::copyData(int in, int out)
+{
+    // copy_file_range копирует внутри ядра (и reflink, где ФС умеет);
+    // если он недоступен для этой пары ФС - обычный read/write
+    for (;;) {
+        if (cancelled) {
+            errno = ECANCELED;
+            return false;
+        }
+        const ssize_t copied = copy_file_range(in, nullptr, out, nullptr, copyBufferSize, 0);
+        if (copied == 0) return true;
+        if (copied > 0) continue;
+        if (errno == EINTR) continue;
+        if (errno == ENOSYS || errno == EXDEV || errno == EINVAL || errno == EOPNOTSUPP) break;
+        return false;
+    }
+
+    QByteArray buffer(copyBufferSize, Qt::Uninitialized);
+    for (;;) {
+        if (cancelled) {
+            errno = ECANCELED;
+            return false;
+        }
+        const ssize_t got = ::read(in, buffer.data(), buffer.size());
+        if (got == 0) return true;
+        if (got < 0) {
+            if (errno == EINTR) continue;
+            return false;
+        }
+        for (ssize_t written = 0; written < got;) {
+            const ssize_t n = ::write(out, buffer.constData() + written, got - written);
+            if (n < 0) {
+                if (errno == EINTR) continue;
+                return false;
+            }
+            written += n;
+        }
+    }
+}
+
+namespace {
+
+bool parseMode(const QJsonValue& value, mode_t* mode)
+{
+    bool ok = false;
+    const uint parsed = value.toString().toUInt(&ok, 8);
+    if (!ok || parsed > 07777) return false;
+    *mode = static_cast<mode_t>(parsed);
+    return true;
+}
+
+bool resolveUser(const QString& name, uid_t* uid)
+{
+    bool numeric = false;
+    const uint id = name.toUInt(&numeric);
+    if (numeric) {
+        *uid = static_cast<uid_t>(id);
+        return true;
+    }
+    const passwd* pw = getpwnam(name.toLocal8Bit().constData());
+    if (!pw) return false;
+    *uid = pw->pw_uid;
+    return true;
+}
+
+bool resolveGroup(const QString& name, gid_t* gid)
+{
+    bool numeric = false;
+    const uint id = name.toUInt(&numeric);
+    if (numeric) {
+        *gid = static_cast<gid_t>(id);
+        return true;
+    }
+    const group* gr = getgrnam(name.toLocal8Bit().constData());
+    if (!gr) return false;
+    *gid = gr->gr_gid;
+    return true;
+}
+
+} // namespace
+
+#else
+
+// Обход на *at()-вызовах есть только в Linux-сборке
+struct FileJob {
+    std::atomic<bool> cancelled { false };
+    std::atomic<qint64> processed { 0 };
+    std::atomic<qint64> failed { 0 };
+    std::atomic<qint64> bytes { 0 };
+    bool dryRun = false;
+    QMutex errorMutex;
+    QJsonArray errors;
+
+    void cancel() { cancelled = true; }
+    void run() {}
+};
+
+#endif
+
+FileOperation::FileOperation(int operationId, const QJsonObject& params, QObject* parent)
+    : QObject(parent),
+      operationId(operationId),
+      valid(false),
+      job(std::make_shared<FileJob>()),
+      workersRunning(0)
+{
+    progressTimer.setInterval(progressIntervalMs);
+    connect(&progressTimer, &QTimer::timeout, this, &FileOperation::reportProgress);
+
+#ifdef Q_OS_LINUX
+    static const QHash<QString, FileOpKind> kinds = {
+        { "chmod", FileOpKind::Chmod }, { "chown", FileOpKind::Chown }, { "setAcl", FileOpKind::SetAcl },
+        { "delete", FileOpKind::Delete },
+        { "copy", FileOpKind::Copy }, { "move", FileOpKind::Move },
+    };
+    const QString op = params["operation"].toString();
+    if (!kinds.contains(op)) {
+        fail(QString("Unknown operation '%1'").arg(op));
+        return;
+    }
+    job->kind = kinds.value(op);
+    job->recursive = params["recursive"].toBool();
+    job->dryRun = params["dryRun"].toBool();
+    job->overwrite = params["overwrite"].toBool();
+
+    QStringList paths;
+    for (const QJsonValue& value : params["paths"].toArray()) paths << value.toString();
+    if (params.contains("path")) paths << params["path"].toString();
+    if (paths.isEmpty()) {
+        fail("No paths given");
+        return;
+    }
+    for (QString& path : paths) {
+        if (!QFileInfo(path).isAbsolute()) {
+            fail(QString("Path must be absolute: %1").arg(path));
+            return;
+        }
+        path = QDir::cleanPath(path);
+        // Корень не удаляется и не переносится, и у него нет родителя для *at()
+        if (path == "/") {
+            fail("Refusing to operate on /");
+            return;
+        }
+    }
+
+    switch (job->kind) {
+    case FileOpKind::Chmod:
+        if (params.contains("mode")) {
+            if (!parseMode(params["mode"], &job->fileMode)) {
+                fail("Invalid mode, expected octal string");
+                return;
+            }
+            job->dirMode = job->fileMode;
+            job->hasFileMode = job->hasDirMode = true;
+        }
+        if (params.contains("fileMode")) {
+            job->hasFileMode = parseMode(params["fileMode"], &job->fileMode);
+            if (!job->hasFileMode) {
+                fail("Invalid fileMode, expected octal string");
+                return;
+            }
+        }
+        if (params.contains("dirMode")) {
+            job->hasDirMode = parseMode(params["dirMode"], &job->dirMode);
+            if (!job->hasDirMode) {
+                fail("Invalid dirMode, expected octal string");
+                return;
+            }
+        }
+        if (!job->hasFileMode && !job->hasDirMode) {
+            fail("chmod needs mode, fileMode or dirMode");
+            return;
+        }
+        break;
+    case FileOpKind::Chown: {
+        const QString owner = params["owner"].toString();
+        const QString groupName = params["group"].toString();
+        if (owner.isEmpty() && groupName.isEmpty()) {
+            fail("chown needs owner or group");
+            return;
+        }
+        if (!owner.isEmpty() && !resolveUser(owner, &job->uid)) {
+            fail(QString("Unknown user '%1'").arg(owner));
+            return;
+        }
+        if (!groupName.isEmpty() && !resolveGroup(groupName, &job->gid)) {
+            fail(QString("Unknown group '%1'").arg(groupName));
+            return;
+        }
+        break;
+    }
+    case FileOpKind::SetAcl: {
+        if (!params.contains("acl") && !params.contains("defaultAcl")) {
+            fail("setAcl needs acl or defaultAcl");
+            return;
+        }
+        QString aclError;
+        if ((params.contains("acl") && !FileAttributes::encodeAcl(params["acl"].toString(), &job->accessAcl, &aclError))
+            || (params.contains("defaultAcl")
+                && !FileAttributes::encodeAcl(params["defaultAcl"].toString(), &job->defaultAcl, &aclError))) {
+            fail(aclError);
+            return;
+        }
+        break;
+    }
+    case FileOpKind::Delete:
+        break;
+    case FileOpKind::Copy:
+    case FileOpKind::Move: {
+        if (!QFileInfo(params["destination"].toString()).isAbsolute()) {
+            fail("destination must be an absolute directory path");
+            return;
+        }
+        // Копия внутрь самой себя никогда не закончится
+        const QString destination = QDir::cleanPath(params["destination"].toString());
+        for (const QString& path : paths) {
+            if (destination == path || destination.startsWith(path + '/')) {
+                fail(QString("destination is inside %1").arg(path));
+                return;
+            }
+        }
+        break;
+    }
+    }
+
+    int destinationFd = -1;
+    if (job->kind == FileOpKind::Copy || job->kind == FileOpKind::Move) {
+        const QByteArray destination = QFile::encodeName(QDir::cleanPath(params["destination"].toString()));
+        destinationFd = ::open(destination.constData(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+        if (destinationFd < 0) {
+            fail(QString("Cannot open destination: %1").arg(qt_error_string(errno)));
+            return;
+        }
+    }
+
+    // Пути из запроса группируются по родителю: один дескриптор на каталог
+    QHash<QString, std::shared_ptr<DirNode>> roots;
+    for (const QString& path : paths) {
+        const QFileInfo info(path);
+        const QString directory = info.path();
+        std::shared_ptr<DirNode> node = roots.value(directory);
+        if (!node) {
+            node = std::make_shared<DirNode>();
+            node->root = true;
+            node->path = directory;
+            node->fd = ::open(QFile::encodeName(directory).constData(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+            if (node->fd < 0) {
+                job->fail(path, errno);
+                continue;
+            }
+            if (destinationFd >= 0) node->dstFd = ::dup(destinationFd);
+            roots.insert(directory, node);
+        }
+        job->queue.append(FileEntry{ node, QFile::encodeName(info.fileName()), false });
+    }
+    if (destinationFd >= 0) ::close(destinationFd);
+    valid = true;
+#else
+    Q_UNUSED(params)
+    fail("Bulk file operations are only supported on Linux");
+#endif
+}
+
+FileOperation::~FileOperation()
+{
+    // Рабочие держат job через shared_ptr и сами выйдут на следующей записи
+    job->cancel();
+}
+
+void FileOperation::fail(const QString& message)
+{
+    valid = false;
+    error = message;
+}
+
+void FileOperation::setWorkerThreads(int count)
+{
+    workerPool()->setMaxThreadCount(count > 0 ? count : defaultWorkerCount());
+}
+
+void FileOperation::start()
+{
+    clock.start();
+    progressTimer.start();
+    QThreadPool* pool = workerPool();
+    // Половина пула на операцию: две одновременные не ждут друг друга
+    workersRunning = qMax(1, pool->maxThreadCount() / 2);
+    const std::shared_ptr<FileJob> shared = job;
+    for (int i = 0; i < workersRunning; ++i) {
+        auto* watcher = new QFutureWatcher<void>(this);
+        connect(watcher, &QFutureWatcher<void>::finished, this, &FileOperation::onWorkerFinished);
+        watcher->setFuture(QtConcurrent::run(pool, [shared]() {
+            ResourceGovernor::enterBackground();
+            shared->run();
+        }));
+    }
+}
+
+void FileOperation::cancel()
+{
+    job->cancel();
+}
+
+QJsonObject FileOperation::state() const
+{
+    QJsonObject result;
+    result["operation"] = operationId;
+    result["processed"] = static_cast<double>(job->processed.load());
+    result["failed"] = static_cast<double>(job->failed.load());
+    result["bytes"] = static_cast<double>(job->bytes.load());
+    result["elapsedMs"] = static_cast<double>(clock.elapsed());
+    result["dryRun"] = job->dryRun;
+    return result;
+}
+
+void FileOperation::reportProgress()
+{
+    emit progress(operationId, state());
+}
+
+void FileOperation::onWorkerFinished()
+{
+    if (--workersRunning > 0) return;
+    progressTimer.stop();
+    QJsonObject summary = state();
+    summary["status"] = job->cancelled ? "cancelled" : "completed";
+    QMutexLocker locker(&job->errorMutex);
+    summary["errors"] = job->errors;
+    summary["errorsTruncated"] = job->failed > job->errors.size();
+    locker.unlock();
+    emit finished(operationId, summary);
+}
@@ -0,0 +1,230 @@
+#include "LogTail.h"
+#include <QFileInfo>
+#include <QCoreApplication>
+
+namespace {
+
+const int flushIntervalMs = 200;
+const int readChunkSize = 256 * 1024;
+const int maxAllowedBytesPerSecond = 4 * 1024 * 1024;
+
+} // namespace
+
+// ========== LogStream ==========
+
+LogStream::LogStream(int streamId, const QString& filterPattern, int bytesPerSecond, QObject* parent)
+    : QObject(parent),
+      valid(true),
+      subscriptionId(streamId),
+      droppedBytes(0),
+      tokens(0),
+      maxBytesPerSecond(qBound(1024, bytesPerSecond, maxAllowedBytesPerSecond))
+{
+    if (!filterPattern.isEmpty()) {
+        filter.setPattern(filterPattern);
+        if (!filter.isValid()) {
+            fail("Invalid filter: " + filter.errorString());
+            return;
+        }
+        filter.optimize();
+    }
+
+    tokens = maxBytesPerSecond;
+    refillClock.start();
+
+    flushTimer.setInterval(flushIntervalMs);
+    connect(&flushTimer, &QTimer::timeout, this, &LogStream::flush);
+    flushTimer.start();
+}
+
+void LogStream::fail(const QString& message)
+{
+    valid = false;
+    error = message;
+}
+
+void LogStream::feed(const QByteArray& bytes)
+{
+    partialLine.append(bytes);
+    int start = 0;
+    int newline;
+    while ((newline = partialLine.indexOf('\n', start)) >= 0) {
+        appendLine(partialLine.mid(start, newline - start + 1));
+        start = newline + 1;
+    }
+    partialLine.remove(0, start);
+
+    // Строка без перевода слишком длинная - отдаём как есть, чтобы буфер не рос
+    if (partialLine.size() > readChunkSize) {
+        appendLine(partialLine);
+        partialLine.clear();
+    }
+}
+
+void LogStream::appendLine(const QByteArray& line)
+{
+    if (filter.pattern().isEmpty() || filter.match(QString::fromUtf8(line)).hasMatch()) {
+        // Не копим больше, чем можно отправить за секунду
+        if (pending.size() + line.size() > maxBytesPerSecond) {
+            droppedBytes += line.size();
+        } else {
+            pending.append(line);
+        }
+    }
+}
+
+void LogStream::flush()
+{
+    tokens = qMin(maxBytesPerSecond, tokens + refillClock.restart() * maxBytesPerSecond / 1000);
+    if (pending.isEmpty() && droppedBytes == 0) return;
+
+    // Отправляем целые строки в пределах бюджета
+    int length = pending.size();
+    if (length > tokens) {
+        if (tokens <= 0) return;
+        length = pending.lastIndexOf('\n', static_cast<int>(tokens) - 1) + 1;
+        if (length <= 0) return;
+    }
+
+    QByteArray chunk = pending.left(length);
+    pending.remove(0, length);
+    tokens -= chunk.size();
+
+    emit dataReady(subscriptionId, chunk, droppedBytes);
+    droppedBytes = 0;
+}
+
+// ========== FileTailStream ==========
+
+FileTailStream::FileTailStream(int subscriptionId, const QString& filePath, qint64 backlogBytes,
+                               const QString& filter, int maxBytesPerSecond, QObject* parent)
+    : LogStream(subscriptionId, filter, maxBytesPerSecond, parent),
+      path(QFileInfo(filePath).absoluteFilePath()),
+      offset(0)
+{
+    if (!valid) return;
+
+    QFileInfo info(path);
+    if (!info.isFile()) {
+        fail("Not a regular file: " + path);
+        return;
+    }
+    if (!reopen(qMax<qint64>(0, info.size() - qMax<qint64>(0, backlogBytes)))) return;
+
+    // Каталог нужен, чтобы заметить пересоздание файла после ротации
+    watcher.addPath(path);
+    watcher.addPath(info.absolutePath());
+    connect(&watcher, &QFileSystemWatcher::fileChanged, this, &FileTailStream::onFileChanged);
+    connect(&watcher, &QFileSystemWatcher::directoryChanged, this, &FileTailStream::onDirectoryChanged);
+
+    onFileChanged();
+}
+
+bool FileTailStream::reopen(qint64 startOffset)
+{
+    file.close();
+    file.setFileName(path);
+    if (!file.open(QIODevice::ReadOnly)) {
+        fail("Cannot open " + path + ": " + file.errorString());
+        return false;
+    }
+    offset = startOffset;
+    return true;
+}
+
+void FileTailStream::onFileChanged()
+{
+    if (!file.isOpen()) return;
+
+    qint64 size = file.size();
+    if (size < offset) {
+        // Файл усечён (logrotate copytruncate) - читаем с начала
+        offset = 0;
+    }
+
+    // Если приросло больше, чем можно отправить, пропускаем середину не читая её
+    const qint64 backlog = size - offset;
+    if (backlog > 4 * readChunkSize && backlog > 2 * budgetLeft()) {
+        qint64 skip = backlog - qMax<qint64>(readChunkSize, budgetLeft());
+        drop(skip);
+        offset += skip;
+    }
+
+    if (!file.seek(offset)) return;
+    while (offset < size) {
+        QByteArray data = file.read(qMin<qint64>(readChunkSize, size - offset));
+        if (data.isEmpty()) break;
+        offset += data.size();
+        feed(data);
+    }
+}
+
+void FileTailStream::onDirectoryChanged()
+{
+    QFileInfo info(path);
+    if (!info.exists()) return; // ждём, пока файл создадут заново
+
+    // Ротация переименованием: под тем же именем теперь другой inode
+    if (!watcher.files().contains(path)) {
+        onFileChanged(); // дочитываем старый файл
+        if (reopen(0)) {
+            watcher.addPath(path);
+            onFileChanged();
+        }
+    }
+}
+
+// ========== JournalStream ==========
+
+JournalStream::JournalStream(int subscriptionId, const QStringList& units, int backlogLines,
+                             const QString& filter, int maxBytesPerSecond, QObject* parent)
+    : LogStream(subscriptionId, filter, maxBytesPerSecond, parent),
+      journalctl(new QProcess(this))
+{
+    if (!valid) return;
+
+    QStringList args = { "--follow", "--no-pager", "--output=short-iso",
+                         "--lines=" + QString::number(qMax(0, backlogLines)) };
+    for (const QString& unit : units) {
+        args << "--unit=" + unit;
+    }
+
+    connect(journalctl, &QProcess::readyReadStandardOutput, this, &JournalStream::onReadyRead);
+    connect(journalctl, QOverload<int, QProcess::ExitStatus>::of(&QProcess::finished),
+            this, &JournalStream::onFinished);
+    // Queued: подписка успевает появиться и получить ответ раньше, чем закроется
+    connect(journalctl, &QProcess::errorOccurred, this, &JournalStream::onError, Qt::QueuedConnection);
+
+    journalctl->start("journalctl", args);
+}
+
+JournalStream::~JournalStream()
+{
+    if (journalctl->state() != QProcess::NotRunning) {
+        // Деструктор QProcess ждёт процесс синхронно; убитый journalctl
+        // доживает до finished без владельца-потока
+        disconnect(journalctl, nullptr, this, nullptr);
+        journalctl->setParent(QCoreApplication::instance());
+        connect(journalctl, QOverload<int, QProcess::ExitStatus>::of(&QProcess::finished),
+                journalctl, &QObject::deleteLater);
+        journalctl->kill();
+    }
+}
+
+void JournalStream::onReadyRead()
+{
+    feed(journalctl->readAllStandardOutput());
+}
+
+void JournalStream::onError(QProcess::ProcessError error)
+{
+    // Остальные ошибки сопровождаются finished
+    if (error != QProcess::FailedToStart) return;
+    emit closed(id(), "Cannot start journalctl: " + journalctl->errorString());
+}
+
+void JournalStream::onFinished(int exitCode, QProcess::ExitStatus status)
+{
+    Q_UNUSED(status);
+    emit closed(id(), QString("journalctl exited with code %1").arg(exitCode));
+}
@@ -0,0 +1,180 @@
+#include "NetworkMonitor.h"
+#include <QFile>
+#include <QJsonArray>
+#include <QList>
+
+namespace {
+
+QByteArray readProcFile(const QString& path)
+{
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly)) return QByteArray();
+    return file.readAll();
+}
+
+double ratePerSecond(qulonglong current, qulonglong previous, qint64 elapsedMs)
+{
+    if (elapsedMs <= 0 || current < previous) return 0.0;
+    return (current - previous) * 1000.0 / elapsedMs;
+}
+
+} // namespace
+
+NetworkMonitor::NetworkMonitor(const QString& procRoot, const QString& sysRoot, QObject* parent)
+    : QObject(parent),
+      procRoot(procRoot),
+      sysRoot(sysRoot),
+      minIntervalMs(500)
+{
+    clock.start();
+}
+
+QJsonObject NetworkMonitor::collect()
+{
+    if (previous.timestampMs >= 0 && clock.elapsed() - previous.timestampMs < minIntervalMs &&
+        !lastResult.isEmpty()) {
+        return lastResult;
+    }
+
+    Sample current = readSample();
+    const bool hasPrevious = previous.timestampMs >= 0;
+    const qint64 elapsedMs = hasPrevious ? current.timestampMs - previous.timestampMs : 0;
+
+    QJsonArray interfaces;
+    for (auto it = current.interfaces.constBegin(); it != current.interfaces.constEnd(); ++it) {
+        const InterfaceCounters& cur = it.value();
+        const InterfaceCounters prev = previous.interfaces.value(it.key(), cur);
+
+        QJsonObject iface;
+        iface["name"] = it.key();
+        iface["operstate"] = QString::fromUtf8(
+            readProcFile(sysRoot + "/class/net/" + it.key() + "/operstate").trimmed());
+        iface["rx_bytes"] = static_cast<qint64>(cur.rxBytes);
+        iface["tx_bytes"] = static_cast<qint64>(cur.txBytes);
+        iface["rx_packets"] = static_cast<qint64>(cur.rxPackets);
+        iface["tx_packets"] = static_cast<qint64>(cur.txPackets);
+        iface["rx_errors"] = static_cast<qint64>(cur.rxErrors);
+        iface["tx_errors"] = static_cast<qint64>(cur.txErrors);
+        iface["rx_dropped"] = static_cast<qint64>(cur.rxDropped);
+        iface["tx_dropped"] = static_cast<qint64>(cur.txDropped);
+        iface["rx_bytes_per_sec"] = ratePerSecond(cur.rxBytes, prev.rxBytes, elapsedMs);
+        iface["tx_bytes_per_sec"] = ratePerSecond(cur.txBytes, prev.txBytes, elapsedMs);
+        iface["rx_packets_per_sec"] = ratePerSecond(cur.rxPackets, prev.rxPackets, elapsedMs);
+        iface["tx_packets_per_sec"] = ratePerSecond(cur.txPackets, prev.txPackets, elapsedMs);
+        iface["errors_per_sec"] = ratePerSecond(cur.rxErrors + cur.txErrors,
+                                                prev.rxErrors + prev.txErrors, elapsedMs);
+        iface["drops_per_sec"] = ratePerSecond(cur.rxDropped + cur.txDropped,
+                                               prev.rxDropped + prev.txDropped, elapsedMs);
+        interfaces.append(iface);
+    }
+
+    auto counter = [&current](const char* key) { return current.protocol.value(key); };
+    auto rate = [&](const char* key) {
+        return hasPrevious ? ratePerSecond(current.protocol.value(key), previous.protocol.value(key), elapsedMs)
+                           : 0.0;
+    };
+
+    QJsonObject tcp;
+    tcp["curr_estab"] = static_cast<qint64>(counter("Tcp.CurrEstab"));
+    tcp["active_opens_per_sec"] = rate("Tcp.ActiveOpens");
+    tcp["passive_opens_per_sec"] = rate("Tcp.PassiveOpens");
+    tcp["in_segs_per_sec"] = rate("Tcp.InSegs");
+    tcp["out_segs_per_sec"] = rate("Tcp.OutSegs");
+    tcp["retrans_segs"] = static_cast<qint64>(counter("Tcp.RetransSegs"));
+    tcp["retrans_segs_per_sec"] = rate("Tcp.RetransSegs");
+    const double outSegs = rate("Tcp.OutSegs");
+    tcp["retrans_percent"] = outSegs > 0 ? rate("Tcp.RetransSegs") * 100.0 / outSegs : 0.0;
+    tcp["in_errs_per_sec"] = rate("Tcp.InErrs");
+    tcp["out_rsts_per_sec"] = rate("Tcp.OutRsts");
+    tcp["timeouts_per_sec"] = rate("TcpExt.TCPTimeouts");
+    tcp["listen_drops_per_sec"] = rate("TcpExt.ListenDrops");
+    tcp["listen_overflows_per_sec"] = rate("TcpExt.ListenOverflows");
+
+    QJsonObject udp;
+    udp["in_datagrams_per_sec"] = rate("Udp.InDatagrams");
+    udp["out_datagrams_per_sec"] = rate("Udp.OutDatagrams");
+    udp["in_errors_per_sec"] = rate("Udp.InErrors");
+    udp["rcvbuf_errors_per_sec"] = rate("Udp.RcvbufErrors");
+
+    QJsonObject result;
+    result["interval_ms"] = elapsedMs;
+    result["interfaces"] = interfaces;
+    result["tcp"] = tcp;
+    result["udp"] = udp;
+    result["sockets"] = readSocketCounts();
+
+    previous = current;
+    lastResult = result;
+    return result;
+}
+
+NetworkMonitor::Sample NetworkMonitor::readSample() const
+{
+    Sample sample;
+    sample.timestampMs = clock.elapsed();
+
+    // Первые две строки /proc/net/dev - заголовок
+    QList<QByteArray> lines = readProcFile(procRoot + "/net/dev").split('\n');
+    for (int i = 2; i < lines.size(); ++i) {
+        const QByteArray& line = lines[i];
+        int colon = line.indexOf(':');
+        if (colon <= 0) continue;
+
+        QList<QByteArray> values = line.mid(colon + 1).simplified().split(' ');
+        if (values.size() < 16) continue;
+
+        InterfaceCounters counters;
+        counters.rxBytes = values[0].toULongLong();
+        counters.rxPackets = values[1].toULongLong();
+        counters.rxErrors = values[2].toULongLong();
+        counters.rxDropped = values[3].toULongLong();
+        counters.txBytes = values[8].toULongLong();
+        counters.txPackets = values[9].toULongLong();
+        counters.txErrors = values[10].toULongLong();
+        counters.txDropped = values[11].toULongLong();
+        sample.interfaces.insert(QString::fromUtf8(line.left(colon).trimmed()), counters);
+    }
+
+    readProtocolTable(procRoot + "/net/snmp", sample.protocol);
+    readProtocolTable(procRoot + "/net/netstat", sample.protocol);
+    return sample;
+}
+
+void NetworkMonitor::readProtocolTable(const QString& path, QHash<QByteArray, qulonglong>& out) const
+{
+    // Файл состоит из пар строк: "Tcp: Name1 Name2 ..." и "Tcp: 1 2 ..."
+    QList<QByteArray> lines = readProcFile(path).split('\n');
+    for (int i = 0; i + 1 < lines.size(); i += 2) {
+        QList<QByteArray> names = lines[i].simplified().split(' ');
+        QList<QByteArray> values = lines[i + 1].simplified().split(' ');
+        if (names.size() != values.size() || names.isEmpty() || names[0] != values[0]) continue;
+
+        QByteArray prefix = names[0];
+        prefix.chop(1); // убираем ':'
+        for (int j = 1; j < names.size(); ++j) {
+            out.insert(prefix + '.' + names[j], values[j].toULongLong());
+        }
+    }
+}
+
+QJsonObject NetworkMonitor::readSocketCounts() const
+{
+    QJsonObject sockets;
+    for (const QByteArray& line : readProcFile(procRoot + "/net/sockstat").split('\n')) {
+        QList<QByteArray> parts = line.simplified().split(' ');
+        if (parts.size() < 3) continue;
+
+        if (parts[0] == "sockets:") {
+            sockets["used"] = parts[2].toLongLong();
+        } else if (parts[0] == "TCP:") {
+            for (int i = 1; i + 1 < parts.size(); i += 2) {
+                if (parts[i] == "inuse") sockets["tcp_inuse"] = parts[i + 1].toLongLong();
+                else if (parts[i] == "orphan") sockets["tcp_orphan"] = parts[i + 1].toLongLong();
+                else if (parts[i] == "tw") sockets["tcp_time_wait"] = parts[i + 1].toLongLong();
+            }
+        } else if (parts[0] == "UDP:" && parts[1] == "inuse") {
+            sockets["udp_inuse"] = parts[2].toLongLong();
+        }
+    }
+    return sockets;
+}
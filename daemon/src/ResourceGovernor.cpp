@@ -0,0 +1,448 @@
+#include "ResourceGovernor.h"
+#include "AsyncLogger.h"
+#include <QFile>
+#include <QFileInfo>
+#include <QDir>
+#include <QTimer>
+#include <QThread>
+#include <QAtomicInt>
+
+#ifdef Q_OS_LINUX
+#include <sched.h>
+#include <unistd.h>
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#include <cerrno>
+#include <cstring>
+#ifdef __GLIBC__
+#include <malloc.h>
+#endif
+#endif
+
+namespace {
+
+const int sampleIntervalMs = 1000;
+// Выход из режима отказов - на столько процентов ниже порога, чтобы не дребезжать
+const int shedHysteresisPercent = 10;
+const qint64 cpuPeriodUsec = 100000;
+
+#ifdef Q_OS_LINUX
+// linux/ioprio.h есть не везде, значения из него
+const int ioprioWhoProcess = 1;
+const int ioprioClassShift = 13;
+const int ioprioClassRealtime = 1;
+const int ioprioClassBestEffort = 2;
+const int ioprioClassIdle = 3;
+
+// Фоновый режим задаётся из главного потока, а применяется каждым рабочим
+// потоком к себе в начале задачи: номер поколения говорит, что настройки сменились
+QAtomicInt backgroundGeneration(1);
+QAtomicInt backgroundPolicy(SCHED_OTHER);
+QAtomicInt backgroundIoPriority(-1); // -1 - как у процесса
+QAtomicInt processIoPriority(0);
+thread_local int appliedGeneration = 0;
+
+int ioClassFromName(const QString& name)
+{
+    if (name == "realtime") return ioprioClassRealtime;
+    if (name == "best-effort") return ioprioClassBestEffort;
+    if (name == "idle") return ioprioClassIdle;
+    return -1;
+}
+
+int ioPriorityValue(int ioClass, int level)
+{
+    return (ioClass << ioprioClassShift) | (ioClass == ioprioClassIdle ? 0 : level);
+}
+#endif
+
+QByteArray readSmallFile(const QString& path)
+{
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly)) return QByteArray();
+    return file.readAll();
+}
+
+bool writeSmallFile(const QString& path, const QByteArray& data, QString* error)
+{
+    QFile file(path);
+    if (file.open(QIODevice::WriteOnly | QIODevice::Unbuffered) && file.write(data) == data.size()) return true;
+    if (error) *error = QString("%1: %2").arg(path, file.errorString());
+    return false;
+}
+
+// Число байт, либо -1 для "max" и отсутствующего файла
+qint64 readLimit(const QString& path)
+{
+    const QByteArray value = readSmallFile(path).trimmed();
+    bool ok = false;
+    const qint64 number = value.toLongLong(&ok);
+    return ok ? number : -1;
+}
+
+// cpu.max: "квота период" или "max период"; результат - доля ядра, -1 без квоты
+double readCpuQuota(const QString& path)
+{
+    const QList<QByteArray> fields = readSmallFile(path).trimmed().split(' ');
+    if (fields.size() != 2) return -1.0;
+    bool quotaOk = false, periodOk = false;
+    const qint64 quota = fields[0].toLongLong(&quotaOk);
+    const qint64 period = fields[1].toLongLong(&periodOk);
+    return quotaOk && periodOk && period > 0 ? double(quota) / period : -1.0;
+}
+
+// Неактивный страничный кэш из memory.stat: ядро отберёт его первым, не трогая
+// рабочую память, поэтому к потреблению он не относится
+qint64 readInactiveFile(const QString& path)
+{
+    for (const QByteArray& line : readSmallFile(path).split('\n')) {
+        if (line.startsWith("inactive_file ")) return line.mid(14).toLongLong();
+    }
+    return 0;
+}
+
+qint64 readCpuUsageUsec(const QString& path)
+{
+    for (const QByteArray& line : readSmallFile(path).split('\n')) {
+        if (line.startsWith("usage_usec ")) return line.mid(11).toLongLong();
+    }
+    return -1;
+}
+
+// "20%" -> "20000 100000"; пусто - без квоты
+QByteArray cpuMaxValue(const QString& quota, bool* ok)
+{
+    *ok = true;
+    if (quota.isEmpty()) return "max " + QByteArray::number(cpuPeriodUsec);
+    QString percent = quota.trimmed();
+    if (percent.endsWith('%')) percent.chop(1);
+    const double value = percent.toDouble(ok);
+    if (!*ok || value <= 0.0) {
+        *ok = false;
+        return QByteArray();
+    }
+    const qint64 usec = qMax<qint64>(1000, qRound64(value * cpuPeriodUsec / 100.0));
+    return QByteArray::number(usec) + ' ' + QByteArray::number(cpuPeriodUsec);
+}
+
+QString parentCgroup(const QString& path)
+{
+    const int slash = path.lastIndexOf('/');
+    return slash > 0 ? path.left(slash) : QString("/");
+}
+
+QJsonValue optionalNumber(double value)
+{
+    return value < 0 ? QJsonValue() : QJsonValue(value);
+}
+
+} // namespace
+
+ResourceGovernor::ResourceGovernor(const QString& procRoot, const QString& cgroupRoot, QObject* parent)
+    : QObject(parent),
+      procRoot(procRoot),
+      cgroupRoot(cgroupRoot),
+      configured(false),
+      sampleTimer(new QTimer(this)),
+      lastSampleUsec(0),
+      shedding(false),
+      shedRequests(0)
+{
+    // Своя cgroup есть только в единой иерархии v2: строка "0::/путь"
+    for (const QByteArray& line : readSmallFile(procRoot + "/self/cgroup").split('\n')) {
+        if (line.startsWith("0::")) startCgroup = QString::fromUtf8(line.mid(3).trimmed());
+    }
+    if (!startCgroup.isEmpty() && !QFileInfo::exists(cgroupRoot + startCgroup + "/cgroup.procs")) startCgroup.clear();
+
+    pool.setMaxThreadCount(qBound(2, QThread::idealThreadCount() / 2, 4));
+    clock.start();
+    connect(sampleTimer, &QTimer::timeout, this, &ResourceGovernor::sample);
+    sampleTimer->start(sampleIntervalMs);
+}
+
+void ResourceGovernor::setOptions(const Options& options)
+{
+    if (!configured && !options.cgroup.isEmpty()) {
+        QString error;
+        if (enterCgroup(options.cgroup, &error)) qCInfo(lcServer) << "Daemon moved to cgroup" << ownCgroup;
+        else qCWarning(lcServer) << "Cannot move daemon to its own cgroup:" << error;
+    } else if (configured && options.cgroup != current.cgroup) {
+        qCWarning(lcServer) << "resources/cgroup change takes effect after restart";
+    }
+
+    if (!ownCgroup.isEmpty()) {
+        QString error;
+        if (!writeLimits(options, &error)) qCWarning(lcServer) << "Cannot set daemon resource limits:" << error;
+    } else if (!options.cpuQuota.isEmpty() || !options.memoryMax.isEmpty() || !options.memoryHigh.isEmpty()) {
+        qCWarning(lcServer) << "resources/cpuQuota and memory limits need resources/cgroup";
+    }
+
+    setBackgroundPolicy(options);
+    const QString cgroup = configured ? current.cgroup : options.cgroup;
+    current = options;
+    current.cgroup = cgroup;
+    configured = true;
+    sample();
+}
+
+bool ResourceGovernor::enterCgroup(const QString& name, QString* error)
+{
+    if (startCgroup.isEmpty()) {
+        if (error) *error = "cgroup v2 hierarchy not found";
+        return false;
+    }
+    const QString relative = QDir::cleanPath(name.startsWith('/') ? name : startCgroup + '/' + name);
+    const QString directory = cgroupRoot + relative;
+    if (!QDir().mkpath(directory)) {
+        if (error) *error = "cannot create " + directory;
+        return false;
+    }
+
+    // Переносится весь процесс со всеми потоками
+#ifdef Q_OS_LINUX
+    if (!writeSmallFile(directory + "/cgroup.procs", QByteArray::number(qint64(::getpid())), error)) return false;
+#endif
+
+    // Контроллеры включаются у родителя, и только когда в нём самом не осталось
+    // процессов - поэтому после переноса
+    const QList<QByteArray> available = readSmallFile(directory + "/cgroup.controllers").trimmed().split(' ');
+    QByteArrayList missing;
+    for (const QByteArray& controller : { QByteArray("cpu"), QByteArray("memory") }) {
+        if (!available.contains(controller)) missing << "+" + controller;
+    }
+    if (!missing.isEmpty()
+        && !writeSmallFile(cgroupRoot + parentCgroup(relative) + "/cgroup.subtree_control", missing.join(' '), error)) {
+        // Без контроллеров пределы не записать: возвращаемся туда, где были,
+        // чтобы не остаться в наполовину настроенной cgroup
+#ifdef Q_OS_LINUX
+        QString backError;
+        if (!writeSmallFile(cgroupRoot + startCgroup + "/cgroup.procs", QByteArray::number(qint64(::getpid())), &backError)) {
+            qCWarning(lcServer) << "Cannot return to cgroup" << startCgroup << ":" << backError;
+            ownCgroup = relative; // остались в новой - пусть это будет видно
+            return false;
+        }
+#endif
+        QDir().rmdir(directory);
+        return false;
+    }
+
+    ownCgroup = relative;
+    previousCpuUsec.clear();
+    return true;
+}
+
+bool ResourceGovernor::writeLimits(const Options& options, QString* error)
+{
+    bool quotaOk = false;
+    const QByteArray cpuMax = cpuMaxValue(options.cpuQuota, &quotaOk);
+    if (!quotaOk) {
+        if (error) *error = QString("bad resources/cpuQuota '%1'").arg(options.cpuQuota);
+        return false;
+    }
+    // memory.max и memory.high сами понимают суффиксы K, M, G
+    const QString directory = cgroupRoot + ownCgroup;
+    return writeSmallFile(directory + "/cpu.max", cpuMax, error)
+        && writeSmallFile(directory + "/memory.high", options.memoryHigh.isEmpty() ? "max" : options.memoryHigh.toUtf8(), error)
+        && writeSmallFile(directory + "/memory.max", options.memoryMax.isEmpty() ? "max" : options.memoryMax.toUtf8(), error);
+}
+
+void ResourceGovernor::setBackgroundPolicy(const Options& options)
+{
+#ifdef Q_OS_LINUX
+    int policy = SCHED_OTHER;
+    if (options.background == "idle") policy = SCHED_IDLE;
+    else if (options.background == "batch") policy = SCHED_BATCH;
+    else if (options.background != "normal") qCWarning(lcServer) << "Unknown resources/background" << options.background;
+
+    int ioPriority = -1;
+    if (!options.backgroundIoClass.isEmpty()) {
+        const int ioClass = ioClassFromName(options.backgroundIoClass);
+        if (ioClass < 0) qCWarning(lcServer) << "Unknown resources/backgroundIoClass" << options.backgroundIoClass;
+        else ioPriority = ioPriorityValue(ioClass, 7);
+    }
+
+    backgroundPolicy.storeRelaxed(policy);
+    backgroundIoPriority.storeRelaxed(ioPriority);
+    backgroundGeneration.fetchAndAddOrdered(1);
+#else
+    Q_UNUSED(options)
+#endif
+}
+
+void ResourceGovernor::enterBackground()
+{
+#ifdef Q_OS_LINUX
+    const int generation = backgroundGeneration.loadAcquire();
+    if (appliedGeneration == generation) return;
+    appliedGeneration = generation;
+
+    // Без CAP_SYS_NICE вернуться из SCHED_IDLE нельзя; поток так и останется фоновым
+    struct sched_param param = {};
+    if (::sched_setscheduler(0, backgroundPolicy.loadRelaxed(), &param) != 0) {
+        qCDebug(lcServer) << "sched_setscheduler:" << std::strerror(errno);
+    }
+    const int ioPriority = backgroundIoPriority.loadRelaxed();
+    if (::syscall(SYS_ioprio_set, ioprioWhoProcess, 0, ioPriority >= 0 ? ioPriority : processIoPriority.loadRelaxed()) != 0) {
+        qCDebug(lcServer) << "ioprio_set:" << std::strerror(errno);
+    }
+#endif
+}
+
+qint64 ResourceGovernor::shedRetryAfterMs() const
+{
+    return 5 * sampleIntervalMs;
+}
+
+void ResourceGovernor::sample()
+{
+    Usage usage;
+    const qint64 nowUsec = clock.nsecsElapsed() / 1000;
+    const qint64 elapsedUsec = lastSampleUsec > 0 ? nowUsec - lastSampleUsec : 0;
+    lastSampleUsec = nowUsec;
+
+    usage.cgroup = ownCgroup.isEmpty() ? startCgroup : ownCgroup;
+
+    // Предел мог задать и предок (MemoryMax= службы), поэтому проходим вверх до корня
+    QHash<QString, qint64> cpuUsec;
+    for (QString level = usage.cgroup; !level.isEmpty() && level != "/"; level = parentCgroup(level)) {
+        const QString directory = cgroupRoot + level;
+        const qint64 memoryCurrent = readLimit(directory + "/memory.current");
+        const qint64 memoryMax = readLimit(directory + "/memory.max");
+        const qint64 memoryHigh = readLimit(directory + "/memory.high");
+        const qint64 limit = memoryMax < 0 ? memoryHigh : memoryHigh < 0 ? memoryMax : qMin(memoryMax, memoryHigh);
+        // memory.current включает кэш прочитанных файлов; после передачи больших
+        // файлов он один доходит до предела, хотя освобождается по первому требованию
+        const qint64 workingSet = memoryCurrent < 0 ? -1
+            : qMax<qint64>(0, memoryCurrent - readInactiveFile(directory + "/memory.stat"));
+        if (level == usage.cgroup) {
+            usage.memoryCurrent = memoryCurrent;
+            usage.memoryWorkingSet = workingSet;
+        }
+        if (limit > 0 && workingSet >= 0) {
+            usage.memoryLimit = usage.memoryLimit < 0 ? limit : qMin(usage.memoryLimit, limit);
+            usage.memoryRatio = qMax(usage.memoryRatio, double(workingSet) / limit);
+        }
+
+        const qint64 used = readCpuUsageUsec(directory + "/cpu.stat");
+        if (used < 0) continue;
+        cpuUsec.insert(level, used);
+        const auto previous = previousCpuUsec.constFind(level);
+        const double cores = elapsedUsec > 0 && previous != previousCpuUsec.constEnd()
+            ? double(used - previous.value()) / elapsedUsec : -1.0;
+        if (level == usage.cgroup && cores >= 0) usage.cpuPercent = cores * 100.0;
+        const double quota = readCpuQuota(directory + "/cpu.max");
+        if (quota > 0) {
+            usage.cpuQuotaPercent = usage.cpuQuotaPercent < 0 ? quota * 100.0 : qMin(usage.cpuQuotaPercent, quota * 100.0);
+            if (cores >= 0) usage.cpuRatio = qMax(usage.cpuRatio, cores / quota);
+        }
+    }
+    previousCpuUsec.swap(cpuUsec);
+#ifdef Q_OS_LINUX
+    // Без cgroup v2 (или в корневой) пределов не видно; память - хотя бы по RSS
+    if (usage.memoryCurrent < 0) {
+        const QList<QByteArray> statm = readSmallFile(procRoot + "/self/statm").split(' ');
+        if (statm.size() > 1) usage.memoryCurrent = statm[1].toLongLong() * ::sysconf(_SC_PAGESIZE);
+        usage.memoryWorkingSet = usage.memoryCurrent;
+    }
+#endif
+    lastUsage = usage;
+
+    const double enter = current.shedPercent / 100.0;
+    const double leave = (current.shedPercent - shedHysteresisPercent) / 100.0;
+    const double ratio = qMax(usage.memoryRatio, usage.cpuRatio);
+    if (!shedding && ratio >= enter) {
+        shedding = true;
+        shedReason = usage.memoryRatio >= usage.cpuRatio ? "memory" : "cpu";
+        qCWarning(lcServer) << "Near resource limits (" << shedReason << qRound(ratio * 100) << "%), deferring background work";
+#if defined(Q_OS_LINUX) && defined(__GLIBC__)
+        // Освобождённое, но удерживаемое malloc возвращаем системе до прихода к memory.max
+        if (shedReason == "memory") ::malloc_trim(0);
+#endif
+    } else if (shedding && ratio < leave) {
+        shedding = false;
+        shedReason.clear();
+        qCInfo(lcServer) << "Resource usage back to normal, background work resumed";
+    }
+}
+
+QJsonObject ResourceGovernor::status() const
+{
+    QJsonObject memory;
+    memory["current"] = optionalNumber(lastUsage.memoryCurrent);
+    memory["workingSet"] = optionalNumber(lastUsage.memoryWorkingSet);
+    memory["limit"] = optionalNumber(lastUsage.memoryLimit);
+    memory["usedPercent"] = lastUsage.memoryLimit > 0 ? QJsonValue(lastUsage.memoryRatio * 100.0) : QJsonValue();
+    memory["max"] = current.memoryMax;
+    memory["high"] = current.memoryHigh;
+
+    QJsonObject cpu;
+    cpu["usagePercent"] = optionalNumber(lastUsage.cpuPercent);
+    cpu["quotaPercent"] = optionalNumber(lastUsage.cpuQuotaPercent);
+    cpu["quota"] = current.cpuQuota;
+
+    QJsonObject priority;
+#ifdef Q_OS_LINUX
+    errno = 0;
+    const int nice = ::getpriority(PRIO_PROCESS, 0);
+    if (errno == 0) priority["nice"] = nice;
+#endif
+    priority["background"] = current.background;
+    priority["backgroundIoClass"] = current.backgroundIoClass;
+
+    QJsonObject shed;
+    shed["active"] = shedding;
+    shed["reason"] = shedReason;
+    shed["thresholdPercent"] = current.shedPercent;
+    shed["deferredRequests"] = shedRequests;
+
+    QJsonObject result;
+    result["cgroup"] = lastUsage.cgroup.isEmpty() ? QJsonValue() : QJsonValue(lastUsage.cgroup);
+    result["ownCgroup"] = !ownCgroup.isEmpty();
+    result["memory"] = memory;
+    result["cpu"] = cpu;
+    result["priority"] = priority;
+    result["shedding"] = shed;
+    return result;
+}
+
+bool ResourceGovernor::setProcessPriority(int nice, const QString& ioClass, int ioLevel, QString* error)
+{
+#ifdef Q_OS_LINUX
+    int ioPriority = 0; // класс по умолчанию: ядро выводит его из nice
+    if (!ioClass.isEmpty()) {
+        const int ioClassValue = ioClassFromName(ioClass);
+        if (ioClassValue < 0) {
+            if (error) *error = QString("unknown process/ioClass '%1'").arg(ioClass);
+            return false;
+        }
+        ioPriority = ioPriorityValue(ioClassValue, ioLevel);
+    }
+
+    // В Linux nice и приоритет ввода-вывода - свойства потока: меняем у всех
+    // уже запущенных, новые наследуют их от создающего потока
+    QString failure;
+    const QStringList tasks = QDir("/proc/self/task").entryList(QDir::Dirs | QDir::NoDotAndDotDot);
+    for (const QString& task : tasks) {
+        const id_t tid = task.toUInt();
+        if (::setpriority(PRIO_PROCESS, tid, nice) != 0 && failure.isEmpty()) {
+            failure = QString("setpriority: %1").arg(std::strerror(errno));
+        }
+        if (::syscall(SYS_ioprio_set, ioprioWhoProcess, tid, ioPriority) != 0 && failure.isEmpty()) {
+            failure = QString("ioprio_set: %1").arg(std::strerror(errno));
+        }
+    }
+    // Фоновые потоки тоже получили приоритет процесса - пусть применят свой заново
+    processIoPriority.storeRelaxed(ioPriority);
+    backgroundGeneration.fetchAndAddOrdered(1);
+    if (!failure.isEmpty()) {
+        if (error) *error = failure;
+        return false;
+    }
+    return true;
+#else
+    Q_UNUSED(ioLevel)
+    if (nice == 0 && ioClass.isEmpty()) return true;
+    if (error) *error = "process priority is only supported on Linux";
+    return false;
+#endif
+}
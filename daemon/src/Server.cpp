@@ -1,5 +1,16 @@
 #include "Server.h"
 #include "ClientConnection.h"
+#include "CgroupMonitor.h"
+#include "NetworkMonitor.h"
+#include "DiskMonitor.h"
+#include "AdmissionControl.h"
+#include "AccessControl.h"
+#include "ExecSession.h"
+#include "ResourceGovernor.h"
+#include "FileAttributes.h"
+#include "DaemonMetrics.h"
+#include "AsyncLogger.h"
+#include "TlsOptions.h"
 #include <QJsonDocument>
 #include <QJsonObject>
 #include <QJsonArray>
@@ -9,95 +20,259 @@
 #include <QSettings>
 #include <QStandardPaths>
 #include <QCoreApplication>
+#include <QThread>
 #include <QDebug>
-#include <QStorageInfo>
 #include <QDateTime>
 #include <QNetworkDatagram>
 #include <QAbstractSocket>
+#include <QTcpSocket>
+#include <QRegularExpression>
+#include <QSet>
+#include <QHostInfo>
+#include <QRandomGenerator>
+#include <algorithm>
+#include <vector>
+
+#ifdef Q_OS_LINUX
+#include <sys/stat.h>
+#endif
+
+namespace {
+
+// Группа и интервалы протокола обнаружения (см. NetworkDiscovery.cpp в клиенте)
+const QHostAddress discoveryGroup("239.255.45.54");
+const int announceIntervalMs = 60000;
+const int maxReplyJitterMs = 250;
+const int discoveryProtocolVersion = 1;
+
+// Одна строка вывода ps, числовые поля разобраны заранее для сортировки
+struct ProcessEntry {
+    QStringList columns;
+    QString command;
+    qlonglong pid = 0;
+    qlonglong vsz = 0;
+    qlonglong rss = 0;
+    double cpu = 0.0;
+    double mem = 0.0;
+};
+
+const QStringList processFields = {
+    "pid", "user", "cpu", "mem", "vsz", "rss", "tty", "stat", "start", "time", "command"
+};
+
+bool lessBy(const ProcessEntry& a, const ProcessEntry& b, const QString& key)
+{
+    if (key == "cpu") return a.cpu < b.cpu;
+    if (key == "mem") return a.mem < b.mem;
+    if (key == "rss") return a.rss < b.rss;
+    if (key == "vsz") return a.vsz < b.vsz;
+    if (key == "user") return a.columns[1] < b.columns[1];
+    if (key == "command") return a.command < b.command;
+    return a.pid < b.pid;
+}
+
+// Имя юнита systemd; с "-" в начале systemctl принял бы его за ключ (-H host)
+bool isValidUnitName(const QString& name)
+{
+    static const QRegularExpression unitName("^[A-Za-z0-9:_.@\\\\-]+$");
+    return !name.isEmpty() && !name.startsWith('-') && unitName.match(name).hasMatch();
+}
+
+} // namespace
 
 Server::Server(QObject* parent)
+    : Server("/proc", "/sys", parent)
+{}
+
+Server::Server(const QString& procRoot, const QString& sysRoot, QObject* parent)
     : QTcpServer(parent),
+      procRoot(procRoot),
+      sysRoot(sysRoot),
+      cgroupMonitor(new CgroupMonitor(sysRoot + "/fs/cgroup", this)),
+      networkMonitor(new NetworkMonitor(procRoot, sysRoot, this)),
+      diskMonitor(new DiskMonitor(procRoot, this)),
+      admissionControl(new AdmissionControl(this)),
+      accessControl(new AccessControl(this)),
+      execCommands(new ExecPolicy(this)),
+      resourceGovernor(new ResourceGovernor(procRoot, sysRoot + "/fs/cgroup", this)),
+      metricsRegistry(new DaemonMetrics(ClientConnection::methods(), this)),
+      metricsEndpoint(nullptr),
+      etagSettleMs(Tuning().etagSettleMs),
       discoverySocket(nullptr),
-      tcpPort(0)
-{}
+      announceTimer(nullptr),
+      tcpPort(0),
+      tlsEnabled(false),
+      plaintextSecretsAllowed(false)
+{
+    admissionControl->setMaxBackground(resourceGovernor->backgroundPool()->maxThreadCount());
+}
 
-void Server::startServer(quint16 port)
+void Server::setTuning(const Tuning& tuning)
+{
+    if (tuning.maxMessageSize != currentTuning.maxMessageSize) {
+        for (ClientConnection* client : qAsConst(clients)) client->setMaxMessageSize(tuning.maxMessageSize);
+    }
+    currentTuning = tuning;
+    // Каталог, изменённый позже этого, валидатора не получает: следующее изменение
+    // в пределах точности времени ФС могло бы не сдвинуть его mtime
+    etagSettleMs.storeRelaxed(tuning.etagSettleMs);
+    cgroupMonitor->setRefreshInterval(tuning.cgroupRefreshMs);
+    cgroupMonitor->setRescanInterval(tuning.cgroupRescanMs);
+    networkMonitor->setMinInterval(tuning.networkMinIntervalMs);
+    diskMonitor->setMinInterval(tuning.diskMinIntervalMs);
+}
+
+bool Server::setTlsOptions(const TlsOptions& options, QString* error)
+{
+    tlsEnabled = false;
+    if (!options.enabled) return true;
+    if (!options.makeConfiguration(QSslSocket::SslServerMode, &tlsConfig, error)) return false;
+    tlsEnabled = true;
+    qCInfo(lcServer) << "TLS enabled, client certificates"
+                     << (options.verifyPeer ? "required" : options.caFile.isEmpty() ? "not requested" : "optional");
+    return true;
+}
+
+void Server::startServer(quint16 port, const QHostAddress& address)
 {
     tcpPort = port;
 
     discoverySocket = new QUdpSocket(this);
 
-    discoverySocket->setSocketOption(QAbstractSocket::MulticastTtlOption, 1);
-
-    if (!discoverySocket->bind(QHostAddress::Any, port,
+    if (!discoverySocket->bind(QHostAddress::AnyIPv4, port,
                               QUdpSocket::ShareAddress | QUdpSocket::ReuseAddressHint)) {
         qCritical() << "Discovery socket bind error:" << discoverySocket->errorString();
     } else {
+        discoverySocket->setSocketOption(QAbstractSocket::MulticastTtlOption, 1);
+        joinDiscoveryGroup();
         connect(discoverySocket, &QUdpSocket::readyRead,
                 this, &Server::handleDiscoveryRequest);
-        qInfo() << "Discovery UDP socket bound to port" << port;
-    }
+        qCInfo(lcDiscovery) << "Discovery UDP socket bound to port" << port;
 
-    qInfo() << "Available IP addresses:";
-    for (const QHostAddress &address : QNetworkInterface::allAddresses()) {
-        if (address.protocol() == QAbstractSocket::IPv4Protocol &&
-            address != QHostAddress::LocalHost) {
-            qInfo() << " - " << address.toString();
-        }
+        // Первое объявление сразу, дальше по таймеру с разбросом
+        announceTimer = new QTimer(this);
+        announceTimer->setSingleShot(true);
+        connect(announceTimer, &QTimer::timeout, this, &Server::sendPeriodicAnnouncement);
+        announceTimer->start(QRandomGenerator::global()->bounded(1000));
     }
 
     // Запуск TCP-сервера
-    if (!this->listen(QHostAddress::Any, port)) {
+    if (!this->listen(address, port)) {
         qCritical() << "TCP server listen error:" << this->errorString();
     }
     else {
-        qInfo() << "TCP server successfully started on port" << port;
+        qCInfo(lcServer) << "TCP server successfully started on port" << port;
     }
 }
 
-void Server::handleDiscoveryRequest()   {
-    qDebug() << "Available interfaces:";
-    foreach (const QNetworkInterface &interface, QNetworkInterface::allInterfaces()) {
-        if (interface.flags() & QNetworkInterface::IsUp &&
-            !(interface.flags() & QNetworkInterface::IsLoopBack)) {
-            qDebug() << "Interface:" << interface.name();
-            foreach (const QNetworkAddressEntry &entry, interface.addressEntries()) {
-                qDebug() << " - IP:" << entry.ip().toString()
-                         << "Broadcast:" << entry.broadcast().toString();
+void Server::joinDiscoveryGroup()
+{
+    // Интерфейсы перечисляются один раз при старте, а не на каждую датаграмму.
+    // На машинах с несколькими сетями вступаем в группу на каждом интерфейсе.
+    for (const QNetworkInterface& iface : QNetworkInterface::allInterfaces()) {
+        const auto flags = iface.flags();
+        if (!(flags & QNetworkInterface::IsUp) || !(flags & QNetworkInterface::CanMulticast) ||
+            (flags & QNetworkInterface::IsLoopBack)) {
+            continue;
+        }
+        if (discoverySocket->joinMulticastGroup(discoveryGroup, iface)) {
+            multicastInterfaces.append(iface);
+            for (const QNetworkAddressEntry& entry : iface.addressEntries()) {
+                if (entry.ip().protocol() == QAbstractSocket::IPv4Protocol) {
+                    qCInfo(lcDiscovery) << "Discovery on" << iface.name() << "-" << entry.ip().toString();
+                }
             }
         }
     }
+    if (multicastInterfaces.isEmpty()) {
+        qWarning() << "Multicast discovery unavailable, only broadcast queries will be answered";
+    }
+}
+
+QByteArray Server::buildAnnouncement() const
+{
+    QJsonObject announce;
+    announce["type"] = "announce";
+    announce["protocol"] = discoveryProtocolVersion;
+    announce["hostname"] = QHostInfo::localHostName();
+    announce["version"] = QCoreApplication::applicationVersion();
+    announce["port"] = tcpPort;
+    announce["ttl"] = 3 * announceIntervalMs / 1000;
+    announce["tls"] = tlsEnabled;
+    announce["auth"] = accessControl->isEnabled();
+
+#ifdef Q_OS_UNIX
+    QFile loadFile(procRoot + "/loadavg");
+    if (loadFile.open(QIODevice::ReadOnly)) {
+        QList<QByteArray> values = loadFile.readAll().split(' ');
+        if (values.size() >= 3) {
+            announce["load"] = QJsonArray{ values[0].toDouble(), values[1].toDouble(), values[2].toDouble() };
+        }
+    }
+#endif
+    announce["cores"] = QThread::idealThreadCount();
+
+    return QJsonDocument(announce).toJson(QJsonDocument::Compact);
+}
+
+void Server::sendPeriodicAnnouncement()
+{
+    const QByteArray announcement = buildAnnouncement();
+    for (const QNetworkInterface& iface : multicastInterfaces) {
+        discoverySocket->setMulticastInterface(iface);
+        discoverySocket->writeDatagram(announcement, discoveryGroup, discoverySocket->localPort());
+    }
+
+    const int jitter = announceIntervalMs / 10;
+    announceTimer->start(announceIntervalMs - jitter + QRandomGenerator::global()->bounded(2 * jitter));
+}
 
+void Server::handleDiscoveryRequest()   {
     while (discoverySocket->hasPendingDatagrams()) {
         QNetworkDatagram datagram = discoverySocket->receiveDatagram();
         QByteArray data = datagram.data();
 
-        qDebug() << "Received UDP datagram from"
-                 << datagram.senderAddress().toString()
-                 << ":" << datagram.senderPort()
-                 << "data:" << data;
-
         if (data == "Открытие_обзора_ОС") {
             QByteArray response = "Обзор_ОС:" + QByteArray::number(tcpPort);
-            qint64 bytesSent = discoverySocket->writeDatagram(
-                response,
-                datagram.senderAddress(),
-                datagram.senderPort()
-            );
-
-            qDebug() << "Sent response to"
-                     << datagram.senderAddress().toString()
-                     << ":" << datagram.senderPort()
-                     << "bytes:" << bytesSent;
+            discoverySocket->writeDatagram(response, datagram.senderAddress(), datagram.senderPort());
+            continue;
         }
+
+        QJsonObject query = QJsonDocument::fromJson(data).object();
+        if (query["type"].toString() != "discover") continue;
+
+        // Ответ со случайной задержкой, чтобы тысячи демонов не ответили одним всплеском.
+        // Повторные запросы от того же отправителя до ответа не плодят датаграммы.
+        const QHostAddress sender = datagram.senderAddress();
+        const quint16 senderPort = static_cast<quint16>(datagram.senderPort());
+        const QString key = sender.toString() + ':' + QString::number(senderPort);
+        if (pendingReplies.contains(key)) continue;
+        pendingReplies.insert(key);
+
+        const int maxJitter = qBound(0, query["jitterMs"].toInt(maxReplyJitterMs), 5000);
+        QTimer::singleShot(QRandomGenerator::global()->bounded(maxJitter + 1), this, [this, sender, senderPort, key]() {
+            pendingReplies.remove(key);
+            discoverySocket->writeDatagram(buildAnnouncement(), sender, senderPort);
+        });
     }
 }
 
 void Server::incomingConnection(qintptr socketDescriptor)
 {
+    // Каждое соединение стоит памяти и дескриптора, поэтому их число ограничено
+    if (clients.size() >= currentTuning.maxClients) {
+        qWarning() << "Too many clients, rejecting connection";
+        metricsRegistry->connectionRejected();
+        QTcpSocket rejected;
+        rejected.setSocketDescriptor(socketDescriptor);
+        rejected.abort();
+        return;
+    }
+
     ClientConnection* connection = new ClientConnection(this);
     if (connection->setSocketDescriptor(socketDescriptor)) {
         clients.append(connection);
+        metricsRegistry->connectionAccepted();
         connect(connection, &ClientConnection::disconnected, this, [this, connection]() {
             clients.removeOne(connection);
             connection->deleteLater();
@@ -130,6 +305,9 @@ QJsonObject Server::getSystemInfo() const
     // Disks
     info["disks"] = getDiskInfo();
 
+    // Network
+    info["network"] = getNetworkStats();
+
     return info;
 }
 
@@ -152,12 +330,13 @@ QStringList Server::getUserList() const
     return users;
 }
 
-QJsonArray Server::getFileSystem(const QString& path) const
+QJsonArray Server::getFileSystem(const QString& path, const QJsonValue& include) const
 {
     QJsonArray files;
     QDir dir(path.isEmpty() ? QDir::rootPath() : path);
 
     if (!dir.exists()) return files;
+    FileAttributes attributes(FileAttributes::parseFields(include));
 
     for (const QFileInfo& info : dir.entryInfoList(QDir::AllEntries | QDir::NoDotAndDotDot | QDir::Hidden)) {
         QJsonObject file;
@@ -170,16 +349,65 @@ QJsonArray Server::getFileSystem(const QString& path) const
         file["group"] = info.group();
         file["created"] = info.birthTime().toString(Qt::ISODate);
         file["modified"] = info.lastModified().toString(Qt::ISODate);
+        if (attributes.fields()) attributes.project(info.absoluteFilePath(), file);
 
         files.append(file);
     }
     return files;
 }
 
-QJsonArray Server::getProcessList() const
+// mtime каталога меняется при создании, удалении и переименовании записей, так что
+// etag из (устройство, inode, mtime, ctime) покрывает состав каталога. Размер и права
+// самих файлов в него не входят: их клиент обновляет запросом без etag.
+QString Server::directoryEtag(const QString& path) const
+{
+    const QString target = path.isEmpty() ? QDir::rootPath() : path;
+    const qint64 now = QDateTime::currentMSecsSinceEpoch();
+#ifdef Q_OS_LINUX
+    struct stat st;
+    if (::stat(QFile::encodeName(target).constData(), &st) != 0 || !S_ISDIR(st.st_mode)) return QString();
+    if (now - qint64(st.st_mtim.tv_sec) * 1000 - st.st_mtim.tv_nsec / 1000000 < etagSettleMs.loadRelaxed()) return QString();
+    return QString("%1-%2-%3.%4-%5.%6")
+        .arg(qulonglong(st.st_dev), 0, 16).arg(qulonglong(st.st_ino), 0, 16)
+        .arg(qlonglong(st.st_mtim.tv_sec)).arg(qlonglong(st.st_mtim.tv_nsec))
+        .arg(qlonglong(st.st_ctim.tv_sec)).arg(qlonglong(st.st_ctim.tv_nsec));
+#else
+    const QFileInfo info(target);
+    if (!info.isDir()) return QString();
+    const qint64 modified = info.lastModified().toMSecsSinceEpoch();
+    if (now - modified < etagSettleMs.loadRelaxed()) return QString();
+    return QString::number(modified, 16);
+#endif
+}
+
+QJsonArray Server::getProcessList(const QJsonObject& query, QString* error) const
 {
     QJsonArray processes;
 #ifdef Q_OS_UNIX
+    // Параметры запроса: user, name (regex по команде), state (буквы STAT),
+    // sort, order ("asc"/"desc"), limit и fields (проекция полей)
+    const QString userFilter = query["user"].toString();
+    const QString stateFilter = query["state"].toString();
+    const QString sortKey = query["sort"].toString();
+    const bool ascending = query["order"].toString() == "asc";
+    const int limit = query["limit"].toInt(0);
+
+    QRegularExpression nameFilter;
+    if (query.contains("name")) {
+        nameFilter.setPattern(query["name"].toString());
+        if (!nameFilter.isValid()) {
+            if (error) *error = "Invalid name pattern: " + nameFilter.errorString();
+            return processes;
+        }
+        nameFilter.optimize();
+    }
+
+    QSet<QString> fields;
+    for (const QJsonValue& field : query["fields"].toArray()) {
+        if (processFields.contains(field.toString())) fields.insert(field.toString());
+    }
+    if (fields.isEmpty()) fields = QSet<QString>(processFields.begin(), processFields.end());
+
     QProcess ps;
     ps.start("ps", {"-eo", "pid,user,pcpu,pmem,vsz,rss,tty,stat,start,time,comm"});
     ps.waitForFinished();
@@ -189,27 +417,57 @@ QJsonArray Server::getProcessList() const
 
     if (lines.size() > 0) lines.removeFirst(); // Удаляем заголовок
 
+    std::vector<ProcessEntry> entries;
+    entries.reserve(lines.size());
+
     for (const QString& line : lines) {
         QStringList parts = line.simplified().split(' ', Qt::SkipEmptyParts);
         if (parts.size() < 11) continue;
 
-        QJsonObject process;
-        process["pid"] = parts[0];
-        process["user"] = parts[1];
-        process["cpu"] = parts[2];
-        process["mem"] = parts[3];
-        process["vsz"] = parts[4];
-        process["rss"] = parts[5];
-        process["tty"] = parts[6];
-        process["stat"] = parts[7];
-        process["start"] = parts[8];
-        process["time"] = parts[9];
+        // Фильтруем до разбора чисел, чтобы не тратить время на лишние строки
+        if (!userFilter.isEmpty() && parts[1] != userFilter) continue;
+        if (!stateFilter.isEmpty() && !stateFilter.contains(parts[7].at(0))) continue;
 
+        ProcessEntry entry;
         // Команда может содержать пробелы
-        process["command"] = parts.mid(10).join(' ');
+        entry.command = parts.mid(10).join(' ');
+        if (!nameFilter.pattern().isEmpty() && !nameFilter.match(entry.command).hasMatch()) continue;
+
+        entry.pid = parts[0].toLongLong();
+        entry.cpu = parts[2].toDouble();
+        entry.mem = parts[3].toDouble();
+        entry.vsz = parts[4].toLongLong();
+        entry.rss = parts[5].toLongLong();
+        parts.erase(parts.begin() + 10, parts.end());
+        entry.columns = parts;
+
+        entries.push_back(std::move(entry));
+    }
+
+    if (!sortKey.isEmpty() || limit > 0) {
+        auto compare = [&sortKey, ascending](const ProcessEntry& a, const ProcessEntry& b) {
+            return ascending ? lessBy(a, b, sortKey) : lessBy(b, a, sortKey);
+        };
+        // Для top-N достаточно частичной сортировки кучей
+        if (limit > 0 && static_cast<size_t>(limit) < entries.size()) {
+            std::partial_sort(entries.begin(), entries.begin() + limit, entries.end(), compare);
+            entries.resize(limit);
+        } else {
+            std::sort(entries.begin(), entries.end(), compare);
+        }
+    }
+
+    for (const ProcessEntry& entry : entries) {
+        QJsonObject process;
+        for (int i = 0; i < 10; ++i) {
+            if (fields.contains(processFields[i])) process[processFields[i]] = entry.columns[i];
+        }
+        if (fields.contains("command")) process["command"] = entry.command;
 
         processes.append(process);
     }
+#else
+    Q_UNUSED(query);
 #endif
     return processes;
 }
@@ -265,6 +523,43 @@ bool Server::changeUserPassword(const QString& username, const QString& password
 #endif
 }
 
+QJsonArray Server::getFileAttributes(const QJsonArray& paths, const QJsonValue& include) const
+{
+    FileAttributes attributes(FileAttributes::parseFields(include));
+    QJsonArray result;
+    for (const QJsonValue& value : paths) {
+        const QString path = value.toString();
+        QJsonObject file;
+        file["path"] = path;
+        const QFileInfo info(path);
+        if (!info.exists() && !info.isSymLink()) {
+            file["error"] = "No such file or directory";
+        } else {
+            file["permissions"] = QString::number(info.permissions(), 8);
+            file["owner"] = info.owner();
+            file["group"] = info.group();
+            attributes.project(path, file);
+        }
+        result.append(file);
+    }
+    return result;
+}
+
+QJsonArray Server::setFileAttributes(const QJsonArray& items)
+{
+    QJsonArray result;
+    for (const QJsonValue& value : items) {
+        const QJsonObject item = value.toObject();
+        const QString path = item["path"].toString();
+        QString error = "Path must be absolute";
+        const bool ok = QFileInfo(path).isAbsolute() && FileAttributes::apply(path, item, &error);
+        QJsonObject outcome{{"path", path}, {"ok", ok}};
+        if (!ok) outcome["error"] = error;
+        result.append(outcome);
+    }
+    return result;
+}
+
 bool Server::setFilePermissions(const QString& path, const QString& permissions)
 {
     QFile file(path);
@@ -285,8 +580,9 @@ bool Server::manageService(const QString& service, const QString& action)
     else if (action == "stop") args << "stop";
     else if (action == "restart") args << "restart";
     else return false;
+    if (!isValidUnitName(service)) return false;
 
-    args << service;
+    args << "--" << service;
 
     QProcess process;
     process.start("systemctl", args);
@@ -330,7 +626,7 @@ QJsonObject Server::getCpuInfo() const
     QJsonObject cpu;
 
 #ifdef Q_OS_UNIX
-    QFile file("/proc/cpuinfo");
+    QFile file(procRoot + "/cpuinfo");
     if (file.open(QIODevice::ReadOnly)) {
         int cores = 0;
         QString model;
@@ -348,24 +644,30 @@ QJsonObject Server::getCpuInfo() const
         cpu["cores"] = cores;
 
         // Get usage
-        QFile statFile("/proc/stat");
+        QFile statFile(procRoot + "/stat");
         if (statFile.open(QIODevice::ReadOnly)) {
             QByteArray firstLine = statFile.readLine();
             statFile.close();
 
-            QList<QByteArray> values = firstLine.split(' ').mid(1);
+            // "cpu  user nice system idle iowait irq softirq steal guest guest_nice";
+            // guest уже учтён в user, поэтому суммируются только первые восемь полей
+            QList<QByteArray> values = firstLine.simplified().split(' ').mid(1);
             if (values.size() > 7) {
                 qulonglong total = 0;
-                for (const QByteArray& val : values) total += val.toULongLong();
-                qulonglong idle = values[3].toULongLong();
+                for (int i = 0; i < 8; ++i) total += values[i].toULongLong();
+                qulonglong idle = values[3].toULongLong() + values[4].toULongLong();
                 qulonglong usage = total - idle;
 
-                cpu["usage_percent"] = usage * 100.0 / total;
+                // Загрузка с момента загрузки системы; текущую клиент считает
+                // по разнице счётчиков между двумя опросами
+                cpu["usage_percent"] = total > 0 ? usage * 100.0 / total : 0.0;
+                cpu["total_ticks"] = static_cast<qint64>(total);
+                cpu["idle_ticks"] = static_cast<qint64>(idle);
             }
         }
 
         // Get temperature
-        QDir thermalDir("/sys/class/thermal");
+        QDir thermalDir(sysRoot + "/class/thermal");
         QStringList thermalZones = thermalDir.entryList({ "thermal_zone*" }, QDir::Dirs);
         for (const QString& zone : thermalZones) {
             QFile typeFile(thermalDir.filePath(zone + "/type"));
@@ -390,7 +692,7 @@ QJsonObject Server::getMemoryInfo() const
     QJsonObject mem;
 
 #ifdef Q_OS_UNIX
-    QFile file("/proc/meminfo");
+    QFile file(procRoot + "/meminfo");
     if (file.open(QIODevice::ReadOnly)) {
         qulonglong total = 0, free = 0, available = 0;
 
@@ -421,28 +723,7 @@ QJsonObject Server::getMemoryInfo() const
 
 QJsonArray Server::getDiskInfo() const
 {
-    QJsonArray disks;
-    for (const QStorageInfo& storage : QStorageInfo::mountedVolumes()) {
-        if (storage.isValid() && storage.isReady()) {
-            QJsonObject disk;
-            disk["name"] = storage.displayName();
-            disk["mount_point"] = storage.rootPath();
-            disk["filesystem"] = QString::fromUtf8(storage.fileSystemType());
-            disk["total"] = static_cast<qint64>(storage.bytesTotal());
-            disk["free"] = static_cast<qint64>(storage.bytesFree());
-            disk["available"] = static_cast<qint64>(storage.bytesAvailable());
-            disk["used"] = static_cast<qint64>(storage.bytesTotal() - storage.bytesFree());
-
-            if (storage.bytesTotal() > 0) {
-                disk["usage_percent"] = (1.0 - static_cast<double>(storage.bytesFree()) / storage.bytesTotal()) * 100.0;
-            } else {
-                disk["usage_percent"] = 0.0;
-            }
-
-            disks.append(disk);
-        }
-    }
-    return disks;
+    return diskMonitor->volumes();
 }
 
 QJsonObject Server::getUptimeInfo() const
@@ -450,7 +731,7 @@ QJsonObject Server::getUptimeInfo() const
     QJsonObject uptime;
 
 #ifdef Q_OS_UNIX
-    QFile file("/proc/uptime");
+    QFile file(procRoot + "/uptime");
     if (file.open(QIODevice::ReadOnly)) {
         QList<QByteArray> values = file.readAll().split(' ');
         if (!values.isEmpty()) {
@@ -491,3 +772,94 @@ QJsonArray Server::getServiceList() const
 #endif
     return services;
 }
+
+QJsonObject Server::getServiceStatus(const QString& service, QString* error) const
+{
+    QJsonObject status;
+    if (!isValidUnitName(service)) {
+        if (error) *error = "Invalid unit name: " + service;
+        return status;
+    }
+    status["service"] = service;
+#ifdef Q_OS_UNIX
+    QProcess systemctl;
+    systemctl.start("systemctl", {"show", "--no-pager",
+                                  "--property=LoadState,ActiveState,SubState,UnitFileState,MainPID",
+                                  "--", service});
+    systemctl.waitForFinished();
+
+    // Вывод в формате Key=Value, по одному свойству в строке
+    QString output = systemctl.readAllStandardOutput();
+    for (const QString& line : output.split('\n', Qt::SkipEmptyParts)) {
+        int eq = line.indexOf('=');
+        if (eq <= 0) continue;
+        QString key = line.left(eq);
+        QString value = line.mid(eq + 1).trimmed();
+        if (key == "LoadState") status["load_state"] = value;
+        else if (key == "ActiveState") status["active_state"] = value;
+        else if (key == "SubState") status["sub_state"] = value;
+        else if (key == "UnitFileState") status["unit_file_state"] = value;
+        else if (key == "MainPID") status["main_pid"] = value.toLongLong();
+    }
+#endif
+    return status;
+}
+
+QJsonArray Server::getCgroupStats(const QJsonObject& query) const
+{
+    return cgroupMonitor->collect(query);
+}
+
+QJsonObject Server::getNetworkStats() const
+{
+    return networkMonitor->collect();
+}
+
+QJsonArray Server::getDiskStats() const
+{
+    return diskMonitor->deviceStats();
+}
+
+// ========== Self-metrics ==========
+
+namespace {
+
+DaemonMetrics::Gauges collectGauges(const QList<ClientConnection*>& clients, const AdmissionControl* admission)
+{
+    DaemonMetrics::Gauges gauges;
+    gauges.connections = clients.size();
+    gauges.expensiveInFlight = admission->expensiveInFlight() + admission->backgroundInFlight();
+    for (const ClientConnection* client : clients) {
+        gauges.queuedBytes += client->pendingOutput();
+        gauges.subscriptions += client->subscriptionCount();
+    }
+    return gauges;
+}
+
+} // namespace
+
+QJsonObject Server::getDaemonStats() const
+{
+    return metricsRegistry->toJson(collectGauges(clients, admissionControl));
+}
+
+QJsonObject Server::getResourceLimits() const
+{
+    return resourceGovernor->status();
+}
+
+QByteArray Server::metricsText() const
+{
+    return metricsRegistry->toPrometheus(collectGauges(clients, admissionControl));
+}
+
+bool Server::startMetricsEndpoint(const QHostAddress& address, quint16 port)
+{
+    if (!metricsEndpoint) metricsEndpoint = new MetricsEndpoint(this, this);
+    if (!metricsEndpoint->listen(address, port)) {
+        qCritical() << "Metrics endpoint failed to start:" << metricsEndpoint->errorString();
+        return false;
+    }
+    qCInfo(lcServer) << "Metrics endpoint listening on" << address.toString() << "port" << port;
+    return true;
+}
@@ -0,0 +1,322 @@
+#include "SyncTarget.h"
+#include "DeltaSync.h"
+#include <QCryptographicHash>
+#include <QDateTime>
+#include <QDir>
+#include <QDirIterator>
+#include <QFileInfo>
+#include <QJsonArray>
+#include <QSaveFile>
+#include <QSet>
+#include <memory>
+#include <utility>
+#include <vector>
+#ifdef Q_OS_UNIX
+#include <fcntl.h>
+#include <sys/stat.h>
+#endif
+
+namespace {
+
+// Каждый файл пачки держит открытый временный файл до переименования
+const int maxCommitFiles = 256;
+
+qint64 jsonInteger(const QJsonValue& value)
+{
+    return static_cast<qint64>(value.toDouble(-1));
+}
+
+#ifdef Q_OS_UNIX
+timespec toTimespec(qint64 msecs)
+{
+    timespec result;
+    result.tv_sec = msecs / 1000;
+    result.tv_nsec = (msecs % 1000) * 1000000;
+    return result;
+}
+#endif
+
+int fileMode(const QString& path)
+{
+#ifdef Q_OS_UNIX
+    struct stat st;
+    if (::lstat(QFile::encodeName(path).constData(), &st) != 0) return -1;
+    return st.st_mode & 07777;
+#else
+    Q_UNUSED(path)
+    return -1;
+#endif
+}
+
+// Совпавший по содержимому файл: только mtime и права, без перезаписи
+bool setMetadata(const QString& path, int mode, qint64 mtime)
+{
+#ifdef Q_OS_UNIX
+    const QByteArray native = QFile::encodeName(path);
+    if (mode >= 0 && ::chmod(native.constData(), static_cast<mode_t>(mode)) != 0) return false;
+    const timespec times[2] = { { 0, UTIME_OMIT }, toTimespec(mtime) };
+    return ::utimensat(AT_FDCWD, native.constData(), times, AT_SYMLINK_NOFOLLOW) == 0;
+#else
+    QFile file(path);
+    return file.open(QIODevice::ReadWrite)
+        && file.setFileTime(QDateTime::fromMSecsSinceEpoch(mtime), QFileDevice::FileModificationTime);
+#endif
+}
+
+// Новое содержимое во временный файл рядом с target; переименование - в commit()
+bool stageFile(const QString& target, const QJsonObject& entry, QSaveFile* file, QString* message)
+{
+    const QFileInfo info(target);
+    // QSaveFile не должен писать сквозь ссылку: она могла бы вести за пределы корня
+    if (info.isSymLink() && !QFile::remove(target)) {
+        *message = "Cannot replace symbolic link";
+        return false;
+    }
+    if (!QDir().mkpath(info.path())) {
+        *message = "Cannot create directory " + info.path();
+        return false;
+    }
+    if (!file->open(QIODevice::WriteOnly)) {
+        *message = file->errorString();
+        return false;
+    }
+
+    QCryptographicHash hash(QCryptographicHash::Sha256);
+    if (entry.contains("delta")) {
+        const int blockSize = entry["blockSize"].toInt();
+        QFile base(target);
+        if (blockSize <= 0 || !base.open(QIODevice::ReadOnly)) {
+            *message = "Delta needs the existing file and its block size";
+            return false;
+        }
+        // Подписи считались по другой версии - к этой разница не подходит
+        if (DeltaSync::fileHash(target) != entry["baseSha256"].toString()) {
+            *message = "File changed since syncTree, send it in full";
+            return false;
+        }
+        if (!DeltaSync::apply(&base, entry["delta"].toArray(), blockSize, file, &hash, message)) return false;
+    } else {
+        const QByteArray data = QByteArray::fromBase64(entry["data"].toString().toLatin1());
+        hash.addData(data);
+        if (file->write(data) != data.size()) {
+            *message = file->errorString();
+            return false;
+        }
+    }
+    if (QString::fromLatin1(hash.result().toHex()) != entry["sha256"].toString()) {
+        *message = "Checksum mismatch";
+        return false;
+    }
+    if (!file->flush()) {
+        *message = file->errorString();
+        return false;
+    }
+
+    // Права и mtime ставятся временному файлу: на место он встаёт уже готовым
+    const int mode = entry["mode"].toInt(-1);
+    const qint64 mtime = jsonInteger(entry["mtime"]);
+#ifdef Q_OS_UNIX
+    if (mode >= 0 && ::fchmod(file->handle(), static_cast<mode_t>(mode)) != 0) {
+        *message = "Cannot set permissions";
+        return false;
+    }
+    if (mtime >= 0) {
+        const timespec times[2] = { { 0, UTIME_OMIT }, toTimespec(mtime) };
+        if (::futimens(file->handle(), times) != 0) {
+            *message = "Cannot set modification time";
+            return false;
+        }
+    }
+#else
+    Q_UNUSED(mode)
+    if (mtime >= 0) file->setFileTime(QDateTime::fromMSecsSinceEpoch(mtime), QFileDevice::FileModificationTime);
+#endif
+    return true;
+}
+
+} // namespace
+
+bool SyncTarget::openRoot(const QJsonObject& params, Root* root, QString* error)
+{
+    root->path = QDir::cleanPath(params["root"].toString());
+    if (!QDir::isAbsolutePath(root->path) || root->path == "/") {
+        *error = "root must be an absolute path other than /";
+        return false;
+    }
+    // Корня ещё может не быть: тогда ссылок внутри него тоже нет
+    root->canonical = QFileInfo(root->path).canonicalFilePath();
+    if (root->canonical.isEmpty()) root->canonical = root->path;
+    return true;
+}
+
+bool SyncTarget::resolve(const Root& root, const QString& relative, QString* target, QString* error)
+{
+    const QString clean = QDir::cleanPath(relative);
+    if (clean.isEmpty() || clean == "." || clean == ".." || clean.startsWith("../") || QDir::isAbsolutePath(clean)) {
+        *error = QString("Invalid relative path '%1'").arg(relative);
+        return false;
+    }
+    *target = root.path + '/' + clean;
+
+    // Ближайший существующий предок после разрешения ссылок должен остаться под корнем
+    QString existing = QFileInfo(*target).path();
+    while (existing.size() > root.path.size() && !QFileInfo::exists(existing)) existing = QFileInfo(existing).path();
+    const QString canonical = QFileInfo(existing).canonicalFilePath();
+    if (!canonical.isEmpty() && canonical != root.canonical && !canonical.startsWith(root.canonical + '/')) {
+        *error = QString("Path '%1' leaves the sync root").arg(relative);
+        return false;
+    }
+    return true;
+}
+
+QJsonObject SyncTarget::compare(const QJsonObject& params, QString* error)
+{
+    Root root;
+    if (!openRoot(params, &root, error)) return QJsonObject();
+    const bool dryRun = params["dryRun"].toBool();
+
+    QSet<QString> listed;
+    QJsonArray transfer;
+    QJsonArray errors;
+    int unchanged = 0;
+    int touched = 0;
+    for (const QJsonValue& value : params["files"].toArray()) {
+        const QJsonObject entry = value.toObject();
+        QString target;
+        if (!resolve(root, entry["path"].toString(), &target, error)) return QJsonObject();
+        const QString relative = QDir::cleanPath(entry["path"].toString());
+        listed.insert(relative);
+
+        const QFileInfo info(target);
+        if (info.isSymLink() || !info.isFile()) {
+            const bool exists = info.exists() || info.isSymLink();
+            transfer.append(QJsonObject{{"path", relative}, {"reason", exists ? "replace" : "new"}});
+            continue;
+        }
+
+        // Быстрая проверка по размеру и mtime; хэш - только если mtime разошёлся
+        const qint64 mtime = jsonInteger(entry["mtime"]);
+        const int mode = entry["mode"].toInt(-1);
+        const bool sameTime = info.lastModified().toMSecsSinceEpoch() == mtime;
+        if (info.size() == jsonInteger(entry["size"])
+            && (sameTime || DeltaSync::fileHash(target) == entry["sha256"].toString())) {
+            if (sameTime && (mode < 0 || fileMode(target) == mode)) {
+                ++unchanged;
+            } else if (dryRun || setMetadata(target, mode, mtime)) {
+                ++touched;
+            } else {
+                errors.append(QJsonObject{{"path", relative}, {"error", "Cannot update metadata"}});
+            }
+            continue;
+        }
+
+        QJsonObject item{{"path", relative}, {"reason", "changed"}};
+        if (info.size() >= DeltaSync::minDeltaSize) {
+            QFile base(target);
+            if (base.open(QIODevice::ReadOnly)) {
+                const int blockSize = DeltaSync::blockSizeFor(info.size());
+                QString sha256;
+                item["signatures"] = DeltaSync::signatures(&base, blockSize, &sha256);
+                item["blockSize"] = blockSize;
+                item["baseSha256"] = sha256;
+            }
+        }
+        transfer.append(item);
+    }
+
+    QJsonArray missingDirs;
+    for (const QJsonValue& value : params["dirs"].toArray()) {
+        QString target;
+        if (!resolve(root, value.toString(), &target, error)) return QJsonObject();
+        if (!QFileInfo(target).isDir()) missingDirs.append(QDir::cleanPath(value.toString()));
+    }
+
+    // Лишние файлы удаляются только в syncTreeCommit, здесь - только список
+    QJsonArray remove;
+    if (params["delete"].toBool() && QFileInfo(root.path).isDir()) {
+        const QDir base(root.path);
+        QDirIterator it(root.path, QDir::Files | QDir::Hidden | QDir::System | QDir::NoDotAndDotDot,
+                        QDirIterator::Subdirectories);
+        while (it.hasNext()) {
+            const QString relative = base.relativeFilePath(it.next());
+            if (!listed.contains(relative)) remove.append(relative);
+        }
+    }
+
+    QJsonObject result;
+    result["transfer"] = transfer;
+    result["missingDirs"] = missingDirs;
+    result["remove"] = remove;
+    result["unchanged"] = unchanged;
+    result["touched"] = touched;
+    result["errors"] = errors;
+    result["dryRun"] = dryRun;
+    return result;
+}
+
+QJsonObject SyncTarget::commit(const QJsonObject& params, QString* error)
+{
+    Root root;
+    if (!openRoot(params, &root, error)) return QJsonObject();
+    const QJsonArray files = params["files"].toArray();
+    if (files.size() > maxCommitFiles) {
+        *error = QString("At most %1 files per syncTreeCommit").arg(maxCommitFiles);
+        return QJsonObject();
+    }
+
+    // Все пути проверяются до первой записи
+    std::vector<std::pair<QString, QString>> targets;
+    for (const QJsonValue& value : files) {
+        QString target;
+        if (!resolve(root, value.toObject()["path"].toString(), &target, error)) return QJsonObject();
+        targets.emplace_back(QDir::cleanPath(value.toObject()["path"].toString()), target);
+    }
+    QStringList removeTargets;
+    for (const QJsonValue& value : params["remove"].toArray()) {
+        QString target;
+        if (!resolve(root, value.toString(), &target, error)) return QJsonObject();
+        removeTargets << target;
+    }
+
+    QJsonArray errors;
+    auto fail = [&errors](const QString& path, const QString& message) {
+        errors.append(QJsonObject{{"path", path}, {"error", message}});
+    };
+
+    for (const QJsonValue& value : params["dirs"].toArray()) {
+        QString target;
+        if (!resolve(root, value.toString(), &target, error)) return QJsonObject();
+        if (!QDir().mkpath(target)) fail(value.toString(), "Cannot create directory");
+    }
+
+    // Сначала вся пачка во временные файлы; незакоммиченные QSaveFile удаляют их сами
+    std::vector<std::unique_ptr<QSaveFile>> staged;
+    for (size_t i = 0; i < targets.size(); ++i) {
+        std::unique_ptr<QSaveFile> file(new QSaveFile(targets[i].second));
+        QString message;
+        if (stageFile(targets[i].second, files[static_cast<int>(i)].toObject(), file.get(), &message)) {
+            staged.push_back(std::move(file));
+        } else {
+            fail(targets[i].first, message);
+        }
+    }
+
+    int written = 0;
+    int removed = 0;
+    if (errors.isEmpty()) {
+        for (size_t i = 0; i < staged.size(); ++i) {
+            if (staged[i]->commit()) ++written;
+            else fail(targets[i].first, staged[i]->errorString());
+        }
+        for (const QString& target : removeTargets) {
+            if (QFile::remove(target)) ++removed;
+            else if (QFileInfo::exists(target)) fail(QDir(root.path).relativeFilePath(target), "Cannot remove");
+        }
+    }
+
+    QJsonObject result;
+    result["written"] = written;
+    result["removed"] = removed;
+    result["errors"] = errors;
+    return result;
+}
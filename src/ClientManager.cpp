@@ -5,18 +5,19 @@
 #include <QJsonDocument>
 #include <QJsonObject>
 #include <QJsonArray>
-#include <QDataStream>
 #include <QDebug>
+#include <QSettings>
 
 ClientManager::ClientManager(QObject* parent)
-    : QObject(parent), blockSize(0), nextId(1)
+    : QObject(parent)
 {
-    socket = new QTcpSocket(this);
-    connect(socket, &QTcpSocket::connected, this, &ClientManager::onConnected);
-    connect(socket, &QTcpSocket::readyRead, this, &ClientManager::onReadyRead);
-    connect(socket, &QTcpSocket::disconnected, this, &ClientManager::disconnected);
-    connect(socket, QOverload<QAbstractSocket::SocketError>::of(&QTcpSocket::error),
-            this, &ClientManager::onErrorOccurred);
+    // Протокол целиком в RpcClient; здесь только разбор ответов в сигналы для GUI
+    rpc = new RpcClient(this);
+    connect(rpc, &RpcClient::connected, this, &ClientManager::connected);
+    connect(rpc, &RpcClient::disconnected, this, &ClientManager::disconnected);
+    connect(rpc, &RpcClient::connectionError, this, &ClientManager::connectionError);
+    connect(rpc, &RpcClient::replyReceived, this, &ClientManager::onReply);
+    connect(rpc, &RpcClient::notificationReceived, this, &ClientManager::processNotification);
 }
 
 void ClientManager::uploadFile(const QString& localPath, const QString& remotePath) {
@@ -29,13 +30,17 @@ void ClientManager::uploadFile(const QString& localPath, const QString& remotePa
     QByteArray fileData = file.readAll();
     file.close();
 
+    // Перезапись существующего файла не меняет mtime каталога, поэтому его список
+    // в кэше больше не верен
+    invalidateDirectory(remotePath);
+
     QJsonObject request;
     request["method"] = "uploadFile";
     QJsonObject params;
     params["remotePath"] = remotePath;
     params["data"] = QString::fromUtf8(fileData.toBase64());
     request["params"] = params;
-    sendJson(request, "uploadFile");
+    sendJson(request, FrameChannel::Bulk);
 }
 
 void ClientManager::downloadFile(const QString& remotePath, const QString& localPath) {
@@ -43,19 +48,70 @@ void ClientManager::downloadFile(const QString& remotePath, const QString& local
     request["method"] = "downloadFile";
     QJsonObject params;
     params["remotePath"] = remotePath;
-    params["savePath"] = localPath;
     request["params"] = params;
-    sendJson(request, "downloadFile");
+    // Демон не знает, куда сохранять: путь запоминаем до ответа
+    int id = sendJson(request);
+    if (id >= 0) requestPaths.insert(id, localPath);
+}
+
+void ClientManager::tailFile(const QString& remotePath, const QString& filter, qint64 backlogBytes) {
+    QJsonObject request;
+    request["method"] = "tailFile";
+    QJsonObject params;
+    params["path"] = remotePath;
+    params["filter"] = filter;
+    params["backlogBytes"] = backlogBytes;
+    request["params"] = params;
+    sendJson(request);
+}
+
+void ClientManager::followJournal(const QStringList& units, const QString& filter, int lines) {
+    QJsonObject request;
+    request["method"] = "followJournal";
+    QJsonObject params;
+    params["units"] = QJsonArray::fromStringList(units);
+    params["filter"] = filter;
+    params["lines"] = lines;
+    request["params"] = params;
+    sendJson(request);
+}
+
+void ClientManager::unsubscribe(int subscriptionId) {
+    QJsonObject request;
+    request["method"] = "unsubscribe";
+    request["params"] = QJsonObject{{"subscription", subscriptionId}};
+    sendJson(request);
 }
 
 void ClientManager::setFilePermissions(const QString& filePath, const QString& permissions) {
+    invalidateDirectory(filePath);
     QJsonObject request;
     request["method"] = "setFilePermissions";
     QJsonObject params;
     params["path"] = filePath;
     params["permissions"] = permissions;
     request["params"] = params;
-    sendJson(request, "setFilePermissions");
+    sendJson(request);
+}
+
+void ClientManager::setPermissionsRecursive(const QString& path, const QString& mode) {
+    invalidateDirectory(path);
+    QJsonObject request;
+    request["method"] = "fileOperation";
+    QJsonObject params;
+    params["operation"] = "chmod";
+    params["paths"] = QJsonArray{path};
+    params["mode"] = mode;
+    params["recursive"] = true;
+    request["params"] = params;
+    sendJson(request);
+}
+
+void ClientManager::cancelFileOperation(int operationId) {
+    QJsonObject request;
+    request["method"] = "cancelFileOperation";
+    request["params"] = QJsonObject{{"operation", operationId}};
+    sendJson(request);
 }
 
 void ClientManager::manageService(const QString& serviceName, const QString& action) {
@@ -65,7 +121,7 @@ void ClientManager::manageService(const QString& serviceName, const QString& act
     params["service"] = serviceName;
     params["action"] = action;
     request["params"] = params;
-    sendJson(request, "manageService");
+    sendJson(request);
 }
 
 void ClientManager::removeUser(const QString& username) {
@@ -74,7 +130,7 @@ void ClientManager::removeUser(const QString& username) {
     QJsonObject params;
     params["username"] = username;
     request["params"] = params;
-    sendJson(request, "removeUser");
+    sendJson(request);
 }
 
 void ClientManager::addUser(const QString& username, const QString& password) {
@@ -84,7 +140,7 @@ void ClientManager::addUser(const QString& username, const QString& password) {
     params["username"] = username;
     params["password"] = password;
     request["params"] = params;
-    sendJson(request, "addUser");
+    sendJson(request);
 }
 
 void ClientManager::changeUserPassword(const QString& username, const QString& newPassword) {
@@ -94,148 +150,168 @@ void ClientManager::changeUserPassword(const QString& username, const QString& n
     params["username"] = username;
     params["password"] = newPassword;
     request["params"] = params;
-    sendJson(request, "changeUserPassword");
+    sendJson(request);
 }
 
-void ClientManager::connectToServer(const QString& host, quint16 port) {
-    socket->connectToHost(host, port);
+void ClientManager::connectToServer(const QString& host, quint16 port, bool useTls) {
+    // Кэш переживает переподключение: при возврате к демону данные видны сразу
+    cacheHost = QString("%1:%2").arg(host).arg(port);
+
+    QSettings settings;
+    TlsOptions tls;
+    tls.enabled = useTls || settings.value("tls/enabled", false).toBool();
+    tls.caFile = settings.value("tls/caCertificates").toString();
+    tls.certificateFile = settings.value("tls/certificate").toString();
+    tls.privateKeyFile = settings.value("tls/privateKey").toString();
+    tls.peerName = settings.value("tls/peerName").toString();
+    tls.verifyPeer = settings.value("tls/verifyPeer", true).toBool();
+    QString error;
+    if (!rpc->setTls(tls, &error)) {
+        emit connectionError("Ошибка настройки TLS: " + error);
+        return;
+    }
+
+    Credentials credentials;
+    credentials.user = settings.value("auth/user").toString();
+    const QString secretFile = settings.value("auth/secretFile").toString();
+    if (!credentials.user.isEmpty() && !Credentials::loadSecret(secretFile, &credentials.secret, &error)) {
+        emit connectionError("Ошибка настройки входа: " + error);
+        return;
+    }
+    rpc->setCredentials(credentials);
+    rpc->connectToHost(host, port);
 }
 
-void ClientManager::onConnected() {
-    emit connected();
+QString ClientManager::role() const {
+    return rpc->role();
 }
 
-void ClientManager::onErrorOccurred(QAbstractSocket::SocketError socketError) {
-    QString errorMsg;
-    switch (socketError) {
-    case QAbstractSocket::ConnectionRefusedError:
-        errorMsg = "Сервер отверг подключение";
-        break;
-    case QAbstractSocket::HostNotFoundError:
-        errorMsg = "Сервер не найден";
-        break;
-    case QAbstractSocket::NetworkError:
-        errorMsg = "Сетевая ошибка";
-        break;
-    default:
-        errorMsg = socket->errorString();
-    }
+void ClientManager::disconnectFromServer() {
+    // Сначала забываем свои вызовы, чтобы отменённые не пришли через callFinished
+    genericCalls.clear();
+    rpc->disconnectFromHost();
+}
 
-    qWarning() << "Connection error:" << errorMsg;
-    emit connectionError(errorMsg);
+int ClientManager::call(const QString& method, const QJsonObject& params) {
+    int id = rpc->call(method, params);
+    if (id >= 0) genericCalls.insert(id);
+    return id;
 }
 
-void ClientManager::sendJson(const QJsonObject& baseObj, const QString& methodName) {
-    if (socket->state() != QAbstractSocket::ConnectedState) {
-        qWarning() << "Trying to send data while not connected";
-        return;
+int ClientManager::sendJson(const QJsonObject& request, FrameChannel::Priority priority) {
+    return rpc->call(request["method"].toString(), request["params"].toObject(), priority);
+}
+
+int ClientManager::sendCached(const QString& method, const QJsonObject& params, const QString& requestPath,
+                              bool useCache) {
+    const QString key = ResponseCache::key(cacheHost, method, params);
+    QJsonObject requestParams = params;
+    if (useCache) {
+        if (const ResponseCache::Entry* cached = cache.find(key)) {
+            const QJsonValue value = cached->value;
+            if (!cached->etag.isEmpty()) requestParams["etag"] = cached->etag;
+            dispatchResult(method, value, requestPath);
+        }
     }
-    QJsonObject obj = baseObj;
-    int id = nextId++;
-    obj["id"] = id;
-    pendingRequests[id] = methodName;
+    // Пустой etag для getFileSystem - полный список, но уже вместе с валидатором
+    if (method == "getFileSystem" && !requestParams.contains("etag")) requestParams["etag"] = QString();
 
-    QJsonDocument doc(obj);
-    QByteArray data = doc.toJson(QJsonDocument::Compact);
+    int id = rpc->call(method, requestParams);
+    if (id >= 0) {
+        cacheKeys.insert(id, key);
+        if (!requestPath.isEmpty()) requestPaths.insert(id, requestPath);
+    }
+    return id;
+}
 
-    QByteArray packet;
-    quint32 len = data.size();
-    QDataStream stream(&packet, QIODevice::WriteOnly);
-    stream.setByteOrder(QDataStream::BigEndian);
-    stream << len;
-    packet.append(data);
-    socket->write(packet);
+void ClientManager::invalidateDirectory(const QString& path) {
+    const QString dir = QFileInfo(path).path();
+    cache.remove(ResponseCache::key(cacheHost, "getFileSystem", QJsonObject{{"path", dir}}));
 }
 
 void ClientManager::requestUserList() {
-    QJsonObject request;
-    request["method"] = "getUserList";
-    request["params"] = QJsonObject();
-    sendJson(request, "getUserList");
+    sendCached("getUserList", QJsonObject(), QString(), true);
 }
 
 void ClientManager::requestSystemInfo() {
     QJsonObject request;
     request["method"] = "getSystemInfo";
-    sendJson(request, "getSystemInfo");
+    sendJson(request);
 }
 
+// Ответ - только список; каталог, к которому он относится, помним сами
 void ClientManager::requestFileSystem(const QString& path) {
-    QJsonObject request;
-    request["method"] = "getFileSystem";
-    request["params"] = QJsonObject{{"path", path}};
-    sendJson(request, "getFileSystem");
+    sendCached("getFileSystem", QJsonObject{{"path", path}}, path, true);
 }
 
-void ClientManager::requestProcessList() {
+void ClientManager::reloadFileSystem(const QString& path) {
+    sendCached("getFileSystem", QJsonObject{{"path", path}}, path, false);
+}
+
+void ClientManager::requestProcessList(const QJsonObject& query) {
     QJsonObject request;
     request["method"] = "getProcessList";
-    sendJson(request, "getProcessList");
+    request["params"] = query;
+    sendJson(request);
 }
 
-
-
-void ClientManager::onReadyRead() {
-    QDataStream in(socket);
-    in.setVersion(QDataStream::Qt_5_14);
-    in.setByteOrder(QDataStream::BigEndian);
-
-    if (blockSize == 0) {
-        if (socket->bytesAvailable() < static_cast<int>(sizeof(quint32))) return;
-        in >> blockSize;
-    }
-    if (socket->bytesAvailable() < blockSize) return;
-
-    QByteArray data;
-    data.resize(blockSize);
-    in.readRawData(data.data(), blockSize);
-    blockSize = 0;
-
-    QJsonParseError parseError;
-    QJsonDocument doc = QJsonDocument::fromJson(data, &parseError);
-    if (parseError.error != QJsonParseError::NoError) {
-        qWarning() << "JSON parse error:" << parseError.errorString();
+void ClientManager::onReply(int id, const QString& method, const RpcResult& reply) {
+    const QString requestPath = requestPaths.take(id);
+    const QString cacheKey = cacheKeys.take(id);
+    if (genericCalls.remove(id)) {
+        emit callFinished(id, method, reply.result, reply.errorMessage);
         return;
     }
-
-    QJsonObject response = doc.object();
-    if (!response.contains("id")) {
-        qWarning() << "JSON-RPC response without id";
-        return;
-    }
-    int id = response["id"].toInt(-1);
-    if (!pendingRequests.contains(id)) {
-        qWarning() << "Unknown id in response:" << id;
-        return;
-    }
-    QString method = pendingRequests.take(id);
-    if (response.contains("error")) {
-        QJsonObject err = response["error"].toObject();
-        qWarning() << "Server returned error for" << method << ":" << err["message"].toString();
+    if (!reply.ok()) {
+        if (reply.isBusy()) {
+            // Демон перегружен или клиент превысил лимит запросов
+            qWarning() << "Server busy for" << method << ", retry after" << reply.retryAfterMs() << "ms";
+        } else if (reply.errorCode == RpcClient::permissionDeniedCode) {
+            emit permissionDenied(method, reply.errorMessage);
+        } else {
+            qWarning() << "Server returned error for" << method << ":" << reply.errorMessage;
+        }
         return;
     }
-    if (!response.contains("result")) {
-        qWarning() << "Response for" << method << "has no result";
-        return;
+
+    QJsonValue result = reply.result;
+    if (method == "getFileSystem" && result.isObject()) {
+        // Новый демон: {etag, entries} или {notModified, etag}; старый шлёт просто массив
+        const QJsonObject listing = result.toObject();
+        if (listing["notModified"].toBool()) return; // из кэша уже показано
+        result = listing["entries"];
+        if (!cacheKey.isEmpty()) cache.insert(cacheKey, result, listing["etag"].toString());
+    } else if (!cacheKey.isEmpty()) {
+        cache.insert(cacheKey, result);
     }
+    dispatchResult(method, result, requestPath);
+}
 
+void ClientManager::dispatchResult(const QString& method, const QJsonValue& result, const QString& requestPath) {
     if (method == "getUserList") {
-        QJsonArray array = response["result"].toArray();
+        QJsonArray array = result.toArray();
         QStringList list;
         for (const auto& val : array) list << val.toString();
         emit userListReceived(list);
     } else if (method == "getSystemInfo") {
-        emit systemInfoReceived(response["result"].toObject());
+        emit systemInfoReceived(result.toObject());
     } else if (method == "getFileSystem") {
-        emit fileSystemReceived(response["result"].toArray());
+        emit fileSystemReceived(requestPath, result.toArray());
     } else if (method == "getProcessList") {
-        emit processListReceived(response["result"].toArray());
+        emit processListReceived(result.toArray());
     } else if (method == "getServiceList") {
-        emit serviceListReceived(response["result"].toArray());
+        emit serviceListReceived(result.toArray());
+    } else if (method == "getCgroupStats") {
+        emit cgroupStatsReceived(result.toArray());
+    } else if (method == "getNetworkStats") {
+        emit networkStatsReceived(result.toObject());
+    } else if (method == "getDiskStats") {
+        emit diskStatsReceived(result.toArray());
+    } else if (method == "getDaemonStats") {
+        emit daemonStatsReceived(result.toObject());
     } else if (method == "downloadFile") {
-        QJsonObject result = response["result"].toObject();
-        QString savePath = result["savePath"].toString();
-        QByteArray fileData = QByteArray::fromBase64(result["data"].toString().toUtf8());
+        const QString& savePath = requestPath;
+        QByteArray fileData = QByteArray::fromBase64(result.toObject()["data"].toString().toUtf8());
 
         QFile file(savePath);
         if (file.open(QIODevice::WriteOnly)) {
@@ -248,17 +324,60 @@ void ClientManager::onReadyRead() {
     } else if (method == "uploadFile") {
         emit fileUploadFinished(true, "Upload completed");
     } else {
-        emit operationFinished(method, response["result"].toObject());
+        emit operationFinished(method, result.toObject());
+    }
+}
+
+void ClientManager::processNotification(const QString& method, const QJsonObject& params) {
+    if (method == "logData") {
+        emit logDataReceived(params["subscription"].toInt(),
+                             params["data"].toString(),
+                             params["dropped"].toVariant().toLongLong());
+    } else if (method == "logClosed") {
+        emit logStreamClosed(params["subscription"].toInt(), params["reason"].toString());
+    } else if (method == "fileOperationProgress") {
+        emit fileOperationProgress(params["operation"].toInt(), params);
+    } else if (method == "fileOperationFinished") {
+        emit fileOperationFinished(params["operation"].toInt(), params);
+    } else {
+        qWarning() << "Unknown notification:" << method;
     }
 }
 
 bool ClientManager::isConnected() const {
-    return socket && socket->state() == QAbstractSocket::ConnectedState;
+    return rpc->isConnected();
 }
 
 void ClientManager::requestServiceList()
+{
+    sendCached("getServiceList", QJsonObject(), QString(), true);
+}
+
+void ClientManager::requestCgroupStats(const QJsonObject& query)
+{
+    QJsonObject request;
+    request["method"] = "getCgroupStats";
+    request["params"] = query;
+    sendJson(request);
+}
+
+void ClientManager::requestNetworkStats()
+{
+    QJsonObject request;
+    request["method"] = "getNetworkStats";
+    sendJson(request);
+}
+
+void ClientManager::requestDiskStats()
+{
+    QJsonObject request;
+    request["method"] = "getDiskStats";
+    sendJson(request);
+}
+
+void ClientManager::requestDaemonStats()
 {
     QJsonObject request;
-    request["method"] = "getServiceList";
-    sendJson(request, "getServiceList");
+    request["method"] = "getDaemonStats";
+    sendJson(request);
 }
@@ -2,12 +2,16 @@
 #define CLIENTMANAGER_H
 
 #include <QObject>
-#include <QTcpSocket>
 #include <QJsonDocument>
 #include <QJsonObject>
 #include <QJsonArray>
 #include <QFile>
+#include <QSet>
+#include <QHash>
+#include "RpcClient.h"
+#include "ResponseCache.h"
 
+// Обёртка над RpcClient для GUI: типизированные запросы и сигналы на каждый ответ
 class ClientManager : public QObject {
     Q_OBJECT
 public:
@@ -15,50 +19,95 @@ public:
 
     bool isConnected() const;
 
-    void connectToServer(const QString& host, quint16 port);
+    // useTls - демон объявил, что принимает только TLS; сертификаты берутся
+    // из секции [tls] настроек клиента
+    void connectToServer(const QString& host, quint16 port, bool useTls = false);
+    void disconnectFromServer();
+    // Роль, выданная демоном после входа (секция [auth] настроек клиента)
+    QString role() const;
+
+    // Произвольный вызов: результат или ошибка приходят через callFinished
+    int call(const QString& method, const QJsonObject& params = QJsonObject());
 
     void requestUserList();
     void requestSystemInfo();
+    // Список каталога: сохранённый в кэше отдаётся сразу, затем перепроверяется
+    // у демона по etag. reloadFileSystem запрашивает список целиком
     void requestFileSystem(const QString& path);
-    void requestProcessList();
+    void reloadFileSystem(const QString& path);
+    void requestProcessList(const QJsonObject& query = QJsonObject());
     void requestServiceList();
+    void requestCgroupStats(const QJsonObject& query = QJsonObject());
+    void requestNetworkStats();
+    void requestDiskStats();
+    void requestDaemonStats();
     void addUser(const QString& username, const QString& password);
     void removeUser(const QString& username);
     void changeUserPassword(const QString& username, const QString& password);
     void setFilePermissions(const QString& path, const QString& permissions);
+    // chmod всего дерева одной операцией на демоне; ход и итог - через
+    // fileOperationProgress/fileOperationFinished
+    void setPermissionsRecursive(const QString& path, const QString& mode);
+    void cancelFileOperation(int operationId);
     void manageService(const QString& service, const QString& action);
 
     void uploadFile(const QString& localPath, const QString& remotePath);
     void downloadFile(const QString& remotePath, const QString& localPath);
 
+    // Подписки на журналы: id подписки приходит через operationFinished
+    void tailFile(const QString& remotePath, const QString& filter = QString(), qint64 backlogBytes = 8192);
+    void followJournal(const QStringList& units, const QString& filter = QString(), int lines = 50);
+    void unsubscribe(int subscriptionId);
+
 signals:
     void connected();
     void disconnected();
     void connectionError(const QString& errorString);
+    // Роли не хватает для метода; данные на экране при этом не меняются
+    void permissionDenied(const QString& method, const QString& message);
 
     void userListReceived(const QStringList& users);
     void systemInfoReceived(const QJsonObject& info);
-    void fileSystemReceived(const QJsonArray& files);
+    void fileSystemReceived(const QString& path, const QJsonArray& files);
     void processListReceived(const QJsonArray& processes);
     void operationFinished(const QString& methodName, const QJsonObject& result);
     void serviceListReceived(const QJsonArray& services);
+    void cgroupStatsReceived(const QJsonArray& groups);
+    void networkStatsReceived(const QJsonObject& stats);
+    void diskStatsReceived(const QJsonArray& devices);
+    void daemonStatsReceived(const QJsonObject& stats);
 
     void fileDownloadFinished(bool success, const QString& message);
     void fileUploadFinished(bool success, const QString& message);
 
+    void logDataReceived(int subscriptionId, const QString& data, qint64 droppedBytes);
+    void logStreamClosed(int subscriptionId, const QString& reason);
+
+    void fileOperationProgress(int operationId, const QJsonObject& state);
+    void fileOperationFinished(int operationId, const QJsonObject& summary);
+
+    void callFinished(int id, const QString& method, const QJsonValue& result, const QString& error);
+
 private slots:
-    void onConnected();
-    void onReadyRead();
-    void onErrorOccurred(QAbstractSocket::SocketError);
+    void onReply(int id, const QString& method, const RpcResult& reply);
+    void processNotification(const QString& method, const QJsonObject& params);
 
 private:
-    void sendJson(const QJsonObject& obj, const QString& methodName);
+    int sendJson(const QJsonObject& request, FrameChannel::Priority priority = FrameChannel::Interactive);
+    // Запрос с кэшем: при useCache сохранённый ответ сразу уходит в сигналы
+    int sendCached(const QString& method, const QJsonObject& params, const QString& requestPath, bool useCache);
+    void dispatchResult(const QString& method, const QJsonValue& result, const QString& requestPath);
+    void invalidateDirectory(const QString& path);
 
-    QTcpSocket* socket;
-    quint32 blockSize;
+    RpcClient* rpc;
+    ResponseCache cache;
+    QString cacheHost; // "адрес:порт" текущего демона, часть ключа кэша
+    QHash<int, QString> cacheKeys; // id запроса -> ключ кэша
 
-    QMap<int, QString> pendingRequests;
-    int nextId;
+    QSet<int> genericCalls;
+    // id запроса -> путь, к которому относится ответ: каталог getFileSystem
+    // или локальный файл downloadFile
+    QHash<int, QString> requestPaths;
 };
 
 #endif // CLIENTMANAGER_H
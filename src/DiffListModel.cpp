@@ -0,0 +1,95 @@
+#include "DiffListModel.h"
+#include <QSet>
+
+namespace {
+
+const int fetchBatchSize = 1000;
+
+} // namespace
+
+DiffListModel::DiffListModel(QObject* parent)
+    : QAbstractListModel(parent), shown(0)
+{}
+
+void DiffListModel::setItems(const QStringList& items)
+{
+    const QSet<QString> newSet(items.begin(), items.end());
+    const QSet<QString> oldSet(values.begin(), values.end());
+
+    // Точечное обновление, только когда всё уже показано и строки уникальны;
+    // иначе (первая загрузка, огромный список) - замена с показом первой порции
+    const bool incremental = shown == values.size() && items.size() <= fetchBatchSize
+        && newSet.size() == items.size() && oldSet.size() == values.size() && !values.isEmpty();
+
+    if (!incremental) {
+        if (shown > 0) {
+            beginRemoveRows(QModelIndex(), 0, shown - 1);
+            values.clear();
+            shown = 0;
+            endRemoveRows();
+        }
+        values = items;
+        const int first = qMin(fetchBatchSize, values.size());
+        if (first > 0) {
+            beginInsertRows(QModelIndex(), 0, first - 1);
+            shown = first;
+            endInsertRows();
+        }
+        return;
+    }
+
+    // Удаляем исчезнувшие, с конца, чтобы индексы оставшихся не съезжали
+    for (int row = values.size() - 1; row >= 0; --row) {
+        if (newSet.contains(values[row])) continue;
+        int first = row;
+        while (first > 0 && !newSet.contains(values[first - 1])) --first;
+        beginRemoveRows(QModelIndex(), first, row);
+        values.erase(values.begin() + first, values.begin() + row + 1);
+        shown = values.size();
+        endRemoveRows();
+        row = first;
+    }
+
+    // Дальше приводим порядок к новому: вставки и перемещения на месте
+    for (int k = 0; k < items.size(); ++k) {
+        if (k < values.size() && values[k] == items[k]) continue;
+        if (!oldSet.contains(items[k])) {
+            beginInsertRows(QModelIndex(), k, k);
+            values.insert(k, items[k]);
+            shown = values.size();
+            endInsertRows();
+        } else {
+            const int from = values.indexOf(items[k], k);
+            beginMoveRows(QModelIndex(), from, from, QModelIndex(), k);
+            values.move(from, k);
+            endMoveRows();
+        }
+    }
+}
+
+int DiffListModel::rowCount(const QModelIndex& parent) const
+{
+    return parent.isValid() ? 0 : shown;
+}
+
+QVariant DiffListModel::data(const QModelIndex& index, int role) const
+{
+    if (!index.isValid() || index.row() >= shown) return QVariant();
+    if (role == Qt::DisplayRole || role == Qt::ToolTipRole) return values.at(index.row());
+    return QVariant();
+}
+
+bool DiffListModel::canFetchMore(const QModelIndex& parent) const
+{
+    return !parent.isValid() && shown < values.size();
+}
+
+void DiffListModel::fetchMore(const QModelIndex& parent)
+{
+    if (parent.isValid()) return;
+    const int count = qMin(fetchBatchSize, values.size() - shown);
+    if (count <= 0) return;
+    beginInsertRows(QModelIndex(), shown, shown + count - 1);
+    shown += count;
+    endInsertRows();
+}
@@ -0,0 +1,29 @@
+#ifndef DIFFLISTMODEL_H
+#define DIFFLISTMODEL_H
+
+#include <QAbstractListModel>
+#include <QStringList>
+
+// Список строк для QListView, который обновляется по разнице со старым
+// содержимым: выделение и прокрутка не сбрасываются при каждом ответе демона.
+// Большой список, как и в RemoteFileModel, отдаётся представлению порциями.
+class DiffListModel : public QAbstractListModel
+{
+    Q_OBJECT
+public:
+    explicit DiffListModel(QObject* parent = nullptr);
+
+    void setItems(const QStringList& items);
+    const QStringList& items() const { return values; }
+
+    int rowCount(const QModelIndex& parent = QModelIndex()) const override;
+    QVariant data(const QModelIndex& index, int role = Qt::DisplayRole) const override;
+    bool canFetchMore(const QModelIndex& parent) const override;
+    void fetchMore(const QModelIndex& parent) override;
+
+private:
+    QStringList values;
+    int shown;
+};
+
+#endif // DIFFLISTMODEL_H
@@ -0,0 +1,243 @@
+#include "FleetManager.h"
+#include "ClientManager.h"
+#include <QTimer>
+#include <QRandomGenerator>
+#include <QDebug>
+
+namespace {
+
+const int connectTimeoutMs = 5000;
+const int baseBackoffMs = 500;
+const int maxBackoffMs = 30000;
+
+} // namespace
+
+FleetManager::FleetManager(QObject* parent)
+    : QObject(parent),
+      nextQueryId(1),
+      maxConcurrentConnects(32),
+      maxAttempts(3)
+{}
+
+QString FleetManager::hostKey(const HostInfo& host)
+{
+    return QString("%1:%2").arg(host.address).arg(host.port);
+}
+
+int FleetManager::fanOut(const QList<HostInfo>& targets, const QString& method, const QJsonObject& params)
+{
+    const int queryId = nextQueryId++;
+    if (targets.isEmpty()) {
+        QTimer::singleShot(0, this, [this, queryId]() { emit queryFinished(queryId); });
+        return queryId;
+    }
+
+    queries[queryId].total = targets.size();
+    for (const HostInfo& info : targets) {
+        Host& host = hostFor(info);
+        host.queue.enqueue({ queryId, method, params });
+
+        if (host.state == HostState::Connected) {
+            flushQueue(host);
+        } else if (host.state == HostState::Idle && !waitingHosts.contains(hostKey(info))) {
+            waitingHosts.enqueue(hostKey(info));
+        }
+    }
+    pump();
+    return queryId;
+}
+
+void FleetManager::cancel(int queryId)
+{
+    // Ответы на уже отправленные запросы просто отбросятся в completeOne
+    queries.remove(queryId);
+}
+
+void FleetManager::disconnectAll()
+{
+    queries.clear();
+    waitingHosts.clear();
+    for (Host& host : hosts) {
+        host.queue.clear();
+        host.inFlight.clear();
+        host.state = HostState::Idle;
+        host.failures = 0;
+        host.client->disconnectFromServer();
+    }
+}
+
+FleetManager::Host& FleetManager::hostFor(const HostInfo& info)
+{
+    const QString key = hostKey(info);
+    auto it = hosts.find(key);
+    if (it != hosts.end()) return it.value();
+
+    Host host;
+    host.info = info;
+    host.client = new ClientManager(this);
+    host.client->setObjectName(key);
+    connect(host.client, &ClientManager::connected, this, &FleetManager::onHostConnected);
+    connect(host.client, &ClientManager::connectionError, this, &FleetManager::onHostError);
+    connect(host.client, &ClientManager::disconnected, this, &FleetManager::onHostDisconnected);
+    connect(host.client, &ClientManager::callFinished, this, &FleetManager::onCallFinished);
+    return hosts.insert(key, host).value();
+}
+
+FleetManager::Host* FleetManager::hostBySender()
+{
+    ClientManager* client = qobject_cast<ClientManager*>(sender());
+    if (!client) return nullptr;
+    auto it = hosts.find(client->objectName());
+    return it != hosts.end() ? &it.value() : nullptr;
+}
+
+int FleetManager::connectingCount() const
+{
+    int count = 0;
+    for (const Host& host : hosts) {
+        if (host.state == HostState::Connecting) ++count;
+    }
+    return count;
+}
+
+void FleetManager::pump()
+{
+    int connecting = connectingCount();
+    while (connecting < maxConcurrentConnects && !waitingHosts.isEmpty()) {
+        const QString key = waitingHosts.dequeue();
+        auto it = hosts.find(key);
+        if (it == hosts.end() || it->state != HostState::Idle || it->queue.isEmpty()) continue;
+
+        it->state = HostState::Connecting;
+        it->client->connectToServer(it->info.address, it->info.port, it->info.tls);
+        ++connecting;
+
+        // Без таймаута зависшее подключение занимало бы слот до таймаута ОС
+        const int attempt = ++it->attempt;
+        QTimer::singleShot(connectTimeoutMs, this, [this, key, attempt]() {
+            auto host = hosts.find(key);
+            if (host != hosts.end() && host->state == HostState::Connecting && host->attempt == attempt) {
+                handleFailure(host.value(), "Connection timed out");
+            }
+        });
+    }
+}
+
+void FleetManager::flushQueue(Host& host)
+{
+    const QString key = hostKey(host.info);
+    while (!host.queue.isEmpty()) {
+        PendingCall call = host.queue.dequeue();
+        if (!queries.contains(call.queryId)) continue;
+
+        int id = host.client->call(call.method, call.params);
+        if (id < 0) completeOne(call.queryId, key, QJsonValue(), "Not connected");
+        else host.inFlight.insert(id, call.queryId);
+    }
+}
+
+// Сигналы из completeOne могут добавить хосты, поэтому сначала забираем данные из host
+void FleetManager::failQueue(Host& host, const QString& error)
+{
+    const QString key = hostKey(host.info);
+    QQueue<PendingCall> queue;
+    queue.swap(host.queue);
+    for (const PendingCall& call : queue) completeOne(call.queryId, key, QJsonValue(), error);
+}
+
+void FleetManager::failInFlight(Host& host, const QString& error)
+{
+    const QString key = hostKey(host.info);
+    const QList<int> lost = host.inFlight.values();
+    host.inFlight.clear();
+    for (int queryId : lost) completeOne(queryId, key, QJsonValue(), error);
+}
+
+void FleetManager::completeOne(int queryId, const QString& key, const QJsonValue& result, const QString& error)
+{
+    auto query = queries.find(queryId);
+    if (query == queries.end()) return;
+
+    emit hostResult(queryId, key, result, error);
+    ++query->done;
+    emit queryProgress(queryId, query->done, query->total);
+    if (query->done >= query->total) {
+        queries.erase(query);
+        emit queryFinished(queryId);
+    }
+}
+
+void FleetManager::onHostConnected()
+{
+    Host* host = hostBySender();
+    if (!host) return;
+
+    host->state = HostState::Connected;
+    host->failures = 0;
+    flushQueue(*host);
+    pump();
+}
+
+void FleetManager::onHostError(const QString& errorString)
+{
+    Host* host = hostBySender();
+    if (host) handleFailure(*host, errorString);
+}
+
+void FleetManager::handleFailure(Host& host, const QString& error)
+{
+    if (host.state == HostState::Backoff) return;
+
+    const QString key = hostKey(host.info);
+    ++host.failures;
+    host.state = HostState::Backoff;
+    host.client->disconnectFromServer();
+
+    if (host.failures >= maxAttempts) {
+        qWarning() << "Fleet host" << key << "unreachable:" << error;
+        host.state = HostState::Idle;
+        host.failures = 0;
+        failQueue(host, error);
+    } else {
+        // Экспоненциальная задержка с разбросом, чтобы хосты не переподключались разом
+        int delay = qMin(maxBackoffMs, baseBackoffMs << (host.failures - 1));
+        delay += QRandomGenerator::global()->bounded(delay / 4 + 1);
+        QTimer::singleShot(delay, this, [this, key]() {
+            auto it = hosts.find(key);
+            if (it == hosts.end() || it->state != HostState::Backoff) return;
+            it->state = HostState::Idle;
+            if (!it->queue.isEmpty()) waitingHosts.enqueue(key);
+            pump();
+        });
+    }
+
+    // Ссылка на host дальше не используется: обработчики сигналов могли изменить hosts
+    auto it = hosts.find(key);
+    if (it != hosts.end()) failInFlight(it.value(), error);
+    pump();
+}
+
+void FleetManager::onHostDisconnected()
+{
+    Host* host = hostBySender();
+    if (!host || host->state != HostState::Connected) return;
+
+    const QString key = hostKey(host->info);
+    host->state = HostState::Idle;
+    const bool hasQueued = !host->queue.isEmpty();
+    failInFlight(*host, "Connection lost");
+
+    if (hasQueued) {
+        waitingHosts.enqueue(key);
+        pump();
+    }
+}
+
+void FleetManager::onCallFinished(int id, const QString& method, const QJsonValue& result, const QString& error)
+{
+    Q_UNUSED(method);
+    Host* host = hostBySender();
+    if (!host || !host->inFlight.contains(id)) return;
+
+    completeOne(host->inFlight.take(id), hostKey(host->info), result, error);
+}
@@ -0,0 +1,87 @@
+#ifndef FLEETMANAGER_H
+#define FLEETMANAGER_H
+
+#include <QObject>
+#include <QHash>
+#include <QList>
+#include <QQueue>
+#include <QJsonObject>
+#include <QJsonValue>
+#include <QElapsedTimer>
+#include "NetworkDiscovery.h"
+
+class ClientManager;
+
+// Держит соединения сразу с множеством демонов и рассылает по ним один запрос.
+// Число одновременных подключений ограничено, упавшие хосты переподключаются
+// с экспоненциальной задержкой, результаты отдаются по мере поступления.
+class FleetManager : public QObject
+{
+    Q_OBJECT
+public:
+    explicit FleetManager(QObject* parent = nullptr);
+
+    void setMaxConcurrentConnects(int count) { maxConcurrentConnects = qMax(1, count); }
+    void setMaxAttempts(int count) { maxAttempts = qMax(1, count); }
+
+    // Возвращает id запроса; по каждому хосту придёт hostResult, в конце queryFinished
+    int fanOut(const QList<HostInfo>& hosts, const QString& method, const QJsonObject& params = QJsonObject());
+    void cancel(int queryId);
+    void disconnectAll();
+
+    static QString hostKey(const HostInfo& host);
+
+signals:
+    void hostResult(int queryId, const QString& host, const QJsonValue& result, const QString& error);
+    void queryProgress(int queryId, int done, int total);
+    void queryFinished(int queryId);
+
+private slots:
+    void onHostConnected();
+    void onHostError(const QString& errorString);
+    void onHostDisconnected();
+    void onCallFinished(int id, const QString& method, const QJsonValue& result, const QString& error);
+
+private:
+    enum class HostState { Idle, Connecting, Connected, Backoff };
+
+    struct PendingCall {
+        int queryId;
+        QString method;
+        QJsonObject params;
+    };
+
+    struct Host {
+        HostInfo info;
+        ClientManager* client = nullptr;
+        HostState state = HostState::Idle;
+        int failures = 0;
+        int attempt = 0;
+        QQueue<PendingCall> queue;
+        QHash<int, int> inFlight; // id запроса в ClientManager -> queryId
+    };
+
+    struct Query {
+        int total = 0;
+        int done = 0;
+    };
+
+    Host& hostFor(const HostInfo& info);
+    Host* hostBySender();
+    void pump();
+    void flushQueue(Host& host);
+    void failQueue(Host& host, const QString& error);
+    void failInFlight(Host& host, const QString& error);
+    void handleFailure(Host& host, const QString& error);
+    void completeOne(int queryId, const QString& key, const QJsonValue& result, const QString& error);
+    int connectingCount() const;
+
+    QHash<QString, Host> hosts;
+    QQueue<QString> waitingHosts;
+    QHash<int, Query> queries;
+    int nextQueryId;
+    int maxConcurrentConnects;
+    int maxAttempts;
+};
+
+#endif // FLEETMANAGER_H
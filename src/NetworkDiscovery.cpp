@@ -4,69 +4,144 @@
 #include <QNetworkInterface>
 #include <QHostAddress>
 #include <QAbstractSocket>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QJsonArray>
+
+namespace {
+
+//      daemon/src/Server.cpp
+const QHostAddress discoveryGroup("239.255.45.54");
+const int defaultTtlSeconds = 180;
+const int expiryCheckMs = 5000;
+
+} // namespace
 
 NetworkDiscovery::NetworkDiscovery(quint16 discoveryPort, QObject* parent)
     : QObject(parent), port_(discoveryPort)
 {
     udpSocket = new QUdpSocket(this);
-    //  AnyIPv4 -   
-    if (!udpSocket->bind(port_,
+    if (!udpSocket->bind(QHostAddress::AnyIPv4, port_,
                          QUdpSocket::ShareAddress | QUdpSocket::ReuseAddressHint)) {
         qCritical() << "UDP bind error:" << udpSocket->errorString();
+    } else {
+        joinGroup();
     }
     connect(udpSocket, &QUdpSocket::readyRead,
             this, &NetworkDiscovery::processPendingDatagrams);
+
+    //     :    ,
+    //         Discovery
+    querySocket = new QUdpSocket(this);
+    querySocket->bind(QHostAddress::AnyIPv4, 0);
+    querySocket->setSocketOption(QAbstractSocket::MulticastTtlOption, 1);
+    connect(querySocket, &QUdpSocket::readyRead,
+            this, &NetworkDiscovery::processPendingDatagrams);
+
+    clock.start();
+    expiryTimer.setInterval(expiryCheckMs);
+    connect(&expiryTimer, &QTimer::timeout, this, &NetworkDiscovery::expireHosts);
+    expiryTimer.start();
 }
 
 NetworkDiscovery::~NetworkDiscovery() { }
 
+void NetworkDiscovery::joinGroup() {
+    for (const QNetworkInterface& iface : QNetworkInterface::allInterfaces()) {
+        const auto flags = iface.flags();
+        if ((flags & QNetworkInterface::IsUp) && (flags & QNetworkInterface::CanMulticast) &&
+            !(flags & QNetworkInterface::IsLoopBack)) {
+            udpSocket->joinMulticastGroup(discoveryGroup, iface);
+        }
+    }
+}
+
 void NetworkDiscovery::startListening() {
-    qDebug() << "Sending discovery broadcast";
+    //           multicast.
+    //     ,    .
+    QJsonObject query;
+    query["type"] = "discover";
+    query["protocol"] = 1;
+    query["jitterMs"] = 250;
+    const QByteArray datagram = QJsonDocument(query).toJson(QJsonDocument::Compact);
 
-    //   UDP-   
-    QUdpSocket broadcastSocket;
-    QByteArray query = "__";
-    if (broadcastSocket.writeDatagram(query, QHostAddress::Broadcast, port_) == -1) {
-        qWarning() << "Broadcast send error:" << broadcastSocket.errorString();
-    } else {
-        qDebug() << "Broadcast sent successfully";
+    if (querySocket->writeDatagram(datagram, discoveryGroup, port_) == -1) {
+        qWarning() << "Multicast discovery send error:" << querySocket->errorString();
+    }
+    if (querySocket->writeDatagram(datagram, QHostAddress::Broadcast, port_) == -1) {
+        qWarning() << "Broadcast send error:" << querySocket->errorString();
     }
+}
 
-    // :   
-    QString localIp = getLocalIp();
-    if (!localIp.isEmpty()) {
-        QString baseIp = localIp.left(localIp.lastIndexOf('.') + 1);
-        for (int i = 1; i < 255; ++i) {
-            QString ip = baseIp + QString::number(i);
-            udpSocket->writeDatagram(query, QHostAddress(ip), port_);
-        }
+QList<HostInfo> NetworkDiscovery::knownHosts() const {
+    QList<HostInfo> result;
+    for (const CachedHost& cached : hosts) result.append(cached.info);
+    return result;
+}
+
+void NetworkDiscovery::rememberHost(const HostInfo& host, int ttlSeconds) {
+    const QString key = QString("%1:%2").arg(host.address).arg(host.port);
+    const qint64 expiresAt = clock.elapsed() + qint64(ttlSeconds) * 1000;
+
+    auto it = hosts.find(key);
+    if (it == hosts.end()) {
+        hosts.insert(key, { host, expiresAt });
+        emit hostDiscovered(host);
+    } else {
+        it->info = host;
+        it->expiresAtMs = expiresAt;
+        emit hostUpdated(host);
     }
 }
 
-QString NetworkDiscovery::getLocalIp() {
-    foreach (const QHostAddress &address, QNetworkInterface::allAddresses()) {
-        if (address.protocol() == QAbstractSocket::IPv4Protocol &&
-            address != QHostAddress::LocalHost) {
-            return address.toString();
+void NetworkDiscovery::expireHosts() {
+    const qint64 now = clock.elapsed();
+    for (auto it = hosts.begin(); it != hosts.end();) {
+        if (it->expiresAtMs <= now) {
+            HostInfo expired = it->info;
+            it = hosts.erase(it);
+            emit hostExpired(expired);
+        } else {
+            ++it;
         }
     }
-    return "";
 }
 
 void NetworkDiscovery::processPendingDatagrams() {
-    qDebug() << "Received datagram";
-    while (udpSocket->hasPendingDatagrams()) {
-        QNetworkDatagram datagram = udpSocket->receiveDatagram();
+    QUdpSocket* socket = qobject_cast<QUdpSocket*>(sender());
+    if (!socket) return;
+
+    while (socket->hasPendingDatagrams()) {
+        QNetworkDatagram datagram = socket->receiveDatagram();
         QByteArray data = datagram.data();
 
-        //    
+        //     "_:<>"
         if (data.startsWith("_:")) {
             bool ok = false;
-            quint16 tcpPort = data.mid(9).toUShort(&ok); //    
+            quint16 tcpPort = data.mid(data.indexOf(':') + 1).toUShort(&ok);
             if (ok) {
-                HostInfo host{ datagram.senderAddress().toString(), tcpPort };
-                emit hostDiscovered(host);
+                HostInfo host;
+                host.address = datagram.senderAddress().toString();
+                host.port = tcpPort;
+                rememberHost(host, defaultTtlSeconds);
             }
+            continue;
         }
+
+        QJsonObject announce = QJsonDocument::fromJson(data).object();
+        if (announce["type"].toString() != "announce") continue;
+
+        HostInfo host;
+        //  IPv4,   IPv6,    
+        QHostAddress sender = datagram.senderAddress();
+        bool isV4 = false;
+        quint32 v4 = sender.toIPv4Address(&isV4);
+        host.address = isV4 ? QHostAddress(v4).toString() : sender.toString();
+        host.port = static_cast<quint16>(announce["port"].toInt(port_));
+        host.hostname = announce["hostname"].toString();
+        host.version = announce["version"].toString();
+        host.load = announce["load"].toArray().at(0).toDouble();
+        host.tls = announce["tls"].toBool();
+        rememberHost(host, announce["ttl"].toInt(defaultTtlSeconds));
     }
 }
@@ -4,11 +4,20 @@
 #include <QObject>
 #include <QUdpSocket>
 #include <QString>
+#include <QHash>
+#include <QTimer>
+#include <QElapsedTimer>
+#include <QMetaType>
 
 struct HostInfo {
     QString address;
     quint16 port;
+    QString hostname;
+    QString version;
+    double load = 0.0;   // средняя загрузка за минуту
+    bool tls = false;    // демон принимает только TLS
 };
+Q_DECLARE_METATYPE(HostInfo)
 
 class NetworkDiscovery : public QObject {
     Q_OBJECT
@@ -16,17 +25,30 @@ public:
     explicit NetworkDiscovery(quint16 discoveryPort, QObject* parent = nullptr);
     ~NetworkDiscovery();
     void startListening();   // запустит «запрос в эфир»
+    QList<HostInfo> knownHosts() const;
 signals:
     void hostDiscovered(const HostInfo& host);
+    void hostUpdated(const HostInfo& host);
+    void hostExpired(const HostInfo& host);
 private slots:
     void processPendingDatagrams();
+    void expireHosts();
 private:
-    QUdpSocket* udpSocket;
-    quint16 port_;   // порт для Discovery (тот же, что у сервера)
-    quint16 lastReceivedTcpPort_;
+    struct CachedHost {
+        HostInfo info;
+        qint64 expiresAtMs;
+    };
+
+    void joinGroup();
+    void rememberHost(const HostInfo& host, int ttlSeconds);
 
+    QUdpSocket* udpSocket;     // слушает объявления группы на порту Discovery
+    QUdpSocket* querySocket;   // шлёт запросы и принимает адресные ответы
+    quint16 port_;   // порт для Discovery (тот же, что у сервера)
 
-    QString getLocalIp();
+    QHash<QString, CachedHost> hosts;
+    QTimer expiryTimer;
+    QElapsedTimer clock;
 };
 
 #endif // NETWORKDISCOVERY_H
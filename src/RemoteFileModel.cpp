@@ -0,0 +1,332 @@
+#include "RemoteFileModel.h"
+#include <QJsonObject>
+#include <QDir>
+#include <algorithm>
+
+namespace {
+
+// Сколько строк представление получает за один fetchMore
+const int fetchBatchSize = 1000;
+// Больше изменений за раз дешевле показать заменой содержимого каталога,
+// чем тысячами отдельных вставок и удалений
+const int maxIncrementalChanges = 256;
+
+QString normalizedPath(const QString& path)
+{
+    return path.isEmpty() ? QString("/") : QDir::cleanPath(path);
+}
+
+} // namespace
+
+bool RemoteFileModel::Entry::operator==(const Entry& other) const
+{
+    return name == other.name && path == other.path && type == other.type && size == other.size
+        && permissions == other.permissions && owner == other.owner && group == other.group
+        && isDir == other.isDir;
+}
+
+RemoteFileModel::RemoteFileModel(QObject* parent)
+    : QAbstractItemModel(parent), root(new Node)
+{
+    root->entry.isDir = true;
+}
+
+RemoteFileModel::~RemoteFileModel()
+{
+    destroyNode(root);
+}
+
+// ========== Загрузка данных ==========
+
+void RemoteFileModel::clear()
+{
+    beginResetModel();
+    for (Node* child : root->children) destroyNode(child);
+    root->children.clear();
+    root->shown = 0;
+    root->state = FetchState::NotFetched;
+    root->entry.path.clear();
+    directories.clear();
+    endResetModel();
+}
+
+void RemoteFileModel::setRootPath(const QString& path)
+{
+    clear();
+    root->entry.path = normalizedPath(path);
+    root->state = FetchState::Fetching;
+    emit fetchRequested(root->entry.path);
+}
+
+QString RemoteFileModel::rootPath() const
+{
+    return root->entry.path;
+}
+
+QStringList RemoteFileModel::loadedDirectories() const
+{
+    QStringList paths;
+    if (root->state == FetchState::Fetched) paths << root->entry.path;
+    for (auto it = directories.constBegin(); it != directories.constEnd(); ++it) {
+        if (it.value()->state == FetchState::Fetched) paths << it.key();
+    }
+    return paths;
+}
+
+RemoteFileModel::Entry RemoteFileModel::parseEntry(const QJsonObject& file)
+{
+    Entry entry;
+    entry.name = file["name"].toString();
+    entry.path = file["path"].toString();
+    entry.type = file["type"].toString();
+    entry.permissions = file["permissions"].toString();
+    entry.owner = file["owner"].toString();
+    entry.group = file["group"].toString();
+    entry.size = static_cast<qint64>(file["size"].toDouble());
+    entry.isDir = entry.type == "Directory";
+    return entry;
+}
+
+// Каталоги сверху, внутри - по имени без учёта регистра
+bool RemoteFileModel::lessThan(const Entry& a, const Entry& b)
+{
+    if (a.isDir != b.isDir) return a.isDir;
+    const int order = a.name.compare(b.name, Qt::CaseInsensitive);
+    return order != 0 ? order < 0 : a.name < b.name;
+}
+
+void RemoteFileModel::setListing(const QString& path, const QJsonArray& files)
+{
+    const QString key = normalizedPath(path);
+    Node* node = key == root->entry.path ? root : directories.value(key);
+    if (!node) return; // каталог уже удалён из дерева или корень сменился
+
+    QVector<Entry> entries;
+    entries.reserve(files.size());
+    for (const QJsonValue& file : files) entries.append(parseEntry(file.toObject()));
+    std::sort(entries.begin(), entries.end(), lessThan);
+
+    if (node->state != FetchState::Fetched || node->children.isEmpty()) {
+        replaceChildren(node, entries);
+    } else {
+        // Сначала считаем изменения: большое обновление дешевле заменой
+        int changes = 0, i = 0, j = 0;
+        const int oldCount = node->children.size();
+        while ((i < oldCount || j < entries.size()) && changes <= maxIncrementalChanges) {
+            if (i < oldCount && (j >= entries.size() || lessThan(node->children[i]->entry, entries[j]))) {
+                ++changes; ++i;
+            } else if (j < entries.size() && (i >= oldCount || lessThan(entries[j], node->children[i]->entry))) {
+                ++changes; ++j;
+            } else {
+                if (node->children[i]->entry != entries[j]) ++changes;
+                ++i; ++j;
+            }
+        }
+        if (changes > maxIncrementalChanges) replaceChildren(node, entries);
+        else if (changes > 0) mergeChildren(node, entries);
+    }
+    node->state = FetchState::Fetched;
+}
+
+void RemoteFileModel::replaceChildren(Node* node, const QVector<Entry>& entries)
+{
+    const QModelIndex parentIndex = indexFor(node);
+
+    // Пока идёт beginRemoveRows, представление ещё может обращаться к старым строкам
+    const bool visible = node->shown > 0;
+    if (visible) beginRemoveRows(parentIndex, 0, node->shown - 1);
+    QVector<Node*> old;
+    old.swap(node->children);
+    node->shown = 0;
+    if (visible) endRemoveRows();
+    for (Node* child : old) destroyNode(child);
+
+    node->children.reserve(entries.size());
+    for (const Entry& entry : entries) createNode(node, entry);
+    renumber(node, 0);
+
+    // Представление получает только первую порцию, остальное - через fetchMore
+    const int first = qMin(fetchBatchSize, node->children.size());
+    if (first > 0) {
+        beginInsertRows(parentIndex, 0, first - 1);
+        node->shown = first;
+        endInsertRows();
+    }
+}
+
+void RemoteFileModel::mergeChildren(Node* node, const QVector<Entry>& entries)
+{
+    const QModelIndex parentIndex = indexFor(node);
+
+    // Оба списка отсортированы одинаково, поэтому хватает одного прохода
+    int i = 0, j = 0;
+    while (i < node->children.size() || j < entries.size()) {
+        QVector<Node*>& children = node->children;
+        if (i < children.size() && (j >= entries.size() || lessThan(children[i]->entry, entries[j]))) {
+            // Исчезла: строки за пределами показанных представление не видело
+            const bool visible = i < node->shown;
+            if (visible) beginRemoveRows(parentIndex, i, i);
+            Node* child = children.takeAt(i);
+            if (visible) --node->shown;
+            renumber(node, i);
+            if (visible) endRemoveRows();
+            destroyNode(child);
+        } else if (j < entries.size() && (i >= children.size() || lessThan(entries[j], children[i]->entry))) {
+            // Появилась: видна, если попадает в показанный диапазон или всё уже показано
+            const bool visible = i < node->shown || node->shown == children.size();
+            if (visible) beginInsertRows(parentIndex, i, i);
+            Node* child = new Node;
+            child->entry = entries[j];
+            child->parent = node;
+            if (child->entry.isDir) directories.insert(normalizedPath(child->entry.path), child);
+            children.insert(i, child);
+            renumber(node, i);
+            if (visible) {
+                ++node->shown;
+                endInsertRows();
+            }
+            ++i; ++j;
+        } else {
+            if (children[i]->entry != entries[j]) {
+                children[i]->entry = entries[j];
+                if (i < node->shown) emit dataChanged(index(i, 0, parentIndex), index(i, ColumnCount - 1, parentIndex));
+            }
+            ++i; ++j;
+        }
+    }
+}
+
+RemoteFileModel::Node* RemoteFileModel::createNode(Node* parent, const Entry& entry)
+{
+    Node* node = new Node;
+    node->entry = entry;
+    node->parent = parent;
+    parent->children.append(node);
+    if (entry.isDir) directories.insert(normalizedPath(entry.path), node);
+    return node;
+}
+
+void RemoteFileModel::destroyNode(Node* node)
+{
+    for (Node* child : node->children) destroyNode(child);
+    if (node != root && node->entry.isDir) {
+        const QString key = normalizedPath(node->entry.path);
+        if (directories.value(key) == node) directories.remove(key);
+    }
+    delete node;
+}
+
+void RemoteFileModel::renumber(Node* node, int from)
+{
+    for (int row = from; row < node->children.size(); ++row) node->children[row]->row = row;
+}
+
+// ========== QAbstractItemModel ==========
+
+RemoteFileModel::Node* RemoteFileModel::nodeFor(const QModelIndex& index) const
+{
+    return index.isValid() ? static_cast<Node*>(index.internalPointer()) : root;
+}
+
+QModelIndex RemoteFileModel::indexFor(Node* node) const
+{
+    return node == root ? QModelIndex() : createIndex(node->row, 0, node);
+}
+
+QModelIndex RemoteFileModel::index(int row, int column, const QModelIndex& parent) const
+{
+    const Node* node = nodeFor(parent);
+    if (row < 0 || row >= node->shown || column < 0 || column >= ColumnCount) return QModelIndex();
+    return createIndex(row, column, node->children[row]);
+}
+
+QModelIndex RemoteFileModel::parent(const QModelIndex& child) const
+{
+    if (!child.isValid()) return QModelIndex();
+    Node* parentNode = nodeFor(child)->parent;
+    return parentNode ? indexFor(parentNode) : QModelIndex();
+}
+
+int RemoteFileModel::rowCount(const QModelIndex& parent) const
+{
+    if (parent.column() > 0) return 0;
+    return nodeFor(parent)->shown;
+}
+
+int RemoteFileModel::columnCount(const QModelIndex&) const
+{
+    return ColumnCount;
+}
+
+bool RemoteFileModel::hasChildren(const QModelIndex& parent) const
+{
+    const Node* node = nodeFor(parent);
+    // Незагруженный каталог показываем раскрываемым, содержимое придёт при раскрытии
+    if (node->entry.isDir && node->state != FetchState::Fetched) return true;
+    return !node->children.isEmpty();
+}
+
+bool RemoteFileModel::canFetchMore(const QModelIndex& parent) const
+{
+    const Node* node = nodeFor(parent);
+    if (!node->entry.isDir || node->entry.path.isEmpty()) return false;
+    if (node->state == FetchState::NotFetched) return true;
+    return node->state == FetchState::Fetched && node->shown < node->children.size();
+}
+
+void RemoteFileModel::fetchMore(const QModelIndex& parent)
+{
+    Node* node = nodeFor(parent);
+    if (node->state == FetchState::NotFetched) {
+        node->state = FetchState::Fetching;
+        emit fetchRequested(normalizedPath(node->entry.path));
+        return;
+    }
+
+    const int count = qMin(fetchBatchSize, node->children.size() - node->shown);
+    if (count <= 0) return;
+    beginInsertRows(parent, node->shown, node->shown + count - 1);
+    node->shown += count;
+    endInsertRows();
+}
+
+QString RemoteFileModel::formatSize(qint64 bytes)
+{
+    const double sizeKB = bytes / 1024.0;
+    return sizeKB > 1024 ? QString("%1 MB").arg(sizeKB / 1024, 0, 'f', 1)
+                         : QString("%1 KB").arg(sizeKB, 0, 'f', 1);
+}
+
+QVariant RemoteFileModel::data(const QModelIndex& index, int role) const
+{
+    if (!index.isValid()) return QVariant();
+    const Entry& entry = nodeFor(index)->entry;
+
+    switch (role) {
+    case Qt::DisplayRole:
+        switch (index.column()) {
+        case NameColumn: return entry.name;
+        case TypeColumn: return entry.type;
+        case SizeColumn: return entry.isDir ? QString() : formatSize(entry.size);
+        case PermissionsColumn: return entry.permissions;
+        case OwnerColumn: return entry.owner;
+        case GroupColumn: return entry.group;
+        }
+        break;
+    case Qt::TextAlignmentRole:
+        if (index.column() == SizeColumn) return static_cast<int>(Qt::AlignRight | Qt::AlignVCenter);
+        break;
+    case PathRole:
+        return entry.path;
+    case IsDirectoryRole:
+        return entry.isDir;
+    }
+    return QVariant();
+}
+
+QVariant RemoteFileModel::headerData(int section, Qt::Orientation orientation, int role) const
+{
+    if (orientation != Qt::Horizontal || role != Qt::DisplayRole) return QVariant();
+    static const QStringList headers = { "Имя", "Тип", "Размер", "Права", "Владелец", "Группа" };
+    return headers.value(section);
+}
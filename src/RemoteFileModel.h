@@ -0,0 +1,91 @@
+#ifndef REMOTEFILEMODEL_H
+#define REMOTEFILEMODEL_H
+
+#include <QAbstractItemModel>
+#include <QJsonArray>
+#include <QHash>
+#include <QVector>
+
+// Дерево файлов удалённого демона для QTreeView.
+//
+// Содержимое каталога запрашивается только при раскрытии (canFetchMore/fetchMore
+// -> сигнал fetchRequested), а большой ответ показывается порциями: представление
+// добирает строки через fetchMore по мере прокрутки. Повторный ответ по уже
+// загруженному каталогу сравнивается со старым и превращается в точечные
+// вставки, удаления и dataChanged, а не в сброс модели.
+class RemoteFileModel : public QAbstractItemModel
+{
+    Q_OBJECT
+public:
+    enum Column { NameColumn, TypeColumn, SizeColumn, PermissionsColumn, OwnerColumn, GroupColumn, ColumnCount };
+    enum Role { PathRole = Qt::UserRole, IsDirectoryRole };
+
+    explicit RemoteFileModel(QObject* parent = nullptr);
+    ~RemoteFileModel() override;
+
+    // Новый корень: модель очищается, и корень сразу запрашивается
+    void setRootPath(const QString& path);
+    QString rootPath() const;
+    void clear();
+
+    // Ответ getFileSystem для каталога path
+    void setListing(const QString& path, const QJsonArray& files);
+    // Каталоги, содержимое которых уже загружено (для обновления)
+    QStringList loadedDirectories() const;
+
+    QModelIndex index(int row, int column, const QModelIndex& parent = QModelIndex()) const override;
+    QModelIndex parent(const QModelIndex& child) const override;
+    int rowCount(const QModelIndex& parent = QModelIndex()) const override;
+    int columnCount(const QModelIndex& parent = QModelIndex()) const override;
+    QVariant data(const QModelIndex& index, int role = Qt::DisplayRole) const override;
+    QVariant headerData(int section, Qt::Orientation orientation, int role = Qt::DisplayRole) const override;
+    bool hasChildren(const QModelIndex& parent = QModelIndex()) const override;
+    bool canFetchMore(const QModelIndex& parent) const override;
+    void fetchMore(const QModelIndex& parent) override;
+
+signals:
+    void fetchRequested(const QString& path);
+
+private:
+    struct Entry {
+        QString name;
+        QString path;
+        QString type;
+        QString permissions;
+        QString owner;
+        QString group;
+        qint64 size = 0;
+        bool isDir = false;
+
+        bool operator==(const Entry& other) const;
+        bool operator!=(const Entry& other) const { return !(*this == other); }
+    };
+
+    enum class FetchState { NotFetched, Fetching, Fetched };
+
+    struct Node {
+        Entry entry;
+        Node* parent = nullptr;
+        int row = 0;
+        QVector<Node*> children;
+        int shown = 0; // сколько детей уже отдано представлению
+        FetchState state = FetchState::NotFetched;
+    };
+
+    static Entry parseEntry(const QJsonObject& file);
+    static bool lessThan(const Entry& a, const Entry& b);
+    static QString formatSize(qint64 bytes);
+
+    Node* nodeFor(const QModelIndex& index) const;
+    QModelIndex indexFor(Node* node) const;
+    Node* createNode(Node* parent, const Entry& entry);
+    void destroyNode(Node* node);
+    void renumber(Node* node, int from);
+    void replaceChildren(Node* node, const QVector<Entry>& entries);
+    void mergeChildren(Node* node, const QVector<Entry>& entries);
+
+    Node* root;
+    QHash<QString, Node*> directories; // путь -> узел каталога, для маршрутизации ответов
+};
+
+#endif // REMOTEFILEMODEL_H
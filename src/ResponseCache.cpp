@@ -0,0 +1,40 @@
+#include "ResponseCache.h"
+#include <QJsonArray>
+#include <QJsonDocument>
+
+ResponseCache::ResponseCache(int maxItems)
+{
+    entries.setMaxCost(maxItems);
+}
+
+// QJsonObject хранит ключи отсортированными, так что одинаковые параметры
+// дают одинаковую строку независимо от порядка заполнения
+QString ResponseCache::key(const QString& host, const QString& method, const QJsonObject& params)
+{
+    return host + '\n' + method + '\n' + QString::fromUtf8(QJsonDocument(params).toJson(QJsonDocument::Compact));
+}
+
+const ResponseCache::Entry* ResponseCache::find(const QString& key) const
+{
+    return entries.object(key);
+}
+
+void ResponseCache::insert(const QString& key, const QJsonValue& value, const QString& etag)
+{
+    auto* entry = new Entry;
+    entry->value = value;
+    entry->etag = etag;
+    const int cost = value.isArray() ? value.toArray().size() : value.isObject() ? value.toObject().size() : 1;
+    // Ответ больше всего кэша QCache не примет и сам удалит
+    entries.insert(key, entry, qMax(1, cost));
+}
+
+void ResponseCache::remove(const QString& key)
+{
+    entries.remove(key);
+}
+
+void ResponseCache::clear()
+{
+    entries.clear();
+}
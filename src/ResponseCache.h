@@ -0,0 +1,35 @@
+#ifndef RESPONSECACHE_H
+#define RESPONSECACHE_H
+
+#include <QCache>
+#include <QJsonObject>
+#include <QJsonValue>
+#include <QString>
+
+// Кэш ответов демона на стороне клиента. Ключ - хост, метод и параметры запроса,
+// поэтому данные разных демонов не смешиваются. Вместе с ответом хранится etag,
+// выданный демоном: по нему запрос перепроверяется, и демон отвечает
+// «не изменилось», не пересылая данные заново.
+class ResponseCache
+{
+public:
+    struct Entry {
+        QJsonValue value;
+        QString etag;
+    };
+
+    // Вес записи - число элементов ответа, предел - сумма весов по всем хостам
+    explicit ResponseCache(int maxItems = 200000);
+
+    static QString key(const QString& host, const QString& method, const QJsonObject& params);
+
+    const Entry* find(const QString& key) const;
+    void insert(const QString& key, const QJsonValue& value, const QString& etag = QString());
+    void remove(const QString& key);
+    void clear();
+
+private:
+    QCache<QString, Entry> entries;
+};
+
+#endif // RESPONSECACHE_H
@@ -0,0 +1,37 @@
+#ifndef RINGBUFFER_H
+#define RINGBUFFER_H
+
+#include <QVector>
+
+// Буфер фиксированной ёмкости: новое значение вытесняет самое старое.
+// Память выделяется один раз, индексы идут от старых к новым.
+template <typename T>
+class RingBuffer
+{
+public:
+    explicit RingBuffer(int capacity = 0) : storage(qMax(1, capacity)), head(0), count(0) {}
+
+    void append(const T& value)
+    {
+        storage[(head + count) % storage.size()] = value;
+        if (count < storage.size()) ++count;
+        else head = (head + 1) % storage.size();
+    }
+
+    void clear() { head = 0; count = 0; }
+
+    int size() const { return count; }
+    int capacity() const { return storage.size(); }
+    bool isEmpty() const { return count == 0; }
+
+    // 0 - самое старое значение, size() - 1 - самое новое
+    const T& at(int index) const { return storage[(head + index) % storage.size()]; }
+    const T& last() const { return at(count - 1); }
+
+private:
+    QVector<T> storage;
+    int head;
+    int count;
+};
+
+#endif // RINGBUFFER_H
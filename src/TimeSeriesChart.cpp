@@ -0,0 +1,248 @@
+#include "TimeSeriesChart.h"
+#include <QPainter>
+#include <QPaintEvent>
+#include <QtMath>
+#include <cmath>
+
+namespace {
+
+// Шесть часов истории при опросе раз в секунду
+const int historyCapacity = 6 * 3600;
+const qint64 defaultWindowMs = 10 * 60 * 1000;
+// Пропуск длиннее этого (потеря связи) рвёт линию, а не соединяет через пустоту
+const qint64 maxGapMs = 5000;
+
+const int marginLeft = 64;
+const int marginRight = 12;
+const int marginTop = 24;
+const int marginBottom = 20;
+
+// Агрегат одного столбца пикселей
+struct Column {
+    double first = 0.0;
+    double min = 0.0;
+    double max = 0.0;
+    double last = 0.0;
+    bool used = false;
+    bool breakBefore = false;
+};
+
+// Верх шкалы для скоростей: 1, 2 или 5 на степень десяти
+double niceCeiling(double value)
+{
+    if (value <= 1024.0) return 1024.0;
+    const double magnitude = qPow(10.0, qFloor(std::log10(value)));
+    for (double step : { 1.0, 2.0, 5.0, 10.0 }) {
+        if (step * magnitude >= value) return step * magnitude;
+    }
+    return 10.0 * magnitude;
+}
+
+QString formatWindow(qint64 ms)
+{
+    const qint64 minutes = ms / 60000;
+    if (minutes >= 60) return QString("-%1 ч").arg(minutes / 60);
+    if (minutes > 0) return QString("-%1 мин").arg(minutes);
+    return QString("-%1 с").arg(ms / 1000);
+}
+
+} // namespace
+
+TimeSeriesChart::TimeSeriesChart(const QString& title, Unit unit, QWidget* parent)
+    : QWidget(parent), title(title), unit(unit), windowMs(defaultWindowMs)
+{
+    // Фон рисуется целиком в paintEvent
+    setAttribute(Qt::WA_OpaquePaintEvent);
+}
+
+int TimeSeriesChart::addSeries(const QString& name, const QColor& color)
+{
+    series.append({ name, color, RingBuffer<Sample>(historyCapacity) });
+    return series.size() - 1;
+}
+
+void TimeSeriesChart::append(int index, qint64 timestampMs, double value)
+{
+    if (index < 0 || index >= series.size()) return;
+    RingBuffer<Sample>& samples = series[index].samples;
+    // Отметки должны возрастать: на этом держится двоичный поиск начала окна
+    if (!samples.isEmpty() && timestampMs < samples.last().timestampMs) return;
+    samples.append({ timestampMs, value });
+    update(); // Qt склеит несколько обновлений в одну перерисовку
+}
+
+void TimeSeriesChart::clear()
+{
+    for (Series& s : series) s.samples.clear();
+    update();
+}
+
+bool TimeSeriesChart::isEmpty() const
+{
+    for (const Series& s : series) {
+        if (!s.samples.isEmpty()) return false;
+    }
+    return true;
+}
+
+void TimeSeriesChart::setTimeWindow(qint64 window)
+{
+    windowMs = qMax<qint64>(1000, window);
+    update();
+}
+
+QSize TimeSeriesChart::sizeHint() const
+{
+    return QSize(480, 160);
+}
+
+QSize TimeSeriesChart::minimumSizeHint() const
+{
+    return QSize(200, 90);
+}
+
+int TimeSeriesChart::lowerBound(const RingBuffer<Sample>& samples, qint64 from)
+{
+    int low = 0, high = samples.size();
+    while (low < high) {
+        const int mid = (low + high) / 2;
+        if (samples.at(mid).timestampMs < from) low = mid + 1;
+        else high = mid;
+    }
+    return low;
+}
+
+// Один проход по видимым точкам: каждая попадает в свой столбец, дальше
+// рисуются только агрегаты столбцов. Стоимость отрисовки не зависит от того,
+// сколько точек в окне - минута или шесть часов.
+QVector<QPointF> TimeSeriesChart::decimate(const Series& s, const QRectF& plot, qint64 from, double top) const
+{
+    const int width = qMax(1, qFloor(plot.width()));
+    QVector<Column> columns(width);
+
+    const RingBuffer<Sample>& samples = s.samples;
+    qint64 previous = -1;
+    for (int i = qMax(0, lowerBound(samples, from) - 1); i < samples.size(); ++i) {
+        const Sample& sample = samples.at(i);
+        const int x = qBound(0, int((sample.timestampMs - from) * width / windowMs), width - 1);
+        Column& column = columns[x];
+        if (!column.used) {
+            column.first = column.min = column.max = sample.value;
+            column.used = true;
+            column.breakBefore = previous >= 0 && sample.timestampMs - previous > maxGapMs;
+        } else {
+            column.min = qMin(column.min, sample.value);
+            column.max = qMax(column.max, sample.value);
+        }
+        column.last = sample.value;
+        previous = sample.timestampMs;
+    }
+
+    // Разрыв линии кодируется точкой NaN, её пропускает отрисовка
+    QVector<QPointF> points;
+    points.reserve(width * 4);
+    auto y = [&](double value) { return plot.bottom() - qBound(0.0, value / top, 1.0) * plot.height(); };
+    for (int x = 0; x < width; ++x) {
+        const Column& column = columns[x];
+        if (!column.used) continue;
+        if (column.breakBefore) points.append(QPointF(qQNaN(), qQNaN()));
+        const double px = plot.left() + x + 0.5;
+        points.append(QPointF(px, y(column.first)));
+        if (column.min != column.max) {
+            points.append(QPointF(px, y(column.min)));
+            points.append(QPointF(px, y(column.max)));
+        }
+        points.append(QPointF(px, y(column.last)));
+    }
+    return points;
+}
+
+QString TimeSeriesChart::formatValue(double value) const
+{
+    if (unit == Unit::Percent) return QString("%1%").arg(value, 0, 'f', 1);
+    static const char* units[] = { "B/s", "KB/s", "MB/s", "GB/s" };
+    int i = 0;
+    while (value >= 1024.0 && i < 3) {
+        value /= 1024.0;
+        ++i;
+    }
+    return QString("%1 %2").arg(value, 0, 'f', i == 0 ? 0 : 1).arg(units[i]);
+}
+
+void TimeSeriesChart::paintEvent(QPaintEvent*)
+{
+    QPainter painter(this);
+    painter.fillRect(rect(), palette().base());
+    const QColor textColor = palette().text().color();
+    QColor gridColor = textColor;
+    gridColor.setAlpha(40);
+
+    const QRectF plot = QRectF(rect()).adjusted(marginLeft, marginTop, -marginRight, -marginBottom);
+    painter.setPen(textColor);
+    painter.drawText(QRectF(8, 4, width() - 16, marginTop - 4), Qt::AlignLeft | Qt::AlignVCenter, title);
+    if (plot.width() < 2 || plot.height() < 2) return;
+
+    // Правый край - последняя пришедшая точка, чтобы при потере связи график
+    // не уезжал влево сам по себе
+    qint64 now = -1;
+    for (const Series& s : series) {
+        if (!s.samples.isEmpty()) now = qMax(now, s.samples.last().timestampMs);
+    }
+    if (now < 0) {
+        painter.drawText(plot, Qt::AlignCenter, "Нет данных");
+        return;
+    }
+    const qint64 from = now - windowMs;
+
+    double top = 100.0;
+    if (unit == Unit::BytesPerSecond) {
+        double peak = 0.0;
+        for (const Series& s : series) {
+            for (int i = lowerBound(s.samples, from); i < s.samples.size(); ++i) {
+                peak = qMax(peak, s.samples.at(i).value);
+            }
+        }
+        top = niceCeiling(peak);
+    }
+
+    // Сетка и подписи осей
+    painter.setPen(gridColor);
+    for (int i = 0; i <= 4; ++i) {
+        const double y = plot.top() + plot.height() * i / 4;
+        painter.drawLine(QPointF(plot.left(), y), QPointF(plot.right(), y));
+    }
+    painter.setPen(textColor);
+    const QRectF axisLabel(0, 0, marginLeft - 6, 16);
+    painter.drawText(axisLabel.translated(0, plot.top() - 8), Qt::AlignRight | Qt::AlignVCenter, formatValue(top));
+    painter.drawText(axisLabel.translated(0, plot.bottom() - 8), Qt::AlignRight | Qt::AlignVCenter, formatValue(0));
+    painter.drawText(QRectF(plot.left(), plot.bottom() + 2, 80, marginBottom - 2),
+                     Qt::AlignLeft | Qt::AlignVCenter, formatWindow(windowMs));
+    painter.drawText(QRectF(plot.right() - 80, plot.bottom() + 2, 80, marginBottom - 2),
+                     Qt::AlignRight | Qt::AlignVCenter, "сейчас");
+
+    // Ряды и легенда с текущими значениями
+    painter.setClipRect(plot.adjusted(0, -1, 0, 1));
+    for (const Series& s : series) {
+        const QVector<QPointF> points = decimate(s, plot, from, top);
+        painter.setPen(QPen(s.color, 1.5));
+        int start = 0;
+        for (int i = 0; i <= points.size(); ++i) {
+            if (i < points.size() && !qIsNaN(points[i].x())) continue;
+            if (i - start > 1) painter.drawPolyline(points.constData() + start, i - start);
+            start = i + 1;
+        }
+    }
+    painter.setClipping(false);
+
+    qreal legendRight = width() - 8;
+    for (int i = series.size() - 1; i >= 0; --i) {
+        const Series& s = series[i];
+        if (s.samples.isEmpty()) continue;
+        const QString text = QString("%1: %2").arg(s.name, formatValue(s.samples.last().value));
+        const qreal textWidth = painter.fontMetrics().horizontalAdvance(text);
+        const QRectF textRect(legendRight - textWidth, 4, textWidth, marginTop - 4);
+        painter.setPen(s.color);
+        painter.drawText(textRect, Qt::AlignRight | Qt::AlignVCenter, text);
+        legendRight -= textWidth + 16;
+    }
+}
@@ -0,0 +1,63 @@
+#ifndef TIMESERIESCHART_H
+#define TIMESERIESCHART_H
+
+#include <QWidget>
+#include <QColor>
+#include <QVector>
+#include "RingBuffer.h"
+
+// График нескольких временных рядов за скользящее окно.
+//
+// Каждый ряд хранится в RingBuffer фиксированной ёмкости, поэтому часы истории
+// с шагом в секунду занимают постоянную память. При отрисовке точки окна
+// раскладываются по столбцам пикселей, и от каждого столбца рисуются только
+// первое, минимальное, максимальное и последнее значения: число отрезков
+// ограничено шириной виджета, а пики не пропадают при любом масштабе.
+class TimeSeriesChart : public QWidget
+{
+    Q_OBJECT
+public:
+    enum class Unit { Percent, BytesPerSecond };
+
+    explicit TimeSeriesChart(const QString& title, Unit unit, QWidget* parent = nullptr);
+
+    // Возвращает номер ряда для append
+    int addSeries(const QString& name, const QColor& color);
+    void append(int series, qint64 timestampMs, double value);
+    void clear();
+    bool isEmpty() const;
+
+    // Ширина видимого окна; история хранится на всю ёмкость буферов
+    void setTimeWindow(qint64 windowMs);
+    qint64 timeWindow() const { return windowMs; }
+
+    QSize sizeHint() const override;
+    QSize minimumSizeHint() const override;
+
+protected:
+    void paintEvent(QPaintEvent* event) override;
+
+private:
+    struct Sample {
+        qint64 timestampMs = 0;
+        double value = 0.0;
+    };
+
+    struct Series {
+        QString name;
+        QColor color;
+        RingBuffer<Sample> samples;
+    };
+
+    // Первый индекс с отметкой не раньше from; отметки в буфере возрастают
+    static int lowerBound(const RingBuffer<Sample>& samples, qint64 from);
+    QVector<QPointF> decimate(const Series& series, const QRectF& plot, qint64 from, double top) const;
+    QString formatValue(double value) const;
+
+    QString title;
+    Unit unit;
+    QVector<Series> series;
+    qint64 windowMs;
+};
+
+#endif // TIMESERIESCHART_H
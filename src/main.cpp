@@ -4,6 +4,9 @@
 
 int main(int argc, char *argv[]) {
     QApplication app(argc, argv);
+    // Имена нужны QSettings: настройки клиента (TLS и прочее) лежат в life.conf
+    app.setOrganizationName("YourCompany");
+    app.setApplicationName("life");
     MainWindow w;
     w.show();
     return app.exec();
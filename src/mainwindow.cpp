@@ -22,12 +22,63 @@
 #include <QPalette>
 #include <QSpacerItem>
 #include <QFileInfo>
+#include <QGridLayout>
+#include <QDateTime>
+#include <QSet>
+#include <QSettings>
+
+namespace {
+
+// Период опроса getSystemInfo для графиков вкладки «Система»
+const int systemPollIntervalMs = 1000;
+
+const quint16 defaultServerPort = 45454;
+
+// Порт демона и обнаружения; тот же ключ server/port, что и в настройках демона
+quint16 serverPort()
+{
+    return static_cast<quint16>(QSettings().value("server/port", defaultServerPort).toUInt());
+}
+
+// Номера рядов в порядке addSeries в createSystemTab
+const int readSeries = 0;
+const int writeSeries = 1;
+const int rxSeries = 0;
+const int txSeries = 1;
+
+QString hostLabel(const HostInfo& host)
+{
+    QString label = QString("%1:%2").arg(host.address).arg(host.port);
+    if (!host.hostname.isEmpty()) {
+        label = QString("%1 (%2) — v%3, загрузка %4")
+            .arg(host.hostname, label, host.version)
+            .arg(host.load, 0, 'f', 2);
+    }
+    if (host.tls) label += ", TLS";
+    return label;
+}
+
+int indexOfHost(const QList<HostInfo>& hosts, const HostInfo& host)
+{
+    for (int i = 0; i < hosts.size(); ++i) {
+        if (hosts[i].address == host.address && hosts[i].port == host.port) return i;
+    }
+    return -1;
+}
+
+} // namespace
 
 MainWindow::MainWindow(QWidget *parent)
     : QMainWindow(parent),
+      lastCpuTotal(0),
+      lastCpuIdle(0),
       discovery(nullptr),
       clientMgr(nullptr),
-      statusLabel(nullptr)
+      fleet(nullptr),
+      statusLabel(nullptr),
+      activeFleetQuery(-1),
+      activeFleetKind(0),
+      activeFleetThreshold(90.0)
 {
     initUI();
     initConnections();
@@ -68,6 +119,7 @@ void MainWindow::initUI()
     createFilesTab();
     createSystemTab();
     createServicesTab();
+    createFleetTab();
 
     // Создание тулбара
     QToolBar *toolBar = new QToolBar("Main Toolbar", this);
@@ -103,8 +155,14 @@ void MainWindow::initUI()
     QApplication::setFont(appFont);
 
     // Инициализация управляющих объектов
-    discovery = new NetworkDiscovery(45454, this);
+    discovery = new NetworkDiscovery(serverPort(), this);
     clientMgr = new ClientManager(this);
+    fleet = new FleetManager(this);
+
+    // Пока есть подключение, системная информация опрашивается для графиков
+    systemPollTimer = new QTimer(this);
+    systemPollTimer->setInterval(systemPollIntervalMs);
+    connect(systemPollTimer, &QTimer::timeout, this, [this]() { clientMgr->requestSystemInfo(); });
 
     // Подключение действий тулбара
     connect(testAction, &QAction::triggered, this, &MainWindow::onTestConnectionClicked);
@@ -113,7 +171,9 @@ void MainWindow::initUI()
     connect(refreshAction, &QAction::triggered, this, [this]() {
         if (clientMgr && clientMgr->isConnected()) {
             clientMgr->requestSystemInfo();
-            clientMgr->requestFileSystem(currentPathLabel->text());
+            // Перезапрашиваем всё раскрытое целиком, мимо кэша: etag каталога не
+            // замечает изменения размера и прав файлов. Модель применит только разницу
+            for (const QString& path : fileModel->loadedDirectories()) clientMgr->reloadFileSystem(path);
         }
     });
 }
@@ -124,7 +184,7 @@ void MainWindow::onTestConnectionClicked()
     if (!testHost.isEmpty()) {
         qDebug() << "Testing connection to" << testHost;
         QTcpSocket testSocket;
-        testSocket.connectToHost(testHost, 45454);
+        testSocket.connectToHost(testHost, serverPort());
 
         if (testSocket.waitForConnected(2000)) {
             QMessageBox::information(this, "Успех", "Соединение установлено!");
@@ -137,10 +197,10 @@ void MainWindow::onTestConnectionClicked()
 
 void MainWindow::onServiceListReceived(const QJsonArray& services)
 {
-    serviceList->clear();
-    for (const QJsonValue& service : services) {
-        serviceList->addItem(service.toString());
-    }
+    QStringList names;
+    names.reserve(services.size());
+    for (const QJsonValue& service : services) names << service.toString();
+    serviceModel->setItems(names);
 }
 
 void MainWindow::initConnections()
@@ -148,8 +208,23 @@ void MainWindow::initConnections()
     connect(discoverButton, &QPushButton::clicked, this, &MainWindow::onDiscoverClicked);
     connect(connectButton, &QPushButton::clicked, this, &MainWindow::onConnectClicked);
     connect(discovery, &NetworkDiscovery::hostDiscovered, this, &MainWindow::onHostDiscovered);
+    connect(discovery, &NetworkDiscovery::hostUpdated, this, &MainWindow::onHostUpdated);
+    connect(discovery, &NetworkDiscovery::hostExpired, this, &MainWindow::onHostExpired);
     connect(clientMgr, &ClientManager::connected, this, &MainWindow::onConnected);
     connect(clientMgr, &ClientManager::connectionError, this, &MainWindow::onConnectionError);
+    connect(clientMgr, &ClientManager::permissionDenied, this, [this](const QString& method, const QString& message) {
+        statusLabel->setText(QString("Недостаточно прав (%1): %2").arg(method, message));
+    });
+    connect(clientMgr, &ClientManager::disconnected, systemPollTimer, &QTimer::stop);
+    connect(clientMgr, &ClientManager::fileOperationProgress, this, [this](int, const QJsonObject& state) {
+        statusLabel->setText(QString("Установка прав: обработано %1, ошибок %2")
+                                 .arg(state["processed"].toInt()).arg(state["failed"].toInt()));
+    });
+    connect(clientMgr, &ClientManager::fileOperationFinished, this, &MainWindow::onFileOperationFinished);
+    connect(chartWindowCombo, QOverload<int>::of(&QComboBox::currentIndexChanged), this, [this](int index) {
+        const qint64 window = chartWindowCombo->itemData(index).toLongLong();
+        for (TimeSeriesChart* chart : { cpuChart, memoryChart, diskChart, networkChart }) chart->setTimeWindow(window);
+    });
     connect(clientMgr, &ClientManager::userListReceived, this, &MainWindow::onUserListReceived);
     connect(clientMgr, &ClientManager::systemInfoReceived, this, &MainWindow::onSystemInfoReceived);
     connect(clientMgr, &ClientManager::fileSystemReceived, this, &MainWindow::onFileSystemReceived);
@@ -166,10 +241,32 @@ void MainWindow::initConnections()
     connect(uploadButton, &QPushButton::clicked, this, &MainWindow::onUploadFile);
     connect(downloadButton, &QPushButton::clicked, this, &MainWindow::onDownloadFile);
     connect(setPermissionsButton, &QPushButton::clicked, this, &MainWindow::onSetPermissions);
+    connect(fileModel, &RemoteFileModel::fetchRequested, clientMgr, &ClientManager::requestFileSystem);
+    connect(fileSystemTree, &QTreeView::doubleClicked, this, &MainWindow::onFileActivated);
+    connect(fileSystemTree->selectionModel(), &QItemSelectionModel::currentChanged,
+            this, &MainWindow::onFileCurrentChanged);
+    connect(parentDirButton, &QPushButton::clicked, this, [this]() {
+        const QString root = fileModel->rootPath();
+        if (!clientMgr->isConnected() || root.isEmpty() || root == "/") return;
+        fileModel->setRootPath(QFileInfo(root).path());
+        currentPathLabel->setText(fileModel->rootPath());
+    });
     connect(addUserButton, &QPushButton::clicked, this, &MainWindow::onManageUser);
     connect(removeUserButton, &QPushButton::clicked, this, &MainWindow::onManageUser);
     connect(changePasswordButton, &QPushButton::clicked, this, &MainWindow::onManageUser);
     connect(serviceControlButton, &QPushButton::clicked, this, &MainWindow::onManageService);
+    connect(fleetRunButton, &QPushButton::clicked, this, &MainWindow::onFleetRunClicked);
+    connect(fleet, &FleetManager::hostResult, this, &MainWindow::onFleetHostResult);
+    connect(fleet, &FleetManager::queryProgress, this, [this](int queryId, int done, int total) {
+        if (queryId == activeFleetQuery) {
+            fleetProgressLabel->setText(QString("Ответили %1 из %2").arg(done).arg(total));
+        }
+    });
+    connect(fleetQueryCombo, QOverload<int>::of(&QComboBox::currentIndexChanged), this, [this](int index) {
+        fleetArgumentEdit->setPlaceholderText(index == 0 ? "Имя службы, например nginx" : "Порог, %");
+        fleetArgumentEdit->setText(index == 1 ? "90" : QString());
+        fleetArgumentEdit->setEnabled(index != 2);
+    });
 
 }
 
@@ -246,17 +343,17 @@ void MainWindow::setDarkTheme()
         QPushButton:pressed {
             background-color: #2a82da;
         }
-        QListWidget, QTreeWidget {
+        QListView, QTreeView {
             background: #252525;
             border: 1px solid #444;
             border-radius: 6px;
             alternate-background-color: #2d2d2d;
         }
-        QListWidget::item, QTreeWidget::item {
+        QListView::item, QTreeView::item {
             padding: 8px;
             border-radius: 4px;
         }
-        QListWidget::item:selected, QTreeWidget::item:selected {
+        QListView::item:selected, QTreeView::item:selected {
             background: #2a82da;
         }
         QHeaderView::section {
@@ -321,10 +418,14 @@ void MainWindow::createUsersTab()
     titleLabel->setStyleSheet("font-size: 14pt; font-weight: bold; color: #2a82da;");
     layout->addWidget(titleLabel);
 
-    userListWidget = new QListWidget(usersTab);
-    userListWidget->setMinimumHeight(300);
-    userListWidget->setAlternatingRowColors(true);
-    layout->addWidget(userListWidget, 1);
+    userModel = new DiffListModel(this);
+    userListView = new QListView(usersTab);
+    userListView->setModel(userModel);
+    userListView->setUniformItemSizes(true);
+    userListView->setEditTriggers(QAbstractItemView::NoEditTriggers);
+    userListView->setMinimumHeight(300);
+    userListView->setAlternatingRowColors(true);
+    layout->addWidget(userListView, 1);
 
     QHBoxLayout *buttonLayout = new QHBoxLayout();
     addUserButton = new QPushButton("Добавить пользователя", usersTab);
@@ -356,16 +457,24 @@ void MainWindow::createFilesTab()
     currentPathLabel = new QLabel("/", filesTab);
     currentPathLabel->setStyleSheet("font-weight: bold; color: #2a82da;");
 
+    parentDirButton = new QPushButton("Вверх", filesTab);
+
     pathLayout->addWidget(pathLabel);
     pathLayout->addWidget(currentPathLabel, 1);
     pathLayout->addStretch();
+    pathLayout->addWidget(parentDirButton);
     layout->addLayout(pathLayout);
 
-    fileSystemTree = new QTreeWidget(filesTab);
+    // Модель подгружает каталоги при раскрытии и отдаёт строки порциями,
+    // одинаковая высота строк избавляет представление от замера каждой строки
+    fileModel = new RemoteFileModel(this);
+    fileSystemTree = new QTreeView(filesTab);
+    fileSystemTree->setModel(fileModel);
+    fileSystemTree->setUniformRowHeights(true);
     fileSystemTree->setMinimumHeight(300);
-    fileSystemTree->setHeaderLabels({"Имя", "Тип", "Размер", "Права", "Владелец", "Группа"});
     fileSystemTree->setColumnWidth(0, 250);
     fileSystemTree->setAlternatingRowColors(true);
+    fileSystemTree->setExpandsOnDoubleClick(false);
     layout->addWidget(fileSystemTree, 1);
 
     QGridLayout *fileGridLayout = new QGridLayout();
@@ -427,6 +536,47 @@ void MainWindow::createSystemTab()
     ramUsageLabel = new QLabel("Неизвестно", ramGroup);
     ramLayout->addRow("Использование:", ramUsageLabel);
 
+    QWidget *infoRow = new QWidget(systemTab);
+    QHBoxLayout *infoLayout = new QHBoxLayout(infoRow);
+    infoLayout->setContentsMargins(0, 0, 0, 0);
+    infoLayout->addWidget(osGroup, 2);
+    infoLayout->addWidget(cpuGroup, 2);
+    infoLayout->addWidget(ramGroup, 1);
+
+    // Графики: история опросов, окно выбирается без потери накопленных данных
+    QWidget *chartsPanel = new QWidget(systemTab);
+    QGridLayout *chartsLayout = new QGridLayout(chartsPanel);
+    chartsLayout->setContentsMargins(0, 0, 0, 0);
+    chartsLayout->setSpacing(10);
+
+    QHBoxLayout *periodLayout = new QHBoxLayout();
+    chartWindowCombo = new QComboBox(chartsPanel);
+    chartWindowCombo->addItem("1 минута", 60 * 1000);
+    chartWindowCombo->addItem("10 минут", 10 * 60 * 1000);
+    chartWindowCombo->addItem("1 час", 60 * 60 * 1000);
+    chartWindowCombo->addItem("6 часов", 6 * 60 * 60 * 1000);
+    chartWindowCombo->setCurrentIndex(1); // совпадает с окном графика по умолчанию
+    periodLayout->addWidget(new QLabel("Период:", chartsPanel));
+    periodLayout->addWidget(chartWindowCombo);
+    periodLayout->addStretch();
+
+    cpuChart = new TimeSeriesChart("Процессор", TimeSeriesChart::Unit::Percent, chartsPanel);
+    cpuChart->addSeries("CPU", QColor("#4fc3f7"));
+    memoryChart = new TimeSeriesChart("Память", TimeSeriesChart::Unit::Percent, chartsPanel);
+    memoryChart->addSeries("RAM", QColor("#81c784"));
+    diskChart = new TimeSeriesChart("Диски: ввод-вывод", TimeSeriesChart::Unit::BytesPerSecond, chartsPanel);
+    diskChart->addSeries("Чтение", QColor("#ffb74d"));
+    diskChart->addSeries("Запись", QColor("#e57373"));
+    networkChart = new TimeSeriesChart("Сеть", TimeSeriesChart::Unit::BytesPerSecond, chartsPanel);
+    networkChart->addSeries("Приём", QColor("#ba68c8"));
+    networkChart->addSeries("Передача", QColor("#4db6ac"));
+
+    chartsLayout->addLayout(periodLayout, 0, 0, 1, 2);
+    chartsLayout->addWidget(cpuChart, 1, 0);
+    chartsLayout->addWidget(memoryChart, 1, 1);
+    chartsLayout->addWidget(diskChart, 2, 0);
+    chartsLayout->addWidget(networkChart, 2, 1);
+
     // Диски
     QGroupBox *diskGroup = new QGroupBox("Диски", systemTab);
     QVBoxLayout *diskLayout = new QVBoxLayout(diskGroup);
@@ -437,11 +587,10 @@ void MainWindow::createSystemTab()
 
     // Компоновка вкладки
     QSplitter *splitter = new QSplitter(Qt::Vertical, systemTab);
-    splitter->addWidget(osGroup);
-    splitter->addWidget(cpuGroup);
-    splitter->addWidget(ramGroup);
+    splitter->addWidget(infoRow);
+    splitter->addWidget(chartsPanel);
     splitter->addWidget(diskGroup);
-    splitter->setSizes({200, 150, 100, 200});
+    splitter->setSizes({150, 400, 150});
     layout->addWidget(splitter, 1);
 
     tabWidget->addTab(systemTab, "Система");
@@ -458,7 +607,11 @@ void MainWindow::createServicesTab()
     titleLabel->setStyleSheet("font-size: 14pt; font-weight: bold; color: #2a82da;");
     layout->addWidget(titleLabel);
 
-    serviceList = new QListWidget(servicesTab);
+    serviceModel = new DiffListModel(this);
+    serviceList = new QListView(servicesTab);
+    serviceList->setModel(serviceModel);
+    serviceList->setUniformItemSizes(true);
+    serviceList->setEditTriggers(QAbstractItemView::NoEditTriggers);
     serviceList->setMinimumHeight(300);
     serviceList->setAlternatingRowColors(true);
     layout->addWidget(serviceList, 1);
@@ -469,6 +622,44 @@ void MainWindow::createServicesTab()
     tabWidget->addTab(servicesTab, "Службы");
 }
 
+void MainWindow::createFleetTab()
+{
+    fleetTab = new QWidget(this);
+    QVBoxLayout *layout = new QVBoxLayout(fleetTab);
+    layout->setContentsMargins(15, 15, 15, 15);
+    layout->setSpacing(15);
+
+    QLabel *titleLabel = new QLabel("Парк серверов", fleetTab);
+    titleLabel->setStyleSheet("font-size: 14pt; font-weight: bold; color: #2a82da;");
+    layout->addWidget(titleLabel);
+
+    QHBoxLayout *queryLayout = new QHBoxLayout();
+    fleetQueryCombo = new QComboBox(fleetTab);
+    fleetQueryCombo->addItems({"Статус службы", "Диски заполнены выше порога", "Загрузка CPU"});
+    fleetArgumentEdit = new QLineEdit(fleetTab);
+    fleetArgumentEdit->setPlaceholderText("Имя службы, например nginx");
+    fleetRunButton = new QPushButton("Выполнить на всех", fleetTab);
+    queryLayout->addWidget(fleetQueryCombo);
+    queryLayout->addWidget(fleetArgumentEdit, 1);
+    queryLayout->addWidget(fleetRunButton);
+    layout->addLayout(queryLayout);
+
+    fleetTable = new QTableWidget(0, 3, fleetTab);
+    fleetTable->setHorizontalHeaderLabels({"Хост", "Статус", "Результат"});
+    fleetTable->horizontalHeader()->setStretchLastSection(true);
+    fleetTable->setColumnWidth(0, 200);
+    fleetTable->setEditTriggers(QAbstractItemView::NoEditTriggers);
+    fleetTable->setSelectionBehavior(QAbstractItemView::SelectRows);
+    fleetTable->setAlternatingRowColors(true);
+    layout->addWidget(fleetTable, 1);
+
+    fleetProgressLabel = new QLabel("Хосты берутся из списка обнаруженных серверов", fleetTab);
+    fleetProgressLabel->setStyleSheet("color: #aaa;");
+    layout->addWidget(fleetProgressLabel);
+
+    tabWidget->addTab(fleetTab, "Парк серверов");
+}
+
 // Реализация слотов
 void MainWindow::onDiscoverClicked() {
     hostsList->clear();
@@ -477,18 +668,45 @@ void MainWindow::onDiscoverClicked() {
     // Тестовый хост для ручной проверки
     HostInfo testHost;
     testHost.address = "127.0.0.1"; // или реальный IP сервера
-    testHost.port = 45454;
+    testHost.port = serverPort();
     discoveredHosts.append(testHost);
     hostsList->addItem(QString("%1:%2").arg(testHost.address).arg(testHost.port));
 
-    // Стандартное обнаружение
+    // Уже известные по объявлениям хосты показываем сразу, затем опрашиваем сеть
+    for (const HostInfo& host : discovery->knownHosts()) {
+        onHostDiscovered(host);
+    }
     discovery->startListening();
 }
 
 void MainWindow::onHostDiscovered(const HostInfo& host)
 {
+    if (indexOfHost(discoveredHosts, host) >= 0) {
+        onHostUpdated(host);
+        return;
+    }
     discoveredHosts.append(host);
-    hostsList->addItem(QString("%1:%2").arg(host.address).arg(host.port));
+    hostsList->addItem(hostLabel(host));
+    statusLabel->setText(QString("Найдено серверов: %1").arg(discoveredHosts.size()));
+}
+
+void MainWindow::onHostUpdated(const HostInfo& host)
+{
+    int idx = indexOfHost(discoveredHosts, host);
+    if (idx < 0) {
+        onHostDiscovered(host);
+        return;
+    }
+    discoveredHosts[idx] = host;
+    hostsList->item(idx)->setText(hostLabel(host));
+}
+
+void MainWindow::onHostExpired(const HostInfo& host)
+{
+    int idx = indexOfHost(discoveredHosts, host);
+    if (idx < 0) return;
+    discoveredHosts.removeAt(idx);
+    delete hostsList->takeItem(idx);
     statusLabel->setText(QString("Найдено серверов: %1").arg(discoveredHosts.size()));
 }
 
@@ -500,18 +718,24 @@ void MainWindow::onConnectClicked()
         return;
     }
     HostInfo h = discoveredHosts.at(idx);
-    clientMgr->connectToServer(h.address, h.port);
+    clientMgr->connectToServer(h.address, h.port, h.tls);
     statusLabel->setText(QString("Подключение к %1:%2...").arg(h.address).arg(h.port));
 }
 
 void MainWindow::onConnected()
 {
-    userListWidget->clear();
+    userModel->setItems(QStringList());
     clientMgr->requestUserList();
     clientMgr->requestSystemInfo();
     clientMgr->requestServiceList();
-    clientMgr->requestFileSystem("/");
-    statusLabel->setText("Подключено. Загрузка данных...");
+    fileModel->setRootPath("/");
+    currentPathLabel->setText("/");
+
+    // История графиков относится к одному демону
+    lastCpuTotal = lastCpuIdle = 0;
+    for (TimeSeriesChart* chart : { cpuChart, memoryChart, diskChart, networkChart }) chart->clear();
+    systemPollTimer->start();
+    statusLabel->setText(QString("Подключено, роль %1. Загрузка данных...").arg(clientMgr->role()));
     tabWidget->setCurrentIndex(1); // Переключение на вкладку пользователей
 }
 
@@ -523,85 +747,117 @@ void MainWindow::onConnectionError(const QString& errorString)
 
 void MainWindow::onUserListReceived(const QStringList& users)
 {
-    userListWidget->clear();
-    userListWidget->addItems(users);
+    userModel->setItems(users);
 }
 
 void MainWindow::onSystemInfoReceived(const QJsonObject& info)
 {
+    // Сообщаем только о первом ответе: дальше это фоновый опрос раз в секунду
+    if (memoryChart->isEmpty()) statusLabel->setText("Системная информация обновлена");
     updateSystemInfo(info);
-    statusLabel->setText("Системная информация обновлена");
 }
 
 void MainWindow::updateSystemInfo(const QJsonObject& info)
 {
+    const qint64 now = QDateTime::currentMSecsSinceEpoch();
+
     // Общая информация
     osNameLabel->setText(info["os_name"].toString());
     kernelLabel->setText(info["kernel_version"].toString());
     uptimeLabel->setText(info["uptime"].toString());
 
     // CPU
-    cpuModelLabel->setText(info["cpu_model"].toString());
-    cpuCoresLabel->setText(QString::number(info["cpu_cores"].toInt()));
-
-    QJsonObject cpuLoad = info["cpu_load"].toObject();
-    cpuUsageLabel->setText(
-        QString("%1% / %2°C")
-        .arg(cpuLoad["usage"].toDouble(), 0, 'f', 1)
-        .arg(cpuLoad["temperature"].toDouble(), 0, 'f', 1)
-    );
-
-    // RAM
-    QJsonObject memInfo = info["memory"].toObject();
-    double totalMB = memInfo["total"].toDouble() / (1024 * 1024);
-    double usedMB = memInfo["used"].toDouble() / (1024 * 1024);
-    double usagePercent = (usedMB / totalMB) * 100;
-
+    const QJsonObject cpu = info["cpu"].toObject();
+    cpuModelLabel->setText(cpu["model"].toString());
+    cpuCoresLabel->setText(QString::number(cpu["cores"].toInt()));
+
+    // usage_percent демона усреднён с загрузки системы; текущая загрузка -
+    // по разнице счётчиков с прошлым опросом. Старый демон счётчиков не шлёт
+    double cpuUsage = cpu["usage_percent"].toDouble();
+    bool cpuSample = !cpu.contains("total_ticks");
+    const qint64 cpuTotal = cpu["total_ticks"].toVariant().toLongLong();
+    const qint64 cpuIdle = cpu["idle_ticks"].toVariant().toLongLong();
+    if (lastCpuTotal > 0 && cpuTotal > lastCpuTotal) {
+        cpuUsage = qBound(0.0, 100.0 * (1.0 - double(cpuIdle - lastCpuIdle) / (cpuTotal - lastCpuTotal)), 100.0);
+        cpuSample = true;
+    }
+    lastCpuTotal = cpuTotal;
+    lastCpuIdle = cpuIdle;
+
+    QString cpuText = QString("%1%").arg(cpuUsage, 0, 'f', 1);
+    if (cpu.contains("temperature")) cpuText += QString(" / %1°C").arg(cpu["temperature"].toDouble(), 0, 'f', 1);
+    cpuUsageLabel->setText(cpuText);
+    if (cpuSample) cpuChart->append(0, now, cpuUsage);
+
+    // RAM: занятой считается память без учёта кэша, как в usage_percent демона
+    const QJsonObject memInfo = info["memory"].toObject();
+    const double totalMB = memInfo["total"].toDouble() / (1024 * 1024);
+    const double usedMB = (memInfo["total"].toDouble() - memInfo["available"].toDouble()) / (1024 * 1024);
+    const double memoryUsage = memInfo["usage_percent"].toDouble();
     ramUsageLabel->setText(
         QString("%1 MB / %2 MB (%3%)")
         .arg(usedMB, 0, 'f', 1)
         .arg(totalMB, 0, 'f', 1)
-        .arg(usagePercent, 0, 'f', 1)
+        .arg(memoryUsage, 0, 'f', 1)
     );
+    memoryChart->append(0, now, memoryUsage);
 
     // Диски
-    QJsonArray disks = info["disks"].toArray();
+    const double gb = 1024.0 * 1024 * 1024;
+    double readRate = 0.0, writeRate = 0.0;
+    QSet<QString> countedDevices;
     diskList->clear();
-    for (const QJsonValue& diskVal : disks) {
-        QJsonObject disk = diskVal.toObject();
+    for (const QJsonValue& diskVal : info["disks"].toArray()) {
+        const QJsonObject disk = diskVal.toObject();
         QString text = QString("%1: %2/%3 GB (%4%)")
             .arg(disk["mount_point"].toString())
-            .arg(disk["used_gb"].toDouble(), 0, 'f', 1)
-            .arg(disk["total_gb"].toDouble(), 0, 'f', 1)
+            .arg(disk["used"].toDouble() / gb, 0, 'f', 1)
+            .arg(disk["total"].toDouble() / gb, 0, 'f', 1)
             .arg(disk["usage_percent"].toDouble(), 0, 'f', 1);
         diskList->addItem(text);
+
+        // Одно устройство может быть смонтировано в нескольких местах
+        const QJsonObject io = disk["io"].toObject();
+        if (io.isEmpty() || countedDevices.contains(disk["device"].toString())) continue;
+        countedDevices.insert(disk["device"].toString());
+        readRate += io["read_bytes_per_sec"].toDouble();
+        writeRate += io["write_bytes_per_sec"].toDouble();
     }
+    diskChart->append(readSeries, now, readRate);
+    diskChart->append(writeSeries, now, writeRate);
+
+    // Сеть: суммарно по интерфейсам, кроме петлевого
+    double rxRate = 0.0, txRate = 0.0;
+    for (const QJsonValue& ifaceVal : info["network"].toObject()["interfaces"].toArray()) {
+        const QJsonObject iface = ifaceVal.toObject();
+        if (iface["name"].toString() == "lo") continue;
+        rxRate += iface["rx_bytes_per_sec"].toDouble();
+        txRate += iface["tx_bytes_per_sec"].toDouble();
+    }
+    networkChart->append(rxSeries, now, rxRate);
+    networkChart->append(txSeries, now, txRate);
 }
 
-void MainWindow::onFileSystemReceived(const QJsonArray& files)
+void MainWindow::onFileSystemReceived(const QString& path, const QJsonArray& files)
 {
-    fileSystemTree->clear();
-
-    for (const QJsonValue& fileVal : files) {
-        QJsonObject file = fileVal.toObject();
-        QTreeWidgetItem* item = new QTreeWidgetItem(fileSystemTree);
-
-        // Правильный формат размера
-        double sizeKB = file["size"].toDouble() / 1024.0;
-        QString sizeText = sizeKB > 1024 ?
-            QString("%1 MB").arg(sizeKB/1024, 0, 'f', 1) :
-            QString("%1 KB").arg(sizeKB, 0, 'f', 1);
+    fileModel->setListing(path, files);
+}
 
-        item->setText(0, file["name"].toString());
-        item->setText(1, file["type"].toString());
-        item->setText(2, sizeText);
-        item->setText(3, file["permissions"].toString());
-        item->setText(4, file["owner"].toString());
-        item->setText(5, file["group"].toString());
+void MainWindow::onFileActivated(const QModelIndex& index)
+{
+    // Двойной щелчок по каталогу делает его корнем дерева
+    if (!index.data(RemoteFileModel::IsDirectoryRole).toBool()) return;
+    fileModel->setRootPath(index.data(RemoteFileModel::PathRole).toString());
+    currentPathLabel->setText(fileModel->rootPath());
+}
 
-        // Сохраняем полный путь
-        item->setData(0, Qt::UserRole, file["path"].toString());
-    }
+void MainWindow::onFileCurrentChanged(const QModelIndex& current)
+{
+    // Текущий путь - куда пойдёт загрузка: выбранный каталог или каталог выбранного файла
+    if (!current.isValid()) return;
+    const QString path = current.data(RemoteFileModel::PathRole).toString();
+    currentPathLabel->setText(current.data(RemoteFileModel::IsDirectoryRole).toBool()
+                              ? path : QFileInfo(path).path());
 }
 
 void MainWindow::onFileUploadFinished(bool success, const QString& message)
@@ -637,13 +893,13 @@ void MainWindow::onUploadFile()
 
 void MainWindow::onDownloadFile()
 {
-    QTreeWidgetItem* item = fileSystemTree->currentItem();
-    if (!item) {
+    const QModelIndex current = fileSystemTree->currentIndex();
+    if (!current.isValid()) {
         QMessageBox::warning(this, "Ошибка", "Файл не выбран");
         return;
     }
 
-    QString remotePath = item->data(0, Qt::UserRole).toString();
+    QString remotePath = current.data(RemoteFileModel::PathRole).toString();
     QString savePath = QFileDialog::getSaveFileName(this, "Сохранить файл");
 
     if (!savePath.isEmpty()) {
@@ -654,22 +910,50 @@ void MainWindow::onDownloadFile()
 
 void MainWindow::onSetPermissions()
 {
-    QTreeWidgetItem* item = fileSystemTree->currentItem();
-    if (!item) {
+    const QModelIndex current = fileSystemTree->currentIndex();
+    if (!current.isValid()) {
         QMessageBox::warning(this, "Ошибка", "Файл не выбран");
         return;
     }
 
-    QString path = item->data(0, Qt::UserRole).toString();
-    QString currentPerms = item->text(3);
+    QString path = current.data(RemoteFileModel::PathRole).toString();
+    QString currentPerms = current.sibling(current.row(), RemoteFileModel::PermissionsColumn).data().toString();
 
     bool ok;
     QString newPerms = QInputDialog::getText(this, "Установка прав",
         "Новые права (например, 755):", QLineEdit::Normal, currentPerms, &ok);
 
-    if (ok && !newPerms.isEmpty()) {
-        clientMgr->setFilePermissions(path, newPerms);
-        statusLabel->setText("Установка прав доступа...");
+    if (!ok || newPerms.isEmpty()) return;
+
+    // Каталог целиком обходит демон, одним запросом вместо запроса на файл
+    if (current.data(RemoteFileModel::IsDirectoryRole).toBool()
+        && QMessageBox::question(this, "Установка прав", "Применить права ко всему содержимому каталога?")
+               == QMessageBox::Yes) {
+        clientMgr->setPermissionsRecursive(path, newPerms);
+        statusLabel->setText("Рекурсивная установка прав...");
+        return;
+    }
+    clientMgr->setFilePermissions(path, newPerms);
+    statusLabel->setText("Установка прав доступа...");
+}
+
+void MainWindow::onFileOperationFinished(int operationId, const QJsonObject& summary)
+{
+    Q_UNUSED(operationId)
+    const int failed = summary["failed"].toInt();
+    statusLabel->setText(QString("Установка прав: %1, обработано %2, ошибок %3")
+                             .arg(summary["status"].toString()).arg(summary["processed"].toInt()).arg(failed));
+
+    // Права поменялись по всему дереву: раскрытые каталоги перечитываем мимо кэша
+    for (const QString& path : fileModel->loadedDirectories()) clientMgr->reloadFileSystem(path);
+
+    if (failed > 0) {
+        QStringList lines;
+        for (const QJsonValue& item : summary["errors"].toArray()) {
+            if (lines.size() >= 10) break;
+            lines << QString("%1: %2").arg(item["path"].toString(), item["error"].toString());
+        }
+        QMessageBox::warning(this, "Ошибка", QString("Не удалось обработать %1:\n%2").arg(failed).arg(lines.join('\n')));
     }
 }
 
@@ -693,12 +977,12 @@ void MainWindow::onManageUser()
         QString password = QInputDialog::getText(this, "Пароль", "Пароль:", QLineEdit::Password);
         clientMgr->addUser(username, password);
     } else {
-        int idx = userListWidget->currentRow();
-        if (idx < 0) {
+        const QModelIndex current = userListView->currentIndex();
+        if (!current.isValid()) {
             QMessageBox::warning(this, "Ошибка", "Выберите пользователя");
             return;
         }
-        QString username = userListWidget->item(idx)->text();
+        QString username = current.data().toString();
         if (action == "Удалить") {
             clientMgr->removeUser(username);
         } else if (action == "Изменить пароль") {
@@ -710,13 +994,13 @@ void MainWindow::onManageUser()
 
 void MainWindow::onManageService()
 {
-    QListWidgetItem* item = serviceList->currentItem();
-    if (!item) {
+    const QModelIndex current = serviceList->currentIndex();
+    if (!current.isValid()) {
         QMessageBox::warning(this, "Ошибка", "Служба не выбрана");
         return;
     }
 
-    QString service = item->text();
+    QString service = current.data().toString();
     QString action = QInputDialog::getItem(this, "Управление службой",
         "Действие:", {"Запустить", "Остановить", "Перезапустить"}, 0, false);
 
@@ -725,3 +1009,76 @@ void MainWindow::onManageService()
         statusLabel->setText(action + " службы " + service + "...");
     }
 }
+
+void MainWindow::onFleetRunClicked()
+{
+    if (discoveredHosts.isEmpty()) {
+        QMessageBox::warning(this, "Ошибка", "Сначала обнаружьте серверы.");
+        return;
+    }
+
+    QString method;
+    QJsonObject params;
+    switch (fleetQueryCombo->currentIndex()) {
+    case 0:
+        if (fleetArgumentEdit->text().trimmed().isEmpty()) {
+            QMessageBox::warning(this, "Ошибка", "Укажите имя службы.");
+            return;
+        }
+        method = "getServiceStatus";
+        params["service"] = fleetArgumentEdit->text().trimmed();
+        break;
+    default:
+        method = "getSystemInfo";
+        break;
+    }
+
+    if (activeFleetQuery >= 0) fleet->cancel(activeFleetQuery);
+    activeFleetKind = fleetQueryCombo->currentIndex();
+    activeFleetThreshold = fleetArgumentEdit->text().toDouble();
+    fleetTable->setRowCount(0);
+    fleetProgressLabel->setText(QString("Ответили 0 из %1").arg(discoveredHosts.size()));
+    activeFleetQuery = fleet->fanOut(discoveredHosts, method, params);
+}
+
+void MainWindow::onFleetHostResult(int queryId, const QString& host, const QJsonValue& result, const QString& error)
+{
+    if (queryId != activeFleetQuery) return;
+
+    QString status = error.isEmpty() ? "OK" : "Ошибка";
+    QString text = error;
+
+    if (error.isEmpty()) {
+        QJsonObject info = result.toObject();
+        switch (activeFleetKind) {
+        case 0:
+            status = info["active_state"].toString();
+            text = QString("%1 (%2)").arg(info["sub_state"].toString(), info["unit_file_state"].toString());
+            break;
+        case 1: {
+            // Показываем только хосты, где есть диск выше порога
+            QStringList full;
+            for (const QJsonValue& diskVal : info["disks"].toArray()) {
+                QJsonObject disk = diskVal.toObject();
+                if (disk["usage_percent"].toDouble() > activeFleetThreshold) {
+                    full << QString("%1 (%2%)").arg(disk["mount_point"].toString())
+                                               .arg(disk["usage_percent"].toDouble(), 0, 'f', 1);
+                }
+            }
+            if (full.isEmpty()) return;
+            status = "Заполнен";
+            text = full.join(", ");
+            break;
+        }
+        default:
+            text = QString("%1%").arg(info["cpu"].toObject()["usage_percent"].toDouble(), 0, 'f', 1);
+            break;
+        }
+    }
+
+    int row = fleetTable->rowCount();
+    fleetTable->insertRow(row);
+    fleetTable->setItem(row, 0, new QTableWidgetItem(host));
+    fleetTable->setItem(row, 1, new QTableWidgetItem(status));
+    fleetTable->setItem(row, 2, new QTableWidgetItem(text));
+}
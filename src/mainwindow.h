@@ -6,14 +6,23 @@
 #include <QListWidget>
 #include <QPushButton>
 #include <QLabel>
-#include <QTreeWidget>
+#include <QTreeView>
+#include <QListView>
 #include <QGroupBox>
 #include <QSplitter>
 #include <QToolBar>
 #include <QProgressBar>
 #include <QJsonObject>
+#include <QComboBox>
+#include <QLineEdit>
+#include <QTableWidget>
+#include <QTimer>
 #include "NetworkDiscovery.h"
 #include "ClientManager.h"
+#include "FleetManager.h"
+#include "RemoteFileModel.h"
+#include "DiffListModel.h"
+#include "TimeSeriesChart.h"
 
 class MainWindow : public QMainWindow
 {
@@ -35,14 +44,17 @@ private:
 
     // Вкладка пользователей
     QWidget *usersTab;
-    QListWidget *userListWidget;
+    QListView *userListView;
+    DiffListModel *userModel;
     QPushButton *addUserButton;
     QPushButton *removeUserButton;
     QPushButton *changePasswordButton;
 
     // Вкладка файловой системы
     QWidget *filesTab;
-    QTreeWidget *fileSystemTree;
+    QTreeView *fileSystemTree;
+    RemoteFileModel *fileModel;
+    QPushButton *parentDirButton;
     QPushButton *fileSelectButton;
     QPushButton *uploadButton;
     QPushButton *downloadButton;
@@ -60,20 +72,42 @@ private:
     QLabel *cpuUsageLabel;
     QLabel *ramUsageLabel;
     QListWidget *diskList;
+    QComboBox *chartWindowCombo;
+    TimeSeriesChart *cpuChart;
+    TimeSeriesChart *memoryChart;
+    TimeSeriesChart *diskChart;
+    TimeSeriesChart *networkChart;
+    QTimer *systemPollTimer;
+    // Счётчики /proc/stat прошлого опроса: загрузка CPU считается по разнице
+    qint64 lastCpuTotal;
+    qint64 lastCpuIdle;
 
     // Вкладка служб
     QWidget *servicesTab;
-    QListWidget *serviceList;
+    QListView *serviceList;
+    DiffListModel *serviceModel;
     QPushButton *serviceControlButton;
 
+    // Вкладка парка серверов
+    QWidget *fleetTab;
+    QComboBox *fleetQueryCombo;
+    QLineEdit *fleetArgumentEdit;
+    QPushButton *fleetRunButton;
+    QTableWidget *fleetTable;
+    QLabel *fleetProgressLabel;
+
     // Управляющие объекты
     NetworkDiscovery* discovery;
     ClientManager* clientMgr;
+    FleetManager* fleet;
 
     // Данные
     QList<HostInfo> discoveredHosts;
     QString currentFilePath;
     QLabel *statusLabel;
+    int activeFleetQuery;
+    int activeFleetKind;
+    double activeFleetThreshold;
 
 private:
     void initUI();
@@ -85,6 +119,7 @@ private:
     void createFilesTab();
     void createSystemTab();
     void createServicesTab();
+    void createFleetTab();
 
     void updateSystemInfo(const QJsonObject& info);
 
@@ -92,12 +127,16 @@ private slots:
     void onTestConnectionClicked();
     void onDiscoverClicked();
     void onHostDiscovered(const HostInfo& host);
+    void onHostUpdated(const HostInfo& host);
+    void onHostExpired(const HostInfo& host);
     void onConnectClicked();
     void onConnected();
     void onConnectionError(const QString& errorString);
     void onUserListReceived(const QStringList& users);
     void onSystemInfoReceived(const QJsonObject& info);
-    void onFileSystemReceived(const QJsonArray& files);
+    void onFileSystemReceived(const QString& path, const QJsonArray& files);
+    void onFileActivated(const QModelIndex& index);
+    void onFileCurrentChanged(const QModelIndex& current);
     void onFileUploadFinished(bool success, const QString& message);
     void onServiceListReceived(const QJsonArray& services);
 
@@ -105,8 +144,11 @@ private slots:
     void onUploadFile();
     void onDownloadFile();
     void onSetPermissions();
+    void onFileOperationFinished(int operationId, const QJsonObject& summary);
     void onManageUser();
     void onManageService();
+    void onFleetRunClicked();
+    void onFleetHostResult(int queryId, const QString& host, const QJsonValue& result, const QString& error);
 };
 
 #endif // MAINWINDOW_H
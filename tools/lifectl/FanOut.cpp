@@ -0,0 +1,146 @@
+#include "FanOut.h"
+#include <QFutureWatcher>
+#include <QTimer>
+
+FanOut::FanOut(const QList<Target>& targets, const QString& method, const QJsonObject& params,
+               int parallel, int timeoutMs, QObject* parent)
+    : QObject(parent),
+      method(method),
+      params(params),
+      parallel(qMax(1, parallel)),
+      timeoutMs(timeoutMs),
+      running(0)
+{
+    for (const Target& target : targets) waiting.enqueue(target);
+}
+
+void FanOut::setTls(const QSslConfiguration& configuration, const QString& peerName)
+{
+    tlsConfiguration = configuration;
+    tlsPeerName = peerName;
+}
+
+void FanOut::start()
+{
+    if (waiting.isEmpty()) {
+        QTimer::singleShot(0, this, &FanOut::finished);
+        return;
+    }
+    while (running < parallel && !waiting.isEmpty()) launchNext();
+}
+
+void FanOut::launchNext()
+{
+    const Target target = waiting.dequeue();
+    ++running;
+
+    RpcClient* client = new RpcClient(this);
+    client->setTlsConfiguration(tlsConfiguration, tlsPeerName);
+    client->setCredentials(credentials);
+    // Таймаут на весь хост: подключение, hello и сам вызов
+    QTimer* deadline = new QTimer(client);
+    deadline->setSingleShot(true);
+    connect(deadline, &QTimer::timeout, this, [this, client, target]() {
+        RpcResult reply;
+        reply.errorCode = RpcClient::timeoutErrorCode;
+        reply.errorMessage = "Timed out";
+        finishHost(client, target, reply);
+    });
+
+    connect(client, &RpcClient::connectionError, this, [this, client, target](const QString& message) {
+        RpcResult reply;
+        reply.errorCode = RpcClient::transportErrorCode;
+        reply.errorMessage = message;
+        finishHost(client, target, reply);
+    });
+
+    connect(client, &RpcClient::connected, this, [this, client, target]() {
+        if (!syncTree.root.isEmpty()) {
+            TreeSync* sync = new TreeSync(client, syncTree, params, client);
+            connect(sync, &TreeSync::finished, this, [this, client, target](const RpcResult& reply) {
+                finishHost(client, target, reply);
+            });
+            sync->start();
+            return;
+        }
+        // Ответ приходит через очередь событий, а уведомления - сразу, из того же
+        // чтения: слушать их надо до вызова, иначе вывод короткой команды теряется
+        if (method == "exec") {
+            execCaptures.insert(target.key(), ExecCapture());
+            connect(client, &RpcClient::notificationReceived, this,
+                    [this, client, target](const QString& name, const QJsonObject& params) {
+                onExecNotification(client, target, name, params);
+            });
+        }
+        QFutureWatcher<RpcResult>* watcher = new QFutureWatcher<RpcResult>(client);
+        connect(watcher, &QFutureWatcher<RpcResult>::finished, this, [this, client, target, watcher]() {
+            const RpcResult reply = watcher->result();
+            if (method == "exec" && reply.ok()) watchExec(client, target, reply.result.toObject()["execution"].toInt());
+            else finishHost(client, target, reply);
+        });
+        watcher->setFuture(client->callAsync(method, params));
+    });
+
+    deadline->start(timeoutMs);
+    client->connectToHost(target.host, target.port);
+}
+
+void FanOut::watchExec(RpcClient* client, const Target& target, int executionId)
+{
+    // Id известен: разбираем то, что пришло раньше ответа
+    const auto it = execCaptures.find(target.key());
+    if (it == execCaptures.end()) return;
+    it->executionId = executionId;
+    const QList<QPair<QString, QJsonObject>> early = it->early;
+    it->early.clear();
+    for (const auto& notification : early) {
+        onExecNotification(client, target, notification.first, notification.second);
+        if (collected.contains(target.key())) return;
+    }
+}
+
+void FanOut::onExecNotification(RpcClient* client, const Target& target, const QString& name, const QJsonObject& params)
+{
+    const auto it = execCaptures.find(target.key());
+    if (it == execCaptures.end()) return;
+    ExecCapture& capture = it.value();
+    if (capture.executionId < 0) {
+        capture.early.append(qMakePair(name, params));
+        return;
+    }
+    // Вывод копится до execFinished; у каждого хоста своё соединение, так что id не пересекаются
+    if (params["execution"].toInt() != capture.executionId) return;
+    if (name == "execOutput") {
+        const QString data = params["data"].toString();
+        if (params["stream"].toString() == "stderr") capture.stderrText += data;
+        else capture.stdoutText += data;
+        emit execOutput(target.key(), params["stream"].toString(), data);
+    } else if (name == "execFinished") {
+        QJsonObject result = params;
+        result.remove("execution");
+        result["stdout"] = capture.stdoutText;
+        result["stderr"] = capture.stderrText;
+        execCaptures.remove(target.key());
+        RpcResult reply;
+        reply.result = result;
+        finishHost(client, target, reply);
+    }
+}
+
+void FanOut::finishHost(RpcClient* client, const Target& target, const RpcResult& reply)
+{
+    // Ошибка сокета после разрыва или таймаута не должна засчитать хост дважды
+    const QString key = target.key();
+    if (collected.contains(key)) return;
+
+    collected.insert(key, reply);
+    execCaptures.remove(key);
+    client->disconnect(this);
+    client->disconnectFromHost();
+    client->deleteLater();
+    --running;
+    emit hostFinished(key, reply);
+
+    if (!waiting.isEmpty()) launchNext();
+    else if (running == 0) emit finished();
+}
@@ -0,0 +1,77 @@
+#ifndef FANOUT_H
+#define FANOUT_H
+
+#include <QObject>
+#include <QMap>
+#include <QQueue>
+#include <QJsonObject>
+#include "RpcClient.h"
+#include "TreeSync.h"
+
+// Один вызов на множестве демонов: не больше parallel соединений одновременно,
+// каждый хост со своим таймаутом. Результаты собираются по ключу "host:port".
+//
+// exec - особый случай: ответ на вызов содержит только id запуска, а вывод и код
+// возврата приходят уведомлениями. Хост считается завершённым по execFinished,
+// и в результат попадают exitCode, status, stdout и stderr.
+//
+// syncTree - тоже: на каждом хосте целый обмен (манифест и пачки записи), его
+// ведёт TreeSync по одному на все хосты сканированию локального дерева.
+class FanOut : public QObject
+{
+    Q_OBJECT
+public:
+    struct Target {
+        QString host;
+        quint16 port = 0;
+        QString key() const { return QString("%1:%2").arg(host).arg(port); }
+    };
+
+    FanOut(const QList<Target>& targets, const QString& method, const QJsonObject& params,
+           int parallel, int timeoutMs, QObject* parent = nullptr);
+
+    // TLS для всех хостов; пустая конфигурация - открытый TCP
+    void setTls(const QSslConfiguration& configuration, const QString& peerName = QString());
+    // Вход на каждом хосте одним и тем же пользователем
+    void setCredentials(const Credentials& credentials) { this->credentials = credentials; }
+    // Локальное дерево: вместо одного вызова на каждом хосте идёт TreeSync
+    void setSyncTree(const TreeSync::LocalTree& tree) { syncTree = tree; }
+
+    void start();
+    const QMap<QString, RpcResult>& results() const { return collected; }
+
+signals:
+    void hostFinished(const QString& key, const RpcResult& reply);
+    // Вывод exec по мере поступления (stream - "stdout" или "stderr")
+    void execOutput(const QString& key, const QString& stream, const QString& data);
+    void finished();
+
+private:
+    void launchNext();
+    void finishHost(RpcClient* client, const Target& target, const RpcResult& reply);
+    void watchExec(RpcClient* client, const Target& target, int executionId);
+    void onExecNotification(RpcClient* client, const Target& target, const QString& name, const QJsonObject& params);
+
+    QQueue<Target> waiting;
+    QString method;
+    QJsonObject params;
+    int parallel;
+    int timeoutMs;
+    int running;
+    QSslConfiguration tlsConfiguration;
+    QString tlsPeerName;
+    Credentials credentials;
+    TreeSync::LocalTree syncTree;
+    QMap<QString, RpcResult> collected;
+
+    struct ExecCapture {
+        int executionId = -1; // -1 - ответа на exec ещё нет
+        // Уведомления, пришедшие раньше ответа (в том же чтении из сокета)
+        QList<QPair<QString, QJsonObject>> early;
+        QString stdoutText;
+        QString stderrText;
+    };
+    QHash<QString, ExecCapture> execCaptures;
+};
+
+#endif // FANOUT_H
@@ -0,0 +1,231 @@
+#include "TreeSync.h"
+#include "DeltaSync.h"
+#include <QCryptographicHash>
+#include <QDateTime>
+#include <QDir>
+#include <QDirIterator>
+#include <QFileInfo>
+#include <QFutureWatcher>
+
+namespace {
+
+// Пачка записи: байт данных и файлов (каждый файл на демоне - открытый временный файл)
+const qint64 maxBatchBytes = 16 * 1024 * 1024;
+const int maxBatchFiles = 256;
+// Файл целиком уходит в одном кадре в base64 (+1/3); запас - на JSON вокруг.
+// Кадр - не единственный предел: документ QJson в Qt 5 не больше 128 МиБ
+// (27-битные смещения). Больше этого файл не передаётся и попадает в ошибки
+const qint64 maxJsonDocumentBytes = 128 * 1024 * 1024;
+const qint64 maxFileBytes = (qMin(FrameChannel::defaultMaxMessageSize, maxJsonDocumentBytes) - 1024 * 1024) / 4 * 3;
+
+// QFile::Permissions -> восьмеричные права Unix
+int unixMode(QFile::Permissions permissions)
+{
+    const int bits = static_cast<int>(permissions);
+    return (((bits >> 12) & 7) << 6) | (((bits >> 4) & 7) << 3) | (bits & 7);
+}
+
+} // namespace
+
+bool TreeSync::LocalTree::scan(const QString& root, LocalTree* tree, QString* error)
+{
+    const QFileInfo rootInfo(root);
+    if (!rootInfo.isDir()) {
+        *error = QString("%1 is not a directory").arg(root);
+        return false;
+    }
+    tree->root = rootInfo.absoluteFilePath();
+    tree->files = QJsonArray();
+    tree->dirs = QJsonArray();
+
+    const QDir base(tree->root);
+    QDirIterator it(tree->root, QDir::Files | QDir::Dirs | QDir::Hidden | QDir::NoDotAndDotDot,
+                    QDirIterator::Subdirectories);
+    while (it.hasNext()) {
+        it.next();
+        const QFileInfo info = it.fileInfo();
+        if (info.isSymLink()) continue;
+        const QString relative = base.relativeFilePath(info.absoluteFilePath());
+        if (info.isDir()) {
+            tree->dirs.append(relative);
+            continue;
+        }
+        const QString sha256 = DeltaSync::fileHash(info.absoluteFilePath());
+        if (sha256.isEmpty()) {
+            *error = QString("Cannot read %1").arg(info.absoluteFilePath());
+            return false;
+        }
+        QJsonObject file;
+        file["path"] = relative;
+        file["size"] = static_cast<double>(info.size());
+        file["mtime"] = static_cast<double>(info.lastModified().toMSecsSinceEpoch());
+        file["mode"] = unixMode(info.permissions());
+        file["sha256"] = sha256;
+        tree->files.append(file);
+    }
+    return true;
+}
+
+TreeSync::TreeSync(RpcClient* client, const LocalTree& tree, const QJsonObject& options, QObject* parent)
+    : QObject(parent),
+      client(client),
+      tree(tree),
+      options(options),
+      nextTransfer(0),
+      batches(0)
+{
+    for (const QJsonValue& value : tree.files) {
+        const QJsonObject file = value.toObject();
+        manifest.insert(file["path"].toString(), file);
+    }
+}
+
+void TreeSync::call(const QString& method, const QJsonObject& params, void (TreeSync::*handler)(const RpcResult&))
+{
+    QFutureWatcher<RpcResult>* watcher = new QFutureWatcher<RpcResult>(this);
+    connect(watcher, &QFutureWatcher<RpcResult>::finished, this, [this, watcher, handler]() {
+        watcher->deleteLater();
+        (this->*handler)(watcher->result());
+    });
+    // Пачки данных не должны задерживать интерактивные вызовы в том же соединении
+    watcher->setFuture(client->callAsync(method, params,
+                                         method == "syncTreeCommit" ? FrameChannel::Bulk : FrameChannel::Interactive));
+}
+
+void TreeSync::start()
+{
+    QJsonObject params = options;
+    params["files"] = tree.files;
+    params["dirs"] = tree.dirs;
+    call("syncTree", params, &TreeSync::onManifest);
+}
+
+void TreeSync::onManifest(const RpcResult& reply)
+{
+    if (!reply.ok()) {
+        emit finished(reply);
+        return;
+    }
+    const QJsonObject result = reply.result.toObject();
+    transfer = result["transfer"].toArray();
+    missingDirs = result["missingDirs"].toArray();
+    removeList = result["remove"].toArray();
+    for (const QJsonValue& error : result["errors"].toArray()) errors.append(error);
+    summary["unchanged"] = result["unchanged"].toInt();
+    summary["touched"] = result["touched"].toInt();
+
+    if (options["dryRun"].toBool()) {
+        QJsonArray paths;
+        for (const QJsonValue& item : transfer) paths.append(item.toObject()["path"]);
+        summary["wouldTransfer"] = paths;
+        summary["wouldRemove"] = removeList;
+        summary["wouldCreateDirs"] = missingDirs;
+        finish();
+        return;
+    }
+    // Неизменное дерево: весь обмен - один манифест
+    if (transfer.isEmpty() && missingDirs.isEmpty() && removeList.isEmpty()) {
+        finish();
+        return;
+    }
+    sendNextBatch();
+}
+
+void TreeSync::sendNextBatch()
+{
+    QJsonArray files;
+    qint64 bytes = 0;
+    while (nextTransfer < transfer.size() && files.size() < maxBatchFiles && bytes < maxBatchBytes) {
+        const QJsonObject item = transfer[nextTransfer].toObject();
+        const QString path = item["path"].toString();
+        const bool hasDelta = item.contains("signatures");
+        const qint64 size = static_cast<qint64>(manifest.value(path)["size"].toDouble());
+        // Большой файл не догружает пачку, а уходит следующей
+        if (!files.isEmpty() && bytes + size > maxBatchBytes) break;
+        ++nextTransfer;
+        // Разница может оказаться маленькой, поэтому её проверяем после подсчёта
+        if (!hasDelta && size > maxFileBytes) {
+            errors.append(QJsonObject{{"path", path},
+                                      {"error", QString("File is too large to send in one frame (%1 bytes, limit %2)")
+                                                    .arg(size).arg(maxFileBytes)}});
+            continue;
+        }
+        QFile file(tree.root + '/' + path);
+        if (!file.open(QIODevice::ReadOnly)) {
+            errors.append(QJsonObject{{"path", path}, {"error", file.errorString()}});
+            continue;
+        }
+        const QByteArray data = file.readAll();
+        const QJsonObject local = manifest.value(path);
+
+        QJsonObject entry;
+        entry["path"] = path;
+        entry["mode"] = local["mode"];
+        entry["mtime"] = local["mtime"];
+        // Файл мог измениться после сканирования: хэш считаем по тому, что уходит
+        entry["sha256"] = QString::fromLatin1(QCryptographicHash::hash(data, QCryptographicHash::Sha256).toHex());
+        if (hasDelta) {
+            qint64 literal = 0;
+            const int blockSize = item["blockSize"].toInt();
+            const QJsonArray delta = DeltaSync::delta(data, item["signatures"].toArray(), blockSize, &literal);
+            if (literal > maxFileBytes) {
+                errors.append(QJsonObject{{"path", path},
+                                          {"error", QString("Changes are too large to send in one frame (%1 bytes, limit %2)")
+                                                        .arg(literal).arg(maxFileBytes)}});
+                continue;
+            }
+            entry["delta"] = delta;
+            entry["blockSize"] = blockSize;
+            entry["baseSha256"] = item["baseSha256"];
+            bytes += literal;
+            summary["deltaFiles"] = summary["deltaFiles"].toInt() + 1;
+            summary["matchedBytes"] = summary["matchedBytes"].toDouble() + (data.size() - literal);
+        } else {
+            // Файл мог вырасти после сканирования
+            if (data.size() > maxFileBytes) {
+                errors.append(QJsonObject{{"path", path},
+                                          {"error", QString("File is too large to send in one frame (%1 bytes, limit %2)")
+                                                        .arg(data.size()).arg(maxFileBytes)}});
+                continue;
+            }
+            entry["data"] = QString::fromLatin1(data.toBase64());
+            bytes += data.size();
+        }
+        files.append(entry);
+    }
+    summary["sentBytes"] = summary["sentBytes"].toDouble() + bytes;
+
+    QJsonObject params;
+    params["root"] = options["root"];
+    params["files"] = files;
+    if (batches == 0) params["dirs"] = missingDirs;
+    if (nextTransfer >= transfer.size()) params["remove"] = removeList;
+    ++batches;
+    call("syncTreeCommit", params, &TreeSync::onBatch);
+}
+
+void TreeSync::onBatch(const RpcResult& reply)
+{
+    if (!reply.ok()) {
+        emit finished(reply);
+        return;
+    }
+    const QJsonObject result = reply.result.toObject();
+    summary["written"] = summary["written"].toInt() + result["written"].toInt();
+    summary["removed"] = summary["removed"].toInt() + result["removed"].toInt();
+    for (const QJsonValue& error : result["errors"].toArray()) errors.append(error);
+
+    if (nextTransfer < transfer.size()) sendNextBatch();
+    else finish();
+}
+
+void TreeSync::finish()
+{
+    summary["files"] = tree.files.size();
+    summary["batches"] = batches;
+    summary["errors"] = errors;
+    summary["dryRun"] = options["dryRun"].toBool();
+    RpcResult reply;
+    reply.result = summary;
+    emit finished(reply);
+}
@@ -0,0 +1,62 @@
+#ifndef TREESYNC_H
+#define TREESYNC_H
+
+#include <QObject>
+#include <QHash>
+#include <QJsonArray>
+#include <QJsonObject>
+#include "RpcClient.h"
+
+// Клиентская сторона syncTree на одном хосте.
+//
+// Локальное дерево сканируется один раз на все хосты: пути, размеры, mtime, права
+// и SHA-256 файлов. Манифест уходит одним вызовом syncTree; если демон ответил,
+// что всё совпадает, синхронизация на этом закончена. Иначе изменённые файлы
+// уходят пачками syncTreeCommit: большие - блочной разницей по подписям демона,
+// остальные целиком. Первая пачка создаёт недостающие каталоги, последняя
+// удаляет лишние файлы (delete=true).
+class TreeSync : public QObject
+{
+    Q_OBJECT
+public:
+    struct LocalTree {
+        QString root;
+        QJsonArray files; // {path, size, mtime, mode, sha256}
+        QJsonArray dirs;
+
+        // Символические ссылки пропускаются
+        static bool scan(const QString& root, LocalTree* tree, QString* error);
+    };
+
+    // options - параметры запроса: root (каталог на демоне), delete, dryRun
+    TreeSync(RpcClient* client, const LocalTree& tree, const QJsonObject& options, QObject* parent = nullptr);
+
+    void start();
+
+signals:
+    // Итог: счётчики и ошибки по путям, либо ошибка вызова
+    void finished(const RpcResult& reply);
+
+private:
+    void call(const QString& method, const QJsonObject& params, void (TreeSync::*handler)(const RpcResult&));
+    void onManifest(const RpcResult& reply);
+    void sendNextBatch();
+    void onBatch(const RpcResult& reply);
+    void finish();
+
+    RpcClient* client;
+    LocalTree tree;
+    QJsonObject options;
+    QHash<QString, QJsonObject> manifest; // путь -> запись манифеста
+
+    QJsonArray transfer;
+    QJsonArray missingDirs;
+    QJsonArray removeList;
+    int nextTransfer;
+    int batches;
+
+    QJsonObject summary;
+    QJsonArray errors;
+};
+
+#endif // TREESYNC_H
@@ -0,0 +1,340 @@
+#include "RpcClient.h"
+#include "FanOut.h"
+#include "TreeSync.h"
+#include <QCoreApplication>
+#include <QCommandLineParser>
+#include <QJsonDocument>
+#include <QJsonArray>
+#include <QFile>
+#include <QSet>
+#include <QTextStream>
+
+namespace {
+
+// Короткие имена команд для частых вызовов; остальное - через "call <метод>"
+const QMap<QString, QString> commandAliases = {
+    { "info", "getSystemInfo" },
+    { "users", "getUserList" },
+    { "ls", "getFileSystem" },
+    { "ps", "getProcessList" },
+    { "services", "getServiceList" },
+    { "status", "getServiceStatus" },
+    { "cgroups", "getCgroupStats" },
+    { "net", "getNetworkStats" },
+    { "disks", "getDiskStats" },
+    { "stats", "getDaemonStats" },
+};
+
+// Позиционный аргумент, который команда принимает без key=value
+const QMap<QString, QString> positionalParam = {
+    { "getFileSystem", "path" },
+    { "getServiceStatus", "service" },
+};
+
+const int exitOk = 0;
+const int exitFailed = 1;
+const int exitUsage = 2;
+
+// key=value; значение, похожее на JSON (число, true, массив), передаётся как JSON
+QJsonValue parseValue(const QString& text)
+{
+    const QJsonDocument doc = QJsonDocument::fromJson(("[" + text + "]").toUtf8());
+    if (doc.isArray() && doc.array().size() == 1) return doc.array().first();
+    return text;
+}
+
+QList<FanOut::Target> parseHosts(const QStringList& specs, quint16 defaultPort)
+{
+    QList<FanOut::Target> targets;
+    QSet<QString> seen;
+    for (const QString& raw : specs) {
+        const QString spec = raw.trimmed();
+        if (spec.isEmpty() || spec.startsWith('#')) continue;
+        FanOut::Target target;
+        const int colon = spec.lastIndexOf(':');
+        bool ok = false;
+        const quint16 port = colon > 0 ? static_cast<quint16>(spec.mid(colon + 1).toUInt(&ok)) : 0;
+        target.host = ok ? spec.left(colon) : spec;
+        target.port = ok ? port : defaultPort;
+        if (seen.contains(target.key())) continue;
+        seen.insert(target.key());
+        targets << target;
+    }
+    return targets;
+}
+
+QJsonObject replyToJson(const RpcResult& reply)
+{
+    QJsonObject entry;
+    if (reply.ok()) {
+        entry["result"] = reply.result;
+    } else {
+        QJsonObject error;
+        error["code"] = reply.errorCode;
+        error["message"] = reply.errorMessage;
+        if (!reply.errorData.isUndefined() && !reply.errorData.isNull()) error["data"] = reply.errorData;
+        entry["error"] = error;
+    }
+    return entry;
+}
+
+QByteArray formatValue(const QJsonValue& value, bool compact)
+{
+    const QJsonDocument::JsonFormat format = compact ? QJsonDocument::Compact : QJsonDocument::Indented;
+    if (value.isObject()) return QJsonDocument(value.toObject()).toJson(format);
+    if (value.isArray()) return QJsonDocument(value.toArray()).toJson(format);
+    // Скаляры QJsonDocument не сериализует напрямую
+    QByteArray wrapped = QJsonDocument(QJsonArray{ value }).toJson(QJsonDocument::Compact);
+    return wrapped.mid(1, wrapped.size() - 2) + '\n';
+}
+
+} // namespace
+
+int main(int argc, char* argv[])
+{
+    QCoreApplication app(argc, argv);
+    app.setApplicationName("lifectl");
+    app.setApplicationVersion("1.0");
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription(
+        "Command-line client for os_overview_server.\n\n"
+        "Commands: info, users, ls <path>, ps, services, status <service>, cgroups, net, disks, stats,\n"
+        "          call <method> [key=value ...], exec <command> [-- args ...],\n"
+        "          sync <local-dir> <remote-dir> [delete=true] [dryRun=true]\n"
+        "Extra parameters are given as key=value (values that parse as JSON are sent as JSON).");
+    parser.addHelpOption();
+    parser.addVersionOption();
+
+    const QCommandLineOption hostOption({ "H", "host" }, "Daemon address.", "host", "127.0.0.1");
+    const QCommandLineOption portOption({ "p", "port" }, "Default daemon port.", "port", "45454");
+    const QCommandLineOption hostsOption("hosts", "Comma-separated host[:port] list to query in parallel.", "list");
+    const QCommandLineOption hostsFileOption("hosts-file", "File with one host[:port] per line.", "file");
+    const QCommandLineOption parallelOption("parallel", "Concurrent connections for --hosts.", "n", "32");
+    const QCommandLineOption timeoutOption({ "t", "timeout" }, "Per-host timeout, ms.", "ms", "30000");
+    const QCommandLineOption paramsOption("params", "Request parameters as a JSON object.", "json");
+    const QCommandLineOption jsonOption("json", "Machine-readable output (one JSON document).");
+    const QCommandLineOption tlsOption("tls", "Connect over TLS.");
+    const QCommandLineOption caOption("ca", "PEM file with CA certificates of the daemons (implies --tls).", "file");
+    const QCommandLineOption certOption("cert", "PEM client certificate for mutual TLS (implies --tls).", "file");
+    const QCommandLineOption keyOption("key", "PEM private key of the client certificate.", "file");
+    const QCommandLineOption peerNameOption("peer-name", "Expected name in the daemon certificate.", "name");
+    const QCommandLineOption insecureOption("insecure", "Do not verify the daemon certificate.");
+    const QCommandLineOption userOption({ "u", "user" }, "Log in as this user (see --secret-file).", "name");
+    const QCommandLineOption secretFileOption("secret-file",
+        "File with the user's shared secret (default: $LIFE_SECRET_FILE).", "file");
+    parser.addOptions({ hostOption, portOption, hostsOption, hostsFileOption, parallelOption,
+                        timeoutOption, paramsOption, jsonOption, tlsOption, caOption, certOption,
+                        keyOption, peerNameOption, insecureOption, userOption, secretFileOption });
+    parser.addPositionalArgument("command", "Command or alias, see above.");
+    parser.process(app);
+
+    QTextStream out(stdout);
+    QTextStream err(stderr);
+
+    QStringList args = parser.positionalArguments();
+    if (args.isEmpty()) {
+        err << parser.helpText();
+        return exitUsage;
+    }
+
+    // Команда -> метод RPC
+    QString command = args.takeFirst();
+    QString method;
+    if (command == "call") {
+        if (args.isEmpty()) {
+            err << "call: method name required\n";
+            return exitUsage;
+        }
+        method = args.takeFirst();
+    } else if (command == "exec") {
+        // Имя команды из списка разрешённых на демоне; аргументы - после "--"
+        if (args.isEmpty()) {
+            err << "exec: command name required\n";
+            return exitUsage;
+        }
+        method = "exec";
+    } else if (command == "sync") {
+        if (args.size() < 2) {
+            err << "sync: local and remote directories required\n";
+            return exitUsage;
+        }
+        method = "syncTree";
+    } else if (commandAliases.contains(command)) {
+        method = commandAliases.value(command);
+    } else {
+        err << "Unknown command: " << command << '\n';
+        return exitUsage;
+    }
+
+    QJsonObject params;
+    if (parser.isSet(paramsOption)) {
+        const QJsonDocument doc = QJsonDocument::fromJson(parser.value(paramsOption).toUtf8());
+        if (!doc.isObject()) {
+            err << "--params must be a JSON object\n";
+            return exitUsage;
+        }
+        params = doc.object();
+    }
+    if (method == "exec") {
+        params["command"] = args.takeFirst();
+        if (!args.isEmpty()) params["args"] = QJsonArray::fromStringList(args);
+        args.clear();
+    }
+    TreeSync::LocalTree syncTree;
+    if (command == "sync") {
+        // Дерево сканируется и хэшируется один раз на все хосты
+        QString scanError;
+        if (!TreeSync::LocalTree::scan(args.takeFirst(), &syncTree, &scanError)) {
+            err << "sync: " << scanError << '\n';
+            return exitUsage;
+        }
+        params["root"] = args.takeFirst();
+    }
+    for (const QString& arg : args) {
+        const int eq = arg.indexOf('=');
+        if (eq > 0) {
+            params[arg.left(eq)] = parseValue(arg.mid(eq + 1));
+        } else if (positionalParam.contains(method) && !params.contains(positionalParam.value(method))) {
+            params[positionalParam.value(method)] = arg;
+        } else {
+            err << "Unexpected argument: " << arg << '\n';
+            return exitUsage;
+        }
+    }
+
+    TlsOptions tls;
+    tls.enabled = parser.isSet(tlsOption) || parser.isSet(caOption) || parser.isSet(certOption);
+    tls.caFile = parser.value(caOption);
+    tls.certificateFile = parser.value(certOption);
+    tls.privateKeyFile = parser.value(keyOption);
+    tls.peerName = parser.value(peerNameOption);
+    tls.verifyPeer = !parser.isSet(insecureOption);
+    QSslConfiguration tlsConfiguration;
+    QString tlsError;
+    if (tls.enabled && !tls.makeConfiguration(QSslSocket::SslClientMode, &tlsConfiguration, &tlsError)) {
+        err << "TLS: " << tlsError << '\n';
+        return exitUsage;
+    }
+
+    // Секрет только из файла: в аргументах его видно в ps
+    Credentials credentials;
+    credentials.user = parser.value(userOption);
+    if (!credentials.user.isEmpty()) {
+        const QString secretFile = parser.isSet(secretFileOption) ? parser.value(secretFileOption)
+                                                                  : qEnvironmentVariable("LIFE_SECRET_FILE");
+        QString secretError;
+        if (!Credentials::loadSecret(secretFile, &credentials.secret, &secretError)) {
+            err << "Auth: " << secretError << '\n';
+            return exitUsage;
+        }
+    }
+
+    const bool json = parser.isSet(jsonOption);
+    const int timeoutMs = qMax(1, parser.value(timeoutOption).toInt());
+    const quint16 defaultPort = static_cast<quint16>(parser.value(portOption).toUInt());
+
+    // Один хост: синхронный API без лишней обвязки. exec и sync идут через FanOut
+    // и на одном хосте: exec отвечает уведомлениями, sync - это несколько вызовов
+    const bool singleHost = !parser.isSet(hostsOption) && !parser.isSet(hostsFileOption);
+    const bool exec = method == "exec";
+    const bool sync = command == "sync";
+    if (exec && !params.contains("timeoutMs")) params["timeoutMs"] = timeoutMs;
+    if (singleHost && !exec && !sync) {
+        RpcClient client;
+        client.setTlsConfiguration(tlsConfiguration, tls.peerName);
+        client.setCredentials(credentials);
+        QString error;
+        RpcResult reply;
+        if (!client.connectSync(parser.value(hostOption), defaultPort, timeoutMs, &error)) {
+            reply.errorCode = RpcClient::transportErrorCode;
+            reply.errorMessage = error;
+        } else {
+            reply = client.callSync(method, params, timeoutMs);
+            client.disconnectFromHost();
+        }
+
+        if (json) {
+            out << formatValue(replyToJson(reply), false);
+        } else if (reply.ok()) {
+            out << formatValue(reply.result, false);
+        } else {
+            err << "Error " << reply.errorCode << ": " << reply.errorMessage << '\n';
+        }
+        return reply.ok() ? exitOk : exitFailed;
+    }
+
+    // Множество хостов: асинхронный API, результаты по мере поступления
+    QStringList specs = parser.value(hostsOption).split(',', Qt::SkipEmptyParts);
+    if (singleHost) specs << parser.value(hostOption);
+    if (parser.isSet(hostsFileOption)) {
+        QFile file(parser.value(hostsFileOption));
+        if (!file.open(QIODevice::ReadOnly | QIODevice::Text)) {
+            err << "Cannot open " << file.fileName() << '\n';
+            return exitUsage;
+        }
+        specs += QString::fromUtf8(file.readAll()).split('\n');
+    }
+    const QList<FanOut::Target> targets = parseHosts(specs, defaultPort);
+    if (targets.isEmpty()) {
+        err << "No hosts given\n";
+        return exitUsage;
+    }
+
+    FanOut fanOut(targets, method, params, parser.value(parallelOption).toInt(), timeoutMs);
+    fanOut.setTls(tlsConfiguration, tls.peerName);
+    fanOut.setCredentials(credentials);
+    fanOut.setSyncTree(syncTree);
+    if (!json && exec && singleHost) {
+        // Один хост: вывод команды идёт прямо в свои stdout и stderr
+        QObject::connect(&fanOut, &FanOut::execOutput, [&](const QString&, const QString& stream, const QString& data) {
+            QTextStream& target = stream == "stderr" ? err : out;
+            target << data;
+            target.flush();
+        });
+        QObject::connect(&fanOut, &FanOut::hostFinished, [&](const QString&, const RpcResult& reply) {
+            const QString status = reply.result.toObject()["status"].toString();
+            if (!reply.ok()) err << "Error " << reply.errorCode << ": " << reply.errorMessage << '\n';
+            else if (status != "exited") err << "Command " << status << '\n';
+        });
+    } else if (!json) {
+        // В текстовом режиме печатаем каждый хост сразу, как только он ответил
+        QObject::connect(&fanOut, &FanOut::hostFinished, [&](const QString& key, const RpcResult& reply) {
+            if (!reply.ok()) {
+                out << "== " << key << " == error " << reply.errorCode << ": " << reply.errorMessage << '\n';
+            } else if (exec) {
+                const QJsonObject result = reply.result.toObject();
+                out << "== " << key << " == " << result["status"].toString() << ' ' << result["exitCode"].toInt() << '\n'
+                    << result["stdout"].toString() << result["stderr"].toString();
+            } else {
+                out << "== " << key << " ==\n" << formatValue(reply.result, false);
+            }
+            out.flush();
+        });
+    }
+    QObject::connect(&fanOut, &FanOut::finished, &app, &QCoreApplication::quit);
+    fanOut.start();
+    app.exec();
+
+    int failed = 0;
+    QJsonObject report;
+    const QMap<QString, RpcResult>& results = fanOut.results();
+    for (auto it = results.constBegin(); it != results.constEnd(); ++it) {
+        const QJsonObject result = it->result.toObject();
+        if (!it->ok() || (exec && (result["status"].toString() != "exited" || result["exitCode"].toInt() != 0))
+            || (sync && !result["errors"].toArray().isEmpty())) {
+            ++failed;
+        }
+        report[it.key()] = replyToJson(it.value());
+    }
+    if (json) {
+        out << QJsonDocument(report).toJson(QJsonDocument::Indented);
+    } else if (exec && singleHost) {
+        // Код возврата команды становится кодом возврата lifectl
+        const QJsonObject result = results.first().result.toObject();
+        if (result["status"].toString() == "exited") return result["exitCode"].toInt();
+    } else {
+        err << results.size() - failed << " of " << results.size() << " hosts succeeded\n";
+    }
+    return failed == 0 ? exitOk : exitFailed;
+}
@@ -0,0 +1,170 @@
+#include "HandshakeBench.h"
+#include "FrameChannel.h"
+#include <QSslSocket>
+#include <QJsonDocument>
+#include <QTextStream>
+#include <QTimer>
+#include <QDebug>
+#include <algorithm>
+#include <memory>
+
+namespace {
+
+const int attemptTimeoutMs = 10000;
+
+qint64 percentile(const std::vector<qint64>& sorted, double p)
+{
+    if (sorted.empty()) return 0;
+    const size_t index = std::min(sorted.size() - 1, static_cast<size_t>(p * sorted.size()));
+    return sorted[index];
+}
+
+QString formatUs(qint64 us)
+{
+    if (us >= 1000) return QString::number(us / 1e3, 'f', 2) + "ms";
+    return QString::number(us) + "us";
+}
+
+QJsonObject summary(const std::vector<qint64>& sorted)
+{
+    QJsonObject entry;
+    entry["p50Us"] = percentile(sorted, 0.50);
+    entry["p99Us"] = percentile(sorted, 0.99);
+    entry["maxUs"] = sorted.empty() ? 0 : sorted.back();
+    return entry;
+}
+
+} // namespace
+
+HandshakeBench::HandshakeBench(const HandshakeOptions& options, QObject* parent)
+    : QObject(parent), options(options), started(0), running(0), failures(0), wallNs(0)
+{}
+
+void HandshakeBench::start()
+{
+    clock.start();
+    const int initial = qMin(options.concurrency, options.count);
+    for (int i = 0; i < initial; ++i) launch();
+}
+
+void HandshakeBench::launch()
+{
+    ++started;
+    ++running;
+
+    auto* socket = new QSslSocket(this);
+    auto* channel = new FrameChannel(socket, socket);
+    socket->setSocketOption(QAbstractSocket::LowDelayOption, 1);
+    const bool tls = !options.tls.isNull();
+    const qint64 startNs = clock.nsecsElapsed();
+    // Одна попытка завершается ровно один раз: ответом, ошибкой или таймаутом
+    auto done = std::make_shared<bool>(false);
+
+    auto complete = [this, socket, done](bool ok) {
+        if (*done) return;
+        *done = true;
+        socket->disconnect(this);
+        socket->abort();
+        socket->deleteLater();
+        finish(ok);
+    };
+    auto sendHello = [channel]() {
+        const QJsonObject hello{{"jsonrpc", "2.0"}, {"id", 1}, {"method", "hello"},
+                                {"params", QJsonObject{{"multiplex", true}}}};
+        channel->sendMessage(QJsonDocument(hello).toJson(QJsonDocument::Compact));
+    };
+
+    connect(socket, &QSslSocket::connected, this, [this, startNs, tls, sendHello]() {
+        tcpUs.push_back((clock.nsecsElapsed() - startNs) / 1000);
+        if (!tls) sendHello();
+    });
+    connect(socket, &QSslSocket::encrypted, this, [this, startNs, sendHello]() {
+        tlsUs.push_back((clock.nsecsElapsed() - startNs) / 1000);
+        sendHello();
+    });
+    connect(channel, &FrameChannel::messageReceived, this, [this, socket, startNs, tls, complete]() {
+        readyUs.push_back((clock.nsecsElapsed() - startNs) / 1000);
+        // К ответу на hello билет TLS 1.3 уже принят
+        if (tls && options.resume) {
+            const QByteArray ticket = socket->sslConfiguration().sessionTicket();
+            if (!ticket.isEmpty()) sessionTicket = ticket;
+        }
+        complete(true);
+    });
+    connect(socket, QOverload<QAbstractSocket::SocketError>::of(&QSslSocket::error), this, [socket, complete]() {
+        qWarning() << "Handshake failed:" << socket->errorString();
+        complete(false);
+    });
+    QTimer::singleShot(attemptTimeoutMs, socket, [complete]() { complete(false); });
+
+    if (!tls) {
+        socket->connectToHost(options.host, options.port);
+        return;
+    }
+    QSslConfiguration config = options.tls;
+    if (options.resume && !sessionTicket.isEmpty()) config.setSessionTicket(sessionTicket);
+    socket->setSslConfiguration(config);
+    socket->connectToHostEncrypted(options.host, options.port,
+                                   options.tlsPeerName.isEmpty() ? options.host : options.tlsPeerName);
+}
+
+void HandshakeBench::finish(bool ok)
+{
+    --running;
+    if (!ok) ++failures;
+    if (started < options.count) {
+        launch();
+        return;
+    }
+    if (running > 0) return;
+
+    wallNs = clock.nsecsElapsed();
+    std::sort(tcpUs.begin(), tcpUs.end());
+    std::sort(tlsUs.begin(), tlsUs.end());
+    std::sort(readyUs.begin(), readyUs.end());
+    emit finished();
+}
+
+QString HandshakeBench::reportText() const
+{
+    QString text;
+    QTextStream out(&text);
+    const double seconds = qMax(wallNs / 1e9, 1e-9);
+    const bool tls = !options.tls.isNull();
+
+    out << QString("%1 connections, %2 concurrent, %3").arg(options.count).arg(options.concurrency)
+           .arg(tls ? (options.resume ? "TLS with session resumption" : "TLS, full handshakes") : "plain TCP")
+        << "\n\n";
+    out << QString("%1 %2 %3 %4\n").arg("phase", -16).arg("p50", 10).arg("p99", 10).arg("max", 10);
+    auto row = [&out](const QString& name, const std::vector<qint64>& sorted) {
+        out << QString("%1 %2 %3 %4\n").arg(name, -16)
+               .arg(formatUs(percentile(sorted, 0.50)), 10)
+               .arg(formatUs(percentile(sorted, 0.99)), 10)
+               .arg(formatUs(sorted.empty() ? 0 : sorted.back()), 10);
+    };
+    row("tcp connect", tcpUs);
+    if (tls) row("tls handshake", tlsUs);
+    row("ready (hello)", readyUs);
+
+    out << QString("\n%1 ok, %2 failed, %3 connections/s\n")
+           .arg(readyUs.size()).arg(failures).arg(readyUs.size() / seconds, 0, 'f', 1);
+    return text;
+}
+
+QJsonObject HandshakeBench::reportJson() const
+{
+    QJsonObject report;
+    report["host"] = options.host;
+    report["port"] = options.port;
+    report["count"] = options.count;
+    report["concurrency"] = options.concurrency;
+    report["tls"] = !options.tls.isNull();
+    report["resume"] = options.resume;
+    report["ok"] = static_cast<qint64>(readyUs.size());
+    report["failed"] = failures;
+    report["connectionsPerSecond"] = readyUs.size() / qMax(wallNs / 1e9, 1e-9);
+    report["tcpConnect"] = summary(tcpUs);
+    if (!options.tls.isNull()) report["tlsHandshake"] = summary(tlsUs);
+    report["ready"] = summary(readyUs);
+    return report;
+}
@@ -0,0 +1,58 @@
+#ifndef HANDSHAKEBENCH_H
+#define HANDSHAKEBENCH_H
+
+#include <QObject>
+#include <QElapsedTimer>
+#include <QJsonObject>
+#include <QSslConfiguration>
+#include <vector>
+
+struct HandshakeOptions {
+    QString host = "127.0.0.1";
+    quint16 port = 45454;
+    int count = 1000;       // сколько подключений всего
+    int concurrency = 10;   // сколько одновременно
+    // Пустая конфигурация - открытый TCP (для сравнения с TLS)
+    QSslConfiguration tls;
+    QString tlsPeerName;
+    // Предъявлять билет прошлого сеанса, как это делает RpcClient
+    bool resume = true;
+};
+
+// Цена подключения: TCP, рукопожатие TLS и ответ на hello, после чего соединение
+// закрывается и открывается следующее. Так ведёт себя опрос парка, где каждый
+// хост опрашивается новым соединением.
+class HandshakeBench : public QObject
+{
+    Q_OBJECT
+public:
+    explicit HandshakeBench(const HandshakeOptions& options, QObject* parent = nullptr);
+
+    void start();
+
+    QString reportText() const;
+    QJsonObject reportJson() const;
+    int succeeded() const { return static_cast<int>(readyUs.size()); }
+
+signals:
+    void finished();
+
+private:
+    void launch();
+    void finish(bool ok);
+
+    HandshakeOptions options;
+    QElapsedTimer clock;
+    QByteArray sessionTicket;
+    int started;
+    int running;
+    int failures;
+    qint64 wallNs;
+
+    // Время от начала подключения, мкс: TCP установлен, TLS готов, ответ на hello
+    std::vector<qint64> tcpUs;
+    std::vector<qint64> tlsUs;
+    std::vector<qint64> readyUs;
+};
+
+#endif // HANDSHAKEBENCH_H
@@ -0,0 +1,486 @@
+#include "LoadGenerator.h"
+#include <QJsonDocument>
+#include <QJsonArray>
+#include <QRandomGenerator>
+#include <QTextStream>
+#include <QDebug>
+#include <algorithm>
+
+namespace {
+
+const int busyErrorCode = -32001;
+
+const int connectTimeoutMs = 10000;
+// После окончания интервала ждём ответы на отправленное, но не дольше
+const int drainTimeoutMs = 5000;
+const int tickIntervalMs = 1;
+// В открытом цикле отставший демон не должен раздувать память генератора
+const int maxOpenLoopInFlight = 10000;
+
+const QMap<QString, QString> presetMixes = {
+    // Панели мониторинга: сборщики метрик, опрашиваемые по таймеру
+    { "metrics", "getSystemInfo:4,getNetworkStats:2,getDiskStats:2,getCgroupStats:1,getDaemonStats:1" },
+    // Навигация и автоматизация: тяжёлые списки через пул потоков демона
+    { "listings", "getFileSystem:3,getProcessList:2,getServiceList:1" },
+    { "transfers", "downloadFile:1,uploadFile:1" },
+    { "mixed", "getSystemInfo:6,getNetworkStats:3,getDiskStats:3,getFileSystem:2,getProcessList:1,downloadFile:1" },
+};
+
+qint64 percentile(const std::vector<qint64>& sorted, double p)
+{
+    if (sorted.empty()) return 0;
+    const size_t index = std::min(sorted.size() - 1, static_cast<size_t>(p * sorted.size()));
+    return sorted[index];
+}
+
+QString formatUs(qint64 us)
+{
+    if (us >= 1000000) return QString::number(us / 1e6, 'f', 2) + "s";
+    if (us >= 1000) return QString::number(us / 1e3, 'f', 2) + "ms";
+    return QString::number(us) + "us";
+}
+
+} // namespace
+
+// ========== LoadGenerator ==========
+
+LoadGenerator::LoadGenerator(const LoadOptions& options, QObject* parent)
+    : QObject(parent),
+      options(options),
+      measuring(false),
+      warmupScheduled(false),
+      stopping(false),
+      done(false),
+      measureStartNs(0),
+      measuredNs(0),
+      readyConnections(0),
+      failedConnections(0),
+      droppedConnections(0),
+      skippedSends(0)
+{
+    int total = 0;
+    for (const RequestKind& kind : this->options.mix) {
+        total += kind.weight;
+        cumulativeWeights.push_back(total);
+        stats[kind.method];
+    }
+}
+
+QList<RequestKind> LoadGenerator::parseMix(const QString& spec, const QJsonObject& defaults, QString* error)
+{
+    QList<RequestKind> mix;
+    const QString expanded = presetMixes.value(spec, spec);
+    for (const QString& item : expanded.split(',', Qt::SkipEmptyParts)) {
+        const QStringList parts = item.trimmed().split(':');
+        RequestKind kind;
+        kind.method = parts.value(0);
+        bool ok = true;
+        kind.weight = parts.size() > 1 ? parts[1].toInt(&ok) : 1;
+        if (kind.method.isEmpty() || !ok || kind.weight <= 0) {
+            if (error) *error = QString("Invalid mix entry '%1'").arg(item);
+            return {};
+        }
+
+        // Параметры методов, которым они нужны, берутся из опций командной строки
+        if (kind.method == "getFileSystem") {
+            kind.params["path"] = defaults["path"];
+        } else if (kind.method == "downloadFile") {
+            kind.params["remotePath"] = defaults["download"];
+            kind.priority = FrameChannel::Bulk;
+        } else if (kind.method == "uploadFile") {
+            kind.params["remotePath"] = defaults["upload"];
+            kind.params["data"] = defaults["uploadData"];
+            kind.priority = FrameChannel::Bulk;
+        } else if (kind.method == "getProcessList") {
+            kind.params["limit"] = defaults["processLimit"];
+        }
+        mix << kind;
+    }
+    if (mix.isEmpty() && error) *error = "Empty request mix";
+    return mix;
+}
+
+void LoadGenerator::start()
+{
+    clock.start();
+    const double perConnectionRate = options.rate > 0 ? options.rate / options.connections : 0.0;
+    for (int i = 0; i < options.connections; ++i) {
+        LoadConnection* connection = new LoadConnection(this, options, perConnectionRate, this);
+        connect(connection, &LoadConnection::ready, this, &LoadGenerator::onConnectionReady);
+        connect(connection, &LoadConnection::failed, this, &LoadGenerator::onConnectionFailed);
+        connect(connection, &LoadConnection::dropped, this, &LoadGenerator::onConnectionDropped);
+        connections << connection;
+        connection->open();
+    }
+
+    // Не ждём бесконечно соединений, которые так и не поднялись
+    QTimer::singleShot(connectTimeoutMs, this, [this]() {
+        if (warmupScheduled || stopping) return;
+        qWarning() << "Only" << readyConnections << "of" << options.connections << "connections ready";
+        scheduleWarmup();
+    });
+}
+
+void LoadGenerator::scheduleWarmup()
+{
+    if (warmupScheduled) return;
+    warmupScheduled = true;
+    if (readyConnections == 0) {
+        stopping = true;
+        complete();
+        return;
+    }
+    QTimer::singleShot(options.warmupSec * 1000, this, &LoadGenerator::beginMeasurement);
+}
+
+void LoadGenerator::onConnectionReady()
+{
+    ++readyConnections;
+    // Прогрев отсчитывается, когда все соединения поднялись или отказали
+    if (readyConnections + failedConnections == options.connections) scheduleWarmup();
+}
+
+void LoadGenerator::onConnectionFailed()
+{
+    ++failedConnections;
+    if (readyConnections + failedConnections == options.connections) scheduleWarmup();
+}
+
+void LoadGenerator::onConnectionDropped()
+{
+    ++droppedConnections;
+    finishIfIdle();
+}
+
+void LoadGenerator::beginMeasurement()
+{
+    if (measuring || stopping) return;
+    measuring = true;
+    measureStartNs = nowNs();
+    QTimer::singleShot(options.durationSec * 1000, this, &LoadGenerator::endMeasurement);
+}
+
+void LoadGenerator::endMeasurement()
+{
+    measuring = false;
+    stopping = true;
+    measuredNs = nowNs() - measureStartNs;
+    for (LoadConnection* connection : connections) connection->stop();
+
+    for (auto it = stats.begin(); it != stats.end(); ++it) {
+        std::sort(it->latenciesUs.begin(), it->latenciesUs.end());
+    }
+
+    finishIfIdle();
+    QTimer::singleShot(drainTimeoutMs, this, &LoadGenerator::complete);
+}
+
+void LoadGenerator::complete()
+{
+    if (done) return;
+    done = true;
+    emit finished();
+}
+
+void LoadGenerator::finishIfIdle()
+{
+    if (!stopping) return;
+    for (LoadConnection* connection : connections) {
+        if (!connection->isIdle()) return;
+    }
+    QTimer::singleShot(0, this, &LoadGenerator::complete);
+}
+
+const RequestKind& LoadGenerator::pickRequest()
+{
+    const int roll = QRandomGenerator::global()->bounded(cumulativeWeights.back());
+    const auto it = std::upper_bound(cumulativeWeights.begin(), cumulativeWeights.end(), roll);
+    return options.mix[static_cast<int>(it - cumulativeWeights.begin())];
+}
+
+void LoadGenerator::record(const QString& method, qint64 latencyNs, bool ok, bool busy, qint64 bytesOut, qint64 bytesIn)
+{
+    if (!measuring) {
+        if (stopping) finishIfIdle();
+        return;
+    }
+    MethodStats& entry = stats[method];
+    entry.bytesOut += bytesOut;
+    entry.bytesIn += bytesIn;
+    if (ok) entry.latenciesUs.push_back(latencyNs / 1000);
+    else if (busy) ++entry.busy;
+    else ++entry.errors;
+}
+
+QString LoadGenerator::reportText() const
+{
+    QString text;
+    QTextStream out(&text);
+    const double seconds = qMax(measuredSeconds(), 1e-9);
+
+    out << QString("%1 connections, %2 s measured").arg(options.connections).arg(seconds, 0, 'f', 1);
+    if (options.rate > 0) out << QString(", target %1 req/s").arg(options.rate);
+    else out << QString(", pipeline %1").arg(options.pipeline);
+    out << (options.multiplex ? ", multiplexed" : ", legacy framing");
+    if (!options.tls.isNull()) out << ", TLS " << (options.tls.protocol() == QSsl::TlsV1_3OrLater ? "1.3" : "1.2+");
+    out << "\n\n";
+
+    out << QString("%1 %2 %3 %4 %5 %6 %7 %8 %9\n")
+           .arg("method", -20).arg("ok", 9).arg("busy", 7).arg("errors", 7).arg("req/s", 10)
+           .arg("p50", 10).arg("p99", 10).arg("p999", 10).arg("max", 10);
+
+    qint64 totalOk = 0, totalBusy = 0, totalErrors = 0, totalIn = 0, totalOut = 0;
+    for (auto it = stats.constBegin(); it != stats.constEnd(); ++it) {
+        const MethodStats& s = it.value();
+        const qint64 ok = static_cast<qint64>(s.latenciesUs.size());
+        out << QString("%1 %2 %3 %4 %5 %6 %7 %8 %9\n")
+               .arg(it.key(), -20).arg(ok, 9).arg(s.busy, 7).arg(s.errors, 7)
+               .arg(ok / seconds, 10, 'f', 1)
+               .arg(formatUs(percentile(s.latenciesUs, 0.50)), 10)
+               .arg(formatUs(percentile(s.latenciesUs, 0.99)), 10)
+               .arg(formatUs(percentile(s.latenciesUs, 0.999)), 10)
+               .arg(formatUs(s.latenciesUs.empty() ? 0 : s.latenciesUs.back()), 10);
+        totalOk += ok;
+        totalBusy += s.busy;
+        totalErrors += s.errors;
+        totalIn += s.bytesIn;
+        totalOut += s.bytesOut;
+    }
+
+    out << QString("\ntotal: %1 ok (%2 req/s), %3 busy, %4 errors, in %5 MB/s, out %6 MB/s\n")
+           .arg(totalOk).arg(totalOk / seconds, 0, 'f', 1).arg(totalBusy).arg(totalErrors)
+           .arg(totalIn / seconds / (1024 * 1024), 0, 'f', 2)
+           .arg(totalOut / seconds / (1024 * 1024), 0, 'f', 2);
+    if (failedConnections > 0) out << "connections failed: " << failedConnections << '\n';
+    if (droppedConnections > 0) out << "connections dropped during run: " << droppedConnections << '\n';
+    if (skippedSends > 0) out << "sends skipped (daemon fell behind target rate): " << skippedSends << '\n';
+    return text;
+}
+
+QJsonObject LoadGenerator::reportJson() const
+{
+    const double seconds = qMax(measuredSeconds(), 1e-9);
+    QJsonObject methods;
+    for (auto it = stats.constBegin(); it != stats.constEnd(); ++it) {
+        const MethodStats& s = it.value();
+        const qint64 ok = static_cast<qint64>(s.latenciesUs.size());
+        QJsonObject entry;
+        entry["ok"] = ok;
+        entry["busy"] = s.busy;
+        entry["errors"] = s.errors;
+        entry["rps"] = ok / seconds;
+        entry["bytesIn"] = s.bytesIn;
+        entry["bytesOut"] = s.bytesOut;
+        entry["p50Us"] = percentile(s.latenciesUs, 0.50);
+        entry["p99Us"] = percentile(s.latenciesUs, 0.99);
+        entry["p999Us"] = percentile(s.latenciesUs, 0.999);
+        entry["maxUs"] = s.latenciesUs.empty() ? 0 : s.latenciesUs.back();
+        methods[it.key()] = entry;
+    }
+
+    QJsonObject report;
+    report["host"] = options.host;
+    report["port"] = options.port;
+    report["connections"] = options.connections;
+    report["pipeline"] = options.pipeline;
+    report["rate"] = options.rate;
+    report["multiplex"] = options.multiplex;
+    report["tls"] = !options.tls.isNull();
+    report["seconds"] = seconds;
+    report["connectFailures"] = failedConnections;
+    report["droppedConnections"] = droppedConnections;
+    report["skippedSends"] = skippedSends;
+    report["methods"] = methods;
+    return report;
+}
+
+// ========== LoadConnection ==========
+
+LoadConnection::LoadConnection(LoadGenerator* generator, const LoadOptions& options, double rate, QObject* parent)
+    : QObject(parent),
+      generator(generator),
+      options(options),
+      socket(new QSslSocket(this)),
+      channel(new FrameChannel(socket, this)),
+      ticker(nullptr),
+      nextId(1),
+      helloId(-1),
+      authId(-1),
+      running(false),
+      wasReady(false),
+      intervalNs(rate > 0 ? static_cast<qint64>(1e9 / rate) : 0),
+      nextSendNs(0)
+{
+    socket->setSocketOption(QAbstractSocket::LowDelayOption, 1);
+    connect(socket, &QSslSocket::connected, this, [this]() {
+        if (this->options.tls.isNull()) onConnected();
+    });
+    connect(socket, &QSslSocket::encrypted, this, &LoadConnection::onEncrypted);
+    connect(socket, &QSslSocket::disconnected, this, &LoadConnection::onDisconnected);
+    connect(socket, QOverload<QAbstractSocket::SocketError>::of(&QSslSocket::error), this, [this]() {
+        if (!wasReady) {
+            qWarning() << "Connection error:" << socket->errorString();
+            emit failed();
+        }
+    });
+    connect(channel, &FrameChannel::messageReceived, this, &LoadConnection::onMessage);
+    connect(channel, &FrameChannel::protocolError, this, [](const QString& message) {
+        qWarning() << "Protocol error:" << message;
+    });
+}
+
+void LoadConnection::open()
+{
+    if (options.tls.isNull()) {
+        socket->connectToHost(options.host, options.port);
+        return;
+    }
+    socket->setSslConfiguration(options.tls);
+    socket->connectToHostEncrypted(options.host, options.port,
+                                   options.tlsPeerName.isEmpty() ? options.host : options.tlsPeerName);
+}
+
+void LoadConnection::onEncrypted()
+{
+    onConnected();
+}
+
+void LoadConnection::stop()
+{
+    running = false;
+    if (ticker) ticker->stop();
+}
+
+void LoadConnection::onConnected()
+{
+    if (!options.multiplex) {
+        begin();
+        return;
+    }
+    QJsonObject hello;
+    hello["method"] = "hello";
+    hello["params"] = QJsonObject{{"multiplex", true}};
+    helloId = sendRaw(hello, FrameChannel::Interactive, nullptr);
+}
+
+void LoadConnection::begin()
+{
+    wasReady = true;
+    running = true;
+    emit ready();
+    onTick();
+}
+
+int LoadConnection::sendRaw(const QJsonObject& request, FrameChannel::Priority priority, qint64* bytes)
+{
+    QJsonObject obj = request;
+    const int id = nextId++;
+    obj["id"] = id;
+    const QByteArray message = QJsonDocument(obj).toJson(QJsonDocument::Compact);
+    if (bytes) *bytes = message.size();
+    channel->sendMessage(message, priority);
+    return id;
+}
+
+void LoadConnection::sendNext(qint64 intendedNs)
+{
+    const RequestKind& kind = generator->pickRequest();
+    QJsonObject request;
+    request["method"] = kind.method;
+    if (!kind.params.isEmpty()) request["params"] = kind.params;
+
+    Pending entry;
+    entry.method = kind.method;
+    entry.startNs = intendedNs;
+    const int id = sendRaw(request, kind.priority, &entry.bytesOut);
+    pending.insert(id, entry);
+}
+
+void LoadConnection::onTick()
+{
+    if (!running) return;
+
+    if (intervalNs == 0) {
+        // Замкнутый цикл: следующий запрос уходит сразу после ответа
+        while (pending.size() < options.pipeline) sendNext(generator->nowNs());
+        return;
+    }
+
+    if (!ticker) {
+        ticker = new QTimer(this);
+        ticker->setTimerType(Qt::PreciseTimer);
+        connect(ticker, &QTimer::timeout, this, &LoadConnection::onTick);
+        // Разносим соединения по фазе, чтобы они не стреляли пачкой
+        nextSendNs = generator->nowNs() + QRandomGenerator::global()->bounded(intervalNs);
+        ticker->start(tickIntervalMs);
+    }
+
+    const qint64 now = generator->nowNs();
+    while (nextSendNs <= now) {
+        if (pending.size() < maxOpenLoopInFlight) sendNext(nextSendNs);
+        else if (generator->isMeasuring()) ++generator->skippedSends;
+        nextSendNs += intervalNs;
+    }
+}
+
+void LoadConnection::onMessage(const QByteArray& message)
+{
+    const qint64 now = generator->nowNs();
+    const QJsonObject response = QJsonDocument::fromJson(message).object();
+    if (!response.contains("id")) return; // уведомления подписок здесь не ждём
+
+    const int id = response["id"].toInt(-1);
+    if (id == helloId) {
+        helloId = -1;
+        const QJsonObject result = response["result"].toObject();
+        channel->setMultiplexing(result["multiplex"].toBool());
+        const QJsonObject auth = result["auth"].toObject();
+        if (auth.contains("challenge") && !options.credentials.isEmpty()) {
+            const QByteArray challenge = QByteArray::fromBase64(auth["challenge"].toString().toLatin1());
+            QJsonObject request;
+            request["method"] = "authenticate";
+            request["params"] = QJsonObject{
+                {"user", options.credentials.user},
+                {"proof", QString::fromLatin1(options.credentials.proof(challenge).toBase64())}
+            };
+            authId = sendRaw(request, FrameChannel::Interactive, nullptr);
+            return;
+        }
+        begin();
+        return;
+    }
+    if (id == authId) {
+        authId = -1;
+        if (response.contains("error")) {
+            // Демон закроет соединение сам, и оно засчитается как неудачное подключение
+            qWarning() << "Authentication failed:" << response["error"].toObject()["message"].toString();
+            return;
+        }
+        begin();
+        return;
+    }
+
+    auto it = pending.find(id);
+    if (it == pending.end()) return;
+    const Pending entry = it.value();
+    pending.erase(it);
+
+    const bool hasError = response.contains("error");
+    const bool busy = hasError && response["error"].toObject()["code"].toInt() == busyErrorCode;
+    generator->record(entry.method, now - entry.startNs, !hasError, busy, entry.bytesOut, message.size());
+
+    if (intervalNs == 0) onTick();
+}
+
+void LoadConnection::onDisconnected()
+{
+    if (!wasReady) return;
+    // Всё, что было в полёте, засчитываем как ошибки
+    for (const Pending& entry : pending) {
+        generator->record(entry.method, 0, false, false, entry.bytesOut, 0);
+    }
+    pending.clear();
+    stop();
+    wasReady = false;
+    emit dropped();
+}
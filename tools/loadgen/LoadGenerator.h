@@ -0,0 +1,172 @@
+#ifndef LOADGENERATOR_H
+#define LOADGENERATOR_H
+
+#include <QObject>
+#include <QSslSocket>
+#include <QSslConfiguration>
+#include <QElapsedTimer>
+#include <QJsonObject>
+#include <QHash>
+#include <QMap>
+#include <QList>
+#include <QTimer>
+#include <vector>
+#include "FrameChannel.h"
+#include "Credentials.h"
+
+// Один вид запроса в смеси нагрузки и его доля
+struct RequestKind {
+    QString method;
+    QJsonObject params;
+    int weight = 1;
+    FrameChannel::Priority priority = FrameChannel::Interactive;
+};
+
+// Статистика по одному методу за измеряемый интервал
+struct MethodStats {
+    std::vector<qint64> latenciesUs; // только успешные ответы
+    qint64 errors = 0;
+    qint64 busy = 0;                 // -32001: лимит частоты или перегрузка демона
+    qint64 bytesIn = 0;
+    qint64 bytesOut = 0;
+};
+
+struct LoadOptions {
+    QString host = "127.0.0.1";
+    quint16 port = 45454;
+    int connections = 10;
+    // Сколько запросов одно соединение держит в полёте (замкнутый цикл)
+    int pipeline = 1;
+    // Общая целевая частота, запросов/с; 0 - замкнутый цикл без пауз
+    double rate = 0.0;
+    int warmupSec = 5;
+    int durationSec = 30;
+    bool multiplex = true;
+    // Пустая конфигурация - открытый TCP
+    QSslConfiguration tls;
+    QString tlsPeerName;
+    // Вход после hello; без него запросы идут с анонимной ролью демона
+    Credentials credentials;
+    QList<RequestKind> mix;
+};
+
+class LoadConnection;
+
+// Открывает N соединений с демоном, гоняет по ним смесь запросов и собирает
+// задержки по методам. Прогрев не попадает в статистику; ответы, пришедшие
+// после окончания интервала, тоже.
+class LoadGenerator : public QObject
+{
+    Q_OBJECT
+public:
+    explicit LoadGenerator(const LoadOptions& options, QObject* parent = nullptr);
+
+    void start();
+
+    const QMap<QString, MethodStats>& results() const { return stats; }
+    double measuredSeconds() const { return measuredNs / 1e9; }
+    int connectFailures() const { return failedConnections; }
+    int disconnects() const { return droppedConnections; }
+
+    // Текстовый отчёт и то же в JSON
+    QString reportText() const;
+    QJsonObject reportJson() const;
+
+    // Готовые смеси: metrics, listings, transfers, mixed; либо "метод:вес,..."
+    static QList<RequestKind> parseMix(const QString& spec, const QJsonObject& defaults, QString* error);
+
+signals:
+    void finished();
+
+private slots:
+    void onConnectionReady();
+    void onConnectionFailed();
+    void onConnectionDropped();
+    void beginMeasurement();
+    void endMeasurement();
+    void complete();
+
+private:
+    friend class LoadConnection;
+
+    const RequestKind& pickRequest();
+    bool isMeasuring() const { return measuring; }
+    qint64 nowNs() const { return clock.nsecsElapsed(); }
+    void record(const QString& method, qint64 latencyNs, bool ok, bool busy, qint64 bytesOut, qint64 bytesIn);
+    void scheduleWarmup();
+    void finishIfIdle();
+
+    LoadOptions options;
+    QList<LoadConnection*> connections;
+    std::vector<int> cumulativeWeights;
+
+    QElapsedTimer clock;
+    bool measuring;
+    bool warmupScheduled;
+    bool stopping;
+    bool done;
+    qint64 measureStartNs;
+    qint64 measuredNs;
+    int readyConnections;
+    int failedConnections;
+    int droppedConnections;
+    qint64 skippedSends;
+
+    QMap<QString, MethodStats> stats;
+};
+
+// Одно соединение нагрузки: после hello держит в полёте pipeline запросов
+// или шлёт их по расписанию, если задана частота
+class LoadConnection : public QObject
+{
+    Q_OBJECT
+public:
+    LoadConnection(LoadGenerator* generator, const LoadOptions& options, double rate, QObject* parent = nullptr);
+
+    void open();
+    void stop();
+    bool isIdle() const { return pending.isEmpty(); }
+
+signals:
+    void ready();
+    void failed();   // не удалось подключиться или согласовать протокол
+    void dropped();  // соединение оборвалось во время прогона
+
+private slots:
+    void onConnected();
+    void onEncrypted();
+    void onMessage(const QByteArray& message);
+    void onDisconnected();
+    void onTick();
+
+private:
+    struct Pending {
+        QString method;
+        qint64 startNs = 0;
+        qint64 bytesOut = 0;
+    };
+
+    void begin();
+    void sendNext(qint64 intendedNs);
+    int sendRaw(const QJsonObject& request, FrameChannel::Priority priority, qint64* bytes);
+
+    LoadGenerator* generator;
+    const LoadOptions& options;
+    QSslSocket* socket;
+    FrameChannel* channel;
+    QTimer* ticker;
+
+    QHash<int, Pending> pending;
+    int nextId;
+    int helloId;
+    int authId;
+    bool running;
+    bool wasReady;
+
+    // Открытый цикл: запросы идут по расписанию, задержка считается от
+    // запланированного момента, а не от фактической отправки
+    qint64 intervalNs;
+    qint64 nextSendNs;
+};
+
+#endif // LOADGENERATOR_H
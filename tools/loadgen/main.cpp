@@ -0,0 +1,159 @@
+#include "LoadGenerator.h"
+#include "HandshakeBench.h"
+#include "TlsOptions.h"
+#include <QCoreApplication>
+#include <QCommandLineParser>
+#include <QJsonDocument>
+#include <QTextStream>
+#include <QRandomGenerator>
+
+int main(int argc, char* argv[])
+{
+    QCoreApplication app(argc, argv);
+    app.setApplicationName("os_overview_loadgen");
+    app.setApplicationVersion("1.0");
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription(
+        "Load generator for os_overview_server.\n"
+        "Mixes: metrics, listings, transfers, mixed, or method:weight,... "
+        "(e.g. getSystemInfo:5,getFileSystem:1).\n"
+        "With --handshakes N measures connection setup instead: N connect/TLS/hello cycles, "
+        "-c of them at a time.");
+    parser.addHelpOption();
+    parser.addVersionOption();
+
+    const QCommandLineOption hostOption({ "H", "host" }, "Daemon address.", "host", "127.0.0.1");
+    const QCommandLineOption portOption({ "p", "port" }, "Daemon port.", "port", "45454");
+    const QCommandLineOption connectionsOption({ "c", "connections" }, "Concurrent connections.", "n", "10");
+    const QCommandLineOption pipelineOption("pipeline", "Requests in flight per connection (closed loop).", "n", "1");
+    const QCommandLineOption rateOption({ "r", "rate" },
+        "Total target rate, requests/s (open loop; latency includes queueing behind the schedule).", "rps", "0");
+    const QCommandLineOption durationOption({ "d", "duration" }, "Measured interval, seconds.", "sec", "30");
+    const QCommandLineOption warmupOption("warmup", "Warm-up before measuring, seconds.", "sec", "5");
+    const QCommandLineOption mixOption({ "m", "mix" }, "Request mix.", "mix", "metrics");
+    const QCommandLineOption pathOption("path", "Directory for getFileSystem.", "path", "/");
+    const QCommandLineOption downloadOption("download", "Remote file for downloadFile.", "path", "/etc/os-release");
+    const QCommandLineOption uploadOption("upload", "Remote file for uploadFile.", "path", "/tmp/os_overview_loadgen.bin");
+    const QCommandLineOption uploadSizeOption("upload-size", "uploadFile payload, KB.", "kb", "1024");
+    const QCommandLineOption processLimitOption("process-limit", "limit for getProcessList (0 = all).", "n", "0");
+    const QCommandLineOption legacyOption("legacy", "Do not negotiate multiplexing (length-prefixed frames only).");
+    const QCommandLineOption jsonOption("json", "Print the report as JSON.");
+    const QCommandLineOption tlsOption("tls", "Connect over TLS.");
+    const QCommandLineOption caOption("ca", "CA certificates for verifying the daemon (PEM).", "file");
+    const QCommandLineOption certOption("cert", "Client certificate (PEM).", "file");
+    const QCommandLineOption keyOption("key", "Client private key (PEM).", "file");
+    const QCommandLineOption peerNameOption("peer-name", "Expected name in the daemon certificate.", "name");
+    const QCommandLineOption insecureOption("insecure", "Do not verify the daemon certificate.");
+    const QCommandLineOption handshakesOption("handshakes", "Measure N connection setups instead of requests.", "n");
+    const QCommandLineOption noResumeOption("no-resume", "With --handshakes: full TLS handshake every time.");
+    const QCommandLineOption userOption({ "u", "user" }, "Log in as this user after hello.", "name");
+    const QCommandLineOption secretFileOption("secret-file", "File with the user's shared secret.", "file");
+    parser.addOptions({ hostOption, portOption, connectionsOption, pipelineOption, rateOption, durationOption,
+                        warmupOption, mixOption, pathOption, downloadOption, uploadOption, uploadSizeOption,
+                        processLimitOption, legacyOption, jsonOption, tlsOption, caOption, certOption,
+                        keyOption, peerNameOption, insecureOption, handshakesOption, noResumeOption,
+                        userOption, secretFileOption });
+    parser.process(app);
+
+    QTextStream err(stderr);
+    QTextStream out(stdout);
+
+    LoadOptions options;
+    options.host = parser.value(hostOption);
+    options.port = static_cast<quint16>(parser.value(portOption).toUInt());
+    options.connections = qMax(1, parser.value(connectionsOption).toInt());
+    options.pipeline = qMax(1, parser.value(pipelineOption).toInt());
+    options.rate = qMax(0.0, parser.value(rateOption).toDouble());
+    options.durationSec = qMax(1, parser.value(durationOption).toInt());
+    options.warmupSec = qMax(0, parser.value(warmupOption).toInt());
+    options.multiplex = !parser.isSet(legacyOption);
+
+    // Конфигурация TLS строится один раз и копируется во все соединения
+    TlsOptions tls;
+    tls.enabled = parser.isSet(tlsOption) || parser.isSet(caOption) || parser.isSet(certOption);
+    tls.caFile = parser.value(caOption);
+    tls.certificateFile = parser.value(certOption);
+    tls.privateKeyFile = parser.value(keyOption);
+    tls.peerName = parser.value(peerNameOption);
+    tls.verifyPeer = !parser.isSet(insecureOption);
+    QString tlsError;
+    if (tls.enabled && !tls.makeConfiguration(QSslSocket::SslClientMode, &options.tls, &tlsError)) {
+        err << "TLS: " << tlsError << '\n';
+        return 2;
+    }
+    options.tlsPeerName = tls.peerName;
+
+    options.credentials.user = parser.value(userOption);
+    QString authError;
+    if (!options.credentials.user.isEmpty()
+        && !Credentials::loadSecret(parser.value(secretFileOption), &options.credentials.secret, &authError)) {
+        err << "Auth: " << authError << '\n';
+        return 2;
+    }
+
+    if (parser.isSet(handshakesOption)) {
+        HandshakeOptions handshake;
+        handshake.host = options.host;
+        handshake.port = options.port;
+        handshake.count = qMax(1, parser.value(handshakesOption).toInt());
+        handshake.concurrency = options.connections;
+        handshake.tls = options.tls;
+        handshake.tlsPeerName = options.tlsPeerName;
+        handshake.resume = !parser.isSet(noResumeOption);
+
+        HandshakeBench bench(handshake);
+        QObject::connect(&bench, &HandshakeBench::finished, &app, [&]() {
+            if (parser.isSet(jsonOption)) {
+                out << QJsonDocument(bench.reportJson()).toJson(QJsonDocument::Indented);
+            } else {
+                out << bench.reportText();
+            }
+            out.flush();
+            app.exit(bench.succeeded() > 0 ? 0 : 1);
+        });
+        bench.start();
+        return app.exec();
+    }
+
+    // Данные для uploadFile генерируются один раз и шлются во всех запросах
+    QJsonObject defaults;
+    defaults["path"] = parser.value(pathOption);
+    defaults["download"] = parser.value(downloadOption);
+    defaults["upload"] = parser.value(uploadOption);
+    defaults["processLimit"] = parser.value(processLimitOption).toInt();
+    const QString mixSpec = parser.value(mixOption);
+    if (mixSpec.contains("uploadFile") || mixSpec == "transfers") {
+        QByteArray payload(qMax(1, parser.value(uploadSizeOption).toInt()) * 1024, Qt::Uninitialized);
+        QRandomGenerator generator(1);
+        for (char& byte : payload) byte = static_cast<char>(generator.bounded(256));
+        defaults["uploadData"] = QString::fromLatin1(payload.toBase64());
+    }
+
+    QString error;
+    options.mix = LoadGenerator::parseMix(mixSpec, defaults, &error);
+    if (options.mix.isEmpty()) {
+        err << error << '\n';
+        return 2;
+    }
+
+    LoadGenerator generator(options);
+    QObject::connect(&generator, &LoadGenerator::finished, &app, [&]() {
+        if (parser.isSet(jsonOption)) {
+            out << QJsonDocument(generator.reportJson()).toJson(QJsonDocument::Indented);
+        } else {
+            out << generator.reportText();
+        }
+        out.flush();
+        app.exit(generator.measuredSeconds() > 0 ? 0 : 1);
+    });
+
+    if (!parser.isSet(jsonOption)) {
+        err << QString("Running %1 connections against %2:%3, warm-up %4 s, measuring %5 s...\n")
+               .arg(options.connections).arg(options.host).arg(options.port)
+               .arg(options.warmupSec).arg(options.durationSec);
+        err.flush();
+    }
+    generator.start();
+    return app.exec();
+}